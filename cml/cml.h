@@ -9,8 +9,6 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 /** @file
  *  @brief Main CML header to include all CML functionality.
  *
- * @todo load vectors, matrices, and quaternions from a stream.
- *
  * @todo Move common vector and matrix class ops to a base class (requires
  * SCOOP-like programming, see below).
  *
@@ -22,9 +20,6 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
  * @todo Implement dedicated square matrix classes to get rid of duplicated
  * code in the specialized matrix classes.
  *
- * @todo Implement automatic temporary generation, along with expression
- * node return types for mat-vec and mat-mat operators.
- *
  * @todo switch to ssize_t instead of size_t to avoid having to explicitly
  * deal with wrap-arounds to 2^32-1 when a size_t is subtracted from.
  *
@@ -66,7 +61,9 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/vector.h>
 #include <cml/matrix.h>
 #include <cml/quaternion.h>
+#include <cml/dual_quaternion.h>
 #include <cml/util.h>
+#include <cml/soa_vector.h>
 #include <cml/mathlib/mathlib.h>
 
 #endif
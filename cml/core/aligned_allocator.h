@@ -0,0 +1,182 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief An STL-compatible allocator returning aligned memory.
+ *
+ * aligned_allocator<T,Align> can be used anywhere std::allocator<T> can,
+ * including as the allocator of a dynamic<> array, e.g.
+ *
+ *   vector< float, dynamic< aligned_allocator<float,32> > > v;
+ *
+ * The start of every block it returns is aligned to Align bytes, which
+ * must be a power of two.  allocator_alignment<> reports that alignment to
+ * the packet kernels, so that they can use aligned loads and stores.
+ *
+ * aligned_new<Align> gives a class operator new and delete returning the
+ * same aligned blocks.  Before C++17, new-expressions only guarantee the
+ * alignment of malloc(), so the aligned fixed<> arrays derive from it to
+ * keep their alignment when allocated on the heap.
+ */
+
+#ifndef aligned_allocator_h
+#define aligned_allocator_h
+
+#include <new>
+#include <cml/core/common.h>
+#include <cml/core/cml_assert.h>
+
+namespace cml {
+
+/** Allocator returning memory aligned to Align bytes. */
+template<typename T, int Align> class aligned_allocator
+{
+  public:
+
+    /* Require Align to be a power of two: */
+    CML_STATIC_REQUIRE(Align > 0 && (Align & (Align-1)) == 0);
+
+    /* Standard: */
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    /** Rebind to an allocator of U with the same alignment. */
+    template<typename U> struct rebind {
+        typedef aligned_allocator<U,Align> other;
+    };
+
+    /** The alignment as an enumerated value. */
+    enum { alignment = Align };
+
+
+  public:
+
+    aligned_allocator() {}
+
+    template<typename U>
+        aligned_allocator(const aligned_allocator<U,Align>&) {}
+
+
+  public:
+
+    pointer address(reference r) const { return &r; }
+    const_pointer address(const_reference r) const { return &r; }
+
+    /** Allocate space for n elements, aligned to Align bytes.
+     *
+     * The block is over-allocated with operator new, and the address
+     * returned by operator new is stored just before the aligned start.
+     *
+     * @throws std::bad_alloc if the memory cannot be allocated, or if the
+     * padded size of n elements does not fit in a size_t.
+     */
+    pointer allocate(size_type n, const void* = 0) {
+        if(n > (size_t(-1) - Align - sizeof(void*))/sizeof(T))
+            throw std::bad_alloc();
+        size_t bytes = n*sizeof(T) + Align + sizeof(void*);
+        char* raw = static_cast<char*>(::operator new(bytes));
+        size_t start = reinterpret_cast<size_t>(raw + sizeof(void*));
+        char* p = raw + sizeof(void*) + ((Align - start%Align) % Align);
+        reinterpret_cast<void**>(p)[-1] = raw;
+        return reinterpret_cast<pointer>(p);
+    }
+
+    /** Release a block returned by allocate(). */
+    void deallocate(pointer p, size_type) {
+        if(p) ::operator delete(reinterpret_cast<void**>(p)[-1]);
+    }
+
+    size_type max_size() const {
+        return (size_type(-1) - Align - sizeof(void*))/sizeof(T);
+    }
+
+    void construct(pointer p, const T& v) { new((void*)p) T(v); }
+    void destroy(pointer p) { p->~T(); }
+};
+
+/** Allocator selector for aligned_allocator<>, as for std::allocator. */
+template<int Align> class aligned_allocator<void,Align>
+{
+  public:
+
+    typedef void value_type;
+    typedef void* pointer;
+    typedef const void* const_pointer;
+
+    template<typename U> struct rebind {
+        typedef aligned_allocator<U,Align> other;
+    };
+
+    enum { alignment = Align };
+};
+
+template<typename T1, typename T2, int Align> inline bool operator==(
+        const aligned_allocator<T1,Align>&, const aligned_allocator<T2,Align>&)
+{
+    return true;
+}
+
+template<typename T1, typename T2, int Align> inline bool operator!=(
+        const aligned_allocator<T1,Align>&, const aligned_allocator<T2,Align>&)
+{
+    return false;
+}
+
+/** Class-level operator new and delete returning memory aligned to Align.
+ *
+ * The placement forms are declared because the class-level ones hide the
+ * global placement new.  aligned_new<0> uses the global operators.
+ */
+template<int Align> struct aligned_new
+{
+    static void* operator new(size_t n) {
+        return aligned_allocator<char,Align>().allocate(n);
+    }
+
+    static void* operator new[](size_t n) {
+        return aligned_allocator<char,Align>().allocate(n);
+    }
+
+    static void* operator new(size_t, void* p) { return p; }
+    static void* operator new[](size_t, void* p) { return p; }
+
+    static void operator delete(void* p) {
+        aligned_allocator<char,Align>().deallocate(static_cast<char*>(p), 0);
+    }
+
+    static void operator delete[](void* p) {
+        aligned_allocator<char,Align>().deallocate(static_cast<char*>(p), 0);
+    }
+
+    static void operator delete(void*, void*) {}
+    static void operator delete[](void*, void*) {}
+};
+
+template<> struct aligned_new<0> {};
+
+/** The guaranteed alignment of memory from an allocator (0 if unknown). */
+template<class Alloc> struct allocator_alignment {
+    enum { value = 0 };
+};
+
+template<typename T, int Align>
+struct allocator_alignment< aligned_allocator<T,Align> > {
+    enum { value = Align };
+};
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,54 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Storage for fixed-size arrays with an explicit alignment.
+ *
+ * Compilers only accept literal alignments in their alignment attributes,
+ * so aligned_array<> is specialized for the supported values: 0 (the
+ * natural alignment of the element type), 16, 32 and 64 bytes.
+ */
+
+#ifndef aligned_array_h
+#define aligned_array_h
+
+#if defined(_MSC_VER)
+#define CML_ALIGN(_n_) __declspec(align(_n_))
+#else
+#define CML_ALIGN(_n_) __attribute__((aligned(_n_)))
+#endif
+
+namespace cml {
+namespace detail {
+
+/** Holds a C array of type ArrayT, aligned to Align bytes. */
+template<class ArrayT, int Align> struct aligned_array;
+
+/** Naturally-aligned storage, with the same layout as ArrayT itself. */
+template<class ArrayT> struct aligned_array<ArrayT,0> {
+    ArrayT m_data;
+};
+
+#define CML_ALIGNED_ARRAY(_n_)                                          \
+template<class ArrayT> struct aligned_array<ArrayT,_n_> {               \
+    CML_ALIGN(_n_) ArrayT m_data;                                       \
+};
+
+CML_ALIGNED_ARRAY(16)
+CML_ALIGNED_ARRAY(32)
+CML_ALIGNED_ARRAY(64)
+
+#undef CML_ALIGNED_ARRAY
+
+} // namespace detail
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -77,6 +77,27 @@ struct row_basis {};
 /** Column-vector matrix basis tag. */
 struct col_basis {};
 
+/** Exact inverse square root tag: 1/std::sqrt(x). */
+struct inv_sqrt_exact {};
+
+/** Inverse square root tag: the hardware estimate, refined by one Newton
+ * step.
+ *
+ * The relative error is below 5e-7 with SSE, or 5e-6 otherwise.
+ */
+struct inv_sqrt_newton {};
+
+/** Inverse square root tag: the raw hardware estimate.
+ *
+ * The relative error is below 3.7e-4 with SSE, or 1.8e-3 otherwise.
+ */
+struct inv_sqrt_estimate {};
+
+/** The inverse square root precision used to normalize vectors,
+ * quaternions and planes (see CML_DEFAULT_INV_SQRT_PRECISION).
+ */
+typedef CML_DEFAULT_INV_SQRT_PRECISION default_inv_sqrt_precision;
+
 /* This is the pair returned from the matrix size() method, as well as from
  * the matrix expression size checking code:
  */
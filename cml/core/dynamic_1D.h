@@ -14,7 +14,9 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define dynamic_1D_h
 
 #include <memory>
+#include <algorithm>            // for std::min, std::swap
 #include <cml/core/common.h>
+#include <cml/core/aligned_allocator.h>
 #include <cml/dynamic.h>
 
 namespace cml {
@@ -25,6 +27,9 @@ namespace cml {
  *
  * @internal The internal array type <em>must</em> have the proper copy
  * semantics, otherwise copy construction will fail.
+ *
+ * @internal The array keeps its allocation when it shrinks, so that
+ * resizing or assigning within capacity() does not reallocate.
  */
 template<typename Element, class Alloc>
 class dynamic_1D
@@ -62,34 +67,72 @@ class dynamic_1D
     /** Dynamic arrays have no fixed size. */
     enum { array_size = -1 };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = allocator_alignment<allocator_type>::value };
+
 
   public:
 
     /** Construct a dynamic array with no size. */
-    dynamic_1D() : m_size(0), m_data(0), m_alloc() {}
+    dynamic_1D() : m_size(0), m_capacity(0), m_data(0), m_alloc() {}
 
     /** Construct a dynamic array given the size. */
-    explicit dynamic_1D(size_t size) : m_size(0), m_data(0), m_alloc() {
+    explicit dynamic_1D(size_t size)
+      : m_size(0), m_capacity(0), m_data(0), m_alloc()
+    {
       this->resize(size);
     }
 
     /** Copy construct a dynamic array. */
     dynamic_1D(const dynamic_1D& other)
-      : m_size(0), m_data(0), m_alloc()
+      : m_size(0), m_capacity(0), m_data(0), m_alloc()
     {
       this->copy(other);
     }
 
+#if defined(CML_HAS_RVALUE_REFERENCES)
+    /** Move construct a dynamic array, taking over the other's storage. */
+    dynamic_1D(dynamic_1D&& other) CML_NOEXCEPT
+      : m_size(0), m_capacity(0), m_data(0), m_alloc()
+    {
+      this->swap(other);
+    }
+#endif
+
     ~dynamic_1D() {
       this->destroy();
     }
 
+    /** Copy assign a dynamic array. */
+    dynamic_1D& operator=(const dynamic_1D& other) {
+      this->copy(other);
+      return *this;
+    }
+
+#if defined(CML_HAS_RVALUE_REFERENCES)
+    /** Move assign a dynamic array.  The current contents are released,
+     * and other is left empty.
+     */
+    dynamic_1D& operator=(dynamic_1D&& other) CML_NOEXCEPT {
+      if(&other != this) {
+	this->destroy();
+	this->swap(other);
+      }
+      return *this;
+    }
+#endif
+
 
   public:
 
     /** Return the number of elements in the array. */
     size_t size() const { return m_size; }
 
+    /** Return the number of elements the array can hold without
+     * reallocating.
+     */
+    size_t capacity() const { return m_capacity; }
+
     /** Access to the data as a C array.
      *
      * @param i a size_t index into the array.
@@ -117,8 +160,10 @@ class dynamic_1D
 
   public:
 
-    /** Set the array size to the given value.  The previous contents are
-     * destroyed before reallocating the array.  If s == size(),
+    /** Set the array size to the given value.  If s <= capacity(), the
+     * current storage is reused: elements past s are destroyed, and new
+     * elements are default-constructed.  Otherwise, the previous contents
+     * are destroyed before reallocating the array.  If s == size(),
      * nothing happens.
      *
      * @warning This is not guaranteed to preserve the original data.
@@ -128,65 +173,85 @@ class dynamic_1D
       /* Nothing to do if the size isn't changing: */
       if(s == m_size) return;
 
-      /* Destroy the current array contents: */
-      this->destroy();
-
-      /* Set the new size if non-zero: */
-      if(s > 0) {
-	value_type* data = m_alloc.allocate(s);
-	for(size_t i = 0; i < s; ++ i)
-	  m_alloc.construct(&data[i], value_type());
+      /* Reallocate if the current storage is too small: */
+      if(s > m_capacity) this->reallocate(s);
 
-	/* Success, save s and data: */
-	m_size = s;
-	m_data = data;
-      }
+      /* Construct or destroy the difference: */
+      for(size_t i = m_size; i < s; ++ i)
+	m_alloc.construct(&m_data[i], value_type());
+      for(size_t i = s; i < m_size; ++ i)
+	m_alloc.destroy(&m_data[i]);
+      m_size = s;
     }
 
-    /** Copy the source array. The previous contents are destroyed before
-     * reallocating the array.  If other == *this, nothing happens.
+    /** Copy the source array.  If the array has room for other.size()
+     * elements, the current storage is reused; otherwise, the previous
+     * contents are destroyed before reallocating the array.  If other ==
+     * *this, nothing happens.
      */
     void copy(const dynamic_1D& other) {
 
       /* Nothing to do if it's the same array: */
       if(&other == this) return;
 
-      /* Destroy the current array contents: */
-      this->destroy();
-
-      /* Set the new size if non-zero: */
+      /* Reallocate if the current storage is too small: */
       size_t s = other.size();
-      if(s > 0) {
-	value_type* data = m_alloc.allocate(s);
-	for(size_t i = 0; i < s; ++ i)
-	  m_alloc.construct(&data[i], other[i]);
-
-	/* Success, so save the new array and the size: */
-	m_size = s;
-	m_data = data;
-      }
+      if(s > m_capacity) this->reallocate(s);
+
+      /* Assign over existing elements, then construct or destroy the
+       * difference:
+       */
+      size_t n = std::min(s, m_size);
+      for(size_t i = 0; i < n; ++ i)
+	m_data[i] = other.m_data[i];
+      for(size_t i = n; i < s; ++ i)
+	m_alloc.construct(&m_data[i], other.m_data[i]);
+      for(size_t i = s; i < m_size; ++ i)
+	m_alloc.destroy(&m_data[i]);
+      m_size = s;
+    }
+
+    /** Exchange the contents of two arrays without copying elements. */
+    void swap(dynamic_1D& other) CML_NOEXCEPT {
+      std::swap(m_size, other.m_size);
+      std::swap(m_capacity, other.m_capacity);
+      std::swap(m_data, other.m_data);
+      std::swap(m_alloc, other.m_alloc);
     }
 
 
   protected:
 
-    /** Destroy the current contents of the array. */
+    /** Destroy the current contents of the array, and release its
+     * storage.
+     */
     void destroy() {
       if(m_data) {
 	for(size_t i = 0; i < m_size; ++ i)
 	  m_alloc.destroy(&m_data[i]);
-	m_alloc.deallocate(m_data, m_size);
-	m_size = 0;
+	m_alloc.deallocate(m_data, m_capacity);
+	m_size = m_capacity = 0;
 	m_data = 0;
       }
     }
 
+    /** Replace the storage with an empty block holding n elements. */
+    void reallocate(size_t n) {
+      value_type* data = m_alloc.allocate(n);
+      this->destroy();
+      m_capacity = n;
+      m_data = data;
+    }
+
 
   protected:
 
     /** Current array size (may be 0). */
     size_t			m_size;
 
+    /** Number of elements allocated (at least m_size). */
+    size_t			m_capacity;
+
     /** Array data (may be NULL). */
     value_type*			m_data;
 
@@ -14,6 +14,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define dynamic_2D_h
 
 #include <memory>
+#include <algorithm>            // for std::min, std::swap
 #include <cml/core/common.h>
 #include <cml/core/dynamic_1D.h>
 #include <cml/dynamic.h>
@@ -28,6 +29,9 @@ namespace cml {
  * semantics, otherwise copy construction will fail.
  *
  * @internal This class does not need a destructor.
+ *
+ * @internal The array keeps its allocation when it shrinks, so that
+ * resizing or assigning within capacity() does not reallocate.
  */
 template<typename Element, typename Layout, class Alloc>
 class dynamic_2D
@@ -74,31 +78,63 @@ class dynamic_2D
   protected:
 
     /** Construct a dynamic array with no size. */
-    dynamic_2D() : m_rows(0), m_cols(0), m_data(0), m_alloc() {}
+    dynamic_2D()
+        : m_rows(0), m_cols(0), m_capacity(0), m_data(0), m_alloc() {}
 
     /** Construct a dynamic matrix given the dimensions. */
     explicit dynamic_2D(size_t rows, size_t cols) 
-        : m_rows(0), m_cols(0), m_data(0), m_alloc()
+        : m_rows(0), m_cols(0), m_capacity(0), m_data(0), m_alloc()
        	{
 	  this->resize(rows, cols);
 	}
 
     /** Copy construct a dynamic matrix. */
     dynamic_2D(const dynamic_2D& other)
-        : m_rows(0), m_cols(0), m_data(0), m_alloc()
+        : m_rows(0), m_cols(0), m_capacity(0), m_data(0), m_alloc()
        	{
 	  this->copy(other);
 	}
 
+#if defined(CML_HAS_RVALUE_REFERENCES)
+    /** Move construct a dynamic matrix, taking over the other's storage. */
+    dynamic_2D(dynamic_2D&& other) CML_NOEXCEPT
+        : m_rows(0), m_cols(0), m_capacity(0), m_data(0), m_alloc()
+       	{
+	  this->swap(other);
+	}
+#endif
+
     ~dynamic_2D() {
       this->destroy();
     }
 
+    /** Copy assign a dynamic matrix. */
+    dynamic_2D& operator=(const dynamic_2D& other) {
+      this->copy(other);
+      return *this;
+    }
+
+#if defined(CML_HAS_RVALUE_REFERENCES)
+    /** Move assign a dynamic matrix.  The current contents are released,
+     * and other is left empty.
+     */
+    dynamic_2D& operator=(dynamic_2D&& other) CML_NOEXCEPT {
+      if(&other != this) {
+	this->destroy();
+	this->swap(other);
+      }
+      return *this;
+    }
+#endif
+
 
   public:
 
     enum { array_rows = -1, array_cols = -1 };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = allocator_alignment<allocator_type>::value };
+
 
   public:
 
@@ -108,6 +144,11 @@ class dynamic_2D
     /** Return the number of cols in the array. */
     size_t cols() const { return m_cols; }
 
+    /** Return the number of elements the array can hold without
+     * reallocating.
+     */
+    size_t capacity() const { return m_capacity; }
+
 
   public:
 
@@ -140,10 +181,12 @@ class dynamic_2D
 
   public:
 
-    /** Set the array dimensions.  The previous contents are destroyed
-     * before reallocating the array.  If the number of rows and columns
-     * isn't changing, nothing happens.  Also, if either rows or cols is 0,
-     * the array is cleared.
+    /** Set the array dimensions.  If rows*cols <= capacity(), the current
+     * storage is reused: elements past rows*cols are destroyed, and new
+     * elements are default-constructed.  Otherwise, the previous contents
+     * are destroyed before reallocating the array.  If the number of rows
+     * and columns isn't changing, nothing happens.  Also, if either rows
+     * or cols is 0, the array is emptied.
      *
      * @warning This is not guaranteed to preserve the original data.
      */
@@ -152,46 +195,58 @@ class dynamic_2D
       /* Nothing to do if the size isn't changing: */
       if(rows == m_rows && cols == m_cols) return;
 
-      /* Destroy the current array contents: */
-      this->destroy();
+      /* An empty array has no dimensions: */
+      size_t n = rows*cols, m = m_rows*m_cols;
+      if(n == 0) rows = cols = 0;
 
-      /* Set the new size if non-zero: */
-      if(rows*cols > 0) {
-	value_type* data = m_alloc.allocate(rows*cols);
-	for(size_t i = 0; i < rows*cols; ++ i)
-	  m_alloc.construct(&data[i], value_type());
+      /* Reallocate if the current storage is too small: */
+      if(n > m_capacity) { this->reallocate(n); m = 0; }
 
-	/* Success, so save the new array and the dimensions: */
-	m_rows = rows;
-	m_cols = cols;
-	m_data = data;
-      }
+      /* Construct or destroy the difference: */
+      for(size_t i = m; i < n; ++ i)
+	m_alloc.construct(&m_data[i], value_type());
+      for(size_t i = n; i < m; ++ i)
+	m_alloc.destroy(&m_data[i]);
+      m_rows = rows;
+      m_cols = cols;
     }
 
-    /** Copy the other array.  The previous contents are destroyed before
-     * reallocating the array.  If other == *this, nothing happens.  Also,
-     * if either other.rows() or other.cols() is 0, the array is cleared.
+    /** Copy the other array.  If the array has room for the other's
+     * elements, the current storage is reused; otherwise, the previous
+     * contents are destroyed before reallocating the array.  If other ==
+     * *this, nothing happens.  Also, if either other.rows() or
+     * other.cols() is 0, the array is emptied.
      */
     void copy(const dynamic_2D& other) {
 
       /* Nothing to do if it's the same array: */
       if(&other == this) return;
 
-      /* Destroy the current array contents: */
-      this->destroy();
+      /* Reallocate if the current storage is too small: */
+      size_t n = other.m_rows*other.m_cols, m = m_rows*m_cols;
+      if(n > m_capacity) { this->reallocate(n); m = 0; }
+
+      /* Assign over existing elements, then construct or destroy the
+       * difference:
+       */
+      size_t k = std::min(n, m);
+      for(size_t i = 0; i < k; ++ i)
+	m_data[i] = other.m_data[i];
+      for(size_t i = k; i < n; ++ i)
+	m_alloc.construct(&m_data[i], other.m_data[i]);
+      for(size_t i = n; i < m; ++ i)
+	m_alloc.destroy(&m_data[i]);
+      m_rows = other.m_rows;
+      m_cols = other.m_cols;
+    }
 
-      /* Set the new size if non-zero: */
-      size_t rows = other.rows(), cols = other.cols();
-      if(rows*cols > 0) {
-	value_type* data = m_alloc.allocate(rows*cols);
-	for(size_t i = 0; i < rows*cols; ++ i)
-	  m_alloc.construct(&data[i], other[i]);
-
-	/* Success, so save the new array and the dimensions: */
-	m_rows = rows;
-	m_cols = cols;
-	m_data = data;
-      }
+    /** Exchange the contents of two arrays without copying elements. */
+    void swap(dynamic_2D& other) CML_NOEXCEPT {
+      std::swap(m_rows, other.m_rows);
+      std::swap(m_cols, other.m_cols);
+      std::swap(m_capacity, other.m_capacity);
+      std::swap(m_data, other.m_data);
+      std::swap(m_alloc, other.m_alloc);
     }
 
 
@@ -216,23 +271,36 @@ class dynamic_2D
 
   protected:
 
-    /** Destroy the current contents of the array. */
+    /** Destroy the current contents of the array, and release its
+     * storage.
+     */
     void destroy() {
       if(m_data) {
 	for(size_t i = 0; i < m_rows*m_cols; ++ i)
 	  m_alloc.destroy(&m_data[i]);
-	m_alloc.deallocate(m_data, m_rows*m_cols);
-	m_rows = m_cols = 0;
+	m_alloc.deallocate(m_data, m_capacity);
+	m_rows = m_cols = m_capacity = 0;
 	m_data = 0;
       }
     }
 
+    /** Replace the storage with an empty block holding n elements. */
+    void reallocate(size_t n) {
+      value_type* data = m_alloc.allocate(n);
+      this->destroy();
+      m_capacity = n;
+      m_data = data;
+    }
+
 
   protected:
 
     /** Current array dimensions (may be 0,0). */
     size_t                      m_rows, m_cols;
 
+    /** Number of elements allocated (at least m_rows*m_cols). */
+    size_t                      m_capacity;
+
     /** Array data (may be NULL). */
     value_type*			m_data;
 
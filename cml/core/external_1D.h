@@ -69,6 +69,9 @@ class external_1D
     /** The length as an enumerated value. */
     enum { array_size = Size };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = 0 };
+
 
   public:
 
@@ -164,6 +167,9 @@ class external_1D<Element,-1>
     /** The length as an enumerated value. */
     enum { array_size = -1 };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = 0 };
+
 
   public:
 
@@ -84,6 +84,9 @@ class external_2D
 
     enum { array_rows = Rows, array_cols = Cols };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = 0 };
+
 
   public:
 
@@ -222,6 +225,9 @@ class external_2D<Element,-1,-1,Layout>
 
     enum { array_rows = -1, array_cols = -1 };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = 0 };
+
 
   public:
 
@@ -14,8 +14,11 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define fixed_1D_h
 
 #include <cml/core/common.h>
+#include <cml/core/fwd.h>
 #include <cml/core/cml_meta.h>
 #include <cml/core/cml_assert.h>
+#include <cml/core/aligned_array.h>
+#include <cml/core/aligned_allocator.h>
 #include <cml/fixed.h>
 
 namespace cml {
@@ -37,14 +40,18 @@ namespace cml {
  * a separate class to take a C array (or pointer) and turn it into an array
  * object.
  *
+ * Align selects the alignment of the array, as for fixed<>, and
+ * aligned_new<> keeps that alignment for heap-allocated arrays.
+ *
  * @sa cml::fixed
  *
  * @internal Do <em>not</em> add the empty constructor and destructor; at
  * least one compiler (Intel C++ 9.0) fails to optimize them away, and they
  * aren't needed anyway here.
  */
-template<typename Element, int Size>
+template<typename Element, int Size, int Align>
 class fixed_1D
+    : public aligned_new<Align>
 {
   public:
 
@@ -52,7 +59,7 @@ class fixed_1D
     CML_STATIC_REQUIRE(Size > 0);
 
     /* Record the generator: */
-    typedef fixed<Size,-1> generator_type;
+    typedef fixed<Size,-1,Align> generator_type;
 
     /* Standard: */
     typedef Element value_type;
@@ -82,6 +89,9 @@ class fixed_1D
     /** The length as an enumerated value. */
     enum { array_size = Size };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = Align };
+
 
   public:
 
@@ -95,7 +105,7 @@ class fixed_1D
      *
      * @note This function does not range-check the argument.
      */
-    reference operator[](size_t i) { return m_data[i]; }
+    reference operator[](size_t i) { return m_store.m_data[i]; }
 
     /** Const access to the data as a C array.
      *
@@ -104,13 +114,15 @@ class fixed_1D
      *
      * @note This function does not range-check the argument.
      */
-    const_reference operator[](size_t i) const { return m_data[i]; }
+    const_reference operator[](size_t i) const {
+        return m_store.m_data[i];
+    }
 
     /** Return access to the data as a raw pointer. */
-    pointer data() { return &m_data[0]; }
+    pointer data() { return &m_store.m_data[0]; }
 
     /** Return access to the data as a raw pointer. */
-    const_pointer data() const { return &m_data[0]; }
+    const_pointer data() const { return &m_store.m_data[0]; }
 
   protected:
 
@@ -119,7 +131,7 @@ class fixed_1D
 
   protected:
 
-    array_impl                  m_data;
+    detail::aligned_array<array_impl,Align> m_store;
 
 
   private:
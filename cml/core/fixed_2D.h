@@ -14,6 +14,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define fixed_2D_h
 
 #include <cml/core/common.h>
+#include <cml/core/fwd.h>
 #include <cml/core/fixed_1D.h>
 
 /* This is used below to create a more meaningful compile-time error when
@@ -36,6 +37,8 @@ namespace cml {
  * better optimize 2D array dereferences.  This is different from
  * dynamic_2D<>, which must use the 1D array method.
  *
+ * Align selects the alignment of the array, as for fixed<>.
+ *
  * @sa cml::fixed
  *
  * @note This class is designed to have the same size as a C array with the
@@ -57,8 +60,10 @@ namespace cml {
  * least one compiler (Intel C++ 9.0) fails to optimize them away, and they
  * aren't needed anyway here.
  */
-template<typename Element, int Rows, int Cols, typename Layout>
+template<typename Element, int Rows, int Cols, typename Layout,
+    int Align>
 class fixed_2D
+    : public aligned_new<Align>
 {
   public:
 
@@ -75,7 +80,7 @@ class fixed_2D
 
 
     /* Record the generator: */
-    typedef fixed<Rows,Cols> generator_type;
+    typedef fixed<Rows,Cols,Align> generator_type;
 
     /* Standard: */
     typedef Element value_type;
@@ -112,6 +117,9 @@ class fixed_2D
 
     enum { array_rows = Rows, array_cols = Cols };
 
+    /** The guaranteed alignment of data(), in bytes (0 if unknown). */
+    enum { array_alignment = Align };
+
 
   public:
 
@@ -151,10 +159,10 @@ class fixed_2D
     }
 
     /** Return access to the data as a raw pointer. */
-    pointer data() { return &m_data[0][0]; }
+    pointer data() { return &m_store.m_data[0][0]; }
 
     /** Return access to the data as a raw pointer. */
-    const_pointer data() const { return &m_data[0][0]; }
+    const_pointer data() const { return &m_store.m_data[0][0]; }
 
 
   public:
@@ -165,19 +173,19 @@ class fixed_2D
   protected:
 
     reference get_element(size_t row, size_t col, row_major) {
-        return m_data[row][col];
+        return m_store.m_data[row][col];
     }
 
     const_reference get_element(size_t row, size_t col, row_major) const {
-        return m_data[row][col];
+        return m_store.m_data[row][col];
     }
 
     reference get_element(size_t row, size_t col, col_major) {
-        return m_data[col][row];
+        return m_store.m_data[col][row];
     }
 
     const_reference get_element(size_t row, size_t col, col_major) const {
-        return m_data[col][row];
+        return m_store.m_data[col][row];
     }
 
 
@@ -194,7 +202,7 @@ class fixed_2D
         >::result array_data;
 
     /* Declare the data array: */
-    array_data                  m_data;
+    detail::aligned_array<array_data,Align> m_store;
 };
 
 } // namespace cml
@@ -20,10 +20,10 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 namespace cml {
 
 /* cml/core/fixed_1D.h */
-template<typename E, int S> class fixed_1D;
+template<typename E, int S, int A = 0> class fixed_1D;
 
 /* cml/core/fixed_2D.h */
-template<typename E, int R, int C, class L> class fixed_2D;
+template<typename E, int R, int C, class L, int A = 0> class fixed_2D;
 
 /* cml/core/dynamic_1D.h */
 template<typename E, class A> class dynamic_1D;
@@ -38,7 +38,7 @@ template<typename E, int S> class external_1D;
 template<typename E, int R, int C, class L> class external_2D;
 
 /* cml/fixed.h */
-template<int Dim1, int Dim2> struct fixed;
+template<int Dim1, int Dim2, int Align> struct fixed;
 
 /* cml/dynamic.h */
 template<class Alloc> struct dynamic;
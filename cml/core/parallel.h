@@ -0,0 +1,379 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Parallel evaluation of large run-time sized expressions.
+ *
+ * When CML_PARALLEL is defined (this requires C++11), assignments of
+ * dynamic-size vector and matrix expressions, dot() and length_squared()
+ * of dynamic-size vectors, mat-vec products and blocked matrix products
+ * are split across a pool of threads once they exceed the thresholds of
+ * the current cml::parallel::policy.  Smaller ones run on the calling
+ * thread as before.
+ *
+ * The pool is created on first use, with one thread less than the policy
+ * asks for, since the calling thread takes part in the work.  Each thread
+ * starts with a contiguous range of the chunks of a job, and steals half
+ * of the remaining range of another thread when its own runs out.  Only
+ * one job runs on the pool at a time: a job started from inside a chunk,
+ * or while another thread is using the pool, runs on the calling thread.
+ *
+ * By default, each thread accumulates its own partial sums for a
+ * reduction, so the rounding of the result varies with the scheduling.
+ * With policy::deterministic set, partial sums are kept per chunk and
+ * added in order; the chunks depend only on policy::grain, so the result
+ * is the same from run to run, whatever the number of threads.
+ */
+
+#ifndef cml_parallel_h
+#define cml_parallel_h
+
+#include <cml/core/common.h>
+
+#if defined(CML_PARALLEL)
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cml {
+namespace parallel {
+
+/** The settings for parallel evaluation.
+ *
+ * The defaults come from the CML_PARALLEL_* macros in cml/defaults.h.
+ */
+struct policy
+{
+    policy()
+        : enabled(true), threads(0)
+        , threshold(CML_PARALLEL_THRESHOLD)
+        , mul_threshold(CML_PARALLEL_MUL_THRESHOLD)
+        , grain(CML_PARALLEL_GRAIN)
+        , deterministic(false) {}
+
+    /** False to evaluate everything on the calling thread. */
+    bool enabled;
+
+    /** The number of threads, including the caller (0 for one per
+     * hardware thread).
+     */
+    size_t threads;
+
+    /** The fewest elements to assign or reduce in parallel. */
+    size_t threshold;
+
+    /** The fewest multiply-adds of a matrix product to compute in
+     * parallel.
+     */
+    size_t mul_threshold;
+
+    /** The number of elements in each chunk of a job. */
+    size_t grain;
+
+    /** True to add the partial sums of reductions in a fixed order. */
+    bool deterministic;
+};
+
+/** A pool of threads running one job of independent chunks at a time. */
+class thread_pool
+{
+  public:
+
+    /** Start threads-1 workers (one per hardware thread if threads is 0).
+     */
+    explicit thread_pool(size_t threads = 0)
+        : m_size(threads ? threads
+                : std::max(1u, std::thread::hardware_concurrency()))
+        , m_queues(new queue[m_size])
+        , m_fn(0), m_call(0), m_generation(0), m_active(0), m_stop(false)
+    {
+        for(size_t t = 1; t < m_size; ++t) {
+            m_workers.push_back(std::thread(&thread_pool::serve, this, t));
+        }
+    }
+
+    /** Stop and join the workers. */
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for(size_t t = 0; t < m_workers.size(); ++t) m_workers[t].join();
+    }
+
+    /** Return the number of threads, including the caller. */
+    size_t size() const { return m_size; }
+
+    /** Call f(c,t) for each chunk c in [0,n), and return when all are done.
+     *
+     * t is the index of the thread running the chunk, in [0,size()).
+     */
+    template<class F> void run(size_t n, const F& f) {
+        std::unique_lock<std::mutex> busy(m_run, std::defer_lock);
+        if(n < 2 || m_size == 1 || in_job() || !busy.try_lock()) {
+            for(size_t c = 0; c < n; ++c) f(c, 0);
+            return;
+        }
+
+        /* A worker woken for the previous job may check in only now, so
+         * wait for it, and publish the whole job before the new generation
+         * lets any worker see it:
+         */
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [this] { return m_active == 0; });
+            m_fn = &f;
+            m_call = &thread_pool::call<F>;
+            for(size_t t = 0; t < m_size; ++t) {
+                std::lock_guard<std::mutex> qlock(m_queues[t].lock);
+                m_queues[t].begin = n*t/m_size;
+                m_queues[t].end = n*(t+1)/m_size;
+            }
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        in_job() = true;
+        this->work(0);
+        in_job() = false;
+
+        /* Workers are active until they find no chunk left: */
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_active == 0; });
+    }
+
+
+  protected:
+
+    /* The chunks [begin,end) not yet taken from a thread: */
+    struct queue {
+        queue() : begin(0), end(0) {}
+        std::mutex lock;
+        size_t begin, end;
+    };
+
+    template<class F>
+        static void call(const void* f, size_t c, size_t t) {
+            (*static_cast<const F*>(f))(c, t);
+        }
+
+    /* True while the thread runs chunks of a job, on any pool: */
+    static bool& in_job() {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    /* Take the next chunk of thread t: */
+    bool take(size_t t, size_t& c) {
+        std::lock_guard<std::mutex> lock(m_queues[t].lock);
+        if(m_queues[t].begin == m_queues[t].end) return false;
+        c = m_queues[t].begin++;
+        return true;
+    }
+
+    /* Move the upper half of the chunks of thread v to thread t: */
+    bool steal(size_t t, size_t v) {
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(m_queues[v].lock);
+            size_t n = m_queues[v].end - m_queues[v].begin;
+            if(n == 0) return false;
+            end = m_queues[v].end;
+            begin = end - (n+1)/2;
+            m_queues[v].end = begin;
+        }
+        std::lock_guard<std::mutex> lock(m_queues[t].lock);
+        m_queues[t].begin = begin;
+        m_queues[t].end = end;
+        return true;
+    }
+
+    /* Run chunks as thread t until there are none left: */
+    void work(size_t t) {
+        for(;;) {
+            size_t c;
+            while(this->take(t, c)) m_call(m_fn, c, t);
+            bool stolen = false;
+            for(size_t k = 1; k < m_size && !stolen; ++k) {
+                stolen = this->steal(t, (t+k) % m_size);
+            }
+            if(!stolen) return;
+        }
+    }
+
+    /* The loop of worker t: */
+    void serve(size_t t) {
+        in_job() = true;
+        size_t seen = 0;
+        for(;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock,
+                        [&] { return m_stop || m_generation != seen; });
+                if(m_stop) return;
+                seen = m_generation;
+                ++m_active;
+            }
+            this->work(t);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(--m_active == 0) m_idle.notify_all();
+        }
+    }
+
+
+  protected:
+
+    size_t m_size;
+    std::unique_ptr<queue[]> m_queues;
+    std::vector<std::thread> m_workers;
+
+    /* The current job: */
+    const void* m_fn;
+    void (*m_call)(const void*, size_t, size_t);
+
+    std::mutex m_run;
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_idle;
+    size_t m_generation, m_active;
+    bool m_stop;
+
+
+  private:
+
+    thread_pool(const thread_pool&);
+    thread_pool& operator=(const thread_pool&);
+};
+
+namespace detail {
+
+inline policy& current_policy() {
+    static policy p;
+    return p;
+}
+
+inline std::mutex& pool_lock() {
+    static std::mutex lock;
+    return lock;
+}
+
+inline std::unique_ptr<thread_pool>& pool_instance() {
+    static std::unique_ptr<thread_pool> pool;
+    return pool;
+}
+
+} // namespace detail
+
+/** Return the current policy. */
+inline const policy& get_policy() {
+    return detail::current_policy();
+}
+
+/** Replace the current policy.
+ *
+ * A change to policy::threads restarts the pool, so this must not be
+ * called while an expression is being evaluated.
+ */
+inline void set_policy(const policy& p) {
+    std::lock_guard<std::mutex> lock(detail::pool_lock());
+    if(p.threads != detail::current_policy().threads) {
+        detail::pool_instance().reset();
+    }
+    detail::current_policy() = p;
+}
+
+/** Return the pool used to evaluate expressions. */
+inline thread_pool& default_pool() {
+    std::lock_guard<std::mutex> lock(detail::pool_lock());
+    std::unique_ptr<thread_pool>& pool = detail::pool_instance();
+    if(!pool) pool.reset(new thread_pool(get_policy().threads));
+    return *pool;
+}
+
+/** True if n elements should be assigned or reduced in parallel. */
+inline bool use_threads(size_t n) {
+    return get_policy().enabled && n >= get_policy().threshold;
+}
+
+/** True if a product of n multiply-adds should be computed in parallel. */
+inline bool use_threads_for_mul(size_t n) {
+    return get_policy().enabled && n >= get_policy().mul_threshold;
+}
+
+/** Call f(begin,end) for consecutive ranges of [0,n), in parallel.
+ *
+ * The ranges hold grain elements, except for the last one.
+ */
+template<class F> inline void
+for_each_range(size_t n, size_t grain, const F& f)
+{
+    grain = std::max(grain, size_t(1));
+    default_pool().run((n + grain-1)/grain, [&](size_t c, size_t) {
+            size_t begin = c*grain;
+            f(begin, std::min(n, begin + grain));
+        });
+}
+
+/** Reduce [0,n) in parallel, where f(begin,end) reduces a range of
+ * policy::grain elements, and combine(a,b) adds two partial results.
+ *
+ * An empty range reduces to T().
+ */
+template<typename T, class F, class CombineT> inline T
+reduce(size_t n, const F& f, const CombineT& combine)
+{
+    if(n == 0) return T();
+
+    const size_t grain = std::max(get_policy().grain, size_t(1));
+    const size_t chunks = (n + grain-1)/grain;
+    thread_pool& pool = default_pool();
+    std::vector<T> partial;
+    std::vector<char> used;
+
+    if(get_policy().deterministic) {
+        /* One partial result per chunk, added in order: */
+        partial.resize(chunks);
+        pool.run(chunks, [&](size_t c, size_t) {
+                size_t begin = c*grain;
+                partial[c] = f(begin, std::min(n, begin + grain));
+            });
+        used.assign(chunks, 1);
+    } else {
+        /* One partial result per thread: */
+        partial.resize(pool.size());
+        used.assign(pool.size(), 0);
+        pool.run(chunks, [&](size_t c, size_t t) {
+                size_t begin = c*grain;
+                T s = f(begin, std::min(n, begin + grain));
+                partial[t] = used[t] ? combine(partial[t], s) : s;
+                used[t] = 1;
+            });
+    }
+
+    size_t i = 0;
+    while(!used[i]) ++i;
+    T sum = partial[i];
+    for(++i; i < partial.size(); ++i) {
+        if(used[i]) sum = combine(sum, partial[i]);
+    }
+    return sum;
+}
+
+} // namespace parallel
+} // namespace cml
+
+#endif // CML_PARALLEL
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,706 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Thin wrappers around SIMD registers.
+ *
+ * packet_traits<T,N> describes an N-lane packet of scalar type T, along
+ * with the handful of operations the CML kernels need (load, store,
+ * broadcast, element-wise arithmetic, reciprocal square root estimates,
+ * minimum and maximum, sign masks, and loading or storing interleaved 3D
+ * points and quaternions).  inv_sqrt<PT>() computes 1/sqrt() of a packet
+ * to the precision of an inv_sqrt_exact, inv_sqrt_newton or
+ * inv_sqrt_estimate tag (see cml/core/common.h).
+ *
+ * The float and double packets map to SSE/SSE2 or AVX registers when the
+ * compiler targets them, and every other combination falls back to a plain
+ * array of N scalars, so kernels written against packet_traits compile
+ * everywhere.  packet_memory<T,N,Align> selects the aligned or unaligned
+ * loads and stores from a compile-time alignment.
+ *
+ * The instruction set is taken from the compiler's target macros (e.g.
+ * -msse2 or -mavx with GCC, /arch:AVX with MSVC).  Define CML_NO_SIMD to
+ * force the scalar fallbacks.
+ */
+
+#ifndef core_simd_h
+#define core_simd_h
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <cml/core/common.h>
+
+#if !defined(CML_NO_SIMD)
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CML_SIMD_SSE2
+#endif
+
+#if defined(CML_SIMD_SSE2) && defined(__AVX__)
+#define CML_SIMD_AVX
+#endif
+
+#if defined(CML_SIMD_AVX) && defined(__FMA__)
+#define CML_SIMD_FMA
+#endif
+
+#endif // CML_NO_SIMD
+
+#if defined(CML_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(CML_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace cml {
+namespace simd {
+
+/** Generic N-lane packet, implemented as an array of scalars. */
+template<typename T, int N> struct scalar_packet {
+    T v[N];
+};
+
+/** Return an estimate of 1/sqrt(x).
+ *
+ * With SSE this is the rsqrtss estimate (relative error below 3.7e-4);
+ * otherwise it is the bit-level estimate refined by one Newton step
+ * (relative error below 1.8e-3).
+ */
+inline float rsqrt_estimate(float x)
+{
+#if defined(CML_SIMD_SSE2)
+    return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+    uint32_t i;
+    std::memcpy(&i, &x, sizeof(i));
+    i = 0x5f375a86u - (i >> 1);
+    float y;
+    std::memcpy(&y, &i, sizeof(y));
+    return y*(1.5f - .5f*x*y*y);
+#endif
+}
+
+/** Return an estimate of 1/sqrt(x), computed in single precision. */
+template<typename T> inline T rsqrt_estimate(T x)
+{
+    return T(rsqrt_estimate(float(x)));
+}
+
+/** Packet operations for N lanes of type T.
+ *
+ * This is the portable fallback; the SIMD specializations below have the
+ * same interface.  load() and store() require the natural alignment of
+ * the packet type, while loadu() and storeu() accept any address.
+ */
+template<typename T, int N> struct packet_traits
+{
+    typedef T value_type;
+    typedef scalar_packet<T,N> packet_type;
+    enum { size = N, vectorized = false };
+
+    static packet_type load(const T* p) { return loadu(p); }
+    static packet_type loadu(const T* p) {
+        packet_type r; for(int i = 0; i < N; ++i) r.v[i] = p[i]; return r;
+    }
+    static void store(T* p, const packet_type& a) { storeu(p,a); }
+    static void storeu(T* p, const packet_type& a) {
+        for(int i = 0; i < N; ++i) p[i] = a.v[i];
+    }
+    static packet_type set1(T s) {
+        packet_type r; for(int i = 0; i < N; ++i) r.v[i] = s; return r;
+    }
+    static packet_type add(const packet_type& a, const packet_type& b) {
+        packet_type r;
+        for(int i = 0; i < N; ++i) r.v[i] = a.v[i] + b.v[i];
+        return r;
+    }
+    static packet_type sub(const packet_type& a, const packet_type& b) {
+        packet_type r;
+        for(int i = 0; i < N; ++i) r.v[i] = a.v[i] - b.v[i];
+        return r;
+    }
+    static packet_type mul(const packet_type& a, const packet_type& b) {
+        packet_type r;
+        for(int i = 0; i < N; ++i) r.v[i] = a.v[i] * b.v[i];
+        return r;
+    }
+    static packet_type div(const packet_type& a, const packet_type& b) {
+        packet_type r;
+        for(int i = 0; i < N; ++i) r.v[i] = a.v[i] / b.v[i];
+        return r;
+    }
+    static packet_type neg(const packet_type& a) {
+        packet_type r; for(int i = 0; i < N; ++i) r.v[i] = - a.v[i]; return r;
+    }
+    static packet_type sqrt(const packet_type& a) {
+        packet_type r;
+        for(int i = 0; i < N; ++i) r.v[i] = T(std::sqrt(a.v[i]));
+        return r;
+    }
+    static packet_type rsqrt(const packet_type& a) {
+        packet_type r;
+        for(int i = 0; i < N; ++i) r.v[i] = rsqrt_estimate(a.v[i]);
+        return r;
+    }
+
+    /** Return 1 or -1, with the sign bit of each lane of a. */
+    static packet_type sign(const packet_type& a) {
+        packet_type r;
+        for(int i = 0; i < N; ++i) r.v[i] = (a.v[i] < T(0)) ? T(-1) : T(1);
+        return r;
+    }
+
+    /** Return a*b + c. */
+    static packet_type madd(
+            const packet_type& a, const packet_type& b, const packet_type& c)
+    {
+        return add(mul(a,b),c);
+    }
+
+    /** Return the lane-wise minimum of a and b.
+     *
+     * As with the SSE instructions, lanes where either is NaN return b.
+     */
+    static packet_type minimum(const packet_type& a, const packet_type& b) {
+        packet_type r;
+        for(int i = 0; i < N; ++i)
+            r.v[i] = (a.v[i] < b.v[i]) ? a.v[i] : b.v[i];
+        return r;
+    }
+
+    /** Return the lane-wise maximum of a and b (b where either is NaN). */
+    static packet_type maximum(const packet_type& a, const packet_type& b) {
+        packet_type r;
+        for(int i = 0; i < N; ++i)
+            r.v[i] = (a.v[i] > b.v[i]) ? a.v[i] : b.v[i];
+        return r;
+    }
+
+    /** Return a mask with bit i set if lane i of a is less than 0. */
+    static int negative_mask(const packet_type& a) {
+        int m = 0;
+        for(int i = 0; i < N; ++i) if(a.v[i] < T(0)) m |= 1 << i;
+        return m;
+    }
+
+    /** Return the sum of the lanes. */
+    static T hsum(const packet_type& a) {
+        T s = a.v[0]; for(int i = 1; i < N; ++i) s += a.v[i]; return s;
+    }
+
+    /** Load N interleaved triples (x0,y0,z0,x1,...) into x, y and z. */
+    static void load3(const T* p,
+            packet_type& x, packet_type& y, packet_type& z)
+    {
+        for(int i = 0; i < N; ++i) {
+            x.v[i] = p[3*i]; y.v[i] = p[3*i+1]; z.v[i] = p[3*i+2];
+        }
+    }
+
+    /** Store x, y and z as N interleaved triples. */
+    static void store3(T* p,
+            const packet_type& x, const packet_type& y, const packet_type& z)
+    {
+        for(int i = 0; i < N; ++i) {
+            p[3*i] = x.v[i]; p[3*i+1] = y.v[i]; p[3*i+2] = z.v[i];
+        }
+    }
+
+    /** Load N interleaved quadruples (a0,b0,c0,d0,a1,...) into a-d. */
+    static void load4(const T* p, packet_type& a, packet_type& b,
+            packet_type& c, packet_type& d)
+    {
+        for(int i = 0; i < N; ++i) {
+            a.v[i] = p[4*i]; b.v[i] = p[4*i+1];
+            c.v[i] = p[4*i+2]; d.v[i] = p[4*i+3];
+        }
+    }
+
+    /** Store a-d as N interleaved quadruples. */
+    static void store4(T* p, const packet_type& a, const packet_type& b,
+            const packet_type& c, const packet_type& d)
+    {
+        for(int i = 0; i < N; ++i) {
+            p[4*i] = a.v[i]; p[4*i+1] = b.v[i];
+            p[4*i+2] = c.v[i]; p[4*i+3] = d.v[i];
+        }
+    }
+};
+
+#if defined(CML_SIMD_SSE2)
+
+/** 4 floats in an SSE register. */
+template<> struct packet_traits<float,4>
+{
+    typedef float value_type;
+    typedef __m128 packet_type;
+    enum { size = 4, vectorized = true };
+
+    static packet_type load(const float* p) { return _mm_load_ps(p); }
+    static packet_type loadu(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, packet_type a) { _mm_store_ps(p,a); }
+    static void storeu(float* p, packet_type a) { _mm_storeu_ps(p,a); }
+    static packet_type set1(float s) { return _mm_set1_ps(s); }
+    static packet_type add(packet_type a, packet_type b) {
+        return _mm_add_ps(a,b); }
+    static packet_type sub(packet_type a, packet_type b) {
+        return _mm_sub_ps(a,b); }
+    static packet_type mul(packet_type a, packet_type b) {
+        return _mm_mul_ps(a,b); }
+    static packet_type div(packet_type a, packet_type b) {
+        return _mm_div_ps(a,b); }
+    static packet_type neg(packet_type a) {
+        return _mm_xor_ps(a, _mm_set1_ps(-0.f)); }
+    static packet_type sqrt(packet_type a) { return _mm_sqrt_ps(a); }
+    static packet_type rsqrt(packet_type a) { return _mm_rsqrt_ps(a); }
+    static packet_type sign(packet_type a) {
+        return _mm_or_ps(_mm_and_ps(a, _mm_set1_ps(-0.f)), _mm_set1_ps(1.f));
+    }
+    static packet_type madd(packet_type a, packet_type b, packet_type c) {
+#if defined(CML_SIMD_FMA)
+        return _mm_fmadd_ps(a,b,c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a,b),c);
+#endif
+    }
+    static packet_type minimum(packet_type a, packet_type b) {
+        return _mm_min_ps(a,b); }
+    static packet_type maximum(packet_type a, packet_type b) {
+        return _mm_max_ps(a,b); }
+    static int negative_mask(packet_type a) {
+        return _mm_movemask_ps(_mm_cmplt_ps(a, _mm_setzero_ps()));
+    }
+    static float hsum(packet_type a) {
+        __m128 s = _mm_add_ps(a, _mm_movehl_ps(a,a));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s,s,1));
+        return _mm_cvtss_f32(s);
+    }
+    static void load3(const float* p,
+            packet_type& x, packet_type& y, packet_type& z)
+    {
+        __m128 a = _mm_loadu_ps(p);         // x0 y0 z0 x1
+        __m128 b = _mm_loadu_ps(p+4);       // y1 z1 x2 y2
+        __m128 c = _mm_loadu_ps(p+8);       // z2 x3 y3 z3
+        __m128 t = _mm_shuffle_ps(b,c,_MM_SHUFFLE(1,0,3,2));
+        x = _mm_shuffle_ps(a,t,_MM_SHUFFLE(3,0,3,0));
+        y = _mm_shuffle_ps(
+                _mm_shuffle_ps(a,b,_MM_SHUFFLE(0,0,1,1)),
+                _mm_shuffle_ps(b,c,_MM_SHUFFLE(2,2,3,3)),
+                _MM_SHUFFLE(2,0,2,0));
+        z = _mm_shuffle_ps(
+                _mm_shuffle_ps(a,b,_MM_SHUFFLE(1,1,2,2)),
+                _mm_shuffle_ps(c,c,_MM_SHUFFLE(3,3,0,0)),
+                _MM_SHUFFLE(2,0,2,0));
+    }
+    static void store3(float* p, packet_type x, packet_type y, packet_type z)
+    {
+        __m128 lo = _mm_unpacklo_ps(x,y);   // x0 y0 x1 y1
+        __m128 hi = _mm_unpackhi_ps(x,y);   // x2 y2 x3 y3
+        _mm_storeu_ps(p, _mm_shuffle_ps(lo,
+                    _mm_shuffle_ps(z,x,_MM_SHUFFLE(1,1,0,0)),
+                    _MM_SHUFFLE(2,0,1,0)));
+        _mm_storeu_ps(p+4, _mm_shuffle_ps(
+                    _mm_shuffle_ps(y,z,_MM_SHUFFLE(1,1,1,1)), hi,
+                    _MM_SHUFFLE(1,0,2,0)));
+        _mm_storeu_ps(p+8, _mm_shuffle_ps(
+                    _mm_shuffle_ps(z,x,_MM_SHUFFLE(3,3,2,2)),
+                    _mm_shuffle_ps(y,z,_MM_SHUFFLE(3,3,3,3)),
+                    _MM_SHUFFLE(2,0,2,0)));
+    }
+    static void load4(const float* p, packet_type& a, packet_type& b,
+            packet_type& c, packet_type& d)
+    {
+        a = _mm_loadu_ps(p); b = _mm_loadu_ps(p+4);
+        c = _mm_loadu_ps(p+8); d = _mm_loadu_ps(p+12);
+        _MM_TRANSPOSE4_PS(a,b,c,d);
+    }
+    static void store4(float* p, packet_type a, packet_type b,
+            packet_type c, packet_type d)
+    {
+        _MM_TRANSPOSE4_PS(a,b,c,d);
+        _mm_storeu_ps(p,a); _mm_storeu_ps(p+4,b);
+        _mm_storeu_ps(p+8,c); _mm_storeu_ps(p+12,d);
+    }
+};
+
+/** 2 doubles in an SSE2 register. */
+template<> struct packet_traits<double,2>
+{
+    typedef double value_type;
+    typedef __m128d packet_type;
+    enum { size = 2, vectorized = true };
+
+    static packet_type load(const double* p) { return _mm_load_pd(p); }
+    static packet_type loadu(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, packet_type a) { _mm_store_pd(p,a); }
+    static void storeu(double* p, packet_type a) { _mm_storeu_pd(p,a); }
+    static packet_type set1(double s) { return _mm_set1_pd(s); }
+    static packet_type add(packet_type a, packet_type b) {
+        return _mm_add_pd(a,b); }
+    static packet_type sub(packet_type a, packet_type b) {
+        return _mm_sub_pd(a,b); }
+    static packet_type mul(packet_type a, packet_type b) {
+        return _mm_mul_pd(a,b); }
+    static packet_type div(packet_type a, packet_type b) {
+        return _mm_div_pd(a,b); }
+    static packet_type neg(packet_type a) {
+        return _mm_xor_pd(a, _mm_set1_pd(-0.)); }
+    static packet_type sqrt(packet_type a) { return _mm_sqrt_pd(a); }
+    static packet_type rsqrt(packet_type a) {
+        return _mm_cvtps_pd(_mm_rsqrt_ps(_mm_cvtpd_ps(a))); }
+    static packet_type sign(packet_type a) {
+        return _mm_or_pd(_mm_and_pd(a, _mm_set1_pd(-0.)), _mm_set1_pd(1.));
+    }
+    static packet_type madd(packet_type a, packet_type b, packet_type c) {
+#if defined(CML_SIMD_FMA)
+        return _mm_fmadd_pd(a,b,c);
+#else
+        return _mm_add_pd(_mm_mul_pd(a,b),c);
+#endif
+    }
+    static packet_type minimum(packet_type a, packet_type b) {
+        return _mm_min_pd(a,b); }
+    static packet_type maximum(packet_type a, packet_type b) {
+        return _mm_max_pd(a,b); }
+    static int negative_mask(packet_type a) {
+        return _mm_movemask_pd(_mm_cmplt_pd(a, _mm_setzero_pd()));
+    }
+    static double hsum(packet_type a) {
+        return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a,a)));
+    }
+    static void load3(const double* p,
+            packet_type& x, packet_type& y, packet_type& z)
+    {
+        __m128d a = _mm_loadu_pd(p);        // x0 y0
+        __m128d b = _mm_loadu_pd(p+2);      // z0 x1
+        __m128d c = _mm_loadu_pd(p+4);      // y1 z1
+        x = _mm_shuffle_pd(a,b,2);
+        y = _mm_shuffle_pd(a,c,1);
+        z = _mm_shuffle_pd(b,c,2);
+    }
+    static void store3(double* p, packet_type x, packet_type y, packet_type z)
+    {
+        _mm_storeu_pd(p, _mm_unpacklo_pd(x,y));
+        _mm_storeu_pd(p+2, _mm_shuffle_pd(z,x,2));
+        _mm_storeu_pd(p+4, _mm_unpackhi_pd(y,z));
+    }
+    static void load4(const double* p, packet_type& a, packet_type& b,
+            packet_type& c, packet_type& d)
+    {
+        __m128d r0 = _mm_loadu_pd(p), r1 = _mm_loadu_pd(p+2);
+        __m128d r2 = _mm_loadu_pd(p+4), r3 = _mm_loadu_pd(p+6);
+        a = _mm_unpacklo_pd(r0,r2); b = _mm_unpackhi_pd(r0,r2);
+        c = _mm_unpacklo_pd(r1,r3); d = _mm_unpackhi_pd(r1,r3);
+    }
+    static void store4(double* p, packet_type a, packet_type b,
+            packet_type c, packet_type d)
+    {
+        _mm_storeu_pd(p, _mm_unpacklo_pd(a,b));
+        _mm_storeu_pd(p+2, _mm_unpacklo_pd(c,d));
+        _mm_storeu_pd(p+4, _mm_unpackhi_pd(a,b));
+        _mm_storeu_pd(p+6, _mm_unpackhi_pd(c,d));
+    }
+};
+
+#endif // CML_SIMD_SSE2
+
+#if defined(CML_SIMD_AVX)
+
+/** 8 floats in an AVX register. */
+template<> struct packet_traits<float,8>
+{
+    typedef float value_type;
+    typedef __m256 packet_type;
+    enum { size = 8, vectorized = true };
+
+    static packet_type load(const float* p) { return _mm256_load_ps(p); }
+    static packet_type loadu(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, packet_type a) { _mm256_store_ps(p,a); }
+    static void storeu(float* p, packet_type a) { _mm256_storeu_ps(p,a); }
+    static packet_type set1(float s) { return _mm256_set1_ps(s); }
+    static packet_type add(packet_type a, packet_type b) {
+        return _mm256_add_ps(a,b); }
+    static packet_type sub(packet_type a, packet_type b) {
+        return _mm256_sub_ps(a,b); }
+    static packet_type mul(packet_type a, packet_type b) {
+        return _mm256_mul_ps(a,b); }
+    static packet_type div(packet_type a, packet_type b) {
+        return _mm256_div_ps(a,b); }
+    static packet_type neg(packet_type a) {
+        return _mm256_xor_ps(a, _mm256_set1_ps(-0.f)); }
+    static packet_type sqrt(packet_type a) { return _mm256_sqrt_ps(a); }
+    static packet_type rsqrt(packet_type a) { return _mm256_rsqrt_ps(a); }
+    static packet_type sign(packet_type a) {
+        return _mm256_or_ps(_mm256_and_ps(a, _mm256_set1_ps(-0.f)),
+                _mm256_set1_ps(1.f));
+    }
+    static packet_type madd(packet_type a, packet_type b, packet_type c) {
+#if defined(CML_SIMD_FMA)
+        return _mm256_fmadd_ps(a,b,c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a,b),c);
+#endif
+    }
+    static packet_type minimum(packet_type a, packet_type b) {
+        return _mm256_min_ps(a,b); }
+    static packet_type maximum(packet_type a, packet_type b) {
+        return _mm256_max_ps(a,b); }
+    static int negative_mask(packet_type a) {
+        return _mm256_movemask_ps(
+                _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LT_OQ));
+    }
+    static float hsum(packet_type a) {
+        return packet_traits<float,4>::hsum(_mm_add_ps(
+                    _mm256_castps256_ps128(a), _mm256_extractf128_ps(a,1)));
+    }
+    static void load3(const float* p,
+            packet_type& x, packet_type& y, packet_type& z)
+    {
+        typedef packet_traits<float,4> half;
+        __m128 x0, y0, z0, x1, y1, z1;
+        half::load3(p, x0, y0, z0);
+        half::load3(p+12, x1, y1, z1);
+        x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+        y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+        z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+    }
+    static void store3(float* p, packet_type x, packet_type y, packet_type z)
+    {
+        typedef packet_traits<float,4> half;
+        half::store3(p, _mm256_castps256_ps128(x),
+                _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+        half::store3(p+12, _mm256_extractf128_ps(x,1),
+                _mm256_extractf128_ps(y,1), _mm256_extractf128_ps(z,1));
+    }
+    static void load4(const float* p, packet_type& a, packet_type& b,
+            packet_type& c, packet_type& d)
+    {
+        typedef packet_traits<float,4> half;
+        __m128 a0, b0, c0, d0, a1, b1, c1, d1;
+        half::load4(p, a0, b0, c0, d0);
+        half::load4(p+16, a1, b1, c1, d1);
+        a = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a1, 1);
+        b = _mm256_insertf128_ps(_mm256_castps128_ps256(b0), b1, 1);
+        c = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c1, 1);
+        d = _mm256_insertf128_ps(_mm256_castps128_ps256(d0), d1, 1);
+    }
+    static void store4(float* p, packet_type a, packet_type b,
+            packet_type c, packet_type d)
+    {
+        typedef packet_traits<float,4> half;
+        half::store4(p, _mm256_castps256_ps128(a), _mm256_castps256_ps128(b),
+                _mm256_castps256_ps128(c), _mm256_castps256_ps128(d));
+        half::store4(p+16, _mm256_extractf128_ps(a,1),
+                _mm256_extractf128_ps(b,1), _mm256_extractf128_ps(c,1),
+                _mm256_extractf128_ps(d,1));
+    }
+};
+
+/** 4 doubles in an AVX register. */
+template<> struct packet_traits<double,4>
+{
+    typedef double value_type;
+    typedef __m256d packet_type;
+    enum { size = 4, vectorized = true };
+
+    static packet_type load(const double* p) { return _mm256_load_pd(p); }
+    static packet_type loadu(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, packet_type a) { _mm256_store_pd(p,a); }
+    static void storeu(double* p, packet_type a) { _mm256_storeu_pd(p,a); }
+    static packet_type set1(double s) { return _mm256_set1_pd(s); }
+    static packet_type add(packet_type a, packet_type b) {
+        return _mm256_add_pd(a,b); }
+    static packet_type sub(packet_type a, packet_type b) {
+        return _mm256_sub_pd(a,b); }
+    static packet_type mul(packet_type a, packet_type b) {
+        return _mm256_mul_pd(a,b); }
+    static packet_type div(packet_type a, packet_type b) {
+        return _mm256_div_pd(a,b); }
+    static packet_type neg(packet_type a) {
+        return _mm256_xor_pd(a, _mm256_set1_pd(-0.)); }
+    static packet_type sqrt(packet_type a) { return _mm256_sqrt_pd(a); }
+    static packet_type rsqrt(packet_type a) {
+        return _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(a))); }
+    static packet_type sign(packet_type a) {
+        return _mm256_or_pd(_mm256_and_pd(a, _mm256_set1_pd(-0.)),
+                _mm256_set1_pd(1.));
+    }
+    static packet_type madd(packet_type a, packet_type b, packet_type c) {
+#if defined(CML_SIMD_FMA)
+        return _mm256_fmadd_pd(a,b,c);
+#else
+        return _mm256_add_pd(_mm256_mul_pd(a,b),c);
+#endif
+    }
+    static packet_type minimum(packet_type a, packet_type b) {
+        return _mm256_min_pd(a,b); }
+    static packet_type maximum(packet_type a, packet_type b) {
+        return _mm256_max_pd(a,b); }
+    static int negative_mask(packet_type a) {
+        return _mm256_movemask_pd(
+                _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_LT_OQ));
+    }
+    static double hsum(packet_type a) {
+        return packet_traits<double,2>::hsum(_mm_add_pd(
+                    _mm256_castpd256_pd128(a), _mm256_extractf128_pd(a,1)));
+    }
+    static void load3(const double* p,
+            packet_type& x, packet_type& y, packet_type& z)
+    {
+        typedef packet_traits<double,2> half;
+        __m128d x0, y0, z0, x1, y1, z1;
+        half::load3(p, x0, y0, z0);
+        half::load3(p+6, x1, y1, z1);
+        x = _mm256_insertf128_pd(_mm256_castpd128_pd256(x0), x1, 1);
+        y = _mm256_insertf128_pd(_mm256_castpd128_pd256(y0), y1, 1);
+        z = _mm256_insertf128_pd(_mm256_castpd128_pd256(z0), z1, 1);
+    }
+    static void store3(double* p, packet_type x, packet_type y, packet_type z)
+    {
+        typedef packet_traits<double,2> half;
+        half::store3(p, _mm256_castpd256_pd128(x),
+                _mm256_castpd256_pd128(y), _mm256_castpd256_pd128(z));
+        half::store3(p+6, _mm256_extractf128_pd(x,1),
+                _mm256_extractf128_pd(y,1), _mm256_extractf128_pd(z,1));
+    }
+    static void load4(const double* p, packet_type& a, packet_type& b,
+            packet_type& c, packet_type& d)
+    {
+        __m256d r0 = _mm256_loadu_pd(p), r1 = _mm256_loadu_pd(p+4);
+        __m256d r2 = _mm256_loadu_pd(p+8), r3 = _mm256_loadu_pd(p+12);
+        __m256d t0 = _mm256_unpacklo_pd(r0,r1);  // a0 a1 c0 c1
+        __m256d t1 = _mm256_unpackhi_pd(r0,r1);  // b0 b1 d0 d1
+        __m256d t2 = _mm256_unpacklo_pd(r2,r3);  // a2 a3 c2 c3
+        __m256d t3 = _mm256_unpackhi_pd(r2,r3);  // b2 b3 d2 d3
+        a = _mm256_permute2f128_pd(t0,t2,0x20);
+        b = _mm256_permute2f128_pd(t1,t3,0x20);
+        c = _mm256_permute2f128_pd(t0,t2,0x31);
+        d = _mm256_permute2f128_pd(t1,t3,0x31);
+    }
+    static void store4(double* p, packet_type a, packet_type b,
+            packet_type c, packet_type d)
+    {
+        __m256d t0 = _mm256_permute2f128_pd(a,c,0x20);  // a0 a1 c0 c1
+        __m256d t1 = _mm256_permute2f128_pd(b,d,0x20);  // b0 b1 d0 d1
+        __m256d t2 = _mm256_permute2f128_pd(a,c,0x31);  // a2 a3 c2 c3
+        __m256d t3 = _mm256_permute2f128_pd(b,d,0x31);  // b2 b3 d2 d3
+        _mm256_storeu_pd(p, _mm256_unpacklo_pd(t0,t1));
+        _mm256_storeu_pd(p+4, _mm256_unpackhi_pd(t0,t1));
+        _mm256_storeu_pd(p+8, _mm256_unpacklo_pd(t2,t3));
+        _mm256_storeu_pd(p+12, _mm256_unpackhi_pd(t2,t3));
+    }
+};
+
+#endif // CML_SIMD_AVX
+
+/** The widest native packet width for T (1 if T is not vectorized). */
+template<typename T> struct native_width { enum { value = 1 }; };
+
+#if defined(CML_SIMD_AVX)
+template<> struct native_width<float> { enum { value = 8 }; };
+template<> struct native_width<double> { enum { value = 4 }; };
+#elif defined(CML_SIMD_SSE2)
+template<> struct native_width<float> { enum { value = 4 }; };
+template<> struct native_width<double> { enum { value = 2 }; };
+#endif
+
+/** The native packet width for T, limited to at most Max lanes. */
+template<typename T, int Max> struct native_width_max {
+    enum { value = (int(native_width<T>::value) < Max)
+        ? int(native_width<T>::value) : Max };
+};
+
+/** Return 1/sqrt(a), computed exactly. */
+template<class PT> inline typename PT::packet_type
+inv_sqrt(const typename PT::packet_type& a, inv_sqrt_exact)
+{
+    return PT::div(PT::set1(typename PT::value_type(1)), PT::sqrt(a));
+}
+
+/** Return 1/sqrt(a), from the estimate refined by one Newton step. */
+template<class PT> inline typename PT::packet_type
+inv_sqrt(const typename PT::packet_type& a, inv_sqrt_newton)
+{
+    typedef typename PT::value_type T;
+    typename PT::packet_type y = PT::rsqrt(a);
+    return PT::mul(y, PT::sub(PT::set1(T(1.5)),
+                PT::mul(PT::mul(PT::set1(T(.5)), a), PT::mul(y,y))));
+}
+
+/** Return the estimate of 1/sqrt(a). */
+template<class PT> inline typename PT::packet_type
+inv_sqrt(const typename PT::packet_type& a, inv_sqrt_estimate)
+{
+    return PT::rsqrt(a);
+}
+
+/** Return 1/sqrt(a) to the default precision. */
+template<class PT> inline typename PT::packet_type
+inv_sqrt(const typename PT::packet_type& a)
+{
+    return inv_sqrt<PT>(a, default_inv_sqrt_precision());
+}
+
+/** Compute a/sqrt(s) by multiplying by inv_sqrt<PT>(s). */
+template<class PT, class Precision> struct div_sqrt_op {
+    typedef typename PT::packet_type packet_type;
+    static packet_type apply(const packet_type& a, const packet_type& s) {
+        return PT::mul(a, inv_sqrt<PT>(s, Precision()));
+    }
+};
+
+/** Compute a/sqrt(s) exactly, by dividing by the square root. */
+template<class PT> struct div_sqrt_op<PT,inv_sqrt_exact> {
+    typedef typename PT::packet_type packet_type;
+    static packet_type apply(const packet_type& a, const packet_type& s) {
+        return PT::div(a, PT::sqrt(s));
+    }
+};
+
+/** Return a/sqrt(s) to the default precision, as normalize() does. */
+template<class PT> inline typename PT::packet_type
+div_sqrt(const typename PT::packet_type& a,
+        const typename PT::packet_type& s)
+{
+    return div_sqrt_op<PT,default_inv_sqrt_precision>::apply(a, s);
+}
+
+/** Unaligned packet loads and stores (default). */
+template<typename T, int N, bool Aligned> struct packet_access {
+    typedef packet_traits<T,N> pt;
+    typedef typename pt::packet_type packet_type;
+    static packet_type load(const T* p) { return pt::loadu(p); }
+    static void store(T* p, const packet_type& a) { pt::storeu(p,a); }
+};
+
+/** Aligned packet loads and stores. */
+template<typename T, int N> struct packet_access<T,N,true> {
+    typedef packet_traits<T,N> pt;
+    typedef typename pt::packet_type packet_type;
+    static packet_type load(const T* p) { return pt::load(p); }
+    static void store(T* p, const packet_type& a) { pt::store(p,a); }
+};
+
+/** Packet loads and stores at addresses with a known alignment.
+ *
+ * Align is the alignment in bytes guaranteed for every address passed to
+ * load() and store() (0 if unknown).  The aligned instructions are used
+ * when it is at least the size of a packet.
+ */
+template<typename T, int N, int Align> struct packet_memory
+: packet_access<T, N, (Align >= int(N*sizeof(T)))> {};
+
+} // namespace simd
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
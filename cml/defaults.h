@@ -29,6 +29,14 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 
 #endif
 
+/* The settings chosen for this host by "make tune" (see tests/bench), which
+ * take precedence over the defaults below.  UseCML.cmake defines
+ * CML_TUNED_CONFIG when the installed CML has them:
+ */
+#if defined(CML_TUNED_CONFIG)
+#include <cml_tuned_config.h>
+#endif
+
 /* The default vector unroll limit: */
 #if !defined(CML_VECTOR_UNROLL_LIMIT)
 #define CML_VECTOR_UNROLL_LIMIT 8
@@ -44,6 +52,50 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define CML_VECTOR_DOT_UNROLL_LIMIT CML_VECTOR_UNROLL_LIMIT
 #endif
 
+/* Run-time sized matrix products use the cache-blocked kernel when every
+ * dimension is at least this large:
+ */
+#if !defined(CML_MATRIX_BLOCKED_MUL_THRESHOLD)
+#define CML_MATRIX_BLOCKED_MUL_THRESHOLD 32
+#endif
+
+/* The longest chain of matrices multiplied by cml::matrix_chain<>: */
+#if !defined(CML_MUL_CHAIN_MAX_LENGTH)
+#define CML_MUL_CHAIN_MAX_LENGTH 16
+#endif
+
+/* Define CML_PARALLEL to evaluate large run-time sized expressions on a
+ * pool of threads (see cml/core/parallel.h).  This needs C++11:
+ */
+#if defined(CML_PARALLEL)
+#if !(__cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900))
+#error "CML_PARALLEL requires C++11."
+#endif
+#endif
+
+/* The default thresholds and chunk size of parallel evaluation, in
+ * elements, except for products, in multiply-adds:
+ */
+#if !defined(CML_PARALLEL_THRESHOLD)
+#define CML_PARALLEL_THRESHOLD 65536
+#endif
+
+#if !defined(CML_PARALLEL_MUL_THRESHOLD)
+#define CML_PARALLEL_MUL_THRESHOLD 2097152
+#endif
+
+#if !defined(CML_PARALLEL_GRAIN)
+#define CML_PARALLEL_GRAIN 16384
+#endif
+
+/* The precision of the inverse square roots used by normalize(), one of
+ * cml::inv_sqrt_exact, cml::inv_sqrt_newton or cml::inv_sqrt_estimate (see
+ * cml/core/common.h):
+ */
+#if !defined(CML_DEFAULT_INV_SQRT_PRECISION)
+#define CML_DEFAULT_INV_SQRT_PRECISION cml::inv_sqrt_exact
+#endif
+
 /* The default array layout is the C/C++ row-major array layout: */
 #if !defined(CML_DEFAULT_ARRAY_LAYOUT)
 #define CML_DEFAULT_ARRAY_LAYOUT cml::row_major
@@ -83,6 +135,23 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define CML_CHECK_MATRIX_EXPR_SIZES
 #endif
 
+/* Dynamic arrays, vectors and matrices get move constructors and move
+ * assignment when the compiler supports rvalue references.  Define
+ * CML_NO_RVALUE_REFERENCES to disable them:
+ */
+#if !defined(CML_HAS_RVALUE_REFERENCES) && !defined(CML_NO_RVALUE_REFERENCES)
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define CML_HAS_RVALUE_REFERENCES
+#endif
+#endif
+
+/* Moves and swaps of dynamic arrays never throw: */
+#if defined(CML_HAS_RVALUE_REFERENCES)
+#define CML_NOEXCEPT noexcept
+#else
+#define CML_NOEXCEPT throw()
+#endif
+
 #if defined(CML_NO_THROW)
 #include <cassert>
 # ifdef NDEBUG
@@ -0,0 +1,59 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief The dual_quaternion<> class for rigid transforms.
+ */
+
+#ifndef cml_dual_quaternion_h
+#define cml_dual_quaternion_h
+
+#include <cml/core/common.h>
+#include <cml/quaternion.h>
+
+namespace cml {
+
+/** A unit dual quaternion representing a rigid transform.
+ *
+ * A dual quaternion is a pair of fixed-size quaternions, the real part r
+ * and the dual part d, stored contiguously as 8 coefficients.  The rigid
+ * transform rotating by the unit quaternion r and then translating by t
+ * has d = t*r/2 (as Hamilton products), so a bone transform takes 8
+ * scalars instead of the 12 of an affine matrix.  Order and Cross have the
+ * same meaning as for quaternion<>.
+ *
+ * Conversions to and from matrices, point transforms and dual quaternion
+ * linear blending (DLB) are in cml/mathlib/dual_quaternion_transform.h.
+ */
+template<typename Element, class Order = scalar_first,
+    class Cross = positive_cross> class dual_quaternion;
+
+} // namespace cml
+
+#include <cml/quaternion/dual_quaternion.h>
+
+namespace cml {
+
+/* Dual quaternions with the orders of the quaternion typedefs: */
+typedef dual_quaternion<float, vector_first,negative_cross>
+    dual_quaternionf_n;
+typedef dual_quaternion<float, vector_first,positive_cross>
+    dual_quaternionf_p;
+typedef dual_quaternion<double,vector_first,negative_cross>
+    dual_quaterniond_n;
+typedef dual_quaternion<double,vector_first,positive_cross>
+    dual_quaterniond_p;
+typedef dual_quaternion<float> dual_quaternionf;
+typedef dual_quaternion<double> dual_quaterniond;
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -19,6 +19,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define array_promotions_h
 
 #include <cml/core/cml_meta.h>
+#include <cml/dynamic.h>
 #include <cml/et/scalar_promotions.h>
 
 namespace cml {
@@ -28,6 +29,27 @@ namespace et {
 
 namespace detail {
 
+/* The allocator selector of a dynamic<> generator, or the default: */
+template<class GeneratorT> struct dynamic_allocator {
+    typedef CML_DEFAULT_ARRAY_ALLOC type;
+};
+
+template<class Alloc> struct dynamic_allocator< dynamic<Alloc> > {
+    typedef Alloc type;
+};
+
+/* Dynamic results use the allocator of a dynamic argument (the left one
+ * if both are dynamic), so that temporaries have the same type as their
+ * arguments and can be moved into them:
+ */
+template<class A1, class A2> struct promote_allocator {
+    typedef typename select_if<
+        same_type<typename A1::memory_tag, dynamic_memory_tag>::is_true,
+        typename dynamic_allocator<typename A1::generator_type>::type,
+        typename dynamic_allocator<typename A2::generator_type>::type
+        >::result type;
+};
+
 /* This is specialized for 1D and 2D promotions: */
 template<class A1, class A2, typename DTag1, typename DTag2,
     typename PromotedSizeTag> struct promote;
@@ -61,9 +83,8 @@ struct promote<A1,A2,oned_tag,oned_tag,dynamic_size_tag>
     typedef typename ScalarPromote<
         left_scalar,right_scalar>::type promoted_scalar;
 
-    /* Next, rebind to get the proper allocator: */
-    typedef typename CML_DEFAULT_ARRAY_ALLOC
-        ::rebind<promoted_scalar>::other allocator;
+    /* Next, take the allocator from a dynamic argument: */
+    typedef typename promote_allocator<A1,A2>::type allocator;
 
     /* Finally, generate the promoted array type: */
     typedef dynamic_1D<promoted_scalar,allocator> type;
@@ -116,9 +137,8 @@ struct promote<A1,A2,twod_tag,oned_tag,dynamic_size_tag>
     typedef typename ScalarPromote<
         left_scalar,right_scalar>::type promoted_scalar;
 
-    /* Next, rebind to get the proper allocator: */
-    typedef typename CML_DEFAULT_ARRAY_ALLOC
-        ::rebind<promoted_scalar>::other allocator;
+    /* Next, take the allocator from a dynamic argument: */
+    typedef typename promote_allocator<A1,A2>::type allocator;
 
     /* Finally, generate the promoted array type: */
     typedef dynamic_1D<promoted_scalar,allocator> type;
@@ -135,9 +155,8 @@ struct promote<A1,A2,oned_tag,twod_tag,dynamic_size_tag>
     typedef typename ScalarPromote<
         left_scalar,right_scalar>::type promoted_scalar;
 
-    /* Next, rebind to get the proper allocator: */
-    typedef typename CML_DEFAULT_ARRAY_ALLOC
-        ::rebind<promoted_scalar>::other allocator;
+    /* Next, take the allocator from a dynamic argument: */
+    typedef typename promote_allocator<A1,A2>::type allocator;
 
     /* Finally, generate the promoted array type: */
     typedef dynamic_1D<promoted_scalar,allocator> type;
@@ -196,9 +215,8 @@ struct promote<A1,A2,twod_tag,twod_tag,dynamic_size_tag>
     typedef typename ScalarPromote<
         left_scalar,right_scalar>::type promoted_scalar;
 
-    /* Next, rebind to get the proper allocator: */
-    typedef typename CML_DEFAULT_ARRAY_ALLOC
-        ::rebind<promoted_scalar>::other allocator;
+    /* Next, take the allocator from a dynamic argument: */
+    typedef typename promote_allocator<A1,A2>::type allocator;
 
     /* Then deduce the array layout: */
     typedef typename A1::layout left_layout;
@@ -0,0 +1,337 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Helpers to assign mat-mat and mat-vec product expressions.
+ *
+ * A product assigned to a matrix or vector is evaluated straight into the
+ * destination, possibly together with one element-wise operand (as in
+ * C = A*B + D, or y = 2*(A*x)).  The operand is carried by ProductCombine<>
+ * (or ProductTerm when there is none), which applies it to each element of
+ * the product as it is computed.
+ *
+ * A product cannot be written into a destination that shares storage with
+ * one of its operands, so the evaluators check the arrays for overlap and
+ * compute into a temporary when they do.
+ */
+
+#ifndef product_assign_h
+#define product_assign_h
+
+#include <functional>
+#include <cml/et/traits.h>
+#include <cml/et/scalar_ops.h>
+#include <cml/vector/vector_expr.h>
+#include <cml/vector/vector_unroller.h>
+#include <cml/matrix/matrix_expr.h>
+#include <cml/matrix/matrix_unroller.h>
+
+namespace cml {
+namespace et {
+namespace detail {
+
+/** True if the arrays [a,a+n) and [b,b+m) have any element in common. */
+template<typename T1, typename T2> inline bool
+ArraysOverlap(const T1* a, size_t n, const T2* b, size_t m)
+{
+    const char* a0 = (const char*) a;
+    const char* b0 = (const char*) b;
+    std::less<const char*> less;
+    return less(a0, (const char*) (b + m))
+        && less(b0, (const char*) (a + n));
+}
+
+/** Return the number of elements stored by a matrix. */
+template<typename E, class AT, typename BO, typename L> inline size_t
+ArrayExtent(const cml::matrix<E,AT,BO,L>& m)
+{
+    return m.rows()*m.cols();
+}
+
+/** Return the number of elements stored by a vector. */
+template<typename E, class AT> inline size_t
+ArrayExtent(const cml::vector<E,AT>& v)
+{
+    return v.size();
+}
+
+/** True if dest shares storage with the operand of a product.
+ *
+ * Operands that are expressions are evaluated into temporaries before
+ * dest is written, so only matrix and vector operands can alias.
+ */
+template<class DestT, class ExprT> inline bool
+OperandAliases(const DestT&, const ExprT&)
+{
+    return false;
+}
+
+template<class DestT, typename E, class AT, typename BO, typename L>
+inline bool
+OperandAliases(const DestT& dest, const cml::matrix<E,AT,BO,L>& m)
+{
+    return ArraysOverlap(dest.data(), ArrayExtent(dest),
+            m.data(), ArrayExtent(m));
+}
+
+template<class DestT, typename E, class AT> inline bool
+OperandAliases(const DestT& dest, const cml::vector<E,AT>& v)
+{
+    return ArraysOverlap(dest.data(), ArrayExtent(dest),
+            v.data(), ArrayExtent(v));
+}
+
+/** True if the element-wise operand may read from dest.
+ *
+ * This is conservative: only scalars, and matrices and vectors stored
+ * elsewhere, are known not to.
+ */
+template<class DestT, class ExprT, class TagT> inline bool
+SummandAliases(const DestT&, const ExprT&, TagT)
+{
+    return true;
+}
+
+template<class DestT, class ExprT> inline bool
+SummandAliases(const DestT&, const ExprT&, scalar_result_tag)
+{
+    return false;
+}
+
+template<class DestT, typename E, class AT, typename BO, typename L,
+    class TagT>
+inline bool
+SummandAliases(const DestT& dest, const cml::matrix<E,AT,BO,L>& m, TagT)
+{
+    return OperandAliases(dest, m);
+}
+
+template<class DestT, typename E, class AT, class TagT> inline bool
+SummandAliases(const DestT& dest, const cml::vector<E,AT>& v, TagT)
+{
+    return OperandAliases(dest, v);
+}
+
+/** Select whether the product can be written directly into dest. */
+template<class OpT> struct IsAssignOp {
+    enum { is_true = false };
+};
+
+template<typename T1, typename T2> struct IsAssignOp< OpAssign<T1,T2> > {
+    enum { is_true = true };
+};
+
+/** A product assigned on its own. */
+struct ProductTerm
+{
+    /** Return element i,j of the assigned matrix from the product's. */
+    template<typename T> T operator()(T p, size_t, size_t) const {
+        return p;
+    }
+
+    /** Return element i of the assigned vector from the product's. */
+    template<typename T> T operator()(T p, size_t) const { return p; }
+
+    /** Nothing else is read while the product is written. */
+    template<class DestT> bool aliases(const DestT&) const { return false; }
+
+    /** Any matrix size fits. */
+    bool fits(size_t, size_t) const { return true; }
+
+    /** Any vector size fits. */
+    bool fits(size_t) const { return true; }
+
+    /** Nothing to apply after the product was written to dest. */
+    template<class DestT> void apply(DestT&) const {}
+
+    /** Assign the finished product P to dest using OpT. */
+    template<class OpT, class DestT, class ProductT>
+        void assign(DestT& dest, const ProductT& P) const
+        {
+            cml::et::UnrollAssignment<OpT>(dest, P);
+        }
+};
+
+/** A product combined element-wise with another operand by OpT.
+ *
+ * SideT is true_type when the product is the left operand of OpT.  The
+ * products in the operand are computed into temporaries when this is
+ * constructed (see Materialize<>), so that reading its elements while the
+ * product is evaluated is cheap and has no side effects.
+ */
+template<class ExprT, class OpT, class SideT>
+class ProductCombine
+{
+  public:
+
+    typedef Materialize<ExprT> operand_materialize;
+    typedef typename operand_materialize::type operand_type;
+    typedef ExprTraits<operand_type> expr_traits;
+    typedef typename expr_traits::const_reference expr_reference;
+    typedef typename expr_traits::result_tag result_tag;
+    typedef typename OpT::value_type value_type;
+
+
+  public:
+
+    /** Return element i,j of the assigned matrix from the product's. */
+    template<typename T> value_type operator()(T p, size_t i, size_t j) const
+    {
+        return this->combine(p, expr_traits().get(m_expr,i,j), SideT());
+    }
+
+    /** Return element i of the assigned vector from the product's. */
+    template<typename T> value_type operator()(T p, size_t i) const {
+        return this->combine(p, expr_traits().get(m_expr,i), SideT());
+    }
+
+    /** True if the operand may read from dest. */
+    template<class DestT> bool aliases(const DestT& dest) const {
+        return SummandAliases(dest, m_expr, result_tag());
+    }
+
+    /** True if the operand has the size of the product. */
+    bool fits(size_t rows, size_t cols) const {
+        return this->fits(rows, cols, result_tag());
+    }
+
+    /** True if the operand has the size of the product. */
+    bool fits(size_t size) const {
+        return this->fits(size, result_tag());
+    }
+
+    /** Combine the operand with the product already written to dest. */
+    template<typename E, class AT, typename BO, typename L>
+        void apply(cml::matrix<E,AT,BO,L>& dest) const
+        {
+            for(size_t i = 0; i < dest.rows(); ++i) {
+                for(size_t j = 0; j < dest.cols(); ++j) {
+                    dest(i,j) = (*this)(dest(i,j), i, j);
+                }
+            }
+        }
+
+    /** Combine the operand with the product already written to dest. */
+    template<typename E, class AT> void apply(cml::vector<E,AT>& dest) const
+    {
+        for(size_t i = 0; i < dest.size(); ++i) {
+            dest[i] = (*this)(dest[i], i);
+        }
+    }
+
+    /** Assign the finished product P, combined with the operand. */
+    template<class AssignT, class DestT, typename E, class AT, typename BO,
+        typename L>
+        void assign(DestT& dest, const cml::matrix<E,AT,BO,L>& P) const
+        {
+            this->template assign<AssignT>(dest, P, SideT());
+        }
+
+    /** Assign the finished product P, combined with the operand. */
+    template<class AssignT, class DestT, typename E, class AT>
+        void assign(DestT& dest, const cml::vector<E,AT>& P) const
+        {
+            this->template assign<AssignT>(dest, P, SideT());
+        }
+
+
+  public:
+
+    /** Construct from the operand to combine with the product. */
+    explicit ProductCombine(
+            typename ExprTraits<ExprT>::const_reference expr)
+        : m_operand(expr), m_expr(m_operand.expression()) {}
+
+
+  protected:
+
+    template<class AssignT, class DestT, typename E, class AT, typename BO,
+        typename L>
+        void assign(DestT& dest, const cml::matrix<E,AT,BO,L>& P,
+                true_type) const
+        {
+            typedef BinaryMatrixOp<cml::matrix<E,AT,BO,L>,operand_type,OpT>
+                ExprT2;
+            UnrollAssignment<AssignT>(dest, MatrixXpr<ExprT2>(
+                        ExprT2(P, m_expr)));
+        }
+
+    template<class AssignT, class DestT, typename E, class AT, typename BO,
+        typename L>
+        void assign(DestT& dest, const cml::matrix<E,AT,BO,L>& P,
+                false_type) const
+        {
+            typedef BinaryMatrixOp<operand_type,cml::matrix<E,AT,BO,L>,OpT>
+                ExprT2;
+            UnrollAssignment<AssignT>(dest, MatrixXpr<ExprT2>(
+                        ExprT2(m_expr, P)));
+        }
+
+    template<class AssignT, class DestT, typename E, class AT>
+        void assign(DestT& dest, const cml::vector<E,AT>& P,
+                true_type) const
+        {
+            typedef BinaryVectorOp<cml::vector<E,AT>,operand_type,OpT>
+                ExprT2;
+            UnrollAssignment<AssignT>(dest, VectorXpr<ExprT2>(
+                        ExprT2(P, m_expr)));
+        }
+
+    template<class AssignT, class DestT, typename E, class AT>
+        void assign(DestT& dest, const cml::vector<E,AT>& P,
+                false_type) const
+        {
+            typedef BinaryVectorOp<operand_type,cml::vector<E,AT>,OpT>
+                ExprT2;
+            UnrollAssignment<AssignT>(dest, VectorXpr<ExprT2>(
+                        ExprT2(m_expr, P)));
+        }
+
+    template<typename T, typename U>
+        value_type combine(T p, U e, true_type) const {
+            return OpT().apply(p, e);
+        }
+
+    template<typename T, typename U>
+        value_type combine(T p, U e, false_type) const {
+            return OpT().apply(e, p);
+        }
+
+    bool fits(size_t, size_t, scalar_result_tag) const { return true; }
+    bool fits(size_t rows, size_t cols, matrix_result_tag) const {
+        return expr_traits().rows(m_expr) == rows
+            && expr_traits().cols(m_expr) == cols;
+    }
+
+    bool fits(size_t, scalar_result_tag) const { return true; }
+    bool fits(size_t size, vector_result_tag) const {
+        return expr_traits().size(m_expr) == size;
+    }
+
+
+  protected:
+
+    operand_materialize m_operand;
+    expr_reference m_expr;
+
+
+  private:
+
+    /* m_expr may refer to m_operand, so this cannot be copied: */
+    ProductCombine(const ProductCombine&);
+    ProductCombine& operator=(const ProductCombine&);
+};
+
+} // namespace detail
+} // namespace et
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
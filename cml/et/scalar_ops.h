@@ -13,8 +13,10 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #ifndef ops_h
 #define ops_h
 
+#include <cmath>
 #include <cml/et/traits.h>
 #include <cml/et/scalar_promotions.h>
+#include <cml/util.h>
 
 /** Declare a unary scalar operator, like negation. */
 #define CML_UNARY_SCALAR_OP(_op_, _op_name_)                            \
@@ -87,6 +89,26 @@ namespace et {
 CML_UNARY_SCALAR_OP(-, OpNeg)
 CML_UNARY_SCALAR_OP(+, OpPos)
 
+/** Square root of a scalar, for element-wise expressions. */
+template<typename ArgT> struct OpSqrt {
+    typedef ExprTraits<ArgT> arg_traits;
+    typedef typename arg_traits::const_reference arg_reference;
+    typedef typename arg_traits::value_type value_type;
+    typedef scalar_result_tag result_tag;
+    value_type apply(arg_reference arg) const {
+        return value_type(std::sqrt(arg)); }
+};
+
+/** Inverse square root of a scalar, to the precision of cml::inv_sqrt(). */
+template<typename ArgT> struct OpInvSqrt {
+    typedef ExprTraits<ArgT> arg_traits;
+    typedef typename arg_traits::const_reference arg_reference;
+    typedef typename arg_traits::value_type value_type;
+    typedef scalar_result_tag result_tag;
+    value_type apply(arg_reference arg) const {
+        return cml::inv_sqrt(value_type(arg)); }
+};
+
 /* Binary scalar ops: */
 CML_BINARY_SCALAR_OP(+, OpAdd)
 CML_BINARY_SCALAR_OP(-, OpSub)
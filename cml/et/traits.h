@@ -135,6 +135,44 @@ template<> struct ExprTraits<float>
 };
 #endif
 
+/** Evaluate the products in an expression before it is read.
+ *
+ * Materialize<ExprT> computes each matrix or mat-vec product node of an
+ * expression into a temporary that it holds, and expression() returns
+ * the expression with the products replaced by their temporaries (of type
+ * Materialize<ExprT>::type).  The temporaries live as long as the
+ * Materialize<> object.  Assignments and reductions use this before their
+ * element loops, so that reading an element does not recompute a row or
+ * column of a product.
+ *
+ * The primary template keeps the expression as it is.  It is specialized
+ * for the product nodes, and for the nodes that pass them through.
+ */
+template<class ExprT> class Materialize
+{
+  public:
+
+    typedef ExprT type;
+    typedef typename ExprTraits<ExprT>::const_reference const_reference;
+
+
+  public:
+
+    /** Return the expression. */
+    const_reference expression() const { return m_expr; }
+
+
+  public:
+
+    /** Hold the expression. */
+    explicit Materialize(const_reference expr) : m_expr(expr) {}
+
+
+  protected:
+
+    const_reference m_expr;
+};
+
 } // namespace et
 } // namespace cml
 
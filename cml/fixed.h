@@ -22,16 +22,26 @@ namespace cml {
  * class of a vector or matrix.  The rebind<> template is used by
  * quaternion<> to select its vector length in a generic way.
  *
+ * Align optionally requests storage aligned to 16, 32 or 64 bytes (0
+ * means the natural alignment of the element type), e.g.
+ * vector< float, fixed<4,-1,16> > or quaternion< float, fixed<-1,-1,16> >.
+ * The packet kernels use aligned loads and stores for arrays whose
+ * alignment is at least the packet size.  Aligned arrays have their own
+ * operator new and delete, so new-expressions keep the alignment before
+ * C++17 as well; standard containers of them need an allocator such as
+ * aligned_allocator<> instead of std::allocator<>.
+ *
  * @sa dynamic
  * @sa external
+ * @sa cml::aligned_allocator
  */
-template<int Dim1 = -1, int Dim2 = -1> struct fixed {
+template<int Dim1 = -1, int Dim2 = -1, int Align = 0> struct fixed {
 
     /** Rebind to a 1D type.
      *
      * This is used by quaternion<>.
      */
-    template<int D> struct rebind { typedef fixed<D> other; };
+    template<int D> struct rebind { typedef fixed<D,-1,Align> other; };
 };
 
 } // namespace cml
@@ -0,0 +1,26 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Reading and writing vectors, matrices and quaternions.
+ *
+ * This is not included by cml/cml.h, since cml/io/mapped_file.h needs the
+ * memory-mapping headers of the operating system.
+ */
+
+#ifndef cml_io_h
+#define cml_io_h
+
+#include <cml/io/binary.h>
+#include <cml/io/mapped_file.h>
+#include <cml/io/parse.h>
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
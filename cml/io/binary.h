@@ -0,0 +1,691 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Binary records of vectors, matrices and quaternions.
+ *
+ * A record holds an array of count objects of the same type and size.  It
+ * starts with a 32-byte header:
+ *
+ *   offset  size  contents
+ *        0     4  "CMLb"
+ *        4     2  0x0102, in the byte order of the writer
+ *        6     1  the format version (binary_format_version)
+ *        7     1  the kind of object (binary_kind)
+ *        8     1  the element class: 'f' (IEEE floating point), 'i'
+ *                 (signed integer) or 'u' (unsigned integer)
+ *        9     1  the element size in bytes
+ *       10     1  matrices: the layout, 1 for row_major, 2 for col_major
+ *       11     1  matrices: the basis, 1 for row_basis, 2 for col_basis
+ *       12     1  quaternions: the order, 1 for scalar_first, 2 for
+ *                 vector_first
+ *       13     1  quaternions: the cross type, 1 for positive_cross, 2 for
+ *                 negative_cross
+ *       14     2  zero
+ *       16     4  the rows of each object (the size of a vector, 4 for a
+ *                 quaternion)
+ *       20     4  the columns of each object (1 for a vector or quaternion)
+ *       24     8  count
+ *
+ * followed by the elements of each object in turn, in the order they are
+ * stored in memory (given by the layout of a matrix, or the order of a
+ * quaternion), in the byte order of the writer.  The header fields are
+ * also in the byte order of the writer.  Records can follow one another
+ * in a stream or file, and memory mapped records can be used in place
+ * (see cml/io/mapped_file.h).
+ *
+ * read_binary() converts records written with the other byte order, or
+ * with another element type, layout or quaternion order.  Objects with a
+ * different basis or cross type are different transformations, and are
+ * not converted.  When nothing needs converting, arrays of fixed-size
+ * objects are read and written with a single stream operation.
+ *
+ * The header is checked before anything is allocated for the objects: a
+ * record of empty objects, or one with more elements than the rest of a
+ * seekable stream or mapped file holds, is rejected.
+ *
+ * @throws std::runtime_error if a record is malformed, or if the stream
+ * fails.
+ *
+ * @throws std::invalid_argument if the objects of a record cannot be read
+ * into the given ones, or if the objects of an array to write do not all
+ * have the same size.
+ */
+
+#ifndef cml_io_binary_h
+#define cml_io_binary_h
+
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include <cml/vector.h>
+#include <cml/matrix.h>
+#include <cml/quaternion.h>
+
+namespace cml {
+
+/** The version of the records written by write_binary(). */
+enum { binary_format_version = 1 };
+
+/** The size of the header of a record, in bytes. */
+enum { binary_header_size = 32 };
+
+/** The kinds of object in a record. */
+enum binary_kind {
+    binary_vector = 1,
+    binary_matrix = 2,
+    binary_quaternion = 3
+};
+
+/** The header of a record (see cml/io/binary.h). */
+struct binary_header
+{
+    binary_header()
+        : version(binary_format_version), kind(0), element_class(0)
+        , element_size(0), layout(0), basis(0), order(0), cross(0)
+        , rows(0), cols(0), count(0), swapped(false) {}
+
+    /** Return the number of elements of each object. */
+    size_t elements() const { return size_t(rows)*size_t(cols); }
+
+    /** Return the size of the elements of the record, in bytes.
+     *
+     * This can overflow for a corrupt header, so check fits() first.
+     */
+    uint64_t data_size() const { return count*elements()*element_size; }
+
+    /** True if the elements of the record fit in the given bytes.
+     *
+     * The sizes are divided rather than multiplied, so that this cannot
+     * overflow.
+     */
+    bool fits(uint64_t bytes) const {
+        const uint64_t n = uint64_t(rows)*uint64_t(cols);
+        if(n == 0 || element_size == 0) return count == 0;
+        return n <= bytes/element_size && count <= bytes/element_size/n;
+    }
+
+    unsigned version, kind;
+    char element_class;
+    unsigned element_size, layout, basis, order, cross;
+    uint32_t rows, cols;
+    uint64_t count;
+
+    /** True if the record was written with the other byte order. */
+    bool swapped;
+};
+
+namespace detail {
+
+/* The header codes of the layouts, bases, orders and cross types: */
+template<class T> struct binary_code;
+template<> struct binary_code<row_major> { enum { value = 1 }; };
+template<> struct binary_code<col_major> { enum { value = 2 }; };
+template<> struct binary_code<row_basis> { enum { value = 1 }; };
+template<> struct binary_code<col_basis> { enum { value = 2 }; };
+template<> struct binary_code<scalar_first> { enum { value = 1 }; };
+template<> struct binary_code<vector_first> { enum { value = 2 }; };
+template<> struct binary_code<positive_cross> { enum { value = 1 }; };
+template<> struct binary_code<negative_cross> { enum { value = 2 }; };
+
+/** Set the element fields of h for elements of type E. */
+template<typename E> inline void binary_describe_element(binary_header& h)
+{
+    typedef std::numeric_limits<E> limits;
+    h.element_class = limits::is_integer ? (limits::is_signed ? 'i' : 'u')
+        : 'f';
+    h.element_size = unsigned(sizeof(E));
+}
+
+/** True if the elements of h have type E. */
+template<typename E> inline bool binary_same_element(const binary_header& h)
+{
+    binary_header e;
+    binary_describe_element<E>(e);
+    return h.element_class == e.element_class
+        && h.element_size == e.element_size;
+}
+
+/** Resize a resizable object to rows x cols, or check the size of one that
+ * is not.
+ */
+template<typename E, class AT> inline bool binary_resize(
+        vector<E,AT>& v, size_t rows, size_t, resizable_tag)
+{
+    v.resize(rows);
+    return true;
+}
+
+template<typename E, class AT> inline bool binary_resize(
+        vector<E,AT>& v, size_t rows, size_t, not_resizable_tag)
+{
+    return v.size() == rows;
+}
+
+template<typename E, class AT, typename BO, class L> inline bool
+binary_resize(matrix<E,AT,BO,L>& m, size_t rows, size_t cols, resizable_tag)
+{
+    m.resize(rows, cols);
+    return true;
+}
+
+template<typename E, class AT, typename BO, class L> inline bool
+binary_resize(matrix<E,AT,BO,L>& m, size_t rows, size_t cols,
+        not_resizable_tag)
+{
+    return m.rows() == rows && m.cols() == cols;
+}
+
+} // namespace detail
+
+/** Describe the objects of type T for the binary records.
+ *
+ * The specializations for vector<>, matrix<> and quaternion<> define:
+ *
+ *   value_type: the element type;
+ *
+ *   kind: the binary_kind;
+ *
+ *   describe(h, x): set the fields of h other than the element and count
+ *   fields from x;
+ *
+ *   same_storage(h): true if the elements of each object of h are stored
+ *   in the same order as in T;
+ *
+ *   fit(x, h): size x for the objects of h, or return false if they cannot
+ *   be read into x;
+ *
+ *   store(x, h, p): set x from the elements of an object of h at p;
+ *
+ *   view(p, h): construct an external<> object of type T on p.
+ */
+template<class T> struct binary_traits;
+
+template<typename E, class AT> struct binary_traits< vector<E,AT> >
+{
+    typedef vector<E,AT> object_type;
+    typedef E value_type;
+    enum { kind = binary_vector };
+
+    static void describe(binary_header& h, const object_type& v) {
+        h.kind = kind;
+        h.rows = uint32_t(v.size());
+        h.cols = 1;
+    }
+
+    static bool same_storage(const binary_header&) { return true; }
+
+    static bool fit(object_type& v, const binary_header& h) {
+        if(h.kind != unsigned(kind) || h.cols != 1) return false;
+        if(object_type::array_size > 0
+                && h.rows != uint32_t(object_type::array_size)) return false;
+        return detail::binary_resize(v, h.rows, 1,
+                typename object_type::resizing_tag());
+    }
+
+    static void store(object_type& v, const binary_header&,
+            const value_type* p)
+    {
+        for(size_t i = 0; i < v.size(); ++i) v[i] = p[i];
+    }
+
+    static object_type view(value_type* p, const binary_header& h) {
+        return view(p, h, typename object_type::size_tag());
+    }
+
+  private:
+
+    static object_type view(value_type* p, const binary_header&,
+            fixed_size_tag)
+    {
+        return object_type(p);
+    }
+
+    static object_type view(value_type* p, const binary_header& h,
+            dynamic_size_tag)
+    {
+        return object_type(p, h.rows);
+    }
+};
+
+template<typename E, class AT, typename BO, class L>
+struct binary_traits< matrix<E,AT,BO,L> >
+{
+    typedef matrix<E,AT,BO,L> object_type;
+    typedef E value_type;
+    enum { kind = binary_matrix };
+
+    static void describe(binary_header& h, const object_type& m) {
+        h.kind = kind;
+        h.layout = detail::binary_code<L>::value;
+        h.basis = detail::binary_code<BO>::value;
+        h.rows = uint32_t(m.rows());
+        h.cols = uint32_t(m.cols());
+    }
+
+    static bool same_storage(const binary_header& h) {
+        return h.layout == unsigned(detail::binary_code<L>::value);
+    }
+
+    static bool fit(object_type& m, const binary_header& h) {
+        if(h.kind != unsigned(kind)
+                || h.basis != unsigned(detail::binary_code<BO>::value)
+                || (h.layout != 1 && h.layout != 2)) return false;
+        if(object_type::array_rows > 0
+                && (h.rows != uint32_t(object_type::array_rows)
+                    || h.cols != uint32_t(object_type::array_cols)))
+            return false;
+        return detail::binary_resize(m, h.rows, h.cols,
+                typename object_type::resizing_tag());
+    }
+
+    static void store(object_type& m, const binary_header& h,
+            const value_type* p)
+    {
+        const size_t rows = m.rows(), cols = m.cols();
+        if(h.layout == 1) {
+            for(size_t i = 0; i < rows; ++i)
+                for(size_t j = 0; j < cols; ++j) m(i,j) = *p++;
+        } else {
+            for(size_t j = 0; j < cols; ++j)
+                for(size_t i = 0; i < rows; ++i) m(i,j) = *p++;
+        }
+    }
+
+    static object_type view(value_type* p, const binary_header& h) {
+        return view(p, h, typename object_type::size_tag());
+    }
+
+  private:
+
+    static object_type view(value_type* p, const binary_header&,
+            fixed_size_tag)
+    {
+        return object_type(p);
+    }
+
+    static object_type view(value_type* p, const binary_header& h,
+            dynamic_size_tag)
+    {
+        return object_type(p, h.rows, h.cols);
+    }
+};
+
+template<typename E, class AT, class OT, class CT>
+struct binary_traits< quaternion<E,AT,OT,CT> >
+{
+    typedef quaternion<E,AT,OT,CT> object_type;
+    typedef E value_type;
+    enum { kind = binary_quaternion };
+
+    static void describe(binary_header& h, const object_type&) {
+        h.kind = kind;
+        h.order = detail::binary_code<OT>::value;
+        h.cross = detail::binary_code<CT>::value;
+        h.rows = 4;
+        h.cols = 1;
+    }
+
+    static bool same_storage(const binary_header& h) {
+        return h.order == unsigned(detail::binary_code<OT>::value);
+    }
+
+    static bool fit(object_type&, const binary_header& h) {
+        return h.kind == unsigned(kind) && h.rows == 4 && h.cols == 1
+            && h.cross == unsigned(detail::binary_code<CT>::value)
+            && (h.order == 1 || h.order == 2);
+    }
+
+    static void store(object_type& q, const binary_header& h,
+            const value_type* p)
+    {
+        enum { W = OT::W, X = OT::X, Y = OT::Y, Z = OT::Z };
+        if(h.order == 1) {
+            q[W] = p[scalar_first::W]; q[X] = p[scalar_first::X];
+            q[Y] = p[scalar_first::Y]; q[Z] = p[scalar_first::Z];
+        } else {
+            q[W] = p[vector_first::W]; q[X] = p[vector_first::X];
+            q[Y] = p[vector_first::Y]; q[Z] = p[vector_first::Z];
+        }
+    }
+
+    static object_type view(value_type* p, const binary_header&) {
+        return object_type(p);
+    }
+};
+
+namespace detail {
+
+inline void binary_swap_bytes(unsigned char* p, size_t n, size_t size)
+{
+    for(size_t i = 0; i < n; ++i, p += size) {
+        for(size_t a = 0, b = size - 1; a < b; ++a, --b) {
+            unsigned char t = p[a]; p[a] = p[b]; p[b] = t;
+        }
+    }
+}
+
+/** Convert n elements of type S at src to type T. */
+template<typename S, typename T> inline void binary_convert(
+        T* dst, const unsigned char* src, size_t n)
+{
+    for(size_t i = 0; i < n; ++i, src += sizeof(S)) {
+        S s; std::memcpy(&s, src, sizeof(S));
+        dst[i] = T(s);
+    }
+}
+
+/** Convert n elements described by h at src, in native byte order, to
+ * type T.
+ */
+template<typename T> inline void binary_decode(
+        T* dst, const unsigned char* src, size_t n, const binary_header& h)
+{
+    switch(h.element_class) {
+      case 'f':
+        if(h.element_size == sizeof(float)) {
+            binary_convert<float>(dst, src, n);
+        } else {
+            binary_convert<double>(dst, src, n);
+        }
+        break;
+      case 'i':
+        switch(h.element_size) {
+          case 1: binary_convert<int8_t>(dst, src, n); break;
+          case 2: binary_convert<int16_t>(dst, src, n); break;
+          case 4: binary_convert<int32_t>(dst, src, n); break;
+          default: binary_convert<int64_t>(dst, src, n); break;
+        }
+        break;
+      default:
+        switch(h.element_size) {
+          case 1: binary_convert<uint8_t>(dst, src, n); break;
+          case 2: binary_convert<uint16_t>(dst, src, n); break;
+          case 4: binary_convert<uint32_t>(dst, src, n); break;
+          default: binary_convert<uint64_t>(dst, src, n); break;
+        }
+        break;
+    }
+}
+
+/* Copy the header fields to and from their place in the header: */
+template<typename T> inline void binary_put(unsigned char* p, T value) {
+    std::memcpy(p, &value, sizeof(T));
+}
+
+template<typename T> inline T binary_get(const unsigned char* p, bool swap) {
+    unsigned char b[sizeof(T)];
+    std::memcpy(b, p, sizeof(T));
+    if(swap) binary_swap_bytes(b, 1, sizeof(T));
+    T value; std::memcpy(&value, b, sizeof(T));
+    return value;
+}
+
+inline void binary_write(std::ostream& os, const void* p, uint64_t n)
+{
+    os.write(static_cast<const char*>(p), std::streamsize(n));
+    CML_THROW_IF(!os, std::runtime_error("cannot write a binary record."));
+}
+
+inline void binary_read(std::istream& is, void* p, uint64_t n)
+{
+    is.read(static_cast<char*>(p), std::streamsize(n));
+    CML_THROW_IF(uint64_t(is.gcount()) != n,
+            std::runtime_error("truncated binary record."));
+}
+
+/** Return the bytes left to read from is, or the largest size if is cannot
+ * seek (e.g. a pipe).
+ */
+inline uint64_t binary_remaining(std::istream& is)
+{
+    typedef std::istream::pos_type pos_type;
+    const pos_type here = is.tellg();
+    if(here == pos_type(-1)) return uint64_t(-1);
+    is.seekg(0, std::ios::end);
+    const pos_type end = is.tellg();
+    is.clear(is.rdstate() & ~std::ios::failbit);
+    is.seekg(here);
+    if(end == pos_type(-1) || end < here) return uint64_t(-1);
+    return uint64_t(std::streamoff(end - here));
+}
+
+inline void write_binary_header(std::ostream& os, const binary_header& h)
+{
+    unsigned char b[binary_header_size] = { 'C', 'M', 'L', 'b' };
+    binary_put(b + 4, uint16_t(0x0102));
+    b[6] = (unsigned char) h.version;
+    b[7] = (unsigned char) h.kind;
+    b[8] = (unsigned char) h.element_class;
+    b[9] = (unsigned char) h.element_size;
+    b[10] = (unsigned char) h.layout;
+    b[11] = (unsigned char) h.basis;
+    b[12] = (unsigned char) h.order;
+    b[13] = (unsigned char) h.cross;
+    binary_put(b + 16, h.rows);
+    binary_put(b + 20, h.cols);
+    binary_put(b + 24, h.count);
+    binary_write(os, b, sizeof(b));
+}
+
+/** Write the count objects at objs, which have the size of the first. */
+template<class T> inline void write_binary_objects(
+        std::ostream& os, const T* objs, size_t count)
+{
+    typedef binary_traits<T> traits;
+    typedef typename traits::value_type value_type;
+
+    binary_header h;
+    h.kind = traits::kind;
+    if(count > 0) traits::describe(h, objs[0]);
+    binary_describe_element<value_type>(h);
+    h.count = count;
+    CML_THROW_IF(count > 0 && h.elements() == 0, std::invalid_argument(
+                "binary records cannot hold empty objects."));
+    for(size_t i = 1; i < count; ++i) {
+        binary_header hi;
+        traits::describe(hi, objs[i]);
+        CML_THROW_IF(hi.rows != h.rows || hi.cols != h.cols,
+                std::invalid_argument(
+                    "binary record objects differ in size."));
+    }
+    write_binary_header(os, h);
+
+    /* Packed fixed-size objects are written at once: */
+    const size_t n = h.elements();
+    if(count > 0 && sizeof(T) == n*sizeof(value_type)
+            && (const void*) objs[0].data() == (const void*) &objs[0])
+    {
+        binary_write(os, objs, h.data_size());
+        return;
+    }
+    for(size_t i = 0; i < count; ++i) {
+        binary_write(os, objs[i].data(), n*sizeof(value_type));
+    }
+}
+
+/** Read the count objects of the record of h into objs. */
+template<class T> inline void read_binary_objects(
+        std::istream& is, const binary_header& h, T* objs, size_t count)
+{
+    typedef binary_traits<T> traits;
+    typedef typename traits::value_type value_type;
+
+    for(size_t i = 0; i < count; ++i) {
+        CML_THROW_IF(!traits::fit(objs[i], h), std::invalid_argument(
+                    "cannot read the binary record into this type."));
+    }
+
+    const size_t n = h.elements();
+    const bool direct = !h.swapped && binary_same_element<value_type>(h)
+        && traits::same_storage(h);
+
+    /* Packed fixed-size objects are read at once: */
+    if(direct && count > 0 && sizeof(T) == n*sizeof(value_type)
+            && (const void*) objs[0].data() == (const void*) &objs[0])
+    {
+        binary_read(is, objs, h.data_size());
+        return;
+    }
+
+    std::vector<unsigned char> raw(direct ? 0 : n*h.element_size);
+    std::vector<value_type> values(direct ? 0 : n);
+    for(size_t i = 0; i < count; ++i) {
+        if(direct) {
+            binary_read(is, objs[i].data(), n*sizeof(value_type));
+            continue;
+        }
+        if(n == 0) continue;
+        binary_read(is, &raw[0], raw.size());
+        if(h.swapped) binary_swap_bytes(&raw[0], n, h.element_size);
+        binary_decode(&values[0], &raw[0], n, h);
+        traits::store(objs[i], h, &values[0]);
+    }
+}
+
+} // namespace detail
+
+/** Decode the header of a record from the binary_header_size bytes at p.
+ *
+ * @throws std::runtime_error if it is not a valid header.
+ */
+inline binary_header decode_binary_header(const unsigned char* p)
+{
+    CML_THROW_IF(std::memcmp(p, "CMLb", 4) != 0,
+            std::runtime_error("not a CML binary record."));
+
+    binary_header h;
+    uint16_t tag = detail::binary_get<uint16_t>(p + 4, false);
+    CML_THROW_IF(tag != 0x0102 && tag != 0x0201,
+            std::runtime_error("bad byte order in a CML binary record."));
+    h.swapped = (tag == 0x0201);
+    h.version = p[6];
+    h.kind = p[7];
+    h.element_class = char(p[8]);
+    h.element_size = p[9];
+    h.layout = p[10];
+    h.basis = p[11];
+    h.order = p[12];
+    h.cross = p[13];
+    h.rows = detail::binary_get<uint32_t>(p + 16, h.swapped);
+    h.cols = detail::binary_get<uint32_t>(p + 20, h.swapped);
+    h.count = detail::binary_get<uint64_t>(p + 24, h.swapped);
+
+    const unsigned s = h.element_size;
+    bool valid_element = (h.element_class == 'f' && (s == 4 || s == 8))
+        || ((h.element_class == 'i' || h.element_class == 'u')
+                && (s == 1 || s == 2 || s == 4 || s == 8));
+    CML_THROW_IF(h.version < 1 || h.version > binary_format_version
+            || h.kind < binary_vector || h.kind > binary_quaternion
+            || !valid_element,
+            std::runtime_error("unsupported CML binary record."));
+    CML_THROW_IF(h.count != 0 && h.elements() == 0,
+            std::runtime_error("bad size in a CML binary record."));
+    return h;
+}
+
+/** Read the header of the next record of is. */
+inline binary_header read_binary_header(std::istream& is)
+{
+    unsigned char b[binary_header_size];
+    detail::binary_read(is, b, sizeof(b));
+    return decode_binary_header(b);
+}
+
+namespace detail {
+
+/** Read the header of the next record of is, and check that its elements
+ * fit in the rest of is.
+ */
+inline binary_header read_checked_binary_header(std::istream& is)
+{
+    binary_header h = read_binary_header(is);
+    CML_THROW_IF(!h.fits(binary_remaining(is)),
+            std::runtime_error("truncated binary record."));
+    return h;
+}
+
+} // namespace detail
+
+/** Write x as a record of one object. */
+template<class T> inline void write_binary(std::ostream& os, const T& x)
+{
+    detail::write_binary_objects(os, &x, 1);
+}
+
+/** Write the count objects at objs as one record.
+ *
+ * @throws std::invalid_argument if the objects differ in size.
+ */
+template<class T> inline void write_binary(
+        std::ostream& os, const T* objs, size_t count)
+{
+    detail::write_binary_objects(os, objs, count);
+}
+
+/** Write the objects of objs as one record.
+ *
+ * @throws std::invalid_argument if the objects differ in size.
+ */
+template<class T, class A> inline void write_binary(
+        std::ostream& os, const std::vector<T,A>& objs)
+{
+    detail::write_binary_objects(os, objs.empty() ? 0 : &objs[0],
+            objs.size());
+}
+
+/** Read a record of one object into x, resizing it if it is dynamic.
+ *
+ * @throws std::invalid_argument if the record does not hold one object
+ * that can be read into x.
+ */
+template<class T> inline void read_binary(std::istream& is, T& x)
+{
+    binary_header h = detail::read_checked_binary_header(is);
+    CML_THROW_IF(h.count != 1, std::invalid_argument(
+                "the binary record does not hold one object."));
+    detail::read_binary_objects(is, h, &x, 1);
+}
+
+/** Read a record of count objects into objs, resizing dynamic ones.
+ *
+ * @throws std::invalid_argument if the record does not hold count objects
+ * that can be read into objs.
+ */
+template<class T> inline void read_binary(
+        std::istream& is, T* objs, size_t count)
+{
+    binary_header h = detail::read_checked_binary_header(is);
+    CML_THROW_IF(h.count != count, std::invalid_argument(
+                "the binary record has the wrong number of objects."));
+    detail::read_binary_objects(is, h, objs, count);
+}
+
+/** Read a record into objs, resized to the number of objects. */
+template<class T, class A> inline void read_binary(
+        std::istream& is, std::vector<T,A>& objs)
+{
+    binary_header h = detail::read_checked_binary_header(is);
+    CML_THROW_IF(h.count > objs.max_size(), std::invalid_argument(
+                "the binary record is too large."));
+    objs.resize(size_t(h.count));
+    detail::read_binary_objects(is, h, objs.empty() ? 0 : &objs[0],
+            objs.size());
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,229 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Memory-mapped views of binary records.
+ *
+ * mapped_file maps a whole file into memory, and mapped_array<T> views a
+ * record of the file (see cml/io/binary.h) as an array of external<>
+ * objects of type T, which refer to the mapped elements without copying
+ * them.  The record must hold objects of exactly the type of T, written
+ * with the byte order of this host.
+ *
+ * The file is opened read-only, and mapped copy-on-write: elements changed
+ * through the objects change only the memory of this process, never the
+ * file.
+ *
+ * The elements of the first record of a file are 32 bytes from its start,
+ * and so are aligned when mapped.  Those of a later record are aligned
+ * when the records before it have a multiple of 8 bytes of elements.
+ *
+ * @throws std::runtime_error if the file cannot be mapped, or if the
+ * record is malformed or lies past the end of the file.
+ *
+ * @throws std::invalid_argument if the record does not hold objects of
+ * type T, or if its elements are not aligned for T.
+ */
+
+#ifndef cml_io_mapped_file_h
+#define cml_io_mapped_file_h
+
+#include <string>
+#include <cml/io/binary.h>
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cml {
+
+/** A file mapped into memory, copy-on-write. */
+class mapped_file
+{
+  public:
+
+    /** Map the file at path. */
+    explicit mapped_file(const std::string& path)
+        : m_data(0), m_size(0)
+    {
+#if defined(_WIN32)
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        m_mapping = 0;
+        LARGE_INTEGER size;
+        bool ok = m_file != INVALID_HANDLE_VALUE
+            && GetFileSizeEx(m_file, &size);
+        if(ok && size.QuadPart > 0) {
+            m_size = size_t(size.QuadPart);
+            m_mapping = CreateFileMappingA(m_file, 0, PAGE_WRITECOPY,
+                    0, 0, 0);
+            if(m_mapping) {
+                m_data = MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0);
+            }
+            ok = m_data != 0;
+        }
+#else
+        bool ok = false;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if(fd >= 0 && ::fstat(fd, &st) == 0) {
+            ok = true;
+            m_size = size_t(st.st_size);
+            if(m_size > 0) {
+                void* p = ::mmap(0, m_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE, fd, 0);
+                ok = p != MAP_FAILED;
+                if(ok) m_data = p;
+            }
+        }
+        if(fd >= 0) ::close(fd);
+#endif
+        if(!ok) this->unmap();
+        CML_THROW_IF(!ok, std::runtime_error("cannot map " + path));
+    }
+
+    ~mapped_file() { this->unmap(); }
+
+    /** Return the first byte of the file (0 if it is empty). */
+    unsigned char* data() const {
+        return static_cast<unsigned char*>(m_data);
+    }
+
+    /** Return the size of the file, in bytes. */
+    size_t size() const { return m_size; }
+
+
+  protected:
+
+    void unmap() {
+#if defined(_WIN32)
+        if(m_data) UnmapViewOfFile(m_data);
+        if(m_mapping) CloseHandle(m_mapping);
+        if(m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = 0;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if(m_data) ::munmap(m_data, m_size);
+#endif
+        m_data = 0;
+    }
+
+
+  protected:
+
+    void*                       m_data;
+    size_t                      m_size;
+#if defined(_WIN32)
+    HANDLE                      m_file;
+    HANDLE                      m_mapping;
+#endif
+
+
+  private:
+
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+};
+
+/** A record of a mapped_file, viewed as an array of external<> objects.
+ *
+ * T is an external<> vector, matrix or quaternion type, e.g.
+ * vector< double, external<3> >, or matrix< float, external<>, col_basis,
+ * col_major > for matrices of any size.  The file must outlive the array
+ * and the objects it returns.
+ */
+template<class T> class mapped_array
+{
+  public:
+
+    typedef binary_traits<T> traits;
+    typedef T object_type;
+    typedef typename traits::value_type value_type;
+
+
+  public:
+
+    /** View the record starting offset bytes into file. */
+    explicit mapped_array(const mapped_file& file, size_t offset = 0)
+        : m_data(0), m_offset(offset)
+    {
+        CML_THROW_IF(offset > file.size()
+                || file.size() - offset < size_t(binary_header_size),
+                std::runtime_error("no binary record in the file."));
+        m_header = decode_binary_header(file.data() + offset);
+        CML_THROW_IF(!m_header.fits(
+                    file.size() - offset - binary_header_size),
+                std::runtime_error("truncated binary record."));
+
+        /* No conversions, since the elements are used in place: */
+        CML_THROW_IF(m_header.swapped
+                || !detail::binary_same_element<value_type>(m_header)
+                || !traits::same_storage(m_header)
+                || !this->matches(), std::invalid_argument(
+                    "cannot view the binary record as this type."));
+        unsigned char* p = file.data() + offset + binary_header_size;
+        CML_THROW_IF(reinterpret_cast<size_t>(p) % sizeof(value_type),
+                std::invalid_argument("misaligned binary record."));
+        m_data = reinterpret_cast<value_type*>(p);
+    }
+
+    /** Return the number of objects. */
+    size_t size() const { return size_t(m_header.count); }
+
+    /** True if there are no objects. */
+    bool empty() const { return m_header.count == 0; }
+
+    /** Return the header of the record. */
+    const binary_header& header() const { return m_header; }
+
+    /** Return the offset of the record that follows this one. */
+    size_t end_offset() const {
+        return m_offset + binary_header_size + size_t(m_header.data_size());
+    }
+
+    /** Return the elements of all of the objects. */
+    value_type* data() const { return m_data; }
+
+    /** Return object i, which refers to the mapped elements. */
+    object_type operator[](size_t i) const {
+        return traits::view(m_data + i*m_header.elements(), m_header);
+    }
+
+
+  protected:
+
+    /* True if the record holds objects of type T: */
+    bool matches() const {
+        if(m_header.kind != unsigned(traits::kind)) return false;
+        if(m_header.count == 0) return true;
+        object_type x = traits::view(0, m_header);
+        return traits::fit(x, m_header);
+    }
+
+
+  protected:
+
+    binary_header               m_header;
+    value_type*                 m_data;
+    size_t                      m_offset;
+};
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
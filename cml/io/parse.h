@@ -0,0 +1,554 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Fast parsing of vectors, matrices and quaternions from text.
+ *
+ * The parsers work on a range of characters [first,last), such as a file
+ * read into memory or mapped with cml/io/mapped_file.h, and do not depend
+ * on the locale: numbers always use '.' as the decimal point.  Numbers are
+ * separated by whitespace, commas, semicolons or brackets, so CSV rows and
+ * the output of operator<< can both be parsed.
+ *
+ * parse_number() reads one number, like C++17 std::from_chars().  Numbers
+ * with up to 15 significant digits and a power of 10 up to 22 (e.g. those
+ * written with the default precision of 6) are converted exactly without
+ * calling the C library; the others fall back to std::strtod().  float
+ * values are rounded from the double value.
+ *
+ * A mapped_file (cml/io/mapped_file.h) can be parsed in place, as the
+ * characters from reinterpret_cast<const char*>(file.data()) on.
+ *
+ * parse_objects() fills fixed-size objects from consecutive numbers,
+ * whatever the lines they are on (e.g. tests/timing/mvals.txt).
+ * parse_rows() reads one object per line, and parse_matrix() one row of
+ * a matrix per line.  Matrices are filled row by row, and quaternions in
+ * the order "w x y z" written by operator<<.
+ *
+ * @throws std::invalid_argument if the text does not hold the numbers
+ * expected, with the line number in the message.
+ */
+
+#ifndef cml_io_parse_h
+#define cml_io_parse_h
+
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <cml/vector.h>
+#include <cml/matrix.h>
+#include <cml/quaternion.h>
+
+namespace cml {
+namespace detail {
+
+inline bool parse_digit(char c) { return c >= '0' && c <= '9'; }
+
+/* True if c separates numbers within a line: */
+inline bool parse_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',' || c == ';'
+        || c == '[' || c == ']' || c == '\v' || c == '\f';
+}
+
+/* Return the exact powers of 10 that are doubles: */
+inline const double* parse_powers_of_10()
+{
+    static const double p[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    return p;
+}
+
+/* Match the case-insensitive word at p, returning its end or 0: */
+inline const char* parse_word(const char* p, const char* last,
+        const char* word)
+{
+    for(; *word; ++p, ++word) {
+        if(p == last || (*p | 0x20) != *word) return 0;
+    }
+    return p;
+}
+
+/* Convert [first,last) with std::strtod(), using the decimal point of the
+ * C locale in effect (if it is a single character):
+ */
+inline double parse_strtod(const char* first, const char* last)
+{
+    /* Numbers this long are rare, so copy them only when they do not fit
+     * on the stack:
+     */
+    char buffer[64];
+    std::string long_number;
+    char* s = buffer;
+    size_t n = size_t(last - first);
+    if(n >= sizeof(buffer)) {
+        long_number.resize(n + 1);
+        s = &long_number[0];
+    }
+    std::memcpy(s, first, n);
+    s[n] = 0;
+
+    const char* point = std::localeconv()->decimal_point;
+    if(point[0] != '.' && point[0] != 0 && point[1] == 0) {
+        char* p = std::strchr(s, '.');
+        if(p) *p = point[0];
+    }
+    return std::strtod(s, 0);
+}
+
+inline const char* parse_double(const char* first, const char* last,
+        double& value)
+{
+    const char* p = first;
+    bool negative = false;
+    if(p != last && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    /* Up to 19 significant digits fit in the mantissa: */
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false, truncated = false;
+    for(; p != last && parse_digit(*p); ++p) {
+        any = true;
+        if(digits < 19) {
+            mantissa = mantissa*10 + uint64_t(*p - '0');
+            if(mantissa) ++digits;
+        } else {
+            ++exponent;
+            truncated = true;
+        }
+    }
+    if(p != last && *p == '.') {
+        ++p;
+        for(; p != last && parse_digit(*p); ++p) {
+            any = true;
+            if(digits < 19) {
+                mantissa = mantissa*10 + uint64_t(*p - '0');
+                if(mantissa) ++digits;
+                --exponent;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+
+    if(!any) {
+        const char* q = parse_word(p, last, "inf");
+        if(q) {
+            const char* r = parse_word(q, last, "inity");
+            value = negative ? -std::numeric_limits<double>::infinity()
+                : std::numeric_limits<double>::infinity();
+            return r ? r : q;
+        }
+        q = parse_word(p, last, "nan");
+        if(q) {
+            value = std::numeric_limits<double>::quiet_NaN();
+            return q;
+        }
+        return first;
+    }
+
+    if(p != last && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negative_exponent = false;
+        if(q != last && (*q == '-' || *q == '+')) {
+            negative_exponent = (*q == '-');
+            ++q;
+        }
+        if(q != last && parse_digit(*q)) {
+            int e = 0;
+            for(; q != last && parse_digit(*q); ++q) {
+                if(e < 100000) e = e*10 + (*q - '0');
+            }
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    /* Exact when the mantissa and the power of 10 are exact doubles: */
+    if(mantissa == 0) {
+        value = negative ? -0. : 0.;
+    } else if(!truncated && mantissa <= (uint64_t(1) << 53)
+            && exponent >= -22 && exponent <= 22)
+    {
+        double m = double(mantissa);
+        value = exponent < 0 ? m/parse_powers_of_10()[-exponent]
+            : m*parse_powers_of_10()[exponent];
+        if(negative) value = -value;
+    } else {
+        value = parse_strtod(first, p);
+    }
+    return p;
+}
+
+template<typename T> inline const char* parse_integer(
+        const char* first, const char* last, T& value)
+{
+    typedef std::numeric_limits<T> limits;
+    const char* p = first;
+    bool negative = false;
+    if(p != last && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if(p == last || !parse_digit(*p)) return first;
+    if(negative && !limits::is_signed) return first;
+
+    /* Accumulate the magnitude, checking the range of T: */
+    const uint64_t max = negative
+        ? uint64_t(-(limits::min() + 1)) + 1 : uint64_t(limits::max());
+    uint64_t n = 0;
+    for(; p != last && parse_digit(*p); ++p) {
+        uint64_t d = uint64_t(*p - '0');
+        if(n > (max - d)/10) return first;
+        n = n*10 + d;
+    }
+    value = (negative && n > 0) ? T(-T(n - 1) - 1) : T(n);
+    return p;
+}
+
+template<typename T, bool Integer = std::numeric_limits<T>::is_integer>
+struct parse_traits
+{
+    static const char* parse(const char* first, const char* last,
+            T& value)
+    {
+        double d;
+        const char* p = parse_double(first, last, d);
+        if(p != first) value = T(d);
+        return p;
+    }
+};
+
+template<typename T> struct parse_traits<T,true>
+{
+    static const char* parse(const char* first, const char* last,
+            T& value)
+    {
+        return parse_integer(first, last, value);
+    }
+};
+
+} // namespace detail
+
+/** Parse a number at the start of [first,last) into value.
+ *
+ * The number is in the format of std::strtod() (without hexadecimal
+ * numbers), or of std::strtol() for integer types, with '.' as the
+ * decimal point whatever the locale.
+ *
+ * @returns the end of the number, or first if there is no number at first
+ * (or an integer is out of the range of T), in which case value is not
+ * changed.
+ */
+template<typename T> inline const char* parse_number(
+        const char* first, const char* last, T& value)
+{
+    return detail::parse_traits<T>::parse(first, last, value);
+}
+
+namespace detail {
+
+/** Iterate over the numbers of a range of text, tracking lines. */
+class number_scanner
+{
+  public:
+
+    number_scanner(const char* first, const char* last)
+        : m_p(first), m_last(last), m_line(1) {}
+
+    /** Skip separators, and newlines if lines is true; return true if
+     * something other than the end of the text (or of the line) follows.
+     */
+    bool skip(bool lines) {
+        for(; m_p != m_last; ++m_p) {
+            if(*m_p == '\n') {
+                if(!lines) return false;
+                ++m_line;
+            } else if(!parse_separator(*m_p)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Parse a number, after separators on the same line. */
+    template<typename T> void number(T& value) {
+        const char* p = this->skip(false)
+            ? parse_number(m_p, m_last, value) : m_p;
+        if(p == m_p || (p != m_last && !parse_separator(*p) && *p != '\n'))
+        {
+            this->fail("number expected");
+        }
+        m_p = p;
+    }
+
+    /** True if a number follows on the same line. */
+    bool more() { return this->skip(false); }
+
+    /** True if a number follows, on any line. */
+    bool more_numbers() {
+        if(!this->skip(true)) return false;
+        double d;
+        return parse_number(m_p, m_last, d) != m_p;
+    }
+
+    /** Return the current position. */
+    const char* position() const { return m_p; }
+
+    void fail(const char* what) const {
+        std::ostringstream msg;
+        msg << what << " on line " << m_line << ".";
+        throw std::invalid_argument(msg.str());
+    }
+
+
+  protected:
+
+    const char*                 m_p;
+    const char*                 m_last;
+    size_t                      m_line;
+};
+
+/* Set the elements of a fixed-size object from the scanner: */
+template<typename E, class AT> inline void
+parse_object(number_scanner& s, vector<E,AT>& v, bool lines)
+{
+    for(size_t i = 0; i < v.size(); ++i) {
+        if(lines) s.skip(true);
+        s.number(v[i]);
+    }
+}
+
+template<typename E, class AT, typename BO, class L> inline void
+parse_object(number_scanner& s, matrix<E,AT,BO,L>& m, bool lines)
+{
+    for(size_t i = 0; i < m.rows(); ++i) {
+        for(size_t j = 0; j < m.cols(); ++j) {
+            if(lines) s.skip(true);
+            s.number(m(i,j));
+        }
+    }
+}
+
+template<typename E, class AT, class OT, class CT> inline void
+parse_object(number_scanner& s, quaternion<E,AT,OT,CT>& q, bool lines)
+{
+    const int order[] = { OT::W, OT::X, OT::Y, OT::Z };
+    for(int i = 0; i < 4; ++i) {
+        if(lines) s.skip(true);
+        s.number(q[order[i]]);
+    }
+}
+
+/* Read the numbers of the current line of s into values: */
+template<typename E> inline void
+parse_line(number_scanner& s, std::vector<E>& values)
+{
+    values.clear();
+    while(s.more()) {
+        E value;
+        s.number(value);
+        values.push_back(value);
+    }
+}
+
+/* Size an object read from a line of n numbers: */
+template<typename E, class AT> inline bool
+parse_fit(vector<E,AT>& v, size_t n, resizable_tag)
+{
+    v.resize(n);
+    return true;
+}
+
+template<typename E, class AT> inline bool
+parse_fit(vector<E,AT>& v, size_t n, not_resizable_tag)
+{
+    return v.size() == n;
+}
+
+template<class MatT> inline void
+parse_resize(MatT& m, size_t rows, size_t cols, resizable_tag)
+{
+    m.resize(rows, cols);
+}
+
+template<class MatT> inline void
+parse_resize(MatT&, size_t, size_t, not_resizable_tag)
+{
+    throw std::invalid_argument("the matrix has the wrong size.");
+}
+
+} // namespace detail
+
+/** Fill the count fixed-size objects at objs from the numbers at the start
+ * of [first,last), whatever the lines they are on.
+ *
+ * @returns the end of the last number read.
+ *
+ * @throws std::invalid_argument if there are fewer numbers than elements.
+ */
+template<class T> inline const char* parse_objects(
+        const char* first, const char* last, T* objs, size_t count)
+{
+    detail::number_scanner s(first, last);
+    for(size_t i = 0; i < count; ++i) {
+        detail::parse_object(s, objs[i], true);
+    }
+    return s.position();
+}
+
+/** Append to objs the fixed-size objects filled by the numbers at the
+ * start of [first,last), up to the end of the text or to something that
+ * is not a number.
+ *
+ * A default-constructed T must have elements, so dynamic vectors and
+ * matrices are read with parse_rows() or parse_matrix() instead.
+ *
+ * @returns the end of the last number read.
+ *
+ * @throws std::invalid_argument if the numbers end within an object, or
+ * if T has no elements.
+ */
+template<class T, class A> inline const char* parse_objects(
+        const char* first, const char* last, std::vector<T,A>& objs)
+{
+    detail::number_scanner s(first, last);
+    while(s.more_numbers()) {
+        const char* p = s.position();
+        T x;
+        detail::parse_object(s, x, true);
+        if(s.position() == p) s.fail("object with no elements");
+        objs.push_back(x);
+    }
+    return s.position();
+}
+
+/** Append to objs one object for each line of [first,last) that is not
+ * blank.
+ *
+ * Each line has the elements of a vector, the rows of a fixed-size matrix
+ * one after the other, or a quaternion.  Dynamic vectors are resized to
+ * the numbers on their line.
+ *
+ * @throws std::invalid_argument if a line does not hold one object.
+ */
+template<class T, class A> inline void parse_rows(
+        const char* first, const char* last, std::vector<T,A>& objs)
+{
+    detail::number_scanner s(first, last);
+    while(s.skip(true)) {
+        T x;
+        detail::parse_object(s, x, false);
+        if(s.more()) s.fail("too many numbers");
+        objs.push_back(x);
+    }
+}
+
+/** Append to vs one vector for each line of [first,last) that is not
+ * blank.
+ *
+ * @throws std::invalid_argument if a line does not hold a vector of the
+ * size of the fixed-size vectors.
+ */
+template<typename E, class AT, class A> inline void parse_rows(
+        const char* first, const char* last, std::vector<vector<E,AT>,A>& vs)
+{
+    typedef vector<E,AT> vector_type;
+    typedef typename vector_type::resizing_tag resizing_tag;
+    detail::number_scanner s(first, last);
+    std::vector<E> values;
+    while(s.skip(true)) {
+        detail::parse_line(s, values);
+        vector_type v;
+        if(!detail::parse_fit(v, values.size(), resizing_tag())) {
+            s.fail("wrong number of elements");
+        }
+        for(size_t i = 0; i < values.size(); ++i) v[i] = values[i];
+        vs.push_back(v);
+    }
+}
+
+/** Read a matrix from [first,last), one row per line that is not blank.
+ *
+ * A resizable matrix is resized to the rows and the numbers on each of
+ * them; the others must have that size.
+ *
+ * @throws std::invalid_argument if the rows differ in length, or the
+ * matrix cannot have their size.
+ */
+template<typename E, class AT, typename BO, class L> inline void
+parse_matrix(const char* first, const char* last, matrix<E,AT,BO,L>& m)
+{
+    detail::number_scanner s(first, last);
+    std::vector<E> values, row;
+    size_t rows = 0, cols = 0;
+    while(s.skip(true)) {
+        detail::parse_line(s, row);
+        if(rows > 0 && row.size() != cols) s.fail("wrong number of columns");
+        cols = row.size();
+        values.insert(values.end(), row.begin(), row.end());
+        ++rows;
+    }
+    if(m.rows() != rows || m.cols() != cols) {
+        typedef typename matrix<E,AT,BO,L>::resizing_tag resizing_tag;
+        detail::parse_resize(m, rows, cols, resizing_tag());
+    }
+    for(size_t i = 0, k = 0; i < rows; ++i) {
+        for(size_t j = 0; j < cols; ++j) m(i,j) = values[k++];
+    }
+}
+
+/** Parse the numbers of text (see parse_objects()). */
+template<class T> inline void parse_objects(
+        const std::string& text, T* objs, size_t count)
+{
+    const char* p = text.data();
+    parse_objects(p, p + text.size(), objs, count);
+}
+
+/** Parse the numbers of text (see parse_objects()). */
+template<class T, class A> inline void parse_objects(
+        const std::string& text, std::vector<T,A>& objs)
+{
+    const char* p = text.data();
+    parse_objects(p, p + text.size(), objs);
+}
+
+/** Parse the lines of text (see parse_rows()). */
+template<class T, class A> inline void parse_rows(
+        const std::string& text, std::vector<T,A>& objs)
+{
+    const char* p = text.data();
+    parse_rows(p, p + text.size(), objs);
+}
+
+/** Parse the rows of text (see parse_matrix()). */
+template<class MatT> inline void parse_matrix(
+        const std::string& text, MatT& m)
+{
+    const char* p = text.data();
+    parse_matrix(p, p + text.size(), m);
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
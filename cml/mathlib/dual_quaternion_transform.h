@@ -0,0 +1,325 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Rigid transforms and skinning with dual quaternions.
+ */
+
+#ifndef dual_quaternion_transform_h
+#define dual_quaternion_transform_h
+
+#include <cml/core/simd.h>
+#include <cml/mathlib/checking.h>
+#include <cml/mathlib/matrix_rotation.h>
+#include <cml/mathlib/matrix_translation.h>
+#include <cml/mathlib/quaternion_rotation.h>
+#include <cml/mathlib/vector_transform.h>
+
+/* Functions for dual quaternions representing rigid transforms.
+ *
+ * Blending follows dual quaternion linear blending (DLB, Kavan et al.,
+ * "Skinning with Dual Quaternions", 2007): the weighted sum of the dual
+ * quaternions, with each one negated if needed to lie on the same side as
+ * the first, divided by the length of its real part.
+ *
+ * The batched blending and skinning functions take k bone influences per
+ * vertex: vertex i uses the bones indices[i*k+j] with the weights
+ * weights[i*k+j] for j < k, and k must be at least 1.  Each vertex's
+ * blend is summed with the coefficients of each quaternion in a SIMD
+ * packet, and skinning then transforms a packet of vertices at a time.
+ */
+
+namespace cml {
+
+//////////////////////////////////////////////////////////////////////////////
+// Conversion to and from matrices
+//////////////////////////////////////////////////////////////////////////////
+
+/** Build an affine transform from a unit dual quaternion */
+template < typename E, class A, class B, class L,
+    typename QE, class OT, class CT > void
+matrix_dual_quaternion(matrix<E,A,B,L>& m, const dual_quaternion<QE,OT,CT>& dq)
+{
+    /* Checking */
+    detail::CheckMatAffine3D(m);
+
+    matrix_rotation_quaternion(m, dq.real());
+    matrix_set_translation(m, dq.translation());
+}
+
+/** Build a dual quaternion from the rotation and translation of an affine
+ *  transform
+ */
+template < typename E, class OT, class CT, class MatT > void
+dual_quaternion_matrix(dual_quaternion<E,OT,CT>& dq, const MatT& m)
+{
+    typedef dual_quaternion<E,OT,CT> dual_quaternion_type;
+    typedef typename dual_quaternion_type::quaternion_type quaternion_type;
+
+    /* Checking */
+    detail::CheckMatAffine3D(m);
+
+    quaternion_type q;
+    quaternion_rotation_matrix(q, m);
+    dq = dual_quaternion_type(q, matrix_get_translation(m));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Transformation of points and vectors
+//////////////////////////////////////////////////////////////////////////////
+
+/** Apply the rigid transform of a unit dual quaternion to a 3D point */
+template < typename E, class OT, class CT, class VecT > vector< E, fixed<3> >
+dual_quaternion_transform_point(
+    const dual_quaternion<E,OT,CT>& dq, const VecT& p)
+{
+    return quaternion_rotate_vector(dq.real(), p) + dq.translation();
+}
+
+/** Apply the rotation of a unit dual quaternion to a 3D vector */
+template < typename E, class OT, class CT, class VecT > vector< E, fixed<3> >
+dual_quaternion_transform_vector(
+    const dual_quaternion<E,OT,CT>& dq, const VecT& v)
+{
+    return quaternion_rotate_vector(dq.real(), v);
+}
+
+/** Apply the rigid transform of a unit dual quaternion to n 3D points.
+ *
+ * The dual quaternion is converted to a matrix once, and the points are
+ * transformed by transform_points().
+ */
+template < typename E, class OT, class CT > void
+dual_quaternion_transform_points(const dual_quaternion<E,OT,CT>& dq,
+        const vector< E, fixed<3> >* in, vector< E, fixed<3> >* out, size_t n)
+{
+    matrix< E, fixed<4,4>, col_basis, col_major > m;
+    matrix_dual_quaternion(m, dq);
+    transform_points(m, in, out, n);
+}
+
+/** Apply the rigid transform of a unit dual quaternion to n interleaved 3D
+ *  points
+ */
+template < typename E, class OT, class CT > void
+dual_quaternion_transform_points(const dual_quaternion<E,OT,CT>& dq,
+        const E* in, E* out, size_t n)
+{
+    matrix< E, fixed<4,4>, col_basis, col_major > m;
+    matrix_dual_quaternion(m, dq);
+    transform_points(m, in, out, n);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Dual quaternion linear blending
+//////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+/** Blend the k bones influencing one vertex.
+ *
+ * The sum is computed with the 4 coefficients of each part in one packet,
+ * and is returned unnormalized in r and d.
+ */
+template < typename T, typename IndexT > inline void
+dual_quaternion_blend_vertex(const T* bones, const IndexT* indices,
+        const T* weights, size_t k,
+        typename quaternion_lanes<T>::packet_type& r,
+        typename quaternion_lanes<T>::packet_type& d)
+{
+    typedef quaternion_lanes<T> lanes;
+    typedef typename lanes::pt pt;
+    typedef typename lanes::packet_type packet_type;
+
+    /* The first bone, which fixes the hemisphere of the blend: */
+    const T* b = bones + 8*size_t(indices[0]);
+    packet_type r0 = pt::loadu(b), w = pt::set1(weights[0]);
+    r = pt::mul(w, r0);
+    d = pt::mul(w, pt::loadu(b+4));
+
+    for(size_t j = 1; j < k; ++j) {
+        b = bones + 8*size_t(indices[j]);
+        packet_type br = pt::loadu(b);
+
+        /* Flip bones on the other side of the first: */
+        packet_type s = pt::mul(br, r0);
+        s = pt::add(s, lanes::template shuffle<1,0,3,2>(s));
+        s = pt::add(s, lanes::template shuffle<2,3,0,1>(s));
+        w = pt::mul(pt::set1(weights[j]), pt::sign(s));
+
+        r = pt::madd(w, br, r);
+        d = pt::madd(w, pt::loadu(b+4), d);
+    }
+}
+
+/** Blend the bones influencing one vertex into out. */
+template < typename T, typename IndexT > inline void
+dual_quaternion_blend_store(const T* bones, const IndexT* indices,
+        const T* weights, size_t k, T* out)
+{
+    typedef quaternion_lanes<T> lanes;
+    typedef typename lanes::pt pt;
+    typedef typename lanes::packet_type packet_type;
+
+    packet_type r, d;
+    dual_quaternion_blend_vertex(bones, indices, weights, k, r, d);
+
+    /* Divide by the length of the real part: */
+    packet_type l = pt::mul(r, r);
+    l = pt::add(l, lanes::template shuffle<1,0,3,2>(l));
+    l = pt::add(l, lanes::template shuffle<2,3,0,1>(l));
+    l = simd::inv_sqrt<pt>(l);
+    pt::storeu(out, pt::mul(r, l));
+    pt::storeu(out+4, pt::mul(d, l));
+}
+
+/** Skin PT::size interleaved 3D points.
+ *
+ * The bones of each vertex are blended separately, then the blends are
+ * transposed so that the transforms are computed a packet of vertices at a
+ * time.
+ */
+template < class PT, class OT, typename T, typename IndexT > inline void
+dual_quaternion_skin_store(const T* bones, const IndexT* indices,
+        const T* weights, size_t k, const T* in, T* out)
+{
+    typedef quaternion_lanes<T> lanes;
+    typedef typename PT::packet_type packet_type;
+    enum { N = PT::size };
+
+    /* Blend each vertex, storing the real parts, then the dual parts: */
+    T buf[8*N];
+    for(int l = 0; l < N; ++l) {
+        typename lanes::packet_type r, d;
+        dual_quaternion_blend_vertex(
+                bones, indices + l*k, weights + l*k, k, r, d);
+        lanes::pt::storeu(buf + 4*l, r);
+        lanes::pt::storeu(buf + 4*(N + l), d);
+    }
+
+    packet_type a[4], r[4], d[4];
+    PT::load4(buf, a[0], a[1], a[2], a[3]);
+    r[0] = a[OT::W]; r[1] = a[OT::X]; r[2] = a[OT::Y]; r[3] = a[OT::Z];
+    PT::load4(buf + 4*N, a[0], a[1], a[2], a[3]);
+    d[0] = a[OT::W]; d[1] = a[OT::X]; d[2] = a[OT::Y]; d[3] = a[OT::Z];
+
+    /* Divide by the length of the real part: */
+    packet_type s = PT::madd(r[3], r[3], PT::madd(r[2], r[2],
+                PT::madd(r[1], r[1], PT::mul(r[0], r[0]))));
+    s = simd::inv_sqrt<PT>(s);
+    r[0] = PT::mul(r[0], s); d[0] = PT::mul(d[0], s);
+    r[1] = PT::mul(r[1], s); d[1] = PT::mul(d[1], s);
+    r[2] = PT::mul(r[2], s); d[2] = PT::mul(d[2], s);
+    r[3] = PT::mul(r[3], s); d[3] = PT::mul(d[3], s);
+
+    /* t = 2*(w_r*v_d - w_d*v_r + v_r x v_d): */
+    packet_type tx = PT::sub(PT::mul(r[2],d[3]), PT::mul(r[3],d[2]));
+    packet_type ty = PT::sub(PT::mul(r[3],d[1]), PT::mul(r[1],d[3]));
+    packet_type tz = PT::sub(PT::mul(r[1],d[2]), PT::mul(r[2],d[1]));
+    tx = PT::madd(r[0], d[1], PT::sub(tx, PT::mul(d[0], r[1])));
+    ty = PT::madd(r[0], d[2], PT::sub(ty, PT::mul(d[0], r[2])));
+    tz = PT::madd(r[0], d[3], PT::sub(tz, PT::mul(d[0], r[3])));
+
+    packet_type px, py, pz;
+    PT::load3(in, px, py, pz);
+    quaternion_rotate_packets<PT>(r[0], r[1], r[2], r[3], px, py, pz);
+    px = PT::add(px, PT::add(tx,tx));
+    py = PT::add(py, PT::add(ty,ty));
+    pz = PT::add(pz, PT::add(tz,tz));
+    PT::store3(out, px, py, pz);
+}
+
+/** Skin n interleaved 3D points, a SIMD packet at a time. */
+template < class OT, typename T, typename IndexT > void
+dual_quaternion_skin(const T* bones, const IndexT* indices,
+        const T* weights, size_t k, const T* in, T* out, size_t n)
+{
+    enum { W = simd::native_width<T>::value };
+    typedef simd::packet_traits<T,W> pt;
+    typedef simd::packet_traits<T,1> st;
+
+    size_t nw = n - n % W, i = 0;
+    for(; i < nw; i += W) {
+        dual_quaternion_skin_store<pt,OT>(bones, indices + i*k,
+                weights + i*k, k, in + 3*i, out + 3*i);
+    }
+    for(; i < n; ++i) {
+        dual_quaternion_skin_store<st,OT>(bones, indices + i*k,
+                weights + i*k, k, in + 3*i, out + 3*i);
+    }
+}
+
+} // namespace detail
+
+/** Blend k unit dual quaternions with the weights w (DLB). */
+template < typename E, class OT, class CT > dual_quaternion<E,OT,CT>
+dual_quaternion_blend(
+    const dual_quaternion<E,OT,CT>* dq, const E* w, size_t k)
+{
+    typedef dual_quaternion<E,OT,CT> dual_quaternion_type;
+
+    dual_quaternion_type result = dq[0] * w[0];
+    for(size_t j = 1; j < k; ++j) {
+        E s = (dot(dq[j].real(), dq[0].real()) < E(0)) ? -w[j] : w[j];
+        result += dq[j] * s;
+    }
+    return result *= inv_sqrt(result.real().length_squared());
+}
+
+/** Blend the bones influencing each of n vertices (DLB).
+ *
+ * out[i] is the blend of the k bones influencing vertex i.
+ */
+template < typename E, class OT, class CT, typename IndexT > void
+dual_quaternion_blend(const dual_quaternion<E,OT,CT>* bones,
+        const IndexT* indices, const E* weights, size_t k,
+        dual_quaternion<E,OT,CT>* out, size_t n)
+{
+    /* The dual quaternions must be packed without padding: */
+    CML_STATIC_REQUIRE(sizeof(dual_quaternion<E,OT,CT>) == 8*sizeof(E));
+
+    for(size_t i = 0; i < n; ++i) {
+        detail::dual_quaternion_blend_store(bones->data(),
+                indices + i*k, weights + i*k, k, out[i].data());
+    }
+}
+
+/** Skin n interleaved 3D points with DLB.
+ *
+ * Point i is transformed by the blend of the k bones influencing it.  in
+ * and out may be the same array.
+ */
+template < typename E, class OT, class CT, typename IndexT > void
+dual_quaternion_skin_points(const dual_quaternion<E,OT,CT>* bones,
+        const IndexT* indices, const E* weights, size_t k,
+        const E* in, E* out, size_t n)
+{
+    /* The dual quaternions must be packed without padding: */
+    CML_STATIC_REQUIRE(sizeof(dual_quaternion<E,OT,CT>) == 8*sizeof(E));
+    detail::dual_quaternion_skin<OT>(
+            bones->data(), indices, weights, k, in, out, n);
+}
+
+/** Skin n 3D points with DLB. */
+template < typename E, class OT, class CT, typename IndexT > void
+dual_quaternion_skin_points(const dual_quaternion<E,OT,CT>* bones,
+        const IndexT* indices, const E* weights, size_t k,
+        const vector< E, fixed<3> >* in, vector< E, fixed<3> >* out, size_t n)
+{
+    /* The vectors must be packed without padding: */
+    CML_STATIC_REQUIRE(sizeof(vector< E, fixed<3> >) == 3*sizeof(E));
+    if(n > 0) dual_quaternion_skin_points(
+            bones, indices, weights, k, in->data(), out->data(), n);
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
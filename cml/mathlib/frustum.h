@@ -18,7 +18,9 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 
 namespace cml {
 
-/* @todo: plane class, and perhaps named arguments instead of an array. */
+/* @todo: perhaps named arguments instead of an array.  See
+ * cml/mathlib/frustum_culling.h for the plane<> and frustum<> classes.
+ */
 
 /* Extract the planes of a frustum given a modelview matrix and a projection
  * matrix with the given near z-clipping range. The planes are normalized by
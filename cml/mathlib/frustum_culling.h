@@ -0,0 +1,464 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Planes, frusta, and batched frustum culling.
+ *
+ * frustum<Real> holds the 6 normalized planes computed by
+ * extract_frustum_planes(), and classifies a bounding sphere or
+ * axis-aligned box as outside, intersecting or inside the frustum.
+ *
+ * cull_spheres() and cull_boxes() classify n bounding volumes held in
+ * separate x, y and z arrays (or soa_vector<>s), testing a SIMD packet of
+ * volumes against one plane at a time.  A box is tested through its center
+ * and half extents, so each plane costs a dot product for the distance of
+ * the center and one for the projected radius.  The planes are visited
+ * starting with the one that last rejected a whole packet, and the loop
+ * stops as soon as every volume of a packet is outside.
+ *
+ * The batched functions optionally take a plane mask per volume, with bit
+ * i set if the volume is known to be inside plane i (e.g. because its
+ * parent in a bounding volume hierarchy is).  Planes set for every volume
+ * of a packet are not tested, and on return the masks of the volumes that
+ * are not outside hold the planes they are inside, for testing their
+ * children.
+ */
+
+#ifndef frustum_culling_h
+#define frustum_culling_h
+
+#include <cml/core/simd.h>
+#include <cml/soa_vector.h>
+#include <cml/mathlib/frustum.h>
+
+namespace cml {
+
+/** A plane in ax+by+cz+d = 0 form. */
+template<typename Real>
+class plane
+{
+  public:
+
+    typedef Real value_type;
+    typedef vector< Real, fixed<3> > vector_type;
+
+
+  public:
+
+    /** Default constructor.
+     *
+     * @note The coefficients are not initialized.
+     */
+    plane() {}
+
+    /** Construct from the coefficients of ax+by+cz+d = 0. */
+    plane(Real a, Real b, Real c, Real d) : m_normal(a,b,c), m_offset(d) {}
+
+    /** Construct from the normal (a,b,c) and d. */
+    template<typename E, class AT>
+    plane(const vector<E,AT>& n, Real d) : m_normal(n), m_offset(d) {}
+
+    /** Construct from an array of 4 coefficients. */
+    explicit plane(const Real p[4]) : m_normal(p[0],p[1],p[2]), m_offset(p[3])
+    {}
+
+
+  public:
+
+    /** Return the normal (a,b,c). */
+    const vector_type& normal() const { return m_normal; }
+
+    /** Return the offset d. */
+    value_type offset() const { return m_offset; }
+
+    /** Return coefficient i, with d at i = 3. */
+    value_type operator[](int i) const {
+        return (i < 3) ? m_normal[i] : m_offset;
+    }
+
+    /** Return ax+by+cz+d for the point p.
+     *
+     * This is the signed distance from the plane if it is normalized.
+     */
+    template<typename E, class AT>
+    value_type distance(const vector<E,AT>& p) const {
+        return dot(m_normal, p) + m_offset;
+    }
+
+    /** Scale the coefficients to a unit normal. */
+    plane& normalize() {
+        Real s = inv_sqrt(m_normal.length_squared());
+        m_normal *= s;
+        m_offset *= s;
+        return *this;
+    }
+
+
+  protected:
+
+    vector_type m_normal;
+    value_type m_offset;
+};
+
+/** The 6 planes of a view frustum.
+ *
+ * The planes are normalized, face into the frustum, and are in the order
+ * of extract_frustum_planes(): left, right, bottom, top, near, far.
+ */
+template<typename Real>
+class frustum
+{
+  public:
+
+    typedef Real value_type;
+    typedef cml::plane<Real> plane_type;
+    typedef vector< Real, fixed<3> > vector_type;
+
+    /** A plane mask with every plane set. */
+    enum { all_planes = 0x3f };
+
+
+  public:
+
+    /** Default constructor.
+     *
+     * @note The planes are not initialized.
+     */
+    frustum() {}
+
+    /** Construct from planes in the format of extract_frustum_planes(). */
+    explicit frustum(const Real planes[6][4]) { set(planes); }
+
+    /** Construct the frustum of a concatenated modelview and projection
+     * matrix, with the given near z-clipping range.
+     */
+    template<class MatT> frustum(const MatT& m, ZClip z_clip) {
+        Real planes[6][4];
+        extract_frustum_planes(m, planes, z_clip);
+        set(planes);
+    }
+
+    /** Construct the frustum of a modelview and a projection matrix, with
+     * the given near z-clipping range.
+     */
+    template<class MatT> frustum(
+            const MatT& modelview, const MatT& projection, ZClip z_clip)
+    {
+        Real planes[6][4];
+        extract_frustum_planes(modelview, projection, planes, z_clip);
+        set(planes);
+    }
+
+    /** Set the planes, normalizing them. */
+    void set(const Real planes[6][4]) {
+        for(int i = 0; i < 6; ++ i)
+            m_planes[i] = plane_type(planes[i]).normalize();
+    }
+
+    /** Return plane i. */
+    const plane_type& get_plane(int i) const { return m_planes[i]; }
+
+    /** Get the corners of the frustum, as get_frustum_corners(). */
+    template<typename E, class A> void
+    get_corners(vector<E,A> corners[8]) const {
+        Real planes[6][4];
+        for(int i = 0; i < 6; ++ i)
+            for(int j = 0; j < 4; ++ j) planes[i][j] = m_planes[i][j];
+        get_frustum_corners(planes, corners);
+    }
+
+    /** Classify the sphere with the given center and radius. */
+    template<typename E, class AT> FrustumContainment
+    classify_sphere(const vector<E,AT>& center, Real radius) const {
+        FrustumContainment result = frustum_inside;
+        for(int i = 0; i < 6; ++ i) {
+            Real d = m_planes[i].distance(center);
+            if(d + radius < Real(0)) return frustum_outside;
+            if(d - radius < Real(0)) result = frustum_intersect;
+        }
+        return result;
+    }
+
+    /** Classify the axis-aligned box between min and max. */
+    template<typename E1, class AT1, typename E2, class AT2>
+    FrustumContainment classify_box(
+            const vector<E1,AT1>& min, const vector<E2,AT2>& max) const
+    {
+        vector_type c = Real(.5)*(max + min), e = Real(.5)*(max - min);
+        FrustumContainment result = frustum_inside;
+        for(int i = 0; i < 6; ++ i) {
+            const vector_type& n = m_planes[i].normal();
+            Real d = m_planes[i].distance(c);
+            Real r = std::fabs(n[0])*e[0] + std::fabs(n[1])*e[1]
+                + std::fabs(n[2])*e[2];
+            if(d + r < Real(0)) return frustum_outside;
+            if(d - r < Real(0)) result = frustum_intersect;
+        }
+        return result;
+    }
+
+
+  protected:
+
+    plane_type m_planes[6];
+};
+
+namespace detail {
+
+/** The planes of a frustum, broadcast to packets. */
+template<class PT> struct frustum_cull_kernel
+{
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+
+    /* The plane coefficients, and the magnitudes of the normals: */
+    packet_type n[6][4], a[6][3];
+
+    explicit frustum_cull_kernel(const frustum<T>& f) {
+        for(int i = 0; i < 6; ++i) {
+            for(int j = 0; j < 4; ++j) n[i][j] = PT::set1(f.get_plane(i)[j]);
+            for(int j = 0; j < 3; ++j)
+                a[i][j] = PT::set1(std::fabs(f.get_plane(i)[j]));
+        }
+    }
+
+    /** Return the distance of the points (x,y,z) from plane i. */
+    packet_type distance(int i, const packet_type& x, const packet_type& y,
+            const packet_type& z) const
+    {
+        return PT::madd(n[i][2], z,
+                PT::madd(n[i][1], y, PT::madd(n[i][0], x, n[i][3])));
+    }
+
+    /** Return the projection of the half extents (x,y,z) on normal i. */
+    packet_type radius(int i, const packet_type& x, const packet_type& y,
+            const packet_type& z) const
+    {
+        return PT::madd(a[i][2], z,
+                PT::madd(a[i][1], y, PT::mul(a[i][0], x)));
+    }
+};
+
+/** A packet of spheres. */
+template<class PT> struct frustum_cull_spheres
+{
+    typedef PT pt;
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+
+    const T *x, *y, *z, *r;
+    packet_type cx, cy, cz, cr;
+
+    void load(size_t k) {
+        cx = PT::loadu(x+k); cy = PT::loadu(y+k);
+        cz = PT::loadu(z+k); cr = PT::loadu(r+k);
+    }
+
+    void plane(const frustum_cull_kernel<PT>& K, int i,
+            packet_type& d, packet_type& e) const
+    {
+        d = K.distance(i, cx, cy, cz);
+        e = cr;
+    }
+};
+
+/** A packet of axis-aligned boxes. */
+template<class PT> struct frustum_cull_boxes
+{
+    typedef PT pt;
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+
+    const T *x0, *y0, *z0, *x1, *y1, *z1;
+    packet_type cx, cy, cz, ex, ey, ez;
+
+    void load(size_t k) {
+        packet_type h = PT::set1(T(.5));
+        packet_type a = PT::loadu(x0+k), b = PT::loadu(x1+k);
+        cx = PT::mul(h, PT::add(b,a)); ex = PT::mul(h, PT::sub(b,a));
+        a = PT::loadu(y0+k); b = PT::loadu(y1+k);
+        cy = PT::mul(h, PT::add(b,a)); ey = PT::mul(h, PT::sub(b,a));
+        a = PT::loadu(z0+k); b = PT::loadu(z1+k);
+        cz = PT::mul(h, PT::add(b,a)); ez = PT::mul(h, PT::sub(b,a));
+    }
+
+    void plane(const frustum_cull_kernel<PT>& K, int i,
+            packet_type& d, packet_type& e) const
+    {
+        d = K.distance(i, cx, cy, cz);
+        e = K.radius(i, ex, ey, ez);
+    }
+};
+
+/** Classify the PT::size volumes at k.
+ *
+ * first is the plane to test first, and is updated when a plane rejects
+ * every volume.  Returns the number of volumes that are not outside.
+ */
+template<class PT, class VolumeT> inline size_t
+frustum_cull_packet(const frustum_cull_kernel<PT>& K, VolumeT& v,
+        size_t k, unsigned char* result, unsigned char* masks, int& first)
+{
+    enum { N = PT::size, all = (1 << N) - 1 };
+    typedef typename PT::packet_type packet_type;
+
+    /* The planes every volume is known to be inside: */
+    int skip = 0;
+    if(masks) {
+        skip = frustum<typename PT::value_type>::all_planes;
+        for(int l = 0; l < N; ++l) skip &= masks[k+l];
+    }
+
+    v.load(k);
+    int out = 0, in[6];
+    for(int j = 0; j < 6; ++j) {
+        int i = first + j; if(i >= 6) i -= 6;
+        if(skip & (1 << i)) { in[i] = all; continue; }
+        packet_type d, e;
+        v.plane(K, i, d, e);
+        out |= PT::negative_mask(PT::add(d,e));
+        if(out == all) {
+            first = i;
+            for(int l = 0; l < N; ++l)
+                result[k+l] = (unsigned char) frustum_outside;
+            return 0;
+        }
+        in[i] = all & ~PT::negative_mask(PT::sub(d,e));
+    }
+
+    size_t count = 0;
+    for(int l = 0; l < N; ++l) {
+        if(out & (1 << l)) {
+            result[k+l] = (unsigned char) frustum_outside;
+            continue;
+        }
+        int m = 0;
+        for(int i = 0; i < 6; ++i) if(in[i] & (1 << l)) m |= 1 << i;
+        if(masks) masks[k+l] = (unsigned char) (m | masks[k+l]);
+        result[k+l] = (unsigned char) ((m == 0x3f)
+                ? frustum_inside : frustum_intersect);
+        ++count;
+    }
+    return count;
+}
+
+/** Classify n volumes, a SIMD packet at a time.
+ *
+ * v and t are the packet and scalar views of the volumes.
+ */
+template<typename T, class PacketVolumeT, class ScalarVolumeT> size_t
+frustum_cull(const frustum<T>& f, PacketVolumeT v, ScalarVolumeT t,
+        unsigned char* result, unsigned char* masks, size_t n)
+{
+    typedef typename PacketVolumeT::pt pt;
+    typedef typename ScalarVolumeT::pt st;
+    enum { W = pt::size };
+
+    /* Local copies, so the planes can stay in registers: */
+    const frustum_cull_kernel<pt> K(f);
+    const frustum_cull_kernel<st> S(f);
+
+    int first = 0;
+    size_t nw = n - n % W, k = 0, count = 0;
+    for(; k < nw; k += W)
+        count += frustum_cull_packet(K, v, k, result, masks, first);
+    for(; k < n; ++k)
+        count += frustum_cull_packet(S, t, k, result, masks, first);
+    return count;
+}
+
+} // namespace detail
+
+/** Classify n spheres with centers (x[i],y[i],z[i]) and radii r[i].
+ *
+ * result[i] is set to the FrustumContainment of sphere i, and the number
+ * of spheres that are not outside is returned.
+ */
+template<typename E> size_t
+cull_spheres(const frustum<E>& f, const E* x, const E* y, const E* z,
+        const E* r, unsigned char* result, size_t n)
+{
+    return cull_spheres(f, x, y, z, r, result, (unsigned char*) 0, n);
+}
+
+/** Classify n spheres, skipping and updating the plane masks of each
+ * sphere (see cml/mathlib/frustum_culling.h).
+ */
+template<typename E> size_t
+cull_spheres(const frustum<E>& f, const E* x, const E* y, const E* z,
+        const E* r, unsigned char* result, unsigned char* masks, size_t n)
+{
+    enum { W = simd::native_width<E>::value };
+    detail::frustum_cull_spheres< simd::packet_traits<E,W> > v;
+    detail::frustum_cull_spheres< simd::packet_traits<E,1> > t;
+    v.x = t.x = x; v.y = t.y = y; v.z = t.z = z; v.r = t.r = r;
+    return detail::frustum_cull(f, v, t, result, masks, n);
+}
+
+/** Classify the spheres with the given centers and radii. */
+template<typename E, class A> size_t
+cull_spheres(const frustum<E>& f, const soa_vector<E,3,A>& centers,
+        const vector< E, dynamic<A> >& radii, unsigned char* result,
+        unsigned char* masks = 0)
+{
+    size_t n = centers.size();
+    if(n == 0) return 0;
+    return cull_spheres(f, centers.plane(0).data(), centers.plane(1).data(),
+            centers.plane(2).data(), radii.data(), result, masks, n);
+}
+
+/** Classify n axis-aligned boxes between (x0[i],y0[i],z0[i]) and
+ * (x1[i],y1[i],z1[i]).
+ *
+ * result[i] is set to the FrustumContainment of box i, and the number of
+ * boxes that are not outside is returned.
+ */
+template<typename E> size_t
+cull_boxes(const frustum<E>& f, const E* x0, const E* y0, const E* z0,
+        const E* x1, const E* y1, const E* z1, unsigned char* result,
+        size_t n)
+{
+    return cull_boxes(f, x0, y0, z0, x1, y1, z1, result,
+            (unsigned char*) 0, n);
+}
+
+/** Classify n axis-aligned boxes, skipping and updating the plane masks of
+ * each box (see cml/mathlib/frustum_culling.h).
+ */
+template<typename E> size_t
+cull_boxes(const frustum<E>& f, const E* x0, const E* y0, const E* z0,
+        const E* x1, const E* y1, const E* z1, unsigned char* result,
+        unsigned char* masks, size_t n)
+{
+    enum { W = simd::native_width<E>::value };
+    detail::frustum_cull_boxes< simd::packet_traits<E,W> > v;
+    detail::frustum_cull_boxes< simd::packet_traits<E,1> > t;
+    v.x0 = t.x0 = x0; v.y0 = t.y0 = y0; v.z0 = t.z0 = z0;
+    v.x1 = t.x1 = x1; v.y1 = t.y1 = y1; v.z1 = t.z1 = z1;
+    return detail::frustum_cull(f, v, t, result, masks, n);
+}
+
+/** Classify the axis-aligned boxes between min and max. */
+template<typename E, class A> size_t
+cull_boxes(const frustum<E>& f, const soa_vector<E,3,A>& min,
+        const soa_vector<E,3,A>& max, unsigned char* result,
+        unsigned char* masks = 0)
+{
+    size_t n = min.size();
+    if(n == 0) return 0;
+    return cull_boxes(f, min.plane(0).data(), min.plane(1).data(),
+            min.plane(2).data(), max.plane(0).data(), max.plane(1).data(),
+            max.plane(2).data(), result, masks, n);
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
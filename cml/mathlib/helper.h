@@ -153,6 +153,12 @@ enum ZClip { z_clip_neg_one, z_clip_zero };
 
 enum SphericalType { latitude, colatitude };
 
+//////////////////////////////////////////////////////////////////////////////
+// Frustum containment
+//////////////////////////////////////////////////////////////////////////////
+
+enum FrustumContainment { frustum_outside, frustum_intersect, frustum_inside };
+
 } // namespace cml
 
 #endif
@@ -13,6 +13,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #ifndef interpolation_h
 #define interpolation_h
 
+#include <cml/core/simd.h>
 #include <cml/mathlib/matrix_rotation.h>
 
 /* Interpolation functions.
@@ -1124,6 +1125,285 @@ trilerp(const T1& val000, const T2& val100,
     return result;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Batched interpolation of arrays of quaternions
+//////////////////////////////////////////////////////////////////////////////
+
+/* The batched slerp(), nlerp() and squad() below blend n quaternions at
+ * once, for example every bone of a pose.  They work a SIMD packet of
+ * quaternions at a time (see cml/core/simd.h), with no branches and no
+ * trigonometric functions: the slerp weights sin(t*theta)/sin(theta) are
+ * evaluated by the polynomial of D. Eberly, "A Fast and Accurate Algorithm
+ * for Computing SLERP" (2011), whose absolute error is below 2e-5 for float
+ * and 4e-8 for double for t in [0,1].  Each pair is blended along the
+ * shorter arc, as by the single-quaternion slerp() and nlerp().
+ *
+ * The weights are either one per quaternion or shared by all of them, and
+ * the output may be the same array as any of the inputs.
+ */
+
+namespace detail {
+
+/** The number of terms and the final-term correction of the slerp
+ * polynomial, per scalar type.
+ */
+template<typename T> struct slerp_polynomial {
+    enum { terms = 16 };
+    static T mu() { return T(1.916668059639); }
+};
+
+template<> struct slerp_polynomial<float> {
+    enum { terms = 8 };
+    static float mu() { return 1.85298109240830f; }
+};
+
+/** The kinds of batched quaternion blend. */
+enum quaternion_blend_mode {
+    blend_slerp,
+    blend_nlerp,
+    blend_squad
+};
+
+/** Blend W quaternions at a time, held as packets of their 4 components. */
+template<typename T, int W, int Mode> struct quaternion_blend
+{
+    typedef simd::packet_traits<T,W> pt;
+    typedef typename pt::packet_type packet_type;
+    enum { terms = slerp_polynomial<T>::terms };
+
+    packet_type u[terms], v[terms], one;
+
+    quaternion_blend() {
+        for(int i = 1; i <= terms; ++i) {
+            T s = (i == terms) ? slerp_polynomial<T>::mu() : T(1);
+            u[i-1] = pt::set1(s/T(i*(2*i+1)));
+            v[i-1] = pt::set1(s*T(i)/T(2*i+1));
+        }
+        one = pt::set1(T(1));
+    }
+
+    /** Return sin(t*theta)/sin(theta), given x1 = cos(theta) - 1. */
+    packet_type weight(packet_type t, packet_type x1) const {
+        packet_type tt = pt::mul(t,t), f = one;
+        for(int i = terms-1; i >= 0; --i)
+            f = pt::madd(pt::mul(pt::sub(pt::mul(u[i],tt),v[i]),x1), f, one);
+        return pt::mul(t,f);
+    }
+
+    static packet_type dot(const packet_type* a, const packet_type* b) {
+        return pt::madd(a[3], b[3], pt::madd(a[2], b[2],
+                    pt::madd(a[1], b[1], pt::mul(a[0], b[0]))));
+    }
+
+    /** r = slerp(a,b,t) along the shorter arc. */
+    void slerp(const packet_type* a, const packet_type* b, packet_type t,
+            packet_type* r) const
+    {
+        packet_type c = dot(a,b), s = pt::sign(c);
+        packet_type x1 = pt::sub(pt::mul(c,s), one);
+        packet_type wa = weight(pt::sub(one,t), x1);
+        packet_type wb = pt::mul(s, weight(t, x1));
+        for(int i = 0; i < 4; ++i)
+            r[i] = pt::madd(b[i], wb, pt::mul(a[i], wa));
+    }
+
+    /** r = nlerp(a,b,t) along the shorter arc. */
+    void nlerp(const packet_type* a, const packet_type* b, packet_type t,
+            packet_type* r) const
+    {
+        packet_type wa = pt::sub(one,t), wb = pt::mul(pt::sign(dot(a,b)), t);
+        for(int i = 0; i < 4; ++i)
+            r[i] = pt::madd(b[i], wb, pt::mul(a[i], wa));
+        packet_type s = simd::inv_sqrt<pt>(dot(r,r));
+        for(int i = 0; i < 4; ++i) r[i] = pt::mul(r[i], s);
+    }
+
+    /** Blend quaternions a and b by t, or for squad, keys a and d with the
+     * intermediate quaternions b and c.
+     */
+    void apply(const T* a, const T* b, const T* c, const T* d,
+            packet_type t, T* out) const
+    {
+        packet_type qa[4], qb[4], r[4];
+        pt::load4(a, qa[0], qa[1], qa[2], qa[3]);
+        pt::load4(b, qb[0], qb[1], qb[2], qb[3]);
+        if(Mode == blend_slerp) {
+            slerp(qa, qb, t, r);
+        } else if(Mode == blend_nlerp) {
+            nlerp(qa, qb, t, r);
+        } else {
+            packet_type qc[4], qd[4], s1[4], s2[4];
+            pt::load4(c, qc[0], qc[1], qc[2], qc[3]);
+            pt::load4(d, qd[0], qd[1], qd[2], qd[3]);
+            slerp(qa, qd, t, s1);
+            slerp(qb, qc, t, s2);
+            slerp(s1, s2, pt::mul(pt::add(t,t), pt::sub(one,t)), r);
+        }
+        pt::store4(out, r[0], r[1], r[2], r[3]);
+    }
+};
+
+/** A blend weight shared by every quaternion. */
+template<typename T> struct uniform_blend_weight {
+    explicit uniform_blend_weight(T t) : m_t(t) {}
+    template<class PT> typename PT::packet_type load(size_t) const {
+        return PT::set1(m_t);
+    }
+    T m_t;
+};
+
+/** An array of blend weights, one per quaternion. */
+template<typename T> struct array_blend_weight {
+    explicit array_blend_weight(const T* t) : m_t(t) {}
+    template<class PT> typename PT::packet_type load(size_t k) const {
+        return PT::loadu(m_t+k);
+    }
+    const T* m_t;
+};
+
+/** Blend n quaternions held as interleaved arrays of 4n elements. */
+template<int Mode, typename T, class WeightT> void
+blend_quaternions(const T* a, const T* b, const T* c, const T* d,
+        const WeightT& t, T* out, size_t n)
+{
+    enum { W = simd::native_width<T>::value };
+    typedef quaternion_blend<T,W,Mode> kernel_type;
+    typedef quaternion_blend<T,1,Mode> tail_type;
+    typedef typename kernel_type::pt pt;
+    typedef typename tail_type::pt pt1;
+
+    const kernel_type K;
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W)
+        K.apply(a+4*k, b+4*k, c+4*k, d+4*k, t.template load<pt>(k), out+4*k);
+    if(k < n) {
+        const tail_type K1;
+        for(; k < n; ++k) K1.apply(a+4*k, b+4*k, c+4*k, d+4*k,
+                t.template load<pt1>(k), out+4*k);
+    }
+}
+
+/** Return the elements of a quaternion array. */
+template<typename E, class OT, class CT> E*
+quaternion_data(quaternion<E,fixed<>,OT,CT>* q)
+{
+    /* The quaternions must be packed without padding: */
+    CML_STATIC_REQUIRE(sizeof(quaternion<E,fixed<>,OT,CT>) == 4*sizeof(E));
+    return &q[0][0];
+}
+
+template<typename E, class OT, class CT> const E*
+quaternion_data(const quaternion<E,fixed<>,OT,CT>* q)
+{
+    CML_STATIC_REQUIRE(sizeof(quaternion<E,fixed<>,OT,CT>) == 4*sizeof(E));
+    return &q[0][0];
+}
+
+} // namespace detail
+
+/** Spherical linear interpolation of n pairs of quaternions, with weights
+ * t[0..n-1].
+ */
+template<typename E, class OT, class CT> void
+slerp(const quaternion<E,fixed<>,OT,CT>* q1,
+        const quaternion<E,fixed<>,OT,CT>* q2, const E* t,
+        quaternion<E,fixed<>,OT,CT>* out, size_t n)
+{
+    if(n == 0) return;
+    const E* a = detail::quaternion_data(q1);
+    const E* b = detail::quaternion_data(q2);
+    detail::blend_quaternions<detail::blend_slerp>(a, b, a, a,
+            detail::array_blend_weight<E>(t), detail::quaternion_data(out), n);
+}
+
+/** Spherical linear interpolation of n pairs of quaternions by t. */
+template<typename E, class OT, class CT> void
+slerp(const quaternion<E,fixed<>,OT,CT>* q1,
+        const quaternion<E,fixed<>,OT,CT>* q2,
+        typename quaternion<E,fixed<>,OT,CT>::value_type t,
+        quaternion<E,fixed<>,OT,CT>* out, size_t n)
+{
+    if(n == 0) return;
+    const E* a = detail::quaternion_data(q1);
+    const E* b = detail::quaternion_data(q2);
+    detail::blend_quaternions<detail::blend_slerp>(a, b, a, a,
+            detail::uniform_blend_weight<E>(t),
+            detail::quaternion_data(out), n);
+}
+
+/** Normalized linear interpolation of n pairs of quaternions, with weights
+ * t[0..n-1].
+ */
+template<typename E, class OT, class CT> void
+nlerp(const quaternion<E,fixed<>,OT,CT>* q1,
+        const quaternion<E,fixed<>,OT,CT>* q2, const E* t,
+        quaternion<E,fixed<>,OT,CT>* out, size_t n)
+{
+    if(n == 0) return;
+    const E* a = detail::quaternion_data(q1);
+    const E* b = detail::quaternion_data(q2);
+    detail::blend_quaternions<detail::blend_nlerp>(a, b, a, a,
+            detail::array_blend_weight<E>(t), detail::quaternion_data(out), n);
+}
+
+/** Normalized linear interpolation of n pairs of quaternions by t. */
+template<typename E, class OT, class CT> void
+nlerp(const quaternion<E,fixed<>,OT,CT>* q1,
+        const quaternion<E,fixed<>,OT,CT>* q2,
+        typename quaternion<E,fixed<>,OT,CT>::value_type t,
+        quaternion<E,fixed<>,OT,CT>* out, size_t n)
+{
+    if(n == 0) return;
+    const E* a = detail::quaternion_data(q1);
+    const E* b = detail::quaternion_data(q2);
+    detail::blend_quaternions<detail::blend_nlerp>(a, b, a, a,
+            detail::uniform_blend_weight<E>(t),
+            detail::quaternion_data(out), n);
+}
+
+/** Spherical quadrangle interpolation of n quaternion keys q1 and q2, with
+ * intermediate quaternions a1 and a2, by the weights t[0..n-1]:
+ *
+ *   squad = slerp(slerp(q1,q2,t), slerp(a1,a2,t), 2t(1-t))
+ *
+ * @note Each of the three slerps takes the shorter arc, so the keys and
+ * intermediates should already lie in a common hemisphere for the curve
+ * to be smooth.
+ */
+template<typename E, class OT, class CT> void
+squad(const quaternion<E,fixed<>,OT,CT>* q1,
+        const quaternion<E,fixed<>,OT,CT>* a1,
+        const quaternion<E,fixed<>,OT,CT>* a2,
+        const quaternion<E,fixed<>,OT,CT>* q2, const E* t,
+        quaternion<E,fixed<>,OT,CT>* out, size_t n)
+{
+    if(n == 0) return;
+    detail::blend_quaternions<detail::blend_squad>(
+            detail::quaternion_data(q1), detail::quaternion_data(a1),
+            detail::quaternion_data(a2), detail::quaternion_data(q2),
+            detail::array_blend_weight<E>(t), detail::quaternion_data(out), n);
+}
+
+/** Spherical quadrangle interpolation of n quaternion keys by t.
+ *
+ * @sa squad()
+ */
+template<typename E, class OT, class CT> void
+squad(const quaternion<E,fixed<>,OT,CT>* q1,
+        const quaternion<E,fixed<>,OT,CT>* a1,
+        const quaternion<E,fixed<>,OT,CT>* a2,
+        const quaternion<E,fixed<>,OT,CT>* q2,
+        typename quaternion<E,fixed<>,OT,CT>::value_type t,
+        quaternion<E,fixed<>,OT,CT>* out, size_t n)
+{
+    if(n == 0) return;
+    detail::blend_quaternions<detail::blend_squad>(
+            detail::quaternion_data(q1), detail::quaternion_data(a1),
+            detail::quaternion_data(a2), detail::quaternion_data(q2),
+            detail::uniform_blend_weight<E>(t),
+            detail::quaternion_data(out), n);
+}
+
 } // namespace cml
 
 #endif
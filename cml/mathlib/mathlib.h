@@ -24,10 +24,14 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/mathlib/matrix_projection.h>
 #include <cml/mathlib/quaternion_basis.h>
 #include <cml/mathlib/quaternion_rotation.h>
+#include <cml/mathlib/dual_quaternion_transform.h>
 #include <cml/mathlib/coord_conversion.h>
 #include <cml/mathlib/interpolation.h>
 #include <cml/mathlib/frustum.h>
+#include <cml/mathlib/frustum_culling.h>
 #include <cml/mathlib/projection.h>
 #include <cml/mathlib/picking.h>
+#include <cml/mathlib/ray_intersection.h>
+#include <cml/mathlib/random_sampling.h>
 
 #endif
@@ -14,6 +14,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define matrix_misc_h
 
 #include <cml/mathlib/checking.h>
+#include <cml/mathlib/epsilon.h>
 
 /* Miscellaneous matrix functions. */
 
@@ -178,6 +179,171 @@ matrix_invert_RT(matrix<E,A,B,L>& m)
   m.set_basis_element(dimension,dimension, E(1));
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Inverses of 3D affine transforms
+//////////////////////////////////////////////////////////////////////////////
+
+/* The functions below read and write the matrix through basis_element(),
+ * so they apply to both row-basis and col-basis matrices.  Writing B for
+ * the 3x3 linear part (basis_element(i,j) for i,j < 3) and t for the
+ * translation, a point p maps to p B + t, and the inverse transform is
+ * given by B^-1 and -t B^-1.
+ */
+
+namespace detail {
+
+/** Set the homogeneous part of a square transform to [0 0 0 1]. */
+template < typename E, class A, class B, class L > void
+set_affine_homogeneous_part(matrix<E,A,B,L>& m)
+{
+    if (m.rows() == m.cols()) {
+        m.set_basis_element(0,3,E(0));
+        m.set_basis_element(1,3,E(0));
+        m.set_basis_element(2,3,E(0));
+        m.set_basis_element(3,3,E(1));
+    }
+}
+
+/** Set the translation of m to -t B^-1, where B^-1 is the linear part of m.
+ */
+template < typename E, class A, class B, class L > void
+set_inverse_translation(matrix<E,A,B,L>& m, E t0, E t1, E t2)
+{
+    for (size_t j = 0; j < 3; ++j) {
+        m.set_basis_element(3,j, -(t0 * m.basis_element(0,j) +
+                                   t1 * m.basis_element(1,j) +
+                                   t2 * m.basis_element(2,j)));
+    }
+}
+
+} // namespace detail
+
+/** Invert a 3D rigid transform (rotation and translation).
+ *
+ * The linear part must be orthonormal.  The inverse is computed by
+ * transposing the rotation and rotating the negated translation, as by
+ * matrix_invert_RT_only() (27 multiplies, versus about 200 for a general
+ * 4x4 inverse).
+ *
+ * m may be 4x4, or 4x3 (row basis) or 3x4 (col basis).
+ *
+ * @sa inverse_affine
+ */
+template < typename E, class A, class B, class L >
+typename matrix<E,A,B,L>::temporary_type
+inverse_rigid(const matrix<E,A,B,L>& m)
+{
+    typedef typename matrix<E,A,B,L>::temporary_type temporary_type;
+
+    /* Checking */
+    detail::CheckMatAffine3D(m);
+
+    temporary_type Z = m;
+    matrix_invert_RT_only(Z);
+    detail::set_affine_homogeneous_part(Z);
+    return Z;
+}
+
+/** Invert a 3D affine transform.
+ *
+ * The 3x3 linear part is inverted by its adjugate, and the negated
+ * translation is transformed by the result (about 60 multiplies and one
+ * division).
+ *
+ * m may be 4x4, or 4x3 (row basis) or 3x4 (col basis).  The homogeneous
+ * part of a 4x4 matrix is assumed to be [0 0 0 1] and is not read.
+ *
+ * @sa inverse_rigid
+ */
+template < typename E, class A, class B, class L >
+typename matrix<E,A,B,L>::temporary_type
+inverse_affine(const matrix<E,A,B,L>& m)
+{
+    typedef typename matrix<E,A,B,L>::temporary_type temporary_type;
+    typedef typename temporary_type::value_type value_type;
+
+    /* Checking */
+    detail::CheckMatAffine3D(m);
+
+    value_type m00 = m.basis_element(0,0);
+    value_type m01 = m.basis_element(0,1);
+    value_type m02 = m.basis_element(0,2);
+    value_type m10 = m.basis_element(1,0);
+    value_type m11 = m.basis_element(1,1);
+    value_type m12 = m.basis_element(1,2);
+    value_type m20 = m.basis_element(2,0);
+    value_type m21 = m.basis_element(2,1);
+    value_type m22 = m.basis_element(2,2);
+
+    /* Cofactors of the first basis vector: */
+    value_type c00 = m11*m22 - m12*m21;
+    value_type c01 = m12*m20 - m10*m22;
+    value_type c02 = m10*m21 - m11*m20;
+
+    value_type D = value_type(1) / (m00*c00 + m01*c01 + m02*c02);
+
+    temporary_type Z;
+    et::detail::Resize(Z,m.rows(),m.cols());
+    Z.set_basis_element(0,0, c00*D);
+    Z.set_basis_element(0,1, (m02*m21 - m01*m22)*D);
+    Z.set_basis_element(0,2, (m01*m12 - m02*m11)*D);
+    Z.set_basis_element(1,0, c01*D);
+    Z.set_basis_element(1,1, (m00*m22 - m02*m20)*D);
+    Z.set_basis_element(1,2, (m02*m10 - m00*m12)*D);
+    Z.set_basis_element(2,0, c02*D);
+    Z.set_basis_element(2,1, (m01*m20 - m00*m21)*D);
+    Z.set_basis_element(2,2, (m00*m11 - m01*m10)*D);
+
+    detail::set_inverse_translation(Z,
+        m.basis_element(3,0), m.basis_element(3,1), m.basis_element(3,2));
+    detail::set_affine_homogeneous_part(Z);
+    return Z;
+}
+
+/** Invert a 3D transform, using the cheapest applicable method.
+ *
+ * If the homogeneous part of m is [0 0 0 1] (within tolerance), m is
+ * inverted by inverse_rigid() when its linear part is orthonormal, and by
+ * inverse_affine() otherwise.  Any other matrix is inverted by inverse().
+ *
+ * m must be a 4x4 matrix.
+ */
+template < typename E, class A, class B, class L >
+typename matrix<E,A,B,L>::temporary_type
+inverse_transform(
+    const matrix<E,A,B,L>& m, E tolerance = epsilon<E>::placeholder())
+{
+    typedef matrix<E,A,B,L> matrix_type;
+    typedef typename matrix_type::value_type value_type;
+
+    /* Checking */
+    detail::CheckMatHomogeneous3D(m);
+    detail::CheckMatSquare(m);
+
+    /* Check for a projective transform: */
+    if (std::fabs(m.basis_element(0,3)) > tolerance ||
+        std::fabs(m.basis_element(1,3)) > tolerance ||
+        std::fabs(m.basis_element(2,3)) > tolerance ||
+        std::fabs(m.basis_element(3,3) - value_type(1)) > tolerance)
+    {
+        return inverse(m);
+    }
+
+    /* Check for an orthonormal linear part: */
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = i; j < 3; ++j) {
+            value_type d =
+                m.basis_element(i,0) * m.basis_element(j,0) +
+                m.basis_element(i,1) * m.basis_element(j,1) +
+                m.basis_element(i,2) * m.basis_element(j,2);
+            if (std::fabs(d - value_type((i == j) ? 1 : 0)) > tolerance) {
+                return inverse_affine(m);
+            }
+        }
+    }
+    return inverse_rigid(m);
+}
+
 } // namespace cml
 
 #endif
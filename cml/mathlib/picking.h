@@ -13,7 +13,10 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #ifndef picking_h
 #define picking_h
 
+#include <cml/core/simd.h>
+#include <cml/soa_vector.h>
 #include <cml/mathlib/projection.h>
+#include <cml/mathlib/vector_transform.h>
 
 /* Functions for picking with rays, volumes, and drag-enclosed volumes. */
 
@@ -190,6 +193,220 @@ void make_pick_drag_volume(
     );
 }
 
+/* Batched pick rays
+ *
+ * pick_ray_generator<> makes the same rays as make_pick_ray() for many
+ * screen points.  The inverse of the concatenated view, projection and
+ * viewport matrices and the viewport depth range are computed once, when
+ * the generator is constructed (or are given directly), rather than for
+ * every ray.  The rays for a batch of points or a grid of pixels are
+ * written to separate x, y and z arrays, and are computed a SIMD packet at
+ * a time.
+ */
+
+namespace detail {
+
+/** Unprojection of screen points to pick rays, a packet at a time. */
+template<typename T> struct pick_ray_kernel
+{
+    typedef transform_kernel<T,transform_projective_point> kernel_type;
+    typedef typename kernel_type::pt pt;
+    typedef typename kernel_type::packet_type packet_type;
+    typedef simd::packet_traits<T,1> st;
+    enum { W = kernel_type::W };
+
+    kernel_type K;
+    T n, f;
+    bool normalize;
+
+    template<class MatT> pick_ray_kernel(
+            const MatT& inverse, T n_, T f_, bool normalize_)
+        : K(inverse), n(n_), f(f_), normalize(normalize_) {}
+
+    /** Store the rays through the W points (x,y) at k. */
+    void apply(const packet_type& x, const packet_type& y,
+            T* ox, T* oy, T* oz, T* dx, T* dy, T* dz, size_t k) const
+    {
+        packet_type px = x, py = y, pz = pt::set1(n);
+        K.apply(px, py, pz);
+        packet_type qx = x, qy = y, qz = pt::set1(f);
+        K.apply(qx, qy, qz);
+        qx = pt::sub(qx, px); qy = pt::sub(qy, py); qz = pt::sub(qz, pz);
+        if(normalize) {
+            packet_type s = pt::madd(qz, qz,
+                    pt::madd(qy, qy, pt::mul(qx, qx)));
+            s = simd::inv_sqrt<pt>(s);
+            qx = pt::mul(qx, s); qy = pt::mul(qy, s); qz = pt::mul(qz, s);
+        }
+        pt::storeu(ox+k, px); pt::storeu(oy+k, py); pt::storeu(oz+k, pz);
+        pt::storeu(dx+k, qx); pt::storeu(dy+k, qy); pt::storeu(dz+k, qz);
+    }
+
+    /** Store the ray through the point (x,y) at k. */
+    void apply(T x, T y,
+            T* ox, T* oy, T* oz, T* dx, T* dy, T* dz, size_t k) const
+    {
+        T px = x, py = y, pz = n;
+        K.apply(px, py, pz);
+        T qx = x, qy = y, qz = f;
+        K.apply(qx, qy, qz);
+        qx -= px; qy -= py; qz -= pz;
+        if(normalize) {
+            T s = inv_sqrt(qx*qx + qy*qy + qz*qz);
+            qx *= s; qy *= s; qz *= s;
+        }
+        ox[k] = px; oy[k] = py; oz[k] = pz;
+        dx[k] = qx; dy[k] = qy; dz[k] = qz;
+    }
+};
+
+} // namespace detail
+
+/** Pick rays from one view, projection and viewport. */
+template<typename Real>
+class pick_ray_generator
+{
+  public:
+
+    typedef Real value_type;
+    typedef vector< Real, fixed<3> > vector_type;
+    typedef matrix< Real, fixed<4,4>, col_basis, col_major > matrix_type;
+
+
+  public:
+
+    /** Construct from view, projection and viewport matrices. */
+    template < class MatT_1, class MatT_2, class MatT_3 >
+    pick_ray_generator(const MatT_1& view, const MatT_2& projection,
+            const MatT_3& viewport)
+    {
+        detail::depth_range_from_viewport_matrix(viewport, m_near, m_far);
+        set_inverse(inverse(detail::matrix_concat_transforms_4x4(view,
+                        detail::matrix_concat_transforms_4x4(
+                            projection, viewport))));
+    }
+
+    /** Construct from the inverse of the concatenated view, projection and
+     * viewport matrices, and the near and far depths of the viewport.
+     */
+    template < class MatT >
+    pick_ray_generator(const MatT& inverse, Real n, Real f)
+        : m_near(n), m_far(f)
+    {
+        set_inverse(inverse);
+    }
+
+    /** Return the inverse of the view, projection and viewport. */
+    const matrix_type& get_inverse() const { return m_inverse; }
+
+
+  public:
+
+    /** Make the pick ray through the screen point (x,y), as
+     * make_pick_ray().
+     */
+    template < typename E, class A > void
+    make_ray(Real x, Real y, vector<E,A>& origin, vector<E,A>& direction,
+            bool normalize = true) const
+    {
+        Real o[3], d[3];
+        make_kernel(normalize).apply(
+                x, y, o, o+1, o+2, d, d+1, d+2, 0);
+        origin.set(o[0], o[1], o[2]);
+        direction.set(d[0], d[1], d[2]);
+    }
+
+    /** Make the pick rays through the n screen points (x[i],y[i]). */
+    void make_rays(const Real* x, const Real* y,
+            Real* ox, Real* oy, Real* oz, Real* dx, Real* dy, Real* dz,
+            size_t n, bool normalize = true) const
+    {
+        typedef detail::pick_ray_kernel<Real> kernel_type;
+        typedef typename kernel_type::pt pt;
+        enum { W = kernel_type::W };
+
+        const kernel_type K(make_kernel(normalize));
+        size_t nw = n - n % W, k = 0;
+        for(; k < nw; k += W) {
+            K.apply(pt::loadu(x+k), pt::loadu(y+k),
+                    ox, oy, oz, dx, dy, dz, k);
+        }
+        for(; k < n; ++k) K.apply(x[k], y[k], ox, oy, oz, dx, dy, dz, k);
+    }
+
+    /** Make the pick rays through the n screen points (x[i],y[i]),
+     * resizing origins and directions to n.
+     */
+    template < class A > void
+    make_rays(const Real* x, const Real* y, soa_vector<Real,3,A>& origins,
+            soa_vector<Real,3,A>& directions, size_t n,
+            bool normalize = true) const
+    {
+        origins.resize(n);
+        directions.resize(n);
+        if(n == 0) return;
+        make_rays(x, y, origins.plane(0).data(), origins.plane(1).data(),
+                origins.plane(2).data(), directions.plane(0).data(),
+                directions.plane(1).data(), directions.plane(2).data(),
+                n, normalize);
+    }
+
+    /** Make the pick rays through a grid of width by height screen points.
+     *
+     * The ray through (x0 + i, y0 + j) is stored at j*width + i, so x0 and
+     * y0 are the first pixel center, e.g. viewport_x + .5.
+     */
+    void make_ray_grid(Real x0, Real y0, size_t width, size_t height,
+            Real* ox, Real* oy, Real* oz, Real* dx, Real* dy, Real* dz,
+            bool normalize = true) const
+    {
+        typedef detail::pick_ray_kernel<Real> kernel_type;
+        typedef typename kernel_type::pt pt;
+        typedef typename kernel_type::packet_type packet_type;
+        enum { W = kernel_type::W };
+
+        const kernel_type K(make_kernel(normalize));
+
+        /* The x offsets of the lanes of a packet: */
+        Real lanes[W];
+        for(int l = 0; l < W; ++l) lanes[l] = Real(l);
+        const packet_type step = pt::loadu(lanes);
+
+        size_t nw = width - width % W;
+        for(size_t j = 0, k = 0; j < height; ++j) {
+            Real y = y0 + Real(j);
+            packet_type py = pt::set1(y);
+            size_t i = 0;
+            for(; i < nw; i += W, k += W) {
+                K.apply(pt::add(pt::set1(x0 + Real(i)), step), py,
+                        ox, oy, oz, dx, dy, dz, k);
+            }
+            for(; i < width; ++i, ++k)
+                K.apply(x0 + Real(i), y, ox, oy, oz, dx, dy, dz, k);
+        }
+    }
+
+
+  protected:
+
+    template < class MatT > void set_inverse(const MatT& m) {
+        for(int i = 0; i < 4; ++ i)
+            for(int j = 0; j < 4; ++ j)
+                m_inverse.set_basis_element(i, j, m.basis_element(i,j));
+    }
+
+    detail::pick_ray_kernel<Real> make_kernel(bool normalize) const {
+        return detail::pick_ray_kernel<Real>(
+                m_inverse, m_near, m_far, normalize);
+    }
+
+
+  protected:
+
+    matrix_type m_inverse;
+    Real m_near, m_far;
+};
+
 } // namespace cml
 
 #endif
@@ -13,6 +13,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #ifndef quaternion_rotation_h
 #define quaternion_rotation_h
 
+#include <cml/core/simd.h>
 #include <cml/mathlib/checking.h>
 
 /* Functions related to quaternion rotations.
@@ -630,6 +631,166 @@ quaternion_to_euler(
     matrix_to_euler(m, angle_0, angle_1, angle_2, order, tolerance);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Rotation of vectors by a quaternion
+//////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+/** Rotate the vectors (vx,vy,vz) by the quaternions (w,x,y,z).
+ *
+ * Each vector is rotated as v + w*t + (q x t) with t = 2*(q x v), which
+ * takes 15 multiplies and 12 adds.  PT is a packet type of T, and every
+ * lane holds a separate vector and quaternion.
+ */
+template<class PT> inline void
+quaternion_rotate_packets(const typename PT::packet_type& w,
+        const typename PT::packet_type& x, const typename PT::packet_type& y,
+        const typename PT::packet_type& z, typename PT::packet_type& vx,
+        typename PT::packet_type& vy, typename PT::packet_type& vz)
+{
+    typedef typename PT::packet_type packet_type;
+
+    /* t = 2*(q x v): */
+    packet_type tx = PT::sub(PT::mul(y,vz), PT::mul(z,vy));
+    packet_type ty = PT::sub(PT::mul(z,vx), PT::mul(x,vz));
+    packet_type tz = PT::sub(PT::mul(x,vy), PT::mul(y,vx));
+    tx = PT::add(tx,tx); ty = PT::add(ty,ty); tz = PT::add(tz,tz);
+
+    /* v + w*t + q x t: */
+    vx = PT::add(PT::madd(w,tx,vx), PT::sub(PT::mul(y,tz), PT::mul(z,ty)));
+    vy = PT::add(PT::madd(w,ty,vy), PT::sub(PT::mul(z,tx), PT::mul(x,tz)));
+    vz = PT::add(PT::madd(w,tz,vz), PT::sub(PT::mul(x,ty), PT::mul(y,tx)));
+}
+
+/** Rotation of vectors by a fixed quaternion. */
+template<typename T> struct quaternion_rotation_kernel
+{
+    quaternion_rotation_kernel(T qw, T qx, T qy, T qz)
+        : w(qw), x(qx), y(qy), z(qz) {}
+
+    /** Rotate the vectors in the lanes of vx, vy and vz. */
+    template<class PT> void apply(typename PT::packet_type& vx,
+            typename PT::packet_type& vy, typename PT::packet_type& vz) const
+    {
+        quaternion_rotate_packets<PT>(PT::set1(w), PT::set1(x),
+                PT::set1(y), PT::set1(z), vx, vy, vz);
+    }
+
+    T w, x, y, z;
+};
+
+/** Return the rotation kernel for quaternion q. */
+template<class QuatT>
+quaternion_rotation_kernel<typename QuatT::value_type>
+make_quaternion_rotation_kernel(const QuatT& q)
+{
+    typedef typename QuatT::order_type order_type;
+    typedef quaternion_rotation_kernel<typename QuatT::value_type> kernel;
+
+    enum {
+        W = order_type::W,
+        X = order_type::X,
+        Y = order_type::Y,
+        Z = order_type::Z
+    };
+
+    return kernel(q[W], q[X], q[Y], q[Z]);
+}
+
+/** Rotate n interleaved 3D vectors, a SIMD packet at a time. */
+template<typename T> void
+quaternion_rotate_aos(const quaternion_rotation_kernel<T>& kernel,
+        const T* in, T* out, size_t n)
+{
+    enum { W = simd::native_width<T>::value };
+    typedef simd::packet_traits<T,W> pt;
+    typedef simd::packet_traits<T,1> st;
+    typedef typename pt::packet_type packet_type;
+    typedef typename st::packet_type scalar_type;
+
+    /* A local copy, so the coefficients can stay in registers while the
+     * output is written:
+     */
+    const quaternion_rotation_kernel<T> K(kernel);
+
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W) {
+        packet_type vx, vy, vz;
+        pt::load3(in+3*k, vx, vy, vz);
+        K.template apply<pt>(vx, vy, vz);
+        pt::store3(out+3*k, vx, vy, vz);
+    }
+    for(; k < n; ++k) {
+        scalar_type vx, vy, vz;
+        st::load3(in+3*k, vx, vy, vz);
+        K.template apply<st>(vx, vy, vz);
+        st::store3(out+3*k, vx, vy, vz);
+    }
+}
+
+} // namespace detail
+
+/** Rotate a 3D vector by a unit quaternion.
+ *
+ * The result is the same as transforming v by the matrix built by
+ * matrix_rotation_quaternion(), but it is computed directly as
+ * v + 2w(q x v) + 2q x (q x v), without forming the matrix or the
+ * products q*v*conjugate(q).
+ */
+template < class QuatT, class VecT >
+vector< typename QuatT::value_type, fixed<3> >
+quaternion_rotate_vector(const QuatT& q, const VecT& v)
+{
+    typedef QuatT quaternion_type;
+    typedef typename quaternion_type::value_type value_type;
+    typedef typename quaternion_type::order_type order_type;
+    typedef vector< value_type, fixed<3> > vector_type;
+
+    enum {
+        W = order_type::W,
+        X = order_type::X,
+        Y = order_type::Y,
+        Z = order_type::Z
+    };
+
+    /* Checking */
+    detail::CheckQuat(q);
+    detail::CheckVec3(v);
+
+    value_type w = q[W], x = q[X], y = q[Y], z = q[Z];
+
+    /* t = 2*(q x v): */
+    value_type tx = value_type(2) * (y * v[2] - z * v[1]);
+    value_type ty = value_type(2) * (z * v[0] - x * v[2]);
+    value_type tz = value_type(2) * (x * v[1] - y * v[0]);
+
+    /* v + w*t + q x t: */
+    return vector_type(
+        v[0] + w * tx + (y * tz - z * ty),
+        v[1] + w * ty + (z * tx - x * tz),
+        v[2] + w * tz + (x * ty - y * tx));
+}
+
+/** Rotate n interleaved 3D vectors by a unit quaternion. */
+template < class QuatT, typename E > void
+quaternion_rotate_vectors(const QuatT& q, const E* in, E* out, size_t n)
+{
+    detail::CheckQuat(q);
+    detail::quaternion_rotate_aos(
+            detail::make_quaternion_rotation_kernel(q), in, out, n);
+}
+
+/** Rotate n 3D vectors by a unit quaternion. */
+template < class QuatT, typename E > void
+quaternion_rotate_vectors(const QuatT& q,
+        const vector< E, fixed<3> >* in, vector< E, fixed<3> >* out, size_t n)
+{
+    /* The vectors must be packed without padding: */
+    CML_STATIC_REQUIRE(sizeof(vector< E, fixed<3> >) == 3*sizeof(E));
+    if(n > 0) quaternion_rotate_vectors(q, in->data(), out->data(), n);
+}
+
 } // namespace cml
 
 #endif
@@ -0,0 +1,340 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Bulk random unit vectors and rotations.
+ *
+ * random_unit_vectors(), random_cone_vectors() and random_rotations() fill
+ * arrays with uniformly distributed samples from an engine (see
+ * cml/random.h), a SIMD packet at a time.  The engine itself is scalar, so
+ * a packet of uniform values is drawn into a buffer and loaded; the square
+ * roots, sines and cosines are then computed on the packets, the circle by
+ * polynomials rather than by calls to std::sin() and std::cos().
+ *
+ * Points on the sphere are a uniform angle about z and a uniform z
+ * (Archimedes' theorem), and points in a cone are the same with z limited
+ * to [cos(theta),1].  Rotations are Shoemake's uniform quaternions.
+ */
+
+#ifndef random_sampling_h
+#define random_sampling_h
+
+#include <cmath>
+#include <cml/core/simd.h>
+#include <cml/soa_vector.h>
+#include <cml/random.h>
+#include <cml/mathlib/misc.h>
+
+namespace cml {
+namespace detail {
+
+/** Return a packet of uniform values in [0,1) from the engine g. */
+template<class PT, class Engine> inline typename PT::packet_type
+random_uniform_packet(Engine& g)
+{
+    typedef typename PT::value_type T;
+    T buf[PT::size];
+    for(int l = 0; l < PT::size; ++l) buf[l] = random_uniform<T>(g);
+    return PT::loadu(buf);
+}
+
+/** The number of polynomial terms giving sin and cos of angles in
+ * [-pi/2,pi/2] to the precision of T.
+ */
+template<typename T> struct random_circle_terms
+{
+    enum { sin_terms = 11, cos_terms = 12 };
+};
+
+template<> struct random_circle_terms<float>
+{
+    enum { sin_terms = 6, cos_terms = 7 };
+};
+
+/** Return the cosine and sine of the uniform angles 2*pi*u - pi.
+ *
+ * The angles are twice those in [-pi/2,pi/2), where the Taylor series
+ * converge quickly, and the double-angle formulas give the result.
+ */
+template<class PT> inline void
+random_circle(const typename PT::packet_type& u,
+        typename PT::packet_type& c, typename PT::packet_type& s)
+{
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+    typedef random_circle_terms<T> terms;
+
+    /* 1/(2k+1)! and 1/(2k)!, with alternating signs: */
+    static const double sin_c[] = {
+        1., -1./6., 1./120., -1./5040., 1./362880., -1./39916800.,
+        1./6227020800., -1./1307674368000., 1./355687428096000.,
+        -1./121645100408832000., 1./51090942171709440000. };
+    static const double cos_c[] = {
+        1., -1./2., 1./24., -1./720., 1./40320., -1./3628800.,
+        1./479001600., -1./87178291200., 1./20922789888000.,
+        -1./6402373705728000., 1./2432902008176640000.,
+        -1./1124000727777607680000. };
+
+    const double pi = constants<double>::pi();
+    packet_type x = PT::sub(PT::mul(PT::set1(T(pi)), u),
+            PT::set1(T(.5*pi)));
+    packet_type x2 = PT::mul(x,x);
+
+    packet_type ps = PT::set1(T(sin_c[terms::sin_terms-1]));
+    for(int k = terms::sin_terms-2; k >= 0; --k)
+        ps = PT::madd(ps, x2, PT::set1(T(sin_c[k])));
+    ps = PT::mul(ps, x);
+    packet_type pc = PT::set1(T(cos_c[terms::cos_terms-1]));
+    for(int k = terms::cos_terms-2; k >= 0; --k)
+        pc = PT::madd(pc, x2, PT::set1(T(cos_c[k])));
+
+    c = PT::sub(PT::mul(pc,pc), PT::mul(ps,ps));
+    s = PT::mul(PT::set1(T(2)), PT::mul(ps,pc));
+}
+
+/** Uniform unit vectors in the cap z >= 1 - h of the unit sphere, rotated
+ * into the frame (e1,e2,axis).
+ */
+template<class PT> struct random_cap_kernel
+{
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+
+    packet_type h, zero, one, e[3][3];
+    bool rotate;
+
+    template<class Engine> void
+    apply(Engine& g, packet_type& x, packet_type& y, packet_type& z) const
+    {
+        packet_type c, s;
+        random_circle<PT>(random_uniform_packet<PT>(g), c, s);
+        packet_type w = PT::sub(one,
+                PT::mul(h, random_uniform_packet<PT>(g)));
+        packet_type r = PT::sqrt(PT::maximum(
+                    PT::sub(one, PT::mul(w,w)), zero));
+        x = PT::mul(r,c); y = PT::mul(r,s); z = w;
+        if(rotate) {
+            packet_type px = x, py = y, pz = z;
+            x = PT::madd(pz, e[2][0], PT::madd(py, e[1][0],
+                        PT::mul(px, e[0][0])));
+            y = PT::madd(pz, e[2][1], PT::madd(py, e[1][1],
+                        PT::mul(px, e[0][1])));
+            z = PT::madd(pz, e[2][2], PT::madd(py, e[1][2],
+                        PT::mul(px, e[0][2])));
+        }
+    }
+
+    void set(T h_, const T (*basis)[3]) {
+        h = PT::set1(h_);
+        zero = PT::set1(T(0));
+        one = PT::set1(T(1));
+        rotate = (basis != 0);
+        for(int i = 0; i < 3; ++i)
+            for(int j = 0; j < 3; ++j)
+                e[i][j] = PT::set1(basis ? basis[i][j] : T(i == j));
+    }
+};
+
+/** Fill the arrays x, y and z with n vectors from the cap z >= 1 - h,
+ * rotated by the rows of basis if it is not null.
+ */
+template<typename T, class Engine> void
+random_cap(T h, const T (*basis)[3], T* x, T* y, T* z, size_t n,
+        Engine& g)
+{
+    enum { W = simd::native_width<T>::value };
+    typedef simd::packet_traits<T,W> pt;
+    typedef simd::packet_traits<T,1> st;
+
+    random_cap_kernel<pt> K;
+    random_cap_kernel<st> S;
+    K.set(h, basis);
+    S.set(h, basis);
+
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W) {
+        typename pt::packet_type px, py, pz;
+        K.apply(g, px, py, pz);
+        pt::storeu(x+k, px); pt::storeu(y+k, py); pt::storeu(z+k, pz);
+    }
+    for(; k < n; ++k) {
+        typename st::packet_type px, py, pz;
+        S.apply(g, px, py, pz);
+        st::storeu(x+k, px); st::storeu(y+k, py); st::storeu(z+k, pz);
+    }
+}
+
+/** Fill p with n interleaved vectors from the cap z >= 1 - h, rotated by
+ * the rows of basis if it is not null.
+ */
+template<typename T, class Engine> void
+random_cap(T h, const T (*basis)[3], T* p, size_t n, Engine& g)
+{
+    enum { W = simd::native_width<T>::value };
+    typedef simd::packet_traits<T,W> pt;
+    typedef simd::packet_traits<T,1> st;
+
+    random_cap_kernel<pt> K;
+    random_cap_kernel<st> S;
+    K.set(h, basis);
+    S.set(h, basis);
+
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W) {
+        typename pt::packet_type px, py, pz;
+        K.apply(g, px, py, pz);
+        pt::store3(p+3*k, px, py, pz);
+    }
+    for(; k < n; ++k) {
+        typename st::packet_type px, py, pz;
+        S.apply(g, px, py, pz);
+        st::store3(p+3*k, px, py, pz);
+    }
+}
+
+/** Compute the frame (e1,e2,axis) for cones about the unit-length axis. */
+template<typename T, class VecT> void
+random_cone_basis(const VecT& axis, T basis[3][3])
+{
+    typedef vector< T, fixed<3> > vector_type;
+    vector_type a, e1;
+    a.set(T(axis[0]), T(axis[1]), T(axis[2]));
+    e1 = axis_3D(cml::index_of_min_abs(a[0],a[1],a[2]));
+    e1 = normalize(cross(e1,a));
+    vector_type e2 = cross(a,e1);
+    for(int j = 0; j < 3; ++j) {
+        basis[0][j] = e1[j]; basis[1][j] = e2[j]; basis[2][j] = a[j];
+    }
+}
+
+/** Shoemake's uniform unit quaternions, stored in the order OT. */
+template<class PT, class OT> struct random_rotation_kernel
+{
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+
+    packet_type zero, one;
+
+    random_rotation_kernel()
+        : zero(PT::set1(T(0))), one(PT::set1(T(1))) {}
+
+    template<class Engine> void apply(Engine& g, T* p) const
+    {
+        packet_type u = random_uniform_packet<PT>(g);
+        packet_type a = PT::sqrt(PT::maximum(PT::sub(one, u), zero));
+        packet_type b = PT::sqrt(u);
+        packet_type c2, s2, c3, s3;
+        random_circle<PT>(random_uniform_packet<PT>(g), c2, s2);
+        random_circle<PT>(random_uniform_packet<PT>(g), c3, s3);
+
+        packet_type q[4];
+        q[OT::W] = PT::mul(b,c3);
+        q[OT::X] = PT::mul(a,s2);
+        q[OT::Y] = PT::mul(a,c2);
+        q[OT::Z] = PT::mul(b,s3);
+        PT::store4(p, q[0], q[1], q[2], q[3]);
+    }
+};
+
+} // namespace detail
+
+/** Fill the arrays x, y and z with n random unit vectors from the engine
+ * g (see cml/mathlib/random_sampling.h).
+ */
+template<typename E, class Engine> void
+random_unit_vectors(E* x, E* y, E* z, size_t n, Engine& g)
+{
+    detail::random_cap(E(2), (const E (*)[3]) 0, x, y, z, n, g);
+}
+
+/** Fill p with n random unit vectors from the engine g. */
+template<typename E, class Engine> void
+random_unit_vectors(vector< E, fixed<3> >* p, size_t n, Engine& g)
+{
+    CML_STATIC_REQUIRE(sizeof(vector< E, fixed<3> >) == 3*sizeof(E));
+    if(n == 0) return;
+    detail::random_cap(E(2), (const E (*)[3]) 0,
+            reinterpret_cast<E*>(p), n, g);
+}
+
+/** Fill v with its size() random unit vectors from the engine g. */
+template<typename E, class A, class Engine> void
+random_unit_vectors(soa_vector<E,3,A>& v, Engine& g)
+{
+    size_t n = v.size();
+    if(n == 0) return;
+    random_unit_vectors(v.plane(0).data(), v.plane(1).data(),
+            v.plane(2).data(), n, g);
+}
+
+/** Fill the arrays x, y and z with n random unit vectors within the angle
+ * theta of the unit-length axis, from the engine g.
+ */
+template<class VecT, typename E, class Engine> void
+random_cone_vectors(const VecT& axis, E theta, E* x, E* y, E* z,
+        size_t n, Engine& g)
+{
+    E basis[3][3];
+    detail::random_cone_basis(axis, basis);
+    detail::random_cap(E(1) - E(std::cos(theta)), basis, x, y, z, n, g);
+}
+
+/** Fill p with n random unit vectors within the angle theta of the
+ * unit-length axis, from the engine g.
+ */
+template<class VecT, typename E, class Engine> void
+random_cone_vectors(const VecT& axis, E theta, vector< E, fixed<3> >* p,
+        size_t n, Engine& g)
+{
+    CML_STATIC_REQUIRE(sizeof(vector< E, fixed<3> >) == 3*sizeof(E));
+    if(n == 0) return;
+    E basis[3][3];
+    detail::random_cone_basis(axis, basis);
+    detail::random_cap(E(1) - E(std::cos(theta)), basis,
+            reinterpret_cast<E*>(p), n, g);
+}
+
+/** Fill v with its size() random unit vectors within the angle theta of
+ * the unit-length axis, from the engine g.
+ */
+template<class VecT, typename E, class A, class Engine> void
+random_cone_vectors(const VecT& axis, E theta, soa_vector<E,3,A>& v,
+        Engine& g)
+{
+    size_t n = v.size();
+    if(n == 0) return;
+    random_cone_vectors(axis, theta, v.plane(0).data(), v.plane(1).data(),
+            v.plane(2).data(), n, g);
+}
+
+/** Fill q with n uniformly distributed random rotations from the engine
+ * g.
+ */
+template<typename E, class OT, class CT, class Engine> void
+random_rotations(quaternion< E, fixed<>, OT, CT >* q, size_t n, Engine& g)
+{
+    CML_STATIC_REQUIRE(
+            sizeof(quaternion< E, fixed<>, OT, CT >) == 4*sizeof(E));
+    enum { W = simd::native_width<E>::value };
+    typedef simd::packet_traits<E,W> pt;
+    typedef simd::packet_traits<E,1> st;
+
+    const detail::random_rotation_kernel<pt,OT> K;
+    const detail::random_rotation_kernel<st,OT> S;
+    E* p = reinterpret_cast<E*>(q);
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W) K.apply(g, p+4*k);
+    for(; k < n; ++k) S.apply(g, p+4*k);
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
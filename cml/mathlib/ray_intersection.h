@@ -0,0 +1,351 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Nearest intersection of a ray with many primitives.
+ *
+ * intersect_ray_spheres(), intersect_ray_boxes() and
+ * intersect_ray_triangles() find the nearest intersection of one ray with
+ * n spheres, axis-aligned boxes or triangles held in separate x, y and z
+ * arrays (or soa_vector<>s).  The ray is broadcast, and a SIMD packet of
+ * primitives is tested at a time; the lanes that hit closer than the
+ * nearest hit so far are rare, and are resolved with scalar code.
+ *
+ * The ray is origin + t*direction, and need not be normalized.  On input,
+ * t is the largest distance to accept, so a search can be continued over
+ * several batches of primitives; on return it is the distance of the
+ * nearest hit, and index is the index of the primitive hit.  The functions
+ * return false, leaving index and t unchanged, if there is no hit at
+ * distances in [0,t).
+ *
+ * A ray starting inside a sphere hits it on the way out, and a ray
+ * starting inside a box hits it at t = 0.  Triangles are hit from either
+ * side, by the Moller-Trumbore test.
+ */
+
+#ifndef ray_intersection_h
+#define ray_intersection_h
+
+#include <limits>
+#include <cml/core/simd.h>
+#include <cml/soa_vector.h>
+
+namespace cml {
+namespace detail {
+
+/** The ray origin and direction, broadcast to packets. */
+template<class PT> struct ray_packet
+{
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+
+    packet_type o[3], d[3], id[3], zero, one;
+
+    template<class VecT1, class VecT2>
+    ray_packet(const VecT1& origin, const VecT2& direction) {
+        for(int i = 0; i < 3; ++i) {
+            o[i] = PT::set1(T(origin[i]));
+            d[i] = PT::set1(T(direction[i]));
+            id[i] = PT::set1(T(1)/T(direction[i]));
+        }
+        zero = PT::set1(T(0));
+        one = PT::set1(T(1));
+    }
+};
+
+/** Record the lanes of hits that are closer than t.
+ *
+ * Returns true if one of the lanes set in hits (with distances th) is
+ * closer than t.
+ */
+template<class PT> inline bool
+ray_nearest_hit(int hits, const typename PT::packet_type& th, size_t k,
+        size_t& index, typename PT::value_type& t)
+{
+    typedef typename PT::value_type T;
+    if(hits == 0) return false;
+
+    T buf[PT::size];
+    PT::storeu(buf, th);
+    bool hit = false;
+    for(int l = 0; l < PT::size; ++l) {
+        if((hits & (1 << l)) && buf[l] < t) {
+            t = buf[l];
+            index = k + l;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+/** A packet of spheres with centers (x,y,z) and radii r. */
+template<class PT> struct ray_spheres
+{
+    typedef PT pt;
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+    enum { all = (1 << PT::size) - 1 };
+
+    const T *x, *y, *z, *r;
+
+    bool test(const ray_packet<PT>& R, size_t k, size_t& index, T& t) const
+    {
+        /* Solve |o + t*d - center|^2 = r^2, i.e. a*t^2 + 2*b*t + c = 0: */
+        packet_type px = PT::sub(R.o[0], PT::loadu(x+k));
+        packet_type py = PT::sub(R.o[1], PT::loadu(y+k));
+        packet_type pz = PT::sub(R.o[2], PT::loadu(z+k));
+        packet_type rr = PT::loadu(r+k);
+        packet_type a = PT::madd(R.d[2], R.d[2],
+                PT::madd(R.d[1], R.d[1], PT::mul(R.d[0], R.d[0])));
+        packet_type b = PT::madd(pz, R.d[2],
+                PT::madd(py, R.d[1], PT::mul(px, R.d[0])));
+        packet_type c = PT::sub(PT::madd(pz, pz,
+                    PT::madd(py, py, PT::mul(px, px))), PT::mul(rr, rr));
+        packet_type disc = PT::sub(PT::mul(b, b), PT::mul(a, c));
+
+        /* Lanes that miss, or where the sphere is behind the origin: */
+        int miss = PT::negative_mask(disc)
+            | (~PT::negative_mask(c) & ~PT::negative_mask(b));
+        if(miss == all) return false;
+
+        /* The near root, or the far root for origins inside (c < 0): */
+        packet_type q = PT::sqrt(PT::maximum(disc, R.zero));
+        packet_type t0 = PT::div(PT::neg(PT::add(b, q)), a);
+        packet_type t1 = PT::div(PT::sub(q, b), a);
+        packet_type w = PT::mul(PT::set1(T(.5)),
+                PT::sub(R.one, PT::sign(c)));
+        packet_type th = PT::madd(w, PT::sub(t1, t0), t0);
+        return ray_nearest_hit<PT>(~miss & all, th, k, index, t);
+    }
+};
+
+/** A packet of axis-aligned boxes between (x0,y0,z0) and (x1,y1,z1). */
+template<class PT> struct ray_boxes
+{
+    typedef PT pt;
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+    enum { all = (1 << PT::size) - 1 };
+
+    const T *x0, *y0, *z0, *x1, *y1, *z1;
+
+    bool test(const ray_packet<PT>& R, size_t k, size_t& index, T& t) const
+    {
+        /* Intersect the slabs: */
+        packet_type a = PT::mul(PT::sub(PT::loadu(x0+k), R.o[0]), R.id[0]);
+        packet_type b = PT::mul(PT::sub(PT::loadu(x1+k), R.o[0]), R.id[0]);
+        packet_type tn = PT::minimum(a,b), tf = PT::maximum(a,b);
+        a = PT::mul(PT::sub(PT::loadu(y0+k), R.o[1]), R.id[1]);
+        b = PT::mul(PT::sub(PT::loadu(y1+k), R.o[1]), R.id[1]);
+        tn = PT::maximum(tn, PT::minimum(a,b));
+        tf = PT::minimum(tf, PT::maximum(a,b));
+        a = PT::mul(PT::sub(PT::loadu(z0+k), R.o[2]), R.id[2]);
+        b = PT::mul(PT::sub(PT::loadu(z1+k), R.o[2]), R.id[2]);
+        tn = PT::maximum(tn, PT::minimum(a,b));
+        tf = PT::minimum(tf, PT::maximum(a,b));
+
+        /* Hits are the lanes with max(tn,0) <= tf: */
+        tn = PT::maximum(tn, R.zero);
+        int hits = ~PT::negative_mask(PT::sub(tf, tn)) & all;
+        return ray_nearest_hit<PT>(hits, tn, k, index, t);
+    }
+};
+
+/** A packet of triangles with vertices p0, p1 and p2. */
+template<class PT> struct ray_triangles
+{
+    typedef PT pt;
+    typedef typename PT::value_type T;
+    typedef typename PT::packet_type packet_type;
+    enum { all = (1 << PT::size) - 1 };
+
+    const T* p0[3];
+    const T* p1[3];
+    const T* p2[3];
+
+    bool test(const ray_packet<PT>& R, size_t k, size_t& index, T& t) const
+    {
+        packet_type v0[3], e1[3], e2[3], p[3], s[3], q[3];
+        for(int i = 0; i < 3; ++i) {
+            v0[i] = PT::loadu(p0[i]+k);
+            e1[i] = PT::sub(PT::loadu(p1[i]+k), v0[i]);
+            e2[i] = PT::sub(PT::loadu(p2[i]+k), v0[i]);
+            s[i] = PT::sub(R.o[i], v0[i]);
+        }
+
+        /* p = d x e2, and the determinant e1.p: */
+        p[0] = PT::sub(PT::mul(R.d[1], e2[2]), PT::mul(R.d[2], e2[1]));
+        p[1] = PT::sub(PT::mul(R.d[2], e2[0]), PT::mul(R.d[0], e2[2]));
+        p[2] = PT::sub(PT::mul(R.d[0], e2[1]), PT::mul(R.d[1], e2[0]));
+        packet_type det = PT::madd(e1[2], p[2],
+                PT::madd(e1[1], p[1], PT::mul(e1[0], p[0])));
+        packet_type inv = PT::div(R.one, det);
+
+        /* The barycentric coordinates u and v: */
+        packet_type u = PT::mul(inv, PT::madd(s[2], p[2],
+                    PT::madd(s[1], p[1], PT::mul(s[0], p[0]))));
+        q[0] = PT::sub(PT::mul(s[1], e1[2]), PT::mul(s[2], e1[1]));
+        q[1] = PT::sub(PT::mul(s[2], e1[0]), PT::mul(s[0], e1[2]));
+        q[2] = PT::sub(PT::mul(s[0], e1[1]), PT::mul(s[1], e1[0]));
+        packet_type v = PT::mul(inv, PT::madd(R.d[2], q[2],
+                    PT::madd(R.d[1], q[1], PT::mul(R.d[0], q[0]))));
+        packet_type th = PT::mul(inv, PT::madd(e2[2], q[2],
+                    PT::madd(e2[1], q[1], PT::mul(e2[0], q[0]))));
+
+        /* Misses, including degenerate triangles and rays parallel to the
+         * triangle:
+         */
+        int miss = PT::negative_mask(u) | PT::negative_mask(v)
+            | PT::negative_mask(PT::sub(R.one, PT::add(u,v)))
+            | PT::negative_mask(th)
+            | PT::negative_mask(PT::sub(PT::mul(det,det),
+                        PT::set1(std::numeric_limits<T>::min())));
+        return ray_nearest_hit<PT>(~miss & all, th, k, index, t);
+    }
+};
+
+/** Find the nearest of n primitives hit by the ray, a SIMD packet at a
+ * time.
+ *
+ * v and s are the packet and scalar views of the primitives.
+ */
+template<class PacketT, class ScalarT, class VecT1, class VecT2> bool
+intersect_ray(const VecT1& origin, const VecT2& direction,
+        const PacketT& v, const ScalarT& s, size_t n, size_t& index,
+        typename PacketT::T& t)
+{
+    typedef typename PacketT::pt pt;
+    typedef typename ScalarT::pt st;
+    enum { W = pt::size };
+
+    const ray_packet<pt> R(origin, direction);
+    const ray_packet<st> S(origin, direction);
+
+    bool hit = false;
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W) hit |= v.test(R, k, index, t);
+    for(; k < n; ++k) hit |= s.test(S, k, index, t);
+    return hit;
+}
+
+} // namespace detail
+
+/** Find the nearest of the n spheres with centers (x[i],y[i],z[i]) and
+ * radii r[i] hit by the ray (see cml/mathlib/ray_intersection.h).
+ */
+template<class VecT1, class VecT2, typename E> bool
+intersect_ray_spheres(const VecT1& origin, const VecT2& direction,
+        const E* x, const E* y, const E* z, const E* r, size_t n,
+        size_t& index, E& t)
+{
+    enum { W = simd::native_width<E>::value };
+    detail::ray_spheres< simd::packet_traits<E,W> > v;
+    detail::ray_spheres< simd::packet_traits<E,1> > s;
+    v.x = s.x = x; v.y = s.y = y; v.z = s.z = z; v.r = s.r = r;
+    return detail::intersect_ray(origin, direction, v, s, n, index, t);
+}
+
+/** Find the nearest of the spheres with the given centers and radii hit
+ * by the ray.
+ */
+template<class VecT1, class VecT2, typename E, class A> bool
+intersect_ray_spheres(const VecT1& origin, const VecT2& direction,
+        const soa_vector<E,3,A>& centers,
+        const vector< E, dynamic<A> >& radii, size_t& index, E& t)
+{
+    size_t n = centers.size();
+    if(n == 0) return false;
+    return intersect_ray_spheres(origin, direction, centers.plane(0).data(),
+            centers.plane(1).data(), centers.plane(2).data(), radii.data(),
+            n, index, t);
+}
+
+/** Find the nearest of the n axis-aligned boxes between
+ * (x0[i],y0[i],z0[i]) and (x1[i],y1[i],z1[i]) hit by the ray (see
+ * cml/mathlib/ray_intersection.h).
+ *
+ * @note The slab test divides by the components of the direction, and
+ * may miss boxes with a face in the plane of the origin that the ray is
+ * parallel to.
+ */
+template<class VecT1, class VecT2, typename E> bool
+intersect_ray_boxes(const VecT1& origin, const VecT2& direction,
+        const E* x0, const E* y0, const E* z0,
+        const E* x1, const E* y1, const E* z1, size_t n,
+        size_t& index, E& t)
+{
+    enum { W = simd::native_width<E>::value };
+    detail::ray_boxes< simd::packet_traits<E,W> > v;
+    detail::ray_boxes< simd::packet_traits<E,1> > s;
+    v.x0 = s.x0 = x0; v.y0 = s.y0 = y0; v.z0 = s.z0 = z0;
+    v.x1 = s.x1 = x1; v.y1 = s.y1 = y1; v.z1 = s.z1 = z1;
+    return detail::intersect_ray(origin, direction, v, s, n, index, t);
+}
+
+/** Find the nearest of the axis-aligned boxes between min and max hit by
+ * the ray.
+ */
+template<class VecT1, class VecT2, typename E, class A> bool
+intersect_ray_boxes(const VecT1& origin, const VecT2& direction,
+        const soa_vector<E,3,A>& min, const soa_vector<E,3,A>& max,
+        size_t& index, E& t)
+{
+    size_t n = min.size();
+    if(n == 0) return false;
+    return intersect_ray_boxes(origin, direction, min.plane(0).data(),
+            min.plane(1).data(), min.plane(2).data(), max.plane(0).data(),
+            max.plane(1).data(), max.plane(2).data(), n, index, t);
+}
+
+/** Find the nearest of the n triangles with vertices p0, p1 and p2 hit by
+ * the ray (see cml/mathlib/ray_intersection.h).
+ *
+ * p0[j], p1[j] and p2[j] point to the arrays of component j of each
+ * vertex.
+ */
+template<class VecT1, class VecT2, typename E> bool
+intersect_ray_triangles(const VecT1& origin, const VecT2& direction,
+        const E* const p0[3], const E* const p1[3], const E* const p2[3],
+        size_t n, size_t& index, E& t)
+{
+    enum { W = simd::native_width<E>::value };
+    detail::ray_triangles< simd::packet_traits<E,W> > v;
+    detail::ray_triangles< simd::packet_traits<E,1> > s;
+    for(int j = 0; j < 3; ++j) {
+        v.p0[j] = s.p0[j] = p0[j];
+        v.p1[j] = s.p1[j] = p1[j];
+        v.p2[j] = s.p2[j] = p2[j];
+    }
+    return detail::intersect_ray(origin, direction, v, s, n, index, t);
+}
+
+/** Find the nearest of the triangles with vertices p0, p1 and p2 hit by
+ * the ray.
+ */
+template<class VecT1, class VecT2, typename E, class A> bool
+intersect_ray_triangles(const VecT1& origin, const VecT2& direction,
+        const soa_vector<E,3,A>& p0, const soa_vector<E,3,A>& p1,
+        const soa_vector<E,3,A>& p2, size_t& index, E& t)
+{
+    size_t n = p0.size();
+    if(n == 0) return false;
+    const E* a[3] = { p0.plane(0).data(), p0.plane(1).data(),
+        p0.plane(2).data() };
+    const E* b[3] = { p1.plane(0).data(), p1.plane(1).data(),
+        p1.plane(2).data() };
+    const E* c[3] = { p2.plane(0).data(), p2.plane(1).data(),
+        p2.plane(2).data() };
+    return intersect_ray_triangles(origin, direction, a, b, c, n, index, t);
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
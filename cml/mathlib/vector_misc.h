@@ -14,6 +14,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define vector_misc_h
 
 #include <cml/mathlib/coord_conversion.h>
+#include <cml/mathlib/misc.h>
 
 /* Miscellaneous vector functions. */
 
@@ -150,27 +151,31 @@ rotate_vector_2D(const VecT& v, Real angle)
     return result_type(c * v[0] - s * v[1], s * v[0] + c * v[1]);
 }
 
-/** Random unit 3D or 2D vector
- *
- * @todo: This is just placeholder code for what will be a more thorough
- * 'random unit' implementation:
- *
- * - All dimensions will be handled uniformly if practical, perhaps through
- *   a normal distrubution PRNG.
- *
- * - Failing that (or perhaps even in this case), dimensions 2 and 3 will be
- *   dispatched to special-case code, most likely implementing the algorithms
- *   below.
- *
- * - Like the utility random functions, the option of using one's own PRGN
- *   will be made available.
- *
- * @todo: Once N-d random vectors are supported, add a 'random unit
- * quaternion' function that wraps a call to random_unit() with a 4D vector as
- * the argument.
- */
-template < typename E, class A > void
-random_unit(vector<E,A>& v)
+namespace detail {
+
+/** Random values from std::rand(), for random_unit(). */
+struct random_std_source
+{
+    template < typename T > T unit() { return T(random_unit()); }
+    template < typename T > T real(T min, T max) {
+        return random_real(min, max);
+    }
+};
+
+/** Random values from an engine, for random_unit(). */
+template < class Engine > struct random_engine_source
+{
+    Engine& g;
+    explicit random_engine_source(Engine& g_) : g(g_) {}
+    template < typename T > T unit() { return random_uniform<T>(g); }
+    template < typename T > T real(T min, T max) {
+        return random_real(min, max, g);
+    }
+};
+
+/** Random unit 3D or 2D vector from the given source. */
+template < typename E, class A, class SourceT > void
+random_unit(vector<E,A>& v, SourceT& source)
 {
     typedef vector<E,A> vector_type;
     typedef typename vector_type::value_type value_type;
@@ -180,18 +185,15 @@ random_unit(vector<E,A>& v)
     switch (v.size()) {
         case 3:
         {
-            vector< E, fixed<3> > temp;
-            spherical_to_cartesian(
-                value_type(1),
-                value_type(random_unit() * constants<value_type>::two_pi()),
-                acos_safe(random_real(value_type(-1),value_type(1))),
-                2,
-                colatitude,
-                temp
-            );
-            v[0] = temp[0];
-            v[1] = temp[1];
-            v[2] = temp[2];
+            /* A uniform angle about z, and a uniform z (Archimedes): */
+            value_type phi = source.template unit<value_type>()
+                * constants<value_type>::two_pi();
+            value_type z = source.real(value_type(-1),value_type(1));
+            value_type r = std::sqrt(std::max(value_type(1) - z*z,
+                        value_type(0)));
+            v[0] = r * std::cos(phi);
+            v[1] = r * std::sin(phi);
+            v[2] = z;
             break;
         }
         case 2:
@@ -199,7 +201,8 @@ random_unit(vector<E,A>& v)
             vector< E, fixed<2> > temp;
             polar_to_cartesian(
                 value_type(1),
-                value_type(random_unit() * constants<value_type>::two_pi()),
+                value_type(source.template unit<value_type>()
+                    * constants<value_type>::two_pi()),
                 temp
             );
             v[0] = temp[0];
@@ -211,22 +214,9 @@ random_unit(vector<E,A>& v)
     }
 }
 
-/* Random vector within a given angle of a unit-length axis, i.e. in a cone
- * (3D) or wedge (2D).
- *
- * The same notes the appear above apply here too, more or less. One
- * difference is that this is really only useful in 2D and 3D (presumably), so
- * we'll probably just do a compile- or run-time dispatch as appropriate.
- *
- * Also, there may be a better algorithm for generating a random unit vector
- * in a cone; need to look into that.
- *
- * All of this 'temp' stuff is because there's no compile-time dispatch for
- * 3D and 2D vectors, but that'll be fixed soon.
- */
-
-template < typename E, class A, class VecT > void
-random_unit(vector<E,A>& v, const VecT& axis, E theta)
+/** Random vector within a given angle of an axis, from the given source. */
+template < typename E, class A, class VecT, class SourceT > void
+random_unit(vector<E,A>& v, const VecT& axis, E theta, SourceT& source)
 {
     typedef vector<E,A> vector_type;
     typedef typename vector_type::value_type value_type;
@@ -248,14 +238,14 @@ random_unit(vector<E,A>& v, const VecT& axis, E theta)
             /* Rotate v 'away from' the axis by a random angle in the range
              * [-theta,theta]
              */
-            temp = rotate_vector(temp_axis,n,random_real(-theta,theta));
+            temp = rotate_vector(temp_axis,n,source.real(-theta,theta));
              
             /* Rotate v about the axis by a random angle in the range [-pi,pi]
              */
             temp = rotate_vector(
                 temp,
                 temp_axis,
-                random_real(
+                source.real(
                     -constants<value_type>::pi(),
                      constants<value_type>::pi()
                 )
@@ -271,7 +261,7 @@ random_unit(vector<E,A>& v, const VecT& axis, E theta)
             vector< E, fixed<2> > temp, temp_axis;
             temp_axis[0] = axis[0];
             temp_axis[1] = axis[1];
-            temp = rotate_vector_2D(temp_axis, random_real(-theta,theta));
+            temp = rotate_vector_2D(temp_axis, source.real(-theta,theta));
             v[0] = temp[0];
             v[1] = temp[1];
             break;
@@ -281,6 +271,74 @@ random_unit(vector<E,A>& v, const VecT& axis, E theta)
     }
 }
 
+} // namespace detail
+
+/** Random unit 3D or 2D vector
+ *
+ * The 3D vector is computed from a uniform angle about z and a uniform z
+ * coordinate, which is uniform on the sphere without an acos.
+ *
+ * @todo: This is just placeholder code for what will be a more thorough
+ * 'random unit' implementation:
+ *
+ * - All dimensions will be handled uniformly if practical, perhaps through
+ *   a normal distrubution PRNG.
+ *
+ * - Failing that (or perhaps even in this case), dimensions 2 and 3 will be
+ *   dispatched to special-case code, most likely implementing the algorithms
+ *   below.
+ *
+ * Like the utility random functions, the vector is drawn from std::rand()
+ * unless an engine (see cml/random.h) is given; random_unit_vectors() in
+ * cml/mathlib/random_sampling.h fills arrays of unit vectors.
+ */
+template < typename E, class A > void
+random_unit(vector<E,A>& v)
+{
+    detail::random_std_source source;
+    detail::random_unit(v, source);
+}
+
+/** Random unit 3D or 2D vector from the engine g. */
+template < typename E, class A, class Engine > void
+random_unit(vector<E,A>& v, Engine& g)
+{
+    detail::random_engine_source<Engine> source(g);
+    detail::random_unit(v, source);
+}
+
+/* Random vector within a given angle of a unit-length axis, i.e. in a cone
+ * (3D) or wedge (2D).
+ *
+ * The same notes the appear above apply here too, more or less. One
+ * difference is that this is really only useful in 2D and 3D (presumably), so
+ * we'll probably just do a compile- or run-time dispatch as appropriate.
+ *
+ * Also, there may be a better algorithm for generating a random unit vector
+ * in a cone; need to look into that.  random_cone_vectors() in
+ * cml/mathlib/random_sampling.h samples the cone uniformly by area.
+ *
+ * All of this 'temp' stuff is because there's no compile-time dispatch for
+ * 3D and 2D vectors, but that'll be fixed soon.
+ */
+
+template < typename E, class A, class VecT > void
+random_unit(vector<E,A>& v, const VecT& axis, E theta)
+{
+    detail::random_std_source source;
+    detail::random_unit(v, axis, theta, source);
+}
+
+/** Random vector within a given angle of a unit-length axis, from the
+ * engine g.
+ */
+template < typename E, class A, class VecT, class Engine > void
+random_unit(vector<E,A>& v, const VecT& axis, E theta, Engine& g)
+{
+    detail::random_engine_source<Engine> source(g);
+    detail::random_unit(v, axis, theta, source);
+}
+
 /* NEW: Manhattan distance */
 
 template< class VecT_1, class VecT_2 >
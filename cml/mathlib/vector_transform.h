@@ -13,6 +13,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #ifndef vector_transform_h
 #define vector_transform_h
 
+#include <cml/core/simd.h>
 #include <cml/mathlib/checking.h>
 
 /* Functions for transforming a vector, representing a geometric point or
@@ -133,6 +134,258 @@ transform_vector(const MatT& m, const VecT& v)
     );
 }
 
+/* Batched transforms
+ *
+ * transform_points(), transform_vectors() and transform_points_4D() apply
+ * the same transform as transform_point(), transform_vector() and
+ * transform_point_4D() to n 3D points at once.  The points may be given as
+ * an array of vector<E,fixed<3>>, as an interleaved array of 3n scalars
+ * (x0,y0,z0,x1,...), or as separate x, y and z arrays.  The output may be
+ * the same array as the input.
+ *
+ * The transform coefficients are read once, and the points are transformed
+ * a SIMD packet at a time (see cml/core/simd.h); interleaved points are
+ * split into x, y and z packets as they are loaded.
+ */
+
+namespace detail {
+
+/** The kinds of batched transform. */
+enum transform_mode {
+    transform_affine_point,
+    transform_linear_vector,
+    transform_projective_point
+};
+
+/** Packet transform of 3D points by coefficients c[i][j], where c[i][j] is
+ * basis_element(i,j) of the transform.
+ *
+ * The translation is zero for transform_linear_vector, and the last column
+ * is only read for transform_projective_point.
+ */
+template<typename T, int Mode> struct transform_kernel
+{
+    enum { W = simd::native_width<T>::value };
+    typedef simd::packet_traits<T,W> pt;
+    typedef typename pt::packet_type packet_type;
+
+    T c[4][4];
+    packet_type p[4][4];
+
+    template<class MatT> explicit transform_kernel(const MatT& m) {
+        for(int i = 0; i < 3; ++i)
+            for(int j = 0; j < 3; ++j)
+                c[i][j] = T(m.basis_element(i,j));
+        for(int j = 0; j < 3; ++j)
+            c[3][j] = (Mode == transform_linear_vector)
+                ? T(0) : T(m.basis_element(3,j));
+        for(int i = 0; i < 4; ++i)
+            c[i][3] = (Mode == transform_projective_point)
+                ? T(m.basis_element(i,3)) : T((i == 3) ? 1 : 0);
+        for(int i = 0; i < 4; ++i)
+            for(int j = 0; j < 4; ++j)
+                p[i][j] = pt::set1(c[i][j]);
+    }
+
+    /** Transform W points in place. */
+    void apply(packet_type& x, packet_type& y, packet_type& z) const {
+        packet_type rx = pt::madd(z, p[2][0],
+                pt::madd(y, p[1][0], pt::madd(x, p[0][0], p[3][0])));
+        packet_type ry = pt::madd(z, p[2][1],
+                pt::madd(y, p[1][1], pt::madd(x, p[0][1], p[3][1])));
+        packet_type rz = pt::madd(z, p[2][2],
+                pt::madd(y, p[1][2], pt::madd(x, p[0][2], p[3][2])));
+        if(Mode == transform_projective_point) {
+            packet_type iw = pt::div(pt::set1(T(1)), pt::madd(z, p[2][3],
+                        pt::madd(y, p[1][3], pt::madd(x, p[0][3], p[3][3]))));
+            rx = pt::mul(rx, iw); ry = pt::mul(ry, iw); rz = pt::mul(rz, iw);
+        }
+        x = rx; y = ry; z = rz;
+    }
+
+    /** Transform one point in place. */
+    void apply(T& x, T& y, T& z) const {
+        T rx = x*c[0][0] + y*c[1][0] + z*c[2][0] + c[3][0];
+        T ry = x*c[0][1] + y*c[1][1] + z*c[2][1] + c[3][1];
+        T rz = x*c[0][2] + y*c[1][2] + z*c[2][2] + c[3][2];
+        if(Mode == transform_projective_point) {
+            T iw = T(1)/(x*c[0][3] + y*c[1][3] + z*c[2][3] + c[3][3]);
+            rx *= iw; ry *= iw; rz *= iw;
+        }
+        x = rx; y = ry; z = rz;
+    }
+};
+
+/** Transform n points held in separate x, y and z arrays. */
+template<typename T, int Mode> void
+transform_soa(const transform_kernel<T,Mode>& kernel,
+        const T* x, const T* y, const T* z, T* ox, T* oy, T* oz, size_t n)
+{
+    typedef transform_kernel<T,Mode> kernel_type;
+    typedef typename kernel_type::pt pt;
+    typedef typename kernel_type::packet_type packet_type;
+    enum { W = kernel_type::W };
+
+    /* A local copy, so the coefficients can stay in registers while the
+     * output is written:
+     */
+    const kernel_type K(kernel);
+
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W) {
+        packet_type vx = pt::loadu(x+k), vy = pt::loadu(y+k),
+                    vz = pt::loadu(z+k);
+        K.apply(vx, vy, vz);
+        pt::storeu(ox+k, vx); pt::storeu(oy+k, vy); pt::storeu(oz+k, vz);
+    }
+    for(; k < n; ++k) {
+        T vx = x[k], vy = y[k], vz = z[k];
+        K.apply(vx, vy, vz);
+        ox[k] = vx; oy[k] = vy; oz[k] = vz;
+    }
+}
+
+/** Transform n points held in an interleaved array of 3n elements. */
+template<typename T, int Mode> void
+transform_aos(const transform_kernel<T,Mode>& kernel,
+        const T* in, T* out, size_t n)
+{
+    typedef transform_kernel<T,Mode> kernel_type;
+    typedef typename kernel_type::pt pt;
+    typedef typename kernel_type::packet_type packet_type;
+    enum { W = kernel_type::W };
+
+    /* A local copy, so the coefficients can stay in registers while the
+     * output is written:
+     */
+    const kernel_type K(kernel);
+
+    size_t nw = n - n % W, k = 0;
+    for(; k < nw; k += W) {
+        packet_type vx, vy, vz;
+        pt::load3(in+3*k, vx, vy, vz);
+        K.apply(vx, vy, vz);
+        pt::store3(out+3*k, vx, vy, vz);
+    }
+    for(; k < n; ++k) {
+        T vx = in[3*k], vy = in[3*k+1], vz = in[3*k+2];
+        K.apply(vx, vy, vz);
+        out[3*k] = vx; out[3*k+1] = vy; out[3*k+2] = vz;
+    }
+}
+
+/** Transform n points held in an array of 3D vectors. */
+template<typename T, int Mode> void
+transform_aos(const transform_kernel<T,Mode>& K,
+        const vector< T, fixed<3> >* in, vector< T, fixed<3> >* out, size_t n)
+{
+    /* The vectors must be packed without padding: */
+    CML_STATIC_REQUIRE(sizeof(vector< T, fixed<3> >) == 3*sizeof(T));
+    if(n > 0) transform_aos(K, in->data(), out->data(), n);
+}
+
+} // namespace detail
+
+/** Apply a 3D affine transform to n 3D points. */
+template < class MatT, typename E > void
+transform_points(const MatT& m,
+        const vector< E, fixed<3> >* in, vector< E, fixed<3> >* out, size_t n)
+{
+    detail::CheckMatAffine3D(m);
+    detail::transform_aos(
+            detail::transform_kernel<E,detail::transform_affine_point>(m),
+            in, out, n);
+}
+
+/** Apply a 3D affine transform to n interleaved 3D points. */
+template < class MatT, typename E > void
+transform_points(const MatT& m, const E* in, E* out, size_t n)
+{
+    detail::CheckMatAffine3D(m);
+    detail::transform_aos(
+            detail::transform_kernel<E,detail::transform_affine_point>(m),
+            in, out, n);
+}
+
+/** Apply a 3D affine transform to n 3D points in separate arrays. */
+template < class MatT, typename E > void
+transform_points(const MatT& m, const E* x, const E* y, const E* z,
+        E* ox, E* oy, E* oz, size_t n)
+{
+    detail::CheckMatAffine3D(m);
+    detail::transform_soa(
+            detail::transform_kernel<E,detail::transform_affine_point>(m),
+            x, y, z, ox, oy, oz, n);
+}
+
+/** Apply a 3D linear transform to n 3D vectors. */
+template < class MatT, typename E > void
+transform_vectors(const MatT& m,
+        const vector< E, fixed<3> >* in, vector< E, fixed<3> >* out, size_t n)
+{
+    detail::CheckMatLinear3D(m);
+    detail::transform_aos(
+            detail::transform_kernel<E,detail::transform_linear_vector>(m),
+            in, out, n);
+}
+
+/** Apply a 3D linear transform to n interleaved 3D vectors. */
+template < class MatT, typename E > void
+transform_vectors(const MatT& m, const E* in, E* out, size_t n)
+{
+    detail::CheckMatLinear3D(m);
+    detail::transform_aos(
+            detail::transform_kernel<E,detail::transform_linear_vector>(m),
+            in, out, n);
+}
+
+/** Apply a 3D linear transform to n 3D vectors in separate arrays. */
+template < class MatT, typename E > void
+transform_vectors(const MatT& m, const E* x, const E* y, const E* z,
+        E* ox, E* oy, E* oz, size_t n)
+{
+    detail::CheckMatLinear3D(m);
+    detail::transform_soa(
+            detail::transform_kernel<E,detail::transform_linear_vector>(m),
+            x, y, z, ox, oy, oz, n);
+}
+
+/** Apply a homogeneous transform to n 3D points, dividing by w. */
+template < class MatT, typename E > void
+transform_points_4D(const MatT& m,
+        const vector< E, fixed<3> >* in, vector< E, fixed<3> >* out, size_t n)
+{
+    detail::CheckMatHomogeneous3D(m);
+    detail::transform_aos(
+            detail::transform_kernel<E,detail::transform_projective_point>(m),
+            in, out, n);
+}
+
+/** Apply a homogeneous transform to n interleaved 3D points, dividing by
+ * w.
+ */
+template < class MatT, typename E > void
+transform_points_4D(const MatT& m, const E* in, E* out, size_t n)
+{
+    detail::CheckMatHomogeneous3D(m);
+    detail::transform_aos(
+            detail::transform_kernel<E,detail::transform_projective_point>(m),
+            in, out, n);
+}
+
+/** Apply a homogeneous transform to n 3D points in separate arrays,
+ * dividing by w.
+ */
+template < class MatT, typename E > void
+transform_points_4D(const MatT& m, const E* x, const E* y, const E* z,
+        E* ox, E* oy, E* oz, size_t n)
+{
+    detail::CheckMatHomogeneous3D(m);
+    detail::transform_soa(
+            detail::transform_kernel<E,detail::transform_projective_point>(m),
+            x, y, z, ox, oy, oz, n);
+}
+
 /** Apply a 2D affine transform to a 2D point */
 template < class MatT, class VecT > TEMP_VEC2
 transform_point_2D(const MatT& m, const VecT& v)
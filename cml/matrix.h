@@ -46,6 +46,7 @@ template<typename Element, class ArrayType,
 #include <cml/matrix/matrix_rowcol.h>
 #include <cml/matrix/matrix_mul.h>
 #include <cml/matvec/matvec_mul.h>
+#include <cml/matvec/matvec_chain.h>
 #include <cml/matrix/matrix_functions.h>
 #include <cml/matrix/matrix_comparison.h>
 #include <cml/matrix/lu.h>
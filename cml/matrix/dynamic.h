@@ -187,6 +187,26 @@ class matrix<Element,dynamic<Alloc>,BasisOrient,Layout>
     explicit matrix(size_t rows, size_t cols)
         : array_type(rows,cols) {}
 
+#if defined(CML_HAS_RVALUE_REFERENCES)
+    /** Move constructor, taking over the storage of m. */
+    matrix(matrix_type&& m) CML_NOEXCEPT
+        : array_type(static_cast<array_type&&>(m)) {}
+
+    /** Move assignment, taking over the storage of m. */
+    matrix_type& operator=(matrix_type&& m) CML_NOEXCEPT {
+        array_type::operator=(static_cast<array_type&&>(m));
+        return *this;
+    }
+
+#if defined(CML_USE_GENERATED_MATRIX_ASSIGN_OP)
+    /* Declaring the move assignment suppresses the generated one: */
+    matrix_type& operator=(const matrix_type& m) {
+        array_type::operator=(m);
+        return *this;
+    }
+#endif
+#endif
+
 
   public:
 
@@ -312,6 +332,13 @@ class matrix<Element,dynamic<Alloc>,BasisOrient,Layout>
 #endif
 };
 
+/** Exchange two dynamic matrices without copying their elements. */
+template<typename E, typename A, typename BO, typename L> inline void
+swap(matrix<E,dynamic<A>,BO,L>& a, matrix<E,dynamic<A>,BO,L>& b)
+{
+    a.swap(b);
+}
+
 } // namespace cml
 
 #endif
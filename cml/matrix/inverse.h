@@ -8,6 +8,9 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
  *-----------------------------------------------------------------------*/
 /** @file
  *  @brief Compute the inverse of a matrix by LU factorization.
+ *
+ * 2x2, 3x3 and 4x4 matrices are inverted using closed-form expressions,
+ * and larger matrices by LU factorization with partial pivoting.
  */
 
 #ifndef matrix_inverse_h
@@ -207,162 +210,110 @@ struct inverse_f<MatT,4>
     }
 };
 
-/* If more extensive general linear algebra functionality is offered in
- * future versions it may be useful to make the elementary row and column
- * operations separate functions. For now they're simply performed in place,
- * but the commented-out lines of code show where the calls to these functions
- * should go if and when they become available.
+/** Invert A in place from its pivoted LU factorization.
+ *
+ * A is first factored in place as PA = LU (detail::lu_pivot_inplace).  U
+ * is then inverted in place, and A^-1 = U^-1 L^-1 P is formed by solving
+ * X L = U^-1 for X a column at a time, from right to left.  Finally, the
+ * row interchanges are applied to the columns of X in reverse order.
+ *
+ * pivots and work must each have room for A.rows() elements.  This is the
+ * only storage needed besides A itself.
+ *
+ * @returns false if A is singular, in which case A is left holding
+ * non-finite values.
  */
- 
-/* @todo: In-place version, and address memory allocation for pivot vector.
- */
-
-/* General NxN inverse by Gauss-Jordan elimination with full pivoting:  */
-template<typename MatT, int _tag>
-struct inverse_f
+template<class MatT> bool
+inverse_lu_inplace(MatT& A, size_t* pivots, typename MatT::value_type* work)
 {
-    typename MatT::temporary_type operator()(const MatT& M) const
-    {
-        /* Shorthand. */
-        typedef typename MatT::value_type value_type;
-        
-        /* Size of matrix */
-        size_t N = M.rows();
+    typedef typename MatT::value_type value_type;
+
+    size_t N = A.rows();
+    int sign;
+    bool nonsingular = lu_pivot_inplace(A, pivots, sign);
+
+    /* Invert U in place, a column at a time: */
+    for(size_t j = 0; j < N; ++j) {
+        A(j,j) = value_type(1)/A(j,j);
+        value_type ajj = -A(j,j);
+
+        /* Column j of U^-1 is -U^-1(0:j,0:j) U(0:j,j) / U(j,j): */
+        for(size_t i = 0; i < j; ++i) {
+            value_type sum = A(i,i)*A(i,j);
+            for(size_t k = i+1; k < j; ++k) sum += A(i,k)*A(k,j);
+            A(i,j) = sum;
+        }
+        for(size_t i = 0; i < j; ++i) A(i,j) *= ajj;
+    }
 
-        /* Matrix containing the inverse: */
-        typename MatT::temporary_type Z;
-        cml::et::detail::Resize(Z,N,N);
-        Z = M;
+    /* Solve X L = U^-1 for X, overwriting L: */
+    for(size_t j = N; j-- > 0;) {
 
-        /* For tracking pivots */
-        std::vector<size_t> row_index(N);
-        std::vector<size_t> col_index(N);
-        std::vector<size_t> pivoted(N,0);
-
-        /* For each column */
-        for (size_t i = 0; i < N; ++i) {
-        
-            /* Find the pivot */
-            size_t row = 0, col = 0;
-            value_type max = value_type(0);
-            for (size_t j = 0; j < N; ++j) {
-                if (!pivoted[j]) {
-                    for (size_t k = 0; k < N; ++k) {
-                        if (!pivoted[k]) {
-                            value_type mag = std::fabs(Z(j,k));
-                            if (mag > max) {
-                                max = mag;
-                                row = j;
-                                col = k;
-                            }
-                        }
-                    }
-                }
-            }
-
-            /* TODO: Check max against epsilon here to catch singularity */
-
-            row_index[i] = row;
-            col_index[i] = col;
-
-            /* Swap rows if necessary */
-            if (row != col) {
-                /*Z.row_op_swap(row,col);*/
-                for (size_t j = 0; j < Z.cols(); ++j) {
-                    std::swap(Z(row,j),Z(col,j));
-                }
-            }
-            
-            /* Process pivot row */
-            pivoted[col] = true;
-            value_type pivot = Z(col,col);
-            Z(col,col) = value_type(1);
-            /*Z.row_op_mult(col,value_type(1)/pivot);*/
-            value_type k = value_type(1)/pivot;
-            for (size_t j = 0; j < Z.cols(); ++j) {
-                Z(col,j) *= k;
-            }
-
-            /* Process other rows */
-            for (size_t j = 0; j < N; ++j) {
-                if (j != col) {
-                    value_type mult = -Z(j,col);
-                    Z(j,col) = value_type(0);
-                    /*Z.row_op_add_mult(col,j,mult);*/
-                    for (size_t k = 0; k < Z.cols(); ++k) {
-                        Z(j,k) += mult * Z(col,k);
-                    }
-                }
-            }
+        /* Save column j of L, and clear it: */
+        for(size_t i = j+1; i < N; ++i) {
+            work[i] = A(i,j);
+            A(i,j) = value_type(0);
         }
 
-        /* Swap columns if necessary */
-        for (size_t i = 0; i < N; ++ i) {
-            if (row_index[i] != col_index[i]) {
-                /*Z.col_op_swap(row_index[i],col_index[i]);*/
-                for (size_t j = 0; j < Z.rows(); ++j) {
-                    std::swap(Z(j,row_index[i]), Z(j,col_index[i]));
-                }
-            }
+        /* X(:,j) -= X(:,j+1:N) L(j+1:N,j): */
+        for(size_t k = j+1; k < N; ++k) {
+            value_type l = work[k];
+            for(size_t i = 0; i < N; ++i) A(i,j) -= A(i,k)*l;
         }
+    }
 
-        /* Return result */
-        return Z;
+    /* Apply the interchanges to the columns, in reverse order: */
+    for(size_t j = N; j-- > 0;) {
+        size_t p = pivots[j];
+        if(p != j) for(size_t i = 0; i < N; ++i) std::swap(A(i,j), A(i,p));
     }
-};
 
-/* Inversion by LU factorization is turned off for now due to lack of
- * pivoting in the implementation, but we may switch back to it at some future
- * time.
+    return nonsingular;
+}
+
+/** Invert a fixed-size matrix in place by LU factorization.
+ *
+ * The pivots and workspace are kept on the stack.
  */
- 
-#if 0
+template<class MatT> inline bool
+inverse_lu_inplace(MatT& A, fixed_size_tag)
+{
+    enum { N = MatT::array_rows };
+    size_t pivots[N];
+    typename MatT::value_type work[N];
+    return inverse_lu_inplace(A, pivots, work);
+}
 
-/* General NxN inverse by LU factorization:  */
+/** Invert a run-time sized matrix in place by LU factorization. */
+template<class MatT> inline bool
+inverse_lu_inplace(MatT& A, dynamic_size_tag)
+{
+    size_t N = A.rows();
+    if(N == 0) return true;
+    std::vector<size_t> pivots(N);
+    std::vector<typename MatT::value_type> work(N);
+    return inverse_lu_inplace(A, &pivots[0], &work[0]);
+}
+
+/* General NxN inverse by LU factorization with partial pivoting: */
 template<typename MatT, int _tag>
 struct inverse_f
 {
     typename MatT::temporary_type operator()(const MatT& M) const
     {
-        /* Shorthand. */
-        typedef typename MatT::value_type value_type;
-
-        /* Compute LU factorization: */
-        size_t N = M.rows();
-        typename MatT::temporary_type LU;
-        cml::et::detail::Resize(LU,N,N);
-        LU = lu(M);
+        typedef typename MatT::temporary_type temporary_type;
 
         /* Matrix containing the inverse: */
-        typename MatT::temporary_type Z;
-        cml::et::detail::Resize(Z,N,N);
-
-        typename MatT::col_vector_type v, x;
-        cml::et::detail::Resize(v,N);
-        cml::et::detail::Resize(x,N);
-        for(size_t i = 0; i < N; ++i)
-            v[i] = value_type(0);
-        /* XXX Need a fill() function here. */
-
-        /* Use lu_solve to solve M*x = v for x, where v = [0 ... 1 ... 0]^T: */
-        for(size_t i = 0; i < N; ++i) {
-            v[i] = 1.;
-            x = lu_solve(LU,v);
-
-            /* x is column i of the inverse of LU: */
-            for(size_t k = 0; k < N; ++ k) {
-                Z(k,i) = x[k];
-            }
-            v[i] = 0.;
-        }
+        temporary_type Z;
+        cml::et::detail::Resize(Z,M.rows(),M.cols());
+        Z = M;
 
+        /* Invert in place: */
+        inverse_lu_inplace(Z, typename temporary_type::size_tag());
         return Z;
     }
-
 };
 
-#endif
-
 /* Note: force_NxN is for checking general NxN inversion against the special-
  * case 2x2, 3x3 and 4x4 code. I'm leaving it in for now since we may need to
  * test the NxN code further if the implementation changes. At some future
@@ -416,6 +367,37 @@ inverse(const MatT& M, dynamic_size_tag/*, bool force_NxN*/)
     */
 }
 
+/* In-place inverse of a fixed-size matrix: */
+template<typename MatT> inline void
+inverse_inplace(MatT& M, fixed_size_tag)
+{
+    /* Require a square matrix: */
+    cml::et::CheckedSquare(M, fixed_size_tag());
+
+    /* Use the closed forms for small matrices: */
+    if(MatT::array_rows <= 4) {
+        M = inverse_f<MatT,MatT::array_rows>()(M);
+    } else {
+        inverse_lu_inplace(M, fixed_size_tag());
+    }
+}
+
+/* In-place inverse of a dynamic-size matrix: */
+template<typename MatT> inline void
+inverse_inplace(MatT& M, dynamic_size_tag)
+{
+    /* Require a square matrix: */
+    cml::et::CheckedSquare(M, dynamic_size_tag());
+
+    /* Dispatch based upon the matrix dimension: */
+    switch(M.rows()) {
+        case 2:  M = inverse_f<MatT,2>()(M); break;     //   2x2
+        case 3:  M = inverse_f<MatT,3>()(M); break;     //   3x3
+        case 4:  M = inverse_f<MatT,4>()(M); break;     //   4x4
+        default: inverse_lu_inplace(M, dynamic_size_tag());
+    }
+}
+
 } // namespace detail
 
 /** Inverse of a matrix. */
@@ -436,6 +418,20 @@ inverse(const et::MatrixXpr<XprT>& e/*, bool force_NxN = false*/)
     return detail::inverse(e,size_tag()/*,force_NxN*/);
 }
 
+/** Invert a matrix in place.
+ *
+ * Matrices larger than 4x4 are inverted by LU factorization without
+ * allocating a second matrix.
+ *
+ * @sa detail::inverse_lu_inplace
+ */
+template<typename E, class AT, typename BO, typename L> inline
+void inverse_inplace(matrix<E,AT,BO,L>& M)
+{
+    typedef typename matrix<E,AT,BO,L>::size_tag size_tag;
+    detail::inverse_inplace(M,size_tag());
+}
+
 } // namespace cml
 
 #endif
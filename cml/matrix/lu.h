@@ -12,7 +12,9 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
  * @todo The LU implementation does not check for a zero diagonal entry
  * (implying that the input has no LU factorization).
  *
- * @todo Should also have a pivoting implementation.
+ * lu_factorization<> implements a blocked LU factorization with partial
+ * pivoting, and keeps the result so that it can be used to solve any
+ * number of systems.
  *
  * @todo need to throw a numeric error if the determinant of the matrix
  * given to lu(), lu_solve(), or inverse() is 0.
@@ -24,10 +26,18 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #ifndef lu_h
 #define lu_h
 
+#include <algorithm>
+#include <vector>
+#include <cmath>
 #include <cml/et/size_checking.h>
 #include <cml/matrix/matrix_expr.h>
 #include <cml/matvec/matvec_promotions.h>
 
+/* The panel width for the blocked pivoted LU factorization: */
+#if !defined(CML_LU_BLOCK_SIZE)
+#define CML_LU_BLOCK_SIZE 32
+#endif
+
 /* This is used below to create a more meaningful compile-time error when
  * lu is not provided with a matrix or MatrixExpr argument:
  */
@@ -115,6 +125,96 @@ lu_copy(const MatT& M)
     return A;
 }
 
+/** Unblocked pivoted factorization of columns k0..k1-1 of A, rows k0..N-1.
+ *
+ * Each row interchange is applied to the whole row, and recorded in
+ * pivots[k].  sign is negated for each interchange.
+ *
+ * @returns false if a zero pivot was found.
+ */
+template<class MatT> bool
+lu_pivot_panel(MatT& A, size_t* pivots, int& sign, size_t k0, size_t k1)
+{
+    typedef typename MatT::value_type value_type;
+
+    size_t N = A.rows();
+    bool nonsingular = true;
+    for(size_t k = k0; k < k1; ++k) {
+
+        /* Find the pivot: */
+        size_t p = k;
+        value_type max = std::fabs(A(k,k));
+        for(size_t i = k+1; i < N; ++i) {
+            value_type mag = std::fabs(A(i,k));
+            if(mag > max) { max = mag; p = i; }
+        }
+        pivots[k] = p;
+
+        /* Interchange rows k and p: */
+        if(p != k) {
+            for(size_t j = 0; j < N; ++j) std::swap(A(k,j), A(p,j));
+            sign = -sign;
+        }
+
+        if(A(k,k) == value_type(0)) {
+            nonsingular = false;
+            continue;
+        }
+
+        /* Compute the multipliers, and update the rest of the panel: */
+        value_type inv = value_type(1)/A(k,k);
+        for(size_t i = k+1; i < N; ++i) {
+            value_type l = (A(i,k) *= inv);
+            for(size_t j = k+1; j < k1; ++j) A(i,j) -= l*A(k,j);
+        }
+    }
+    return nonsingular;
+}
+
+/** Compute PA = LU in-place by a blocked factorization with partial
+ * pivoting.
+ *
+ * L is unit lower triangular and packed below the diagonal of A, and U is
+ * packed on and above the diagonal.  pivots must have room for A.rows()
+ * entries, and receives the row interchanges; sign is set to the sign of
+ * the permutation.
+ *
+ * @returns false if a zero pivot was found (A is singular).
+ */
+template<class MatT> bool
+lu_pivot_inplace(MatT& A, size_t* pivots, int& sign)
+{
+    typedef typename MatT::value_type value_type;
+
+    size_t N = A.rows();
+    const size_t NB = CML_LU_BLOCK_SIZE;
+    bool nonsingular = true;
+    sign = 1;
+    for(size_t k0 = 0; k0 < N; k0 += NB) {
+        size_t k1 = std::min(k0+NB, N);
+
+        /* Factor the panel of columns k0..k1-1: */
+        if(!lu_pivot_panel(A, pivots, sign, k0, k1)) nonsingular = false;
+
+        /* Compute U12 = L11^-1 A12 by forward substitution: */
+        for(size_t k = k0; k < k1; ++k) {
+            for(size_t i = k+1; i < k1; ++i) {
+                value_type l = A(i,k);
+                for(size_t j = k1; j < N; ++j) A(i,j) -= l*A(k,j);
+            }
+        }
+
+        /* Update the trailing submatrix, A22 -= L21 U12: */
+        for(size_t i = k1; i < N; ++i) {
+            for(size_t p = k0; p < k1; ++p) {
+                value_type l = A(i,p);
+                for(size_t j = k1; j < N; ++j) A(i,j) -= l*A(p,j);
+            }
+        }
+    }
+    return nonsingular;
+}
+
 } // namespace detail
 
 /** LU factorization for a matrix, with L a unit lower triangular matrix.
@@ -189,6 +289,222 @@ lu_solve(const MatT& LU, const VecT& b)
   return x;
 }
 
+/** LU factorization with partial pivoting, PA = LU.
+ *
+ * The factorization is computed once, by the constructor or by factor(),
+ * and can then be used to solve any number of systems Ax = b.  L (unit
+ * lower triangular) and U are packed into a single matrix, and the row
+ * permutation P is stored as the sequence of row interchanges made during
+ * the factorization: row k was swapped with row pivots()[k], k = 0..N-1.
+ *
+ * The factorization is right-looking and blocked (see
+ * detail::lu_pivot_inplace).
+ *
+ * The solve functions work in place on their argument, and do not
+ * allocate.  Re-factoring a matrix of the same size reuses the existing
+ * storage.
+ *
+ * MatT is the type of the matrix to factor; the factors are stored in a
+ * MatT::temporary_type.
+ *
+ * @note A zero pivot does not stop the factorization, but is recorded by
+ * is_singular().  Solving with a singular factorization divides by zero.
+ */
+template<class MatT>
+class lu_factorization
+{
+  public:
+
+    typedef lu_factorization<MatT> factorization_type;
+    typedef typename MatT::temporary_type matrix_type;
+    typedef typename matrix_type::value_type value_type;
+    typedef typename matrix_type::size_tag size_tag;
+    typedef std::vector<size_t> pivot_type;
+
+
+  public:
+
+    /** Create an empty factorization. */
+    lu_factorization() : m_sign(1), m_singular(false) {}
+
+    /** Factor M. */
+    template<class M2> explicit lu_factorization(const M2& M)
+        : m_sign(1), m_singular(false) { this->factor(M); }
+
+
+  public:
+
+    /** Return the size of the factored matrix. */
+    size_t size() const { return m_pivots.size(); }
+
+    /** Return the packed L and U factors. */
+    const matrix_type& lu() const { return m_lu; }
+
+    /** Return the row interchanges. */
+    const pivot_type& pivots() const { return m_pivots; }
+
+    /** Return true if a zero pivot was found. */
+    bool is_singular() const { return m_singular; }
+
+    /** Return the determinant of the factored matrix. */
+    value_type determinant() const {
+        value_type D = value_type(m_sign);
+        for(size_t i = 0; i < size(); ++i) D *= m_lu(i,i);
+        return D;
+    }
+
+
+  public:
+
+    /** Factor the square matrix (or matrix expression) M. */
+    template<class M2> void factor(const M2& M)
+    {
+        /* Verify that the matrix is square, and get the size: */
+        size_t N = cml::et::CheckedSquare(
+                M, typename et::ExprTraits<M2>::size_tag());
+
+        /* Copy M (the storage is reused if the size hasn't changed): */
+        cml::et::detail::Resize(m_lu,N,N);
+        m_lu = M;
+        m_pivots.resize(N);
+        m_sign = 1;
+        m_singular = (N > 0) &&
+            !detail::lu_pivot_inplace(m_lu, &m_pivots[0], m_sign);
+    }
+
+
+  public:
+
+    /** Solve Ax = b in place, with b given in x on entry.
+     *
+     * x can be a vector, or a matrix whose columns are each a right-hand
+     * side.
+     */
+    template<class XT> void solve_inplace(XT& x) const {
+        this->solve_inplace(x, typename et::ExprTraits<XT>::result_tag());
+    }
+
+    /** Solve Ax = b for x.
+     *
+     * If x is resizable, it is resized to match b (which does not allocate
+     * when the size is unchanged).
+     */
+    template<class XT, class BT> void solve(XT& x, const BT& b) const {
+        this->copy_rhs(x, b, typename et::ExprTraits<XT>::result_tag());
+        this->solve_inplace(x);
+    }
+
+
+  protected:
+
+    /** Solve for a single right-hand side. */
+    template<class VecT> void solve_inplace(VecT& x, et::vector_result_tag)
+        const
+    {
+        size_t N = size();
+        et::GetCheckedSize<matrix_type,VecT,dynamic_size_tag>()
+            .equal_or_fail(N, size_t(x.size()));
+
+        /* Apply the row interchanges: */
+        for(size_t i = 0; i < N; ++i) {
+            if(m_pivots[i] != i) std::swap(x[i], x[m_pivots[i]]);
+        }
+
+        /* Solve Ly = Pb by forward substitution: */
+        for(size_t i = 0; i < N; ++i) {
+            value_type xi = x[i];
+            for(size_t j = 0; j < i; ++j) xi -= m_lu(i,j)*x[j];
+            x[i] = xi;
+        }
+
+        /* Solve Ux = y by backward substitution: */
+        for(size_t i = N; i-- > 0;) {
+            value_type xi = x[i];
+            for(size_t j = i+1; j < N; ++j) xi -= m_lu(i,j)*x[j];
+            x[i] = xi/m_lu(i,i);
+        }
+    }
+
+    /** Solve for the columns of X. */
+    template<class XMatT> void solve_inplace(XMatT& X, et::matrix_result_tag)
+        const
+    {
+        size_t N = size(), M = X.cols();
+        et::GetCheckedSize<matrix_type,XMatT,dynamic_size_tag>()
+            .equal_or_fail(N, size_t(X.rows()));
+
+        /* Apply the row interchanges: */
+        for(size_t i = 0; i < N; ++i) {
+            size_t p = m_pivots[i];
+            if(p != i) for(size_t j = 0; j < M; ++j) std::swap(X(i,j),X(p,j));
+        }
+
+        /* Solve LY = PB by forward substitution, a row at a time: */
+        for(size_t i = 0; i < N; ++i) {
+            for(size_t k = 0; k < i; ++k) {
+                value_type l = m_lu(i,k);
+                for(size_t j = 0; j < M; ++j) X(i,j) -= l*X(k,j);
+            }
+        }
+
+        /* Solve UX = Y by backward substitution: */
+        for(size_t i = N; i-- > 0;) {
+            for(size_t k = i+1; k < N; ++k) {
+                value_type u = m_lu(i,k);
+                for(size_t j = 0; j < M; ++j) X(i,j) -= u*X(k,j);
+            }
+            value_type inv = value_type(1)/m_lu(i,i);
+            for(size_t j = 0; j < M; ++j) X(i,j) *= inv;
+        }
+    }
+
+    template<class VecT, class BT> void copy_rhs(
+            VecT& x, const BT& b, et::vector_result_tag) const
+    {
+        cml::et::detail::Resize(x, b.size());
+        x = b;
+    }
+
+    template<class XMatT, class BT> void copy_rhs(
+            XMatT& X, const BT& B, et::matrix_result_tag) const
+    {
+        cml::et::detail::Resize(X, B.rows(), B.cols());
+        X = B;
+    }
+
+
+  protected:
+
+    matrix_type                 m_lu;
+    pivot_type                  m_pivots;
+    int                         m_sign;
+    bool                        m_singular;
+};
+
+/** Compute the LU factorization of a matrix with partial pivoting.
+ *
+ * @sa lu_factorization
+ */
+template<typename E, class AT, typename BO, class L>
+inline lu_factorization< matrix<E,AT,BO,L> >
+lu_factor(const matrix<E,AT,BO,L>& m)
+{
+    return lu_factorization< matrix<E,AT,BO,L> >(m);
+}
+
+/** Compute the LU factorization of a matrix expression with partial
+ * pivoting.
+ *
+ * @sa lu_factorization
+ */
+template<typename XprT>
+inline lu_factorization< typename et::MatrixXpr<XprT>::temporary_type >
+lu_factor(const et::MatrixXpr<XprT>& e)
+{
+    return lu_factorization<
+        typename et::MatrixXpr<XprT>::temporary_type>(e);
+}
+
 } // namespace cml
 
 #endif
@@ -232,6 +232,9 @@ class UnaryMatrixOp
         return OpT().apply(expr_traits().get(m_expr,i,j));
     }
 
+    /** Return reference to contained expression. */
+    expr_reference expression() const { return m_expr; }
+
 
   public:
 
@@ -376,6 +379,12 @@ class BinaryMatrixOp
                 right_traits().get(m_right,i,j));
     }
 
+    /** Return reference to left expression. */
+    left_reference left_expression() const { return m_left; }
+
+    /** Return reference to right expression. */
+    right_reference right_expression() const { return m_right; }
+
 
   public:
 
@@ -435,6 +444,99 @@ struct ExprTraits< BinaryMatrixOp<LeftT,RightT,OpT> >
     size_t cols(const expr_type& e) const { return e.cols(); }
 };
 
+/** Materialize<> for MatrixXpr<>: evaluate the products it wraps. */
+template<class ExprT>
+class Materialize< MatrixXpr<ExprT> >
+{
+  public:
+
+    typedef Materialize<ExprT> expr_materialize;
+    typedef MatrixXpr<typename expr_materialize::type> type;
+
+
+  public:
+
+    /** Return the expression with its products evaluated. */
+    type expression() const { return type(m_expr.expression()); }
+
+
+  public:
+
+    /** Evaluate the products of e. */
+    explicit Materialize(const MatrixXpr<ExprT>& e)
+        : m_expr(e.expression()) {}
+
+
+  protected:
+
+    expr_materialize m_expr;
+};
+
+/** Materialize<> for UnaryMatrixOp<>: evaluate the products of the
+ * subexpression.
+ */
+template<class ExprT, class OpT>
+class Materialize< UnaryMatrixOp<ExprT,OpT> >
+{
+  public:
+
+    typedef Materialize<ExprT> expr_materialize;
+    typedef UnaryMatrixOp<typename expr_materialize::type,OpT> type;
+
+
+  public:
+
+    /** Return the expression with its products evaluated. */
+    type expression() const { return type(m_expr.expression()); }
+
+
+  public:
+
+    /** Evaluate the products of e. */
+    explicit Materialize(const UnaryMatrixOp<ExprT,OpT>& e)
+        : m_expr(e.expression()) {}
+
+
+  protected:
+
+    expr_materialize m_expr;
+};
+
+/** Materialize<> for BinaryMatrixOp<>: evaluate the products of both
+ * subexpressions.
+ */
+template<class LeftT, class RightT, class OpT>
+class Materialize< BinaryMatrixOp<LeftT,RightT,OpT> >
+{
+  public:
+
+    typedef Materialize<LeftT> left_materialize;
+    typedef Materialize<RightT> right_materialize;
+    typedef BinaryMatrixOp<typename left_materialize::type,
+            typename right_materialize::type, OpT> type;
+
+
+  public:
+
+    /** Return the expression with its products evaluated. */
+    type expression() const {
+        return type(m_left.expression(), m_right.expression());
+    }
+
+
+  public:
+
+    /** Evaluate the products of e. */
+    explicit Materialize(const BinaryMatrixOp<LeftT,RightT,OpT>& e)
+        : m_left(e.left_expression()), m_right(e.right_expression()) {}
+
+
+  protected:
+
+    left_materialize m_left;
+    right_materialize m_right;
+};
+
 /* Helper struct to verify that both arguments are matrix expressions: */
 template<typename LeftTraits, typename RightTraits>
 struct MatrixExpressions
@@ -9,20 +9,31 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 /** @file
  *  @brief Multiply two matrices.
  *
- * @todo Does it make sense to put mat-mat multiplication as a node into the
- * expression tree?
+ * A product is returned as an et::MatrixMulOp node, which is evaluated when
+ * it is assigned.  C = A*B is computed straight into C by the kernels
+ * below, and so is C = A*B + D (or any other element-wise operation of the
+ * product with an operand), without a temporary for A*B.  An operand of the
+ * product that is itself an expression, including another product, is
+ * evaluated into a temporary first.  If C shares storage with A or B, the
+ * product is computed into a temporary before C is written.
  *
- * @internal This does not need to return an expression type, since the
- * temporary generation for the matrix result is handled automatically by the
- * compiler.  i.e. when used in an expression, the result is automatically
- * included in the expression tree as a temporary by the compiler.
+ * A product used in any other way (e.g. transpose(A*B) + D) is computed
+ * into a temporary by et::Materialize<> before the assignment reads the
+ * expression.  Reading an element of the node itself computes just that
+ * element.
+ *
+ * Define CML_NO_LAZY_PRODUCTS to have operator*() return the product as a
+ * temporary matrix instead.
  */
 
 #ifndef	matrix_mul_h
 #define	matrix_mul_h
 
 #include <cml/et/size_checking.h>
+#include <cml/et/product_assign.h>
 #include <cml/matrix/matrix_expr.h>
+#include <cml/matrix/matrix_mul_blocked.h>
+#include <cml/matrix/matrix_mul_fixed.h>
 
 /* This is used below to create a more meaningful compile-time error when
  * mul is not provided with matrix or MatrixExpr arguments:
@@ -64,9 +75,272 @@ MatMulCheckedSize(const LeftT& left, const RightT& right, dynamic_size_tag)
 }
 
 
+/** Matrix multiplication by the textbook i-j-k loop.
+ *
+ * This is the fallback kernel for small or fixed-size matrices, and for
+ * operands that are not stored as contiguous arrays.
+ */
+template<class ResultT, class LeftT, class RightT> void
+MatMulLoop(ResultT& C, const LeftT& left, const RightT& right)
+{
+    typedef typename ResultT::value_type value_type;
+    for(size_t i = 0; i < left.rows(); ++i) {               /* rows */
+        for(size_t j = 0; j < right.cols(); ++j) {          /* cols */
+            value_type sum(left(i,0)*right(0,j));
+            for(size_t k = 1; k < right.rows(); ++k) {
+                sum += (left(i,k)*right(k,j));
+            }
+            C(i,j) = sum;
+        }
+    }
+}
+
+/** Matrix multiplication by the i-j-k loop, as C OpT= f(left*right).
+ *
+ * Each element of the product is combined with f (e.g. adding an element
+ * of another matrix) as soon as it is computed, so that the result is
+ * written in a single pass.
+ */
+template<class OpT, class ResultT, class LeftT, class RightT, class CombineT>
+void MatMulLoop(ResultT& C, const LeftT& left, const RightT& right,
+        const CombineT& f)
+{
+    typedef typename ResultT::value_type value_type;
+    for(size_t i = 0; i < left.rows(); ++i) {               /* rows */
+        for(size_t j = 0; j < right.cols(); ++j) {          /* cols */
+            value_type sum(left(i,0)*right(0,j));
+            for(size_t k = 1; k < right.rows(); ++k) {
+                sum += (left(i,k)*right(k,j));
+            }
+            OpT().apply(C(i,j), f(sum,i,j));
+        }
+    }
+}
+
+/** Select the multiplication kernel for a fixed-size result. */
+template<class ResultT, class LeftT, class RightT> inline void
+MatMulKernel(ResultT& C, const LeftT& left, const RightT& right,
+        fixed_size_tag)
+{
+    MatMulLoop(C, left, right);
+}
+
+/** Select the multiplication kernel for two fixed-size matrices.
+ *
+ * 2x2, 3x3 and 4x4 products use the unrolled kernels from
+ * matrix_mul_fixed.h, unless CML_NO_FIXED_MATRIX_MUL_KERNELS is defined.
+ */
+template<class ResultT,
+    typename E1, class AT1, typename BO1, typename L1,
+    typename E2, class AT2, typename BO2, typename L2>
+inline void
+MatMulKernel(ResultT& C,
+        const matrix<E1,AT1,BO1,L1>& left,
+        const matrix<E2,AT2,BO2,L2>& right,
+        fixed_size_tag)
+{
+#if defined(CML_NO_FIXED_MATRIX_MUL_KERNELS)
+    MatMulLoop(C, left, right);
+#else
+    typedef matrix<E1,AT1,BO1,L1> left_type;
+    typedef matrix<E2,AT2,BO2,L2> right_type;
+    FixedMatMul<left_type::array_rows, left_type::array_cols,
+        right_type::array_cols>::mul(C, left, right);
+#endif
+}
+
+/** Select the multiplication kernel for a generic run-time sized result. */
+template<class ResultT, class LeftT, class RightT> inline void
+MatMulKernel(ResultT& C, const LeftT& left, const RightT& right,
+        dynamic_size_tag)
+{
+    MatMulLoop(C, left, right);
+}
+
+/** Select the multiplication kernel for two run-time sized matrices.
+ *
+ * Dynamic and external arrays with every dimension at least
+ * CML_MATRIX_BLOCKED_MUL_THRESHOLD use the cache-blocked kernel, and
+ * smaller ones use the plain loop.
+ */
+template<class ResultT,
+    typename E1, class AT1, typename BO1, typename L1,
+    typename E2, class AT2, typename BO2, typename L2>
+inline void
+MatMulKernel(ResultT& C,
+        const matrix<E1,AT1,BO1,L1>& left,
+        const matrix<E2,AT2,BO2,L2>& right,
+        dynamic_size_tag)
+{
+    const size_t T = CML_MATRIX_BLOCKED_MUL_THRESHOLD;
+    if(left.rows() >= T && left.cols() >= T && right.cols() >= T) {
+        blocked_mul(C, left, right);
+    } else {
+        MatMulLoop(C, left, right);
+    }
+}
+
+/** True if MatMulKernel() multiplies by MatMulLoop(). */
+template<class LeftT, class RightT, class SizeT> inline bool
+MatMulUsesLoop(const LeftT&, const RightT&, SizeT)
+{
+    return true;
+}
+
+/** True if MatMulKernel() multiplies two fixed-size matrices by
+ * MatMulLoop().
+ */
+template<typename E1, class AT1, typename BO1, typename L1,
+    typename E2, class AT2, typename BO2, typename L2>
+inline bool
+MatMulUsesLoop(const matrix<E1,AT1,BO1,L1>&, const matrix<E2,AT2,BO2,L2>&,
+        fixed_size_tag)
+{
+#if defined(CML_NO_FIXED_MATRIX_MUL_KERNELS)
+    return true;
+#else
+    typedef matrix<E1,AT1,BO1,L1> left_type;
+    typedef matrix<E2,AT2,BO2,L2> right_type;
+    return !FixedMatMul<left_type::array_rows, left_type::array_cols,
+        right_type::array_cols>::unrolled;
+#endif
+}
+
+/** True if MatMulKernel() multiplies two run-time sized matrices by
+ * MatMulLoop().
+ */
+template<typename E1, class AT1, typename BO1, typename L1,
+    typename E2, class AT2, typename BO2, typename L2>
+inline bool
+MatMulUsesLoop(const matrix<E1,AT1,BO1,L1>& left,
+        const matrix<E2,AT2,BO2,L2>& right, dynamic_size_tag)
+{
+    const size_t T = CML_MATRIX_BLOCKED_MUL_THRESHOLD;
+    return !(left.rows() >= T && left.cols() >= T && right.cols() >= T);
+}
+
+/** Resize a product's destination to R x C. */
+template<class MatT> inline void
+MatMulResize(MatT& dest, size_t R, size_t C, resizable_tag)
+{
+    cml::et::detail::Resize(dest, R, C);
+}
+
+/** Check that a destination that cannot be resized is R x C.
+ *
+ * @throws std::invalid_argument if it is not.
+ */
+template<class MatT> inline void
+MatMulResize(MatT& dest, size_t R, size_t C, not_resizable_tag)
+{
+    et::GetCheckedSize<MatT,MatT,dynamic_size_tag> check;
+    check.equal_or_fail(dest.rows(), R);
+    check.equal_or_fail(dest.cols(), C);
+}
+
+/** Compute dest OpT= f(left*right) for two matrices.
+ *
+ * The product is written straight into dest when dest has its size (or
+ * is resized to it) and shares no storage with left or right.  If the
+ * product would be computed by MatMulLoop() anyway, f is applied to each
+ * element in the same pass; otherwise, the selected kernel writes dest,
+ * and f is applied in place afterwards.  In every other case, the product
+ * is computed into a temporary, which is then assigned to dest like any
+ * other matrix.
+ *
+ * @sa et::detail::ProductTerm
+ * @sa et::detail::ProductCombine
+ */
+template<class OpT, class MatT,
+    typename E1, class AT1, typename BO1, typename L1,
+    typename E2, class AT2, typename BO2, typename L2,
+    class CombineT>
+void
+MatMulAssign(MatT& dest,
+        const matrix<E1,AT1,BO1,L1>& left,
+        const matrix<E2,AT2,BO2,L2>& right,
+        const CombineT& f)
+{
+    typedef matrix<E1,AT1,BO1,L1> left_type;
+    typedef matrix<E2,AT2,BO2,L2> right_type;
+    typedef typename et::MatrixPromote<left_type,right_type>::type
+        result_type;
+    typedef typename result_type::size_tag size_tag;
+
+    const size_t R = left.rows(), C = right.cols();
+    bool aliased = (et::detail::OperandAliases(dest, left)
+            || et::detail::OperandAliases(dest, right));
+
+    /* A dest that is assigned, and not read, can take the product's size: */
+    if(et::detail::IsAssignOp<OpT>::is_true && !aliased && !f.aliases(dest))
+        MatMulResize(dest, R, C, typename MatT::resizing_tag());
+
+    bool direct = (!aliased && dest.rows() == R && dest.cols() == C
+            && f.fits(R,C));
+
+    if(direct && MatMulUsesLoop(left, right, size_tag())) {
+        MatMulLoop<OpT>(dest, left, right, f);
+    } else if(direct && et::detail::IsAssignOp<OpT>::is_true
+            && !f.aliases(dest))
+    {
+        MatMulKernel(dest, left, right, size_tag());
+        f.apply(dest);
+    } else {
+        result_type P;
+        cml::et::detail::Resize(P, R, C);
+        MatMulKernel(P, left, right, size_tag());
+        f.template assign<OpT>(dest, P);
+    }
+}
+
+/** Compute dest OpT= f(left*right) for a matrix and an expression.
+ *
+ * The expression is evaluated into a temporary first.
+ */
+template<class OpT, class MatT,
+    typename E1, class AT1, typename BO1, typename L1,
+    class RightT, class CombineT>
+inline void
+MatMulAssign(MatT& dest,
+        const matrix<E1,AT1,BO1,L1>& left,
+        const RightT& right,
+        const CombineT& f)
+{
+    typedef et::ExprTraits<RightT> right_traits;
+    typename et::MatrixXpr<RightT>::temporary_type tmp;
+    cml::et::detail::Resize(tmp,
+            right_traits().rows(right), right_traits().cols(right));
+    tmp = et::MatrixXpr<RightT>(right);
+    MatMulAssign<OpT>(dest, left, tmp, f);
+}
+
+/** Compute dest OpT= f(left*right) for an expression and a matrix or
+ * expression.
+ *
+ * The left expression is evaluated into a temporary first.
+ */
+template<class OpT, class MatT, class LeftT, class RightT, class CombineT>
+inline void
+MatMulAssign(MatT& dest, const LeftT& left, const RightT& right,
+        const CombineT& f)
+{
+    typedef et::ExprTraits<LeftT> left_traits;
+    typename et::MatrixXpr<LeftT>::temporary_type tmp;
+    cml::et::detail::Resize(tmp,
+            left_traits().rows(left), left_traits().cols(left));
+    tmp = et::MatrixXpr<LeftT>(left);
+    MatMulAssign<OpT>(dest, tmp, right, f);
+}
+
 /** Matrix multiplication.
  *
- * Computes C = A x B (O(N^3), non-blocked algorithm).
+ * Computes C = A x B (O(N^3)).  Large run-time sized products use a
+ * cache-blocked kernel, small square fixed-size products use unrolled
+ * (and where possible SIMD) kernels, and everything else a non-blocked
+ * loop.
+ *
+ * @sa detail::blocked_mul
+ * @sa detail::FixedMatMul
  */
 template<class LeftT, class RightT>
 inline typename et::MatrixPromote<
@@ -110,23 +384,342 @@ mul(const LeftT& left, const RightT& right)
     result_type C;
     cml::et::detail::Resize(C, N);
 
-    /* XXX Specialize this for fixed-size matrices: */
+    /* Select the multiplication kernel: */
+    detail::MatMulKernel(C, left, right, size_tag());
+
+    return C;
+}
+
+} // namespace detail
+
+namespace et {
+
+/** A matrix product in an expression tree.
+ *
+ * The product is evaluated when it is assigned, by detail::MatMulAssign();
+ * see MatrixAssignment<> below, or into a temporary by Materialize<> when
+ * it is part of a larger expression.  Element access computes the single
+ * element as an inner product, so the node never changes once built.
+ */
+template<class LeftT, class RightT>
+class MatrixMulOp
+{
+  public:
+
+    typedef MatrixMulOp<LeftT,RightT> expr_type;
+
+    /* Copy the expression by value into higher-up expressions: */
+    typedef expr_type expr_const_reference;
+
+    typedef matrix_result_tag result_tag;
+
+    /* For matching by assignability: */
+    typedef cml::et::not_assignable_tag assignable_tag;
+
+    /* Record the expression traits for the two subexpressions: */
+    typedef ExprTraits<LeftT> left_traits;
+    typedef ExprTraits<RightT> right_traits;
+
+    /* Reference types for the two subexpressions: */
+    typedef typename left_traits::const_reference left_reference;
+    typedef typename right_traits::const_reference right_reference;
+
+    /* Figure out the expression's resulting (matrix) type: */
+    typedef typename left_traits::result_type left_result;
+    typedef typename right_traits::result_type right_result;
+    typedef typename MatrixPromote<left_result,right_result>::type result_type;
     typedef typename result_type::value_type value_type;
-    for(size_t i = 0; i < left.rows(); ++i) {               /* rows */
-        for(size_t j = 0; j < right.cols(); ++j) {          /* cols */
-            value_type sum(left(i,0)*right(0,j));
-            for(size_t k = 1; k < right.rows(); ++k) {
-                sum += (left(i,k)*right(k,j));
-            }
-            C(i,j) = sum;
+    typedef typename result_type::size_tag size_tag;
+
+    /* Get the temporary type: */
+    typedef typename result_type::temporary_type temporary_type;
+
+
+  public:
+
+    /** Record result size as an enum (if applicable). */
+    enum {
+        array_rows = result_type::array_rows,
+        array_cols = result_type::array_cols
+    };
+
+
+  public:
+
+    /** Return the expression size as a pair. */
+    matrix_size size() const {
+        return matrix_size(this->rows(),this->cols());
+    }
+
+    /** Return number of rows in the result. */
+    size_t rows() const {
+        return left_traits().rows(m_left);
+    }
+
+    /** Return number of cols in the result. */
+    size_t cols() const {
+        return right_traits().cols(m_right);
+    }
+
+    /** Compute value at index i,j of the result matrix. */
+    value_type operator()(size_t i, size_t j) const {
+        value_type sum(left_traits().get(m_left,i,0)
+                *right_traits().get(m_right,0,j));
+        for(size_t k = 1; k < left_traits().cols(m_left); ++k) {
+            sum += (left_traits().get(m_left,i,k)
+                    *right_traits().get(m_right,k,j));
         }
+        return sum;
     }
 
-    return C;
+    /** Return reference to left expression. */
+    left_reference left_expression() const { return m_left; }
+
+    /** Return reference to right expression. */
+    right_reference right_expression() const { return m_right; }
+
+
+  public:
+
+    /** Construct from the two subexpressions.
+     *
+     * @throws std::invalid_argument if the left subexpression does not
+     * have as many columns as the right has rows.
+     */
+    explicit MatrixMulOp(left_reference left, right_reference right)
+        : m_left(left), m_right(right)
+    {
+        cml::detail::MatMulCheckedSize(left, right, size_tag());
+    }
+
+    /** Copy constructor. */
+    MatrixMulOp(const expr_type& e)
+        : m_left(e.m_left), m_right(e.m_right) {}
+
+
+  protected:
+
+    left_reference m_left;
+    right_reference m_right;
+
+
+  private:
+
+    /* Cannot be assigned to: */
+    expr_type& operator=(const expr_type&);
+};
+
+/** Expression traits for MatrixMulOp<>. */
+template<class LeftT, class RightT>
+struct ExprTraits< MatrixMulOp<LeftT,RightT> >
+{
+    typedef MatrixMulOp<LeftT,RightT> expr_type;
+    typedef LeftT left_type;
+    typedef RightT right_type;
+
+    typedef typename expr_type::value_type value_type;
+    typedef typename expr_type::expr_const_reference const_reference;
+    typedef typename expr_type::result_tag result_tag;
+    typedef typename expr_type::size_tag size_tag;
+    typedef typename expr_type::result_type result_type;
+    typedef typename expr_type::assignable_tag assignable_tag;
+    typedef expr_node_tag node_tag;
+
+    value_type get(const expr_type& e, size_t i, size_t j) const {
+        return e(i,j);
+    }
+
+    matrix_size size(const expr_type& e) const { return e.size(); }
+    size_t rows(const expr_type& e) const { return e.rows(); }
+    size_t cols(const expr_type& e) const { return e.cols(); }
+};
+
+namespace detail {
+
+/** Compute dest OpT= f(P) for the product P. */
+template<class OpT, class MatT, class LeftT, class RightT, class CombineT>
+inline void
+AssignMatrixProduct(MatT& dest, const MatrixMulOp<LeftT,RightT>& P,
+        const CombineT& f)
+{
+    cml::detail::MatMulAssign<OpT>(
+            dest, P.left_expression(), P.right_expression(), f);
 }
 
+/** Assign a matrix product. */
+template<class LeftT, class RightT>
+struct MatrixAssignment< MatrixXpr< MatrixMulOp<LeftT,RightT> > >
+{
+    typedef MatrixXpr< MatrixMulOp<LeftT,RightT> > src_type;
+
+    template<class OpT, typename E, class AT, typename BO, typename L>
+        static void assign(cml::matrix<E,AT,BO,L>& dest,
+                const src_type& src)
+        {
+            AssignMatrixProduct<OpT>(
+                    dest, src.expression(), ProductTerm());
+        }
+};
+
+/** Assign a matrix product combined element-wise with another operand. */
+template<class LeftT, class RightT, class ExprT, class OpT2>
+struct MatrixAssignment< MatrixXpr<
+        BinaryMatrixOp<MatrixMulOp<LeftT,RightT>,ExprT,OpT2> > >
+{
+    typedef BinaryMatrixOp<MatrixMulOp<LeftT,RightT>,ExprT,OpT2> expr_type;
+    typedef ProductCombine<ExprT,OpT2,true_type> combine_type;
+
+    template<class OpT, typename E, class AT, typename BO, typename L>
+        static void assign(cml::matrix<E,AT,BO,L>& dest,
+                const MatrixXpr<expr_type>& src)
+        {
+            expr_type e(src.expression());
+            combine_type f(e.right_expression());
+            AssignMatrixProduct<OpT>(dest, e.left_expression(), f);
+        }
+};
+
+/** Assign an operand combined element-wise with a matrix product. */
+template<class ExprT, class LeftT, class RightT, class OpT2>
+struct MatrixAssignment< MatrixXpr<
+        BinaryMatrixOp<ExprT,MatrixMulOp<LeftT,RightT>,OpT2> > >
+{
+    typedef BinaryMatrixOp<ExprT,MatrixMulOp<LeftT,RightT>,OpT2> expr_type;
+    typedef ProductCombine<ExprT,OpT2,false_type> combine_type;
+
+    template<class OpT, typename E, class AT, typename BO, typename L>
+        static void assign(cml::matrix<E,AT,BO,L>& dest,
+                const MatrixXpr<expr_type>& src)
+        {
+            expr_type e(src.expression());
+            combine_type f(e.left_expression());
+            AssignMatrixProduct<OpT>(dest, e.right_expression(), f);
+        }
+};
+
+/** Assign two matrix products combined element-wise.
+ *
+ * The right product is computed into a temporary first (see
+ * ProductCombine<>), and the left one is written into dest.
+ */
+template<class LeftT1, class RightT1, class LeftT2, class RightT2,
+    class OpT2>
+struct MatrixAssignment< MatrixXpr< BinaryMatrixOp<
+        MatrixMulOp<LeftT1,RightT1>,MatrixMulOp<LeftT2,RightT2>,OpT2> > >
+{
+    typedef MatrixMulOp<LeftT2,RightT2> right_type;
+    typedef BinaryMatrixOp<MatrixMulOp<LeftT1,RightT1>,right_type,OpT2>
+        expr_type;
+    typedef ProductCombine<right_type,OpT2,true_type> combine_type;
+
+    template<class OpT, typename E, class AT, typename BO, typename L>
+        static void assign(cml::matrix<E,AT,BO,L>& dest,
+                const MatrixXpr<expr_type>& src)
+        {
+            expr_type e(src.expression());
+            combine_type f(e.right_expression());
+            AssignMatrixProduct<OpT>(dest, e.left_expression(), f);
+        }
+};
+
 } // namespace detail
 
+/** Materialize<> for MatrixMulOp<>: compute the product. */
+template<class LeftT, class RightT>
+class Materialize< MatrixMulOp<LeftT,RightT> >
+{
+  public:
+
+    typedef MatrixMulOp<LeftT,RightT> expr_type;
+    typedef typename expr_type::temporary_type type;
+
+
+  public:
+
+    /** Return the product. */
+    const type& expression() const { return m_result; }
+
+
+  public:
+
+    /** Compute the product e into a temporary. */
+    explicit Materialize(const expr_type& e) {
+        typedef typename expr_type::value_type value_type;
+        typedef OpAssign<value_type,value_type> op_type;
+        cml::et::detail::Resize(m_result, e.rows(), e.cols());
+        detail::AssignMatrixProduct<op_type>(
+                m_result, e, detail::ProductTerm());
+    }
+
+
+  protected:
+
+    type m_result;
+};
+
+/** Materialize<> for a MatrixXpr<> holding a product. */
+template<class LeftT, class RightT>
+class Materialize< MatrixXpr< MatrixMulOp<LeftT,RightT> > >
+    : public Materialize< MatrixMulOp<LeftT,RightT> >
+{
+  public:
+
+    /** Compute the product e into a temporary. */
+    explicit Materialize(const MatrixXpr< MatrixMulOp<LeftT,RightT> >& e)
+        : Materialize< MatrixMulOp<LeftT,RightT> >(e.expression()) {}
+};
+
+} // namespace et
+
+#if !defined(CML_NO_LAZY_PRODUCTS)
+
+/** operator*() for two matrices. */
+template<typename E1, class AT1, typename L1,
+         typename E2, class AT2, typename L2,
+         typename BO>
+inline et::MatrixXpr<
+    et::MatrixMulOp< matrix<E1,AT1,BO,L1>, matrix<E2,AT2,BO,L2> >
+>
+operator*(const matrix<E1,AT1,BO,L1>& left,
+          const matrix<E2,AT2,BO,L2>& right)
+{
+    typedef et::MatrixMulOp<
+        matrix<E1,AT1,BO,L1>, matrix<E2,AT2,BO,L2> > ExprT;
+    return et::MatrixXpr<ExprT>(ExprT(left,right));
+}
+
+/** operator*() for a matrix and a MatrixXpr. */
+template<typename E, class AT, typename BO, typename L, typename XprT>
+inline et::MatrixXpr< et::MatrixMulOp< matrix<E,AT,BO,L>, XprT > >
+operator*(const matrix<E,AT,BO,L>& left,
+          const et::MatrixXpr<XprT>& right)
+{
+    typedef et::MatrixMulOp< matrix<E,AT,BO,L>, XprT > ExprT;
+    return et::MatrixXpr<ExprT>(ExprT(left,right.expression()));
+}
+
+/** operator*() for a MatrixXpr and a matrix. */
+template<typename XprT, typename E, class AT, typename BO, typename L>
+inline et::MatrixXpr< et::MatrixMulOp< XprT, matrix<E,AT,BO,L> > >
+operator*(const et::MatrixXpr<XprT>& left,
+          const matrix<E,AT,BO,L>& right)
+{
+    typedef et::MatrixMulOp< XprT, matrix<E,AT,BO,L> > ExprT;
+    return et::MatrixXpr<ExprT>(ExprT(left.expression(),right));
+}
+
+/** operator*() for two MatrixXpr's. */
+template<typename XprT1, typename XprT2>
+inline et::MatrixXpr< et::MatrixMulOp<XprT1,XprT2> >
+operator*(const et::MatrixXpr<XprT1>& left,
+          const et::MatrixXpr<XprT2>& right)
+{
+    typedef et::MatrixMulOp<XprT1,XprT2> ExprT;
+    return et::MatrixXpr<ExprT>(
+            ExprT(left.expression(),right.expression()));
+}
+
+#else
 
 /** operator*() for two matrices. */
 template<typename E1, class AT1, typename L1,
@@ -197,6 +790,8 @@ operator*(const et::MatrixXpr<XprT1>& left,
     return detail::mul(ltmp,rtmp);
 }
 
+#endif // CML_NO_LAZY_PRODUCTS
+
 } // namespace cml
 
 #endif
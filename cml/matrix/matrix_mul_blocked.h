@@ -0,0 +1,276 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Cache-blocked, register-tiled matrix multiplication.
+ *
+ * This implements C = A x B for large, run-time sized matrices using the
+ * usual three-level blocking scheme: B is copied a KC x NC panel at a time
+ * into a contiguous buffer of NR-wide column slivers, A is copied an MC x
+ * KC block at a time into a buffer of MR-high row slivers, and a small
+ * MR x NR micro-kernel accumulates each tile of C in registers.  The
+ * packing step reads the operands through their strides, so row-major and
+ * col-major arrays (and mixed layouts) are handled without first copying
+ * the operands into a promoted temporary.
+ *
+ * The packing buffers are aligned to CML_MUL_PACK_ALIGNMENT bytes (a cache
+ * line by default), so that each sliver starts on a cache line and the
+ * micro-kernel's loads of B never split one.
+ *
+ * The block sizes can be overridden by defining CML_MUL_BLOCK_MC,
+ * CML_MUL_BLOCK_KC and CML_MUL_BLOCK_NC before including CML.  MC must be
+ * a multiple of MR, and NC a multiple of NR.
+ *
+ * @sa CML_MATRIX_BLOCKED_MUL_THRESHOLD
+ */
+
+#ifndef matrix_mul_blocked_h
+#define matrix_mul_blocked_h
+
+#include <algorithm>
+#include <vector>
+#include <cml/core/common.h>
+#include <cml/core/aligned_allocator.h>
+#include <cml/core/parallel.h>
+
+/* Rows of A packed per block (must be a multiple of MR): */
+#if !defined(CML_MUL_BLOCK_MC)
+#define CML_MUL_BLOCK_MC 128
+#endif
+
+/* Depth of the packed A and B blocks: */
+#if !defined(CML_MUL_BLOCK_KC)
+#define CML_MUL_BLOCK_KC 256
+#endif
+
+/* Columns of B packed per panel (must be a multiple of NR): */
+#if !defined(CML_MUL_BLOCK_NC)
+#define CML_MUL_BLOCK_NC 2048
+#endif
+
+/* Alignment of the packing buffers, in bytes: */
+#if !defined(CML_MUL_PACK_ALIGNMENT)
+#define CML_MUL_PACK_ALIGNMENT 64
+#endif
+
+namespace cml {
+namespace detail {
+
+/** Register tile dimensions for the blocked multiply micro-kernel. */
+struct BlockedMulTile {
+    enum { MR = 4, NR = 8 };
+};
+
+/** The strides of a 2D array, in elements. */
+struct MatStrides {
+    MatStrides(size_t r, size_t c) : rs(r), cs(c) {}
+    size_t rs, cs;
+};
+
+/** Get the strides of a row-major array. */
+template<class MatT> inline MatStrides
+GetMatStrides(const MatT& m, row_major) {
+    return MatStrides(m.cols(), 1);
+}
+
+/** Get the strides of a col-major array. */
+template<class MatT> inline MatStrides
+GetMatStrides(const MatT& m, col_major) {
+    return MatStrides(1, m.rows());
+}
+
+/** Get the strides of a matrix based upon its layout. */
+template<class MatT> inline MatStrides
+GetMatStrides(const MatT& m) {
+    return GetMatStrides(m, typename MatT::layout());
+}
+
+/** Pack an mc x kc block of A into MR-high row slivers.
+ *
+ * Rows past mc are zero-filled, so the micro-kernel never needs to treat
+ * the edges of the matrix specially.
+ */
+template<typename T, typename SrcT> inline void
+blocked_mul_pack_A(T* buf, const SrcT* a, MatStrides s, size_t mc, size_t kc)
+{
+    enum { MR = BlockedMulTile::MR };
+    for(size_t ir = 0; ir < mc; ir += MR) {
+        size_t mr = std::min(size_t(MR), mc-ir);
+        const SrcT* a_ir = a + ir*s.rs;
+        for(size_t p = 0; p < kc; ++p) {
+            const SrcT* a_p = a_ir + p*s.cs;
+            size_t i = 0;
+            for(; i < mr; ++i) buf[i] = T(a_p[i*s.rs]);
+            for(; i < size_t(MR); ++i) buf[i] = T(0);
+            buf += MR;
+        }
+    }
+}
+
+/** Pack a kc x nc panel of B into NR-wide column slivers.
+ *
+ * Columns past nc are zero-filled.
+ */
+template<typename T, typename SrcT> inline void
+blocked_mul_pack_B(T* buf, const SrcT* b, MatStrides s, size_t kc, size_t nc)
+{
+    enum { NR = BlockedMulTile::NR };
+    for(size_t jr = 0; jr < nc; jr += NR) {
+        size_t nr = std::min(size_t(NR), nc-jr);
+        const SrcT* b_jr = b + jr*s.cs;
+        for(size_t p = 0; p < kc; ++p) {
+            const SrcT* b_p = b_jr + p*s.rs;
+            size_t j = 0;
+            for(; j < nr; ++j) buf[j] = T(b_p[j*s.cs]);
+            for(; j < size_t(NR); ++j) buf[j] = T(0);
+            buf += NR;
+        }
+    }
+}
+
+/** Accumulate one MR x NR tile of C from packed slivers of A and B.
+ *
+ * Only the leading mr x nr corner of the tile is written back to C.
+ *
+ * @internal The accumulator is a plain local array with compile-time
+ * bounds, so an optimizing compiler keeps it in (vector) registers and
+ * vectorizes the j loop.
+ */
+template<typename T> inline void
+blocked_mul_micro_kernel(
+        size_t kc, const T* a, const T* b,
+        T* c, MatStrides s, size_t mr, size_t nr)
+{
+    enum { MR = BlockedMulTile::MR, NR = BlockedMulTile::NR };
+
+    T ab[MR][NR];
+    for(int i = 0; i < MR; ++i)
+        for(int j = 0; j < NR; ++j) ab[i][j] = T(0);
+
+    for(size_t p = 0; p < kc; ++p) {
+        for(int i = 0; i < MR; ++i) {
+            T a_i = a[i];
+            for(int j = 0; j < NR; ++j) ab[i][j] += a_i*b[j];
+        }
+        a += MR; b += NR;
+    }
+
+    for(size_t i = 0; i < mr; ++i)
+        for(size_t j = 0; j < nr; ++j) c[i*s.rs + j*s.cs] += ab[i][j];
+}
+
+/** Blocked multiplication of rows [first,last) of C = A x B.
+ *
+ * Each call packs its own blocks of A and panels of B, so calls for
+ * disjoint row ranges can run at the same time.
+ */
+template<class ResultT, class LeftT, class RightT> void
+blocked_mul_rows(ResultT& C, const LeftT& A, const RightT& B,
+        size_t first, size_t last)
+{
+    typedef typename ResultT::value_type value_type;
+    enum {
+        MR = BlockedMulTile::MR, NR = BlockedMulTile::NR,
+        MC = CML_MUL_BLOCK_MC, KC = CML_MUL_BLOCK_KC, NC = CML_MUL_BLOCK_NC
+    };
+
+    size_t M = last - first, K = A.cols(), N = B.cols();
+    MatStrides sA = GetMatStrides(A);
+    MatStrides sB = GetMatStrides(B);
+    MatStrides sC = GetMatStrides(C);
+
+    /* Clear the rows of C, since each KC-deep block accumulates into them:
+     */
+    value_type* c = C.data();
+    for(size_t i = first; i < last; ++i)
+        for(size_t j = 0; j < N; ++j) c[i*sC.rs + j*sC.cs] = value_type(0);
+
+    /* The packing buffers hold whole slivers, so round the largest A
+     * block and B panel up to multiples of MR and NR:
+     */
+    size_t kc_max = std::min(size_t(KC), K);
+    size_t mc_max = (std::min(size_t(MC), M) + MR-1)/MR*MR;
+    size_t nc_max = (std::min(size_t(NC), N) + NR-1)/NR*NR;
+    typedef aligned_allocator<value_type,CML_MUL_PACK_ALIGNMENT> allocator;
+    std::vector<value_type,allocator> bufA(mc_max*kc_max);
+    std::vector<value_type,allocator> bufB(nc_max*kc_max);
+
+    for(size_t jc = 0; jc < N; jc += NC) {
+        size_t nc = std::min(size_t(NC), N-jc);
+
+        for(size_t pc = 0; pc < K; pc += KC) {
+            size_t kc = std::min(size_t(KC), K-pc);
+
+            /* Pack B(pc:pc+kc, jc:jc+nc): */
+            blocked_mul_pack_B(&bufB[0],
+                    B.data() + pc*sB.rs + jc*sB.cs, sB, kc, nc);
+
+            for(size_t ic = first; ic < last; ic += MC) {
+                size_t mc = std::min(size_t(MC), last-ic);
+
+                /* Pack A(ic:ic+mc, pc:pc+kc): */
+                blocked_mul_pack_A(&bufA[0],
+                        A.data() + ic*sA.rs + pc*sA.cs, sA, mc, kc);
+
+                /* Macro-kernel: sweep the packed slivers of B and A: */
+                for(size_t jr = 0; jr < nc; jr += NR) {
+                    size_t nr = std::min(size_t(NR), nc-jr);
+                    const value_type* b = &bufB[0] + jr*kc;
+                    for(size_t ir = 0; ir < mc; ir += MR) {
+                        size_t mr = std::min(size_t(MR), mc-ir);
+                        const value_type* a = &bufA[0] + ir*kc;
+                        value_type* c_ij =
+                            c + (ic+ir)*sC.rs + (jc+jr)*sC.cs;
+                        blocked_mul_micro_kernel(kc, a, b, c_ij, sC, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** Blocked matrix multiplication, C = A x B.
+ *
+ * C must already have the correct size.  A, B and C may each be row-major
+ * or col-major, and may be any matrix type exposing data() (fixed, dynamic
+ * or external storage).  The operand elements are converted to C's
+ * value_type as they are packed.
+ *
+ * When CML_PARALLEL is defined and the product is large enough, blocks of
+ * rows of C are computed on separate threads: MC rows each, or fewer (but
+ * at least 32) to give each thread two blocks.
+ *
+ * @note A and B must not alias C.
+ */
+template<class ResultT, class LeftT, class RightT> void
+blocked_mul(ResultT& C, const LeftT& A, const RightT& B)
+{
+    size_t M = A.rows();
+#if defined(CML_PARALLEL)
+    if(cml::parallel::use_threads_for_mul(M*A.cols()*B.cols())) {
+        enum { MR = BlockedMulTile::MR, MC = CML_MUL_BLOCK_MC };
+        size_t T = 2*cml::parallel::default_pool().size();
+        size_t rows = std::min(size_t(MC), (M + T-1)/T);
+        rows = std::max((rows + MR-1)/MR*MR, size_t(32));
+        cml::parallel::for_each_range(M, rows,
+                [&](size_t begin, size_t end) {
+                    blocked_mul_rows(C, A, B, begin, end);
+                });
+        return;
+    }
+#endif
+    blocked_mul_rows(C, A, B, 0, M);
+}
+
+} // namespace detail
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
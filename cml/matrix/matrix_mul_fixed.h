@@ -0,0 +1,204 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Unrolled kernels for small fixed-size matrix products.
+ *
+ * 2x2 and 3x3 products are written out in full.  4x4 products between
+ * matrices with the same element type are computed a row at a time using
+ * SIMD packets (see cml/core/simd.h): each row of C is the sum of the rows
+ * of B weighted by the corresponding row of A.  This requires B and C to
+ * be row-major; if instead A and C are col-major, the same kernel computes
+ * the transposed product C^T = B^T A^T directly on the stored arrays.  All
+ * remaining layout combinations use the scalar unrolled kernel.
+ *
+ * The basis orientation does not affect how the product is computed, so
+ * both row_basis and col_basis matrices use the same kernels.
+ *
+ * Define CML_NO_FIXED_MATRIX_MUL_KERNELS to use the generic loop instead.
+ */
+
+#ifndef matrix_mul_fixed_h
+#define matrix_mul_fixed_h
+
+#include <cml/core/simd.h>
+#include <cml/matrix/matrix_mul_blocked.h>
+
+namespace cml {
+namespace detail {
+
+/* Forward declare the generic loop from matrix_mul.h: */
+template<class ResultT, class LeftT, class RightT> void
+MatMulLoop(ResultT& C, const LeftT& left, const RightT& right);
+
+/** Compute a 4x4 product from contiguous row-major B and C.
+ *
+ * A is read through its strides, so it may have either layout.  AlignB and
+ * AlignC are the alignments of B and C in bytes; since every packet starts
+ * a multiple of W elements into a row, aligned loads and stores are used
+ * when an array is aligned to at least the packet size.
+ */
+template<int AlignB, int AlignC, typename T> inline void
+mul_4x4_rows(T* c, const T* a, MatStrides sA, const T* b)
+{
+    enum { W = simd::native_width_max<T,4>::value };
+    typedef simd::packet_traits<T,W> pt;
+    typedef typename pt::packet_type packet_type;
+    typedef simd::packet_memory<T,W,AlignB> mem_b;
+    typedef simd::packet_memory<T,W,AlignC> mem_c;
+
+    /* Load the rows of B once: */
+    packet_type b0[4/W], b1[4/W], b2[4/W], b3[4/W];
+    for(int w = 0; w < 4/W; ++w) {
+        b0[w] = mem_b::load(b + 0 + w*W);
+        b1[w] = mem_b::load(b + 4 + w*W);
+        b2[w] = mem_b::load(b + 8 + w*W);
+        b3[w] = mem_b::load(b + 12 + w*W);
+    }
+
+    for(int i = 0; i < 4; ++i) {
+        const T* a_i = a + i*sA.rs;
+        packet_type a0 = pt::set1(a_i[0*sA.cs]);
+        packet_type a1 = pt::set1(a_i[1*sA.cs]);
+        packet_type a2 = pt::set1(a_i[2*sA.cs]);
+        packet_type a3 = pt::set1(a_i[3*sA.cs]);
+        for(int w = 0; w < 4/W; ++w) {
+            packet_type r = pt::mul(a0, b0[w]);
+            r = pt::madd(a1, b1[w], r);
+            r = pt::madd(a2, b2[w], r);
+            r = pt::madd(a3, b3[w], r);
+            mem_c::store(c + 4*i + w*W, r);
+        }
+    }
+}
+
+/** Fully unrolled 2x2 product. */
+template<class ResultT, class LeftT, class RightT> inline void
+mul_2x2_unrolled(ResultT& C, const LeftT& A, const RightT& B)
+{
+    typedef typename ResultT::value_type T;
+    T a00 = A(0,0), a01 = A(0,1), a10 = A(1,0), a11 = A(1,1);
+    T b00 = B(0,0), b01 = B(0,1), b10 = B(1,0), b11 = B(1,1);
+    C(0,0) = a00*b00 + a01*b10; C(0,1) = a00*b01 + a01*b11;
+    C(1,0) = a10*b00 + a11*b10; C(1,1) = a10*b01 + a11*b11;
+}
+
+/** Fully unrolled 3x3 product. */
+template<class ResultT, class LeftT, class RightT> inline void
+mul_3x3_unrolled(ResultT& C, const LeftT& A, const RightT& B)
+{
+    typedef typename ResultT::value_type T;
+    T b00 = B(0,0), b01 = B(0,1), b02 = B(0,2);
+    T b10 = B(1,0), b11 = B(1,1), b12 = B(1,2);
+    T b20 = B(2,0), b21 = B(2,1), b22 = B(2,2);
+    for(int i = 0; i < 3; ++i) {
+        T a0 = A(i,0), a1 = A(i,1), a2 = A(i,2);
+        C(i,0) = a0*b00 + a1*b10 + a2*b20;
+        C(i,1) = a0*b01 + a1*b11 + a2*b21;
+        C(i,2) = a0*b02 + a1*b12 + a2*b22;
+    }
+}
+
+/** Fully unrolled scalar 4x4 product. */
+template<class ResultT, class LeftT, class RightT> inline void
+mul_4x4_unrolled(ResultT& C, const LeftT& A, const RightT& B)
+{
+    typedef typename ResultT::value_type T;
+    for(int i = 0; i < 4; ++i) {
+        T a0 = A(i,0), a1 = A(i,1), a2 = A(i,2), a3 = A(i,3);
+        C(i,0) = a0*B(0,0) + a1*B(1,0) + a2*B(2,0) + a3*B(3,0);
+        C(i,1) = a0*B(0,1) + a1*B(1,1) + a2*B(2,1) + a3*B(3,1);
+        C(i,2) = a0*B(0,2) + a1*B(1,2) + a2*B(2,2) + a3*B(3,2);
+        C(i,3) = a0*B(0,3) + a1*B(1,3) + a2*B(2,3) + a3*B(3,3);
+    }
+}
+
+/** Select the 4x4 kernel from the layouts of C, A and B.
+ *
+ * The first argument is true when A, B and C have the same element type,
+ * so that the packet kernel can read their arrays directly.
+ */
+template<class ResultT, class LeftT, class RightT, class LA, class LB>
+inline void FixedMul4x4(ResultT& C, const LeftT& A, const RightT& B,
+        true_type, row_major, LA, row_major)
+{
+    mul_4x4_rows<RightT::array_alignment, ResultT::array_alignment>(
+            C.data(), A.data(), GetMatStrides(A), B.data());
+}
+
+template<class ResultT, class LeftT, class RightT, class LB>
+inline void FixedMul4x4(ResultT& C, const LeftT& A, const RightT& B,
+        true_type, col_major, col_major, LB)
+{
+    /* C^T = B^T A^T, where C^T and A^T are the stored row-major arrays: */
+    MatStrides sB = GetMatStrides(B);
+    mul_4x4_rows<LeftT::array_alignment, ResultT::array_alignment>(
+            C.data(), B.data(), MatStrides(sB.cs,sB.rs), A.data());
+}
+
+template<class ResultT, class LeftT, class RightT,
+    class SameT, class LC, class LA, class LB>
+inline void FixedMul4x4(ResultT& C, const LeftT& A, const RightT& B,
+        SameT, LC, LA, LB)
+{
+    mul_4x4_unrolled(C, A, B);
+}
+
+/** Dispatch a fixed-size product by its dimensions.
+ *
+ * Square products of size 2, 3 and 4 use the unrolled kernels; everything
+ * else falls through to the loop.
+ */
+template<int Rows, int Inner, int Cols> struct FixedMatMul {
+    enum { unrolled = false };
+    template<class ResultT, class LeftT, class RightT>
+    static void mul(ResultT& C, const LeftT& A, const RightT& B) {
+        MatMulLoop(C, A, B);
+    }
+};
+
+template<> struct FixedMatMul<2,2,2> {
+    enum { unrolled = true };
+    template<class ResultT, class LeftT, class RightT>
+    static void mul(ResultT& C, const LeftT& A, const RightT& B) {
+        mul_2x2_unrolled(C, A, B);
+    }
+};
+
+template<> struct FixedMatMul<3,3,3> {
+    enum { unrolled = true };
+    template<class ResultT, class LeftT, class RightT>
+    static void mul(ResultT& C, const LeftT& A, const RightT& B) {
+        mul_3x3_unrolled(C, A, B);
+    }
+};
+
+template<> struct FixedMatMul<4,4,4> {
+    enum { unrolled = true };
+    template<class ResultT, class LeftT, class RightT>
+    static void mul(ResultT& C, const LeftT& A, const RightT& B) {
+        typedef typename ResultT::value_type T;
+        typedef typename LeftT::value_type T1;
+        typedef typename RightT::value_type T2;
+        typedef typename is_true<
+            same_type<T,T1>::is_true && same_type<T,T2>::is_true
+            >::result same_elements;
+        FixedMul4x4(C, A, B, same_elements(),
+                typename ResultT::layout(),
+                typename LeftT::layout(),
+                typename RightT::layout());
+    }
+};
+
+} // namespace detail
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
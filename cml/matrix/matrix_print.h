@@ -14,6 +14,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define matrix_print_h
 
 #include <iostream>
+#include <vector>
 
 namespace cml {
 
@@ -51,6 +52,102 @@ operator<<(std::ostream& os, const et::MatrixXpr<XprT>& m)
     return os;
 }
 
+namespace detail {
+
+/* Skip spaces and tabs, but not newlines: */
+inline void skip_blanks(std::istream& is)
+{
+    for(;;) {
+        std::istream::int_type c = is.peek();
+        if(c != ' ' && c != '\t' && c != '\r') return;
+        is.get();
+    }
+}
+
+/* Read c, after any whitespace: */
+inline bool read_char(std::istream& is, char c)
+{
+    char d;
+    if(is >> d && d == c) return true;
+    is.setstate(std::ios::failbit);
+    return false;
+}
+
+/* Read the rows of a resizable matrix, up to a blank line or a line that
+ * does not start with [:
+ */
+template<typename E, class AT, typename BO, class L> inline void
+read_matrix_rows(std::istream& is, matrix<E,AT,BO,L>& m, resizable_tag)
+{
+    std::vector<E> values;
+    size_t rows = 0, cols = 0;
+    is >> std::ws;
+    while(is.peek() == '[') {
+        is.get();
+        size_t n = 0;
+        for(;;) {
+            is >> std::ws;
+            if(is.peek() == ']') { is.get(); break; }
+            E value;
+            if(!(is >> value)) return;
+            values.push_back(value);
+            ++n;
+        }
+        if(rows > 0 && n != cols) {
+            is.setstate(std::ios::failbit);
+            return;
+        }
+        cols = n;
+        ++rows;
+
+        /* Continue on the next line: */
+        skip_blanks(is);
+        if(is.peek() != '\n') break;
+        is.get();
+        skip_blanks(is);
+    }
+    if(rows == 0) {
+        is.setstate(std::ios::failbit);
+        return;
+    }
+    m.resize(rows, cols);
+    for(size_t i = 0, k = 0; i < rows; ++i) {
+        for(size_t j = 0; j < cols; ++j) m(i,j) = values[k++];
+    }
+}
+
+template<typename E, class AT, typename BO, class L> inline void
+read_matrix_rows(std::istream& is, matrix<E,AT,BO,L>&, not_resizable_tag)
+{
+    is.setstate(std::ios::failbit);
+}
+
+} // namespace detail
+
+/** Input a matrix from a std::istream, as written by operator<<.
+ *
+ * Each row is enclosed in brackets, e.g. "[ 1 0 ]\n[ 0 1 ]".  A resizable
+ * matrix of size 0 is resized to hold the rows on consecutive lines, up
+ * to a blank line or a line that does not start with a bracket.
+ */
+template<typename E, class AT, typename BO, class L> inline std::istream&
+operator>>(std::istream& is, matrix<E,AT,BO,L>& m)
+{
+    if(m.rows() == 0 || m.cols() == 0) {
+        typedef typename matrix<E,AT,BO,L>::resizing_tag resizing_tag;
+        detail::read_matrix_rows(is, m, resizing_tag());
+        return is;
+    }
+    for(size_t i = 0; i < m.rows(); ++i) {
+        if(!detail::read_char(is, '[')) return is;
+        for(size_t j = 0; j < m.cols(); ++j) {
+            if(!(is >> m(i,j))) return is;
+        }
+        if(!detail::read_char(is, ']')) return is;
+    }
+    return is;
+}
+
 } // namespace cml
 
 #endif
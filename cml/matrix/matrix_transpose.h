@@ -154,6 +154,36 @@ struct ExprTraits< MatrixTransposeOp<ExprT> >
     size_t cols(const expr_type& e) const { return e.cols(); }
 };
 
+/** Materialize<> for MatrixTransposeOp<>: evaluate the products of the
+ * subexpression.
+ */
+template<class ExprT>
+class Materialize< MatrixTransposeOp<ExprT> >
+{
+  public:
+
+    typedef Materialize<ExprT> expr_materialize;
+    typedef MatrixTransposeOp<typename expr_materialize::type> type;
+
+
+  public:
+
+    /** Return the expression with its products evaluated. */
+    type expression() const { return type(m_expr.expression()); }
+
+
+  public:
+
+    /** Evaluate the products of e. */
+    explicit Materialize(const MatrixTransposeOp<ExprT>& e)
+        : m_expr(e.expression()) {}
+
+
+  protected:
+
+    expr_materialize m_expr;
+};
+
 } // namespace et
 
 
@@ -22,6 +22,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/et/traits.h>
 #include <cml/et/size_checking.h>
 #include <cml/et/scalar_ops.h>
+#include <cml/core/parallel.h>
 
 #if !defined(CML_2D_UNROLLER) && !defined(CML_NO_2D_UNROLLER)
 #error "The matrix unroller has not been defined."
@@ -237,6 +238,10 @@ class MatrixAssignmentUnroller
 
 
     /** Use a loop for dynamic-sized matrix assignment.
+     *
+     * When CML_PARALLEL is defined and the matrix is large enough, the
+     * rows are split across threads.  The products in src were already
+     * computed by MatrixAssignment<>, so the threads only read from it.
      *
      * @note The target matrix must already have the correct size.
      *
@@ -245,11 +250,32 @@ class MatrixAssignmentUnroller
      */
     void operator()(matrix_type& dest, const SrcT& src, cml::dynamic_size_tag)
     {
-        typedef ExprTraits<SrcT> src_traits;
         matrix_size N = this->CheckOrResize(
                 dest,src,typename matrix_type::resizing_tag());
-        for(size_t i = 0; i < N.first; ++i) {
-            for(size_t j = 0; j < N.second; ++j) {
+#if defined(CML_PARALLEL)
+        if(cml::parallel::use_threads(N.first*N.second)) {
+            size_t grain = cml::parallel::get_policy().grain;
+            grain = std::max(grain/std::max(N.second, size_t(1)), size_t(1));
+            cml::parallel::for_each_range(N.first, grain,
+                    [&](size_t begin, size_t end) {
+                        this->Loop(dest, src, begin, end, N.second);
+                    });
+            return;
+        }
+#endif
+        this->Loop(dest, src, 0, N.first, N.second);
+    }
+
+
+  protected:
+
+    /** Evaluate rows [first,last) of a dynamic-sized assignment. */
+    void Loop(matrix_type& dest, const SrcT& src,
+            size_t first, size_t last, size_t cols)
+    {
+        typedef ExprTraits<SrcT> src_traits;
+        for(size_t i = first; i < last; ++i) {
+            for(size_t j = 0; j < cols; ++j) {
                 OpT().apply(dest(i,j), src_traits().get(src,i,j));
                 /* Note: we don't need get(), since dest is a matrix. */
             }
@@ -257,6 +283,31 @@ class MatrixAssignmentUnroller
     }
 };
 
+/** Assign an expression to a matrix.
+ *
+ * The primary template assigns element by element with the unroller,
+ * after computing the products in src into temporaries (see
+ * Materialize<>).  Expressions that are better evaluated as a whole
+ * specialize this, e.g. matrix products in cml/matrix/matrix_mul.h.
+ */
+template<class SrcT> struct MatrixAssignment
+{
+    template<class OpT, typename E, class AT, typename BO, typename L>
+        static void assign(cml::matrix<E,AT,BO,L>& dest, const SrcT& src)
+        {
+            typedef cml::matrix<E,AT,BO,L> matrix_type;
+            typedef typename Materialize<SrcT>::type src_type;
+            typedef MatrixAssignmentUnroller<OpT,E,AT,BO,L,src_type>
+                unroller;
+            Materialize<SrcT> evaluated(src);
+            unroller()(dest, evaluated.expression(),
+                    typename matrix_type::size_tag());
+            /* XXX It may make sense to unroll if either side is a fixed
+             * size.
+             */
+        }
+};
+
 }
 
 /** This constructs an assignment unroller for fixed-size arrays.
@@ -273,15 +324,7 @@ class MatrixAssignmentUnroller
 template<class OpT, class SrcT, typename E, class AT, typename BO, typename L>
 inline void UnrollAssignment(cml::matrix<E,AT,BO,L>& dest, const SrcT& src)
 {
-    /* Record the destination matrix type, and the expression traits: */
-    typedef cml::matrix<E,AT,BO,L> matrix_type;
-
-    /* Record the type of the unroller: */
-    typedef detail::MatrixAssignmentUnroller<OpT,E,AT,BO,L,SrcT> unroller;
-
-    /* Finally, do the unroll call: */
-    unroller()(dest, src, typename matrix_type::size_tag());
-    /* XXX It may make sense to unroll if either side is a fixed size. */
+    detail::MatrixAssignment<SrcT>::template assign<OpT>(dest, src);
 }
 
 } // namespace et
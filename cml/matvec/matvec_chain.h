@@ -0,0 +1,620 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Multiply a chain of matrices, optionally applied to a vector.
+ *
+ * mul_chain(m1,m2,...,mn) computes m1*m2*...*mn, and mul_chain(m1,...,mn,x)
+ * computes m1*m2*...*mn*x, for up to 10 matrices of the same type.  The
+ * order of the products is chosen to need the fewest multiplications:
+ *
+ * - Fixed-size matrices in a chain are square, so every order of the
+ *   matrix products costs the same; the chain is multiplied left to right,
+ *   and applied to x right to left, one mat-vec product per matrix.
+ * - For run-time sized matrices, the order is found when the product is
+ *   computed, from the sizes of the matrices (the classic matrix-chain
+ *   dynamic program).
+ *
+ * Intermediate matrix products are written into a workspace held by a
+ * matrix_chain<>: two matrices, used in turn, for a chain multiplied from
+ * one end, and one more for each level of nesting otherwise.  A
+ * matrix_chain<> can be kept to reuse its workspace between products (e.g.
+ * once per frame), so that a chain of run-time sized matrices allocates
+ * nothing once the workspace has grown to the largest product.  Chains
+ * longer than 10 matrices, up to CML_MUL_CHAIN_MAX_LENGTH, can be built
+ * with matrix_chain<>::push_back().
+ */
+
+#ifndef matvec_chain_h
+#define matvec_chain_h
+
+#include <stdexcept>
+#include <cml/matrix/matrix_mul.h>
+#include <cml/matvec/matvec_mul.h>
+
+namespace cml {
+namespace detail {
+
+/** The number of workspace matrices a chain may need. */
+template<class SizeT> struct MulChainWorkspace {
+    enum { size = CML_MUL_CHAIN_MAX_LENGTH };
+};
+
+/** Fixed-size chains are multiplied from one end. */
+template<> struct MulChainWorkspace<fixed_size_tag> {
+    enum { size = 2 };
+};
+
+} // namespace detail
+
+/** A chain of matrices of the same type, to be multiplied together.
+ *
+ * The chain holds pointers to the matrices, which must outlive it, or be
+ * removed by clear() first.
+ *
+ * @sa mul_chain
+ */
+template<class MatT>
+class matrix_chain
+{
+  public:
+
+    typedef matrix_chain<MatT> chain_type;
+    typedef MatT matrix_type;
+    typedef typename MatT::value_type value_type;
+    typedef typename MatT::size_tag size_tag;
+    typedef typename MatT::temporary_type temporary_type;
+
+    /** The vector type of the chain applied to a vector of type VecT. */
+    template<class VecT> struct vector_result {
+        typedef typename detail::MatVecMulPromote<
+            temporary_type, VecT, detail::mul_Ax>::type type;
+    };
+
+    /** The longest chain. */
+    enum { max_length = CML_MUL_CHAIN_MAX_LENGTH };
+
+
+  public:
+
+    /** Create an empty chain. */
+    matrix_chain() : m_length(0) {}
+
+
+  public:
+
+    /** Return the number of matrices in the chain. */
+    size_t length() const { return m_length; }
+
+    /** Remove the matrices from the chain, keeping the workspace. */
+    void clear() { m_length = 0; }
+
+    /** Append m to the chain.
+     *
+     * @throws std::length_error if the chain already has max_length
+     * matrices.
+     */
+    chain_type& push_back(const MatT& m) {
+        CML_THROW_IF(m_length == size_t(max_length),
+                std::length_error("matrix chain is too long."));
+        m_ops[m_length++] = &m;
+        return *this;
+    }
+
+    /** Compute C = m1*m2*...*mn.
+     *
+     * C may be one of the matrices in the chain.
+     *
+     * @throws std::invalid_argument if the chain is empty, or if the sizes
+     * of the matrices are incompatible.
+     */
+    template<class ResultT> void product(ResultT& C) {
+        this->check_sizes(0);
+        if(m_length == 1) {
+            C = this->op(0);
+        } else if(this->operands_alias(C)) {
+            temporary_type P;
+            this->chain_product(P, size_tag());
+            C = P;
+        } else {
+            this->chain_product(C, size_tag());
+        }
+    }
+
+    /** Compute y = m1*m2*...*mn*x.
+     *
+     * y may be x, or share storage with one of the matrices.
+     *
+     * @throws std::invalid_argument if the chain is empty, or if the sizes
+     * of the matrices and x are incompatible.
+     */
+    template<class ResultT, class VecT>
+        void product(ResultT& y, const VecT& x)
+        {
+            this->check_sizes(x.size());
+            if(et::detail::OperandAliases(y, x) || this->operands_alias(y)) {
+                typename vector_result<VecT>::type z;
+                this->chain_product(z, x, size_tag());
+                y = z;
+            } else {
+                this->chain_product(y, x, size_tag());
+            }
+        }
+
+
+  protected:
+
+    /* Return matrix i of the chain: */
+    const MatT& op(size_t i) const { return *m_ops[i]; }
+
+    /* Fail if the chain is empty, or if its sizes are incompatible (with
+     * a vector of size N, if N > 0):
+     */
+    void check_sizes(size_t N) const {
+        CML_THROW_IF(m_length == 0,
+                std::invalid_argument("matrix chain is empty."));
+        bool ok = (N == 0 || this->op(m_length-1).cols() == N);
+        for(size_t i = 1; i < m_length; ++i) {
+            ok = ok && (this->op(i-1).cols() == this->op(i).rows());
+        }
+        CML_THROW_IF(!ok, std::invalid_argument(
+                    "matrix chain has incompatible sizes."));
+    }
+
+    /* True if dest shares storage with any matrix of the chain: */
+    template<class DestT> bool operands_alias(const DestT& dest) const {
+        for(size_t i = 0; i < m_length; ++i) {
+            if(et::detail::OperandAliases(dest, this->op(i))) return true;
+        }
+        return false;
+    }
+
+    /* Compute C = A*B: */
+    template<class ResultT, class LeftT, class RightT>
+        static void mul(ResultT& C, const LeftT& A, const RightT& B)
+        {
+            cml::et::detail::Resize(C, A.rows(), B.cols());
+            cml::detail::MatMulKernel(C, A, B, size_tag());
+        }
+
+    /* Compute y = A*x: */
+    template<class ResultT, class LeftT, class VecT>
+        static void mul_vector(ResultT& y, const LeftT& A, const VecT& x)
+        {
+            typedef typename ResultT::value_type sum_type;
+            typedef et::OpAssign<sum_type,sum_type> op_type;
+            cml::et::detail::Resize(y, A.rows());
+            cml::detail::MatVecLoop<op_type>(y, A, x,
+                    et::detail::ProductTerm(), detail::mul_Ax());
+        }
+
+
+  protected:
+
+    /* Multiply a fixed-size chain from left to right: */
+    template<class ResultT>
+        void chain_product(ResultT& C, fixed_size_tag)
+        {
+            size_t last = m_length-1, w = 0;
+            if(last == 1) {
+                mul(C, this->op(0), this->op(1));
+                return;
+            }
+            mul(m_work[0], this->op(0), this->op(1));
+            for(size_t i = 2; i < last; ++i, w = 1-w) {
+                mul(m_work[1-w], m_work[w], this->op(i));
+            }
+            mul(C, m_work[w], this->op(last));
+        }
+
+    /* Apply a fixed-size chain to x from right to left: */
+    template<class ResultT, class VecT>
+        void chain_product(ResultT& y, const VecT& x, fixed_size_tag)
+        {
+            typedef typename vector_result<VecT>::type vector_type;
+            if(m_length == 1) {
+                mul_vector(y, this->op(0), x);
+                return;
+            }
+            vector_type v[2];
+            size_t w = 0;
+            mul_vector(v[0], this->op(m_length-1), x);
+            for(size_t i = m_length-2; i > 0; --i, w = 1-w) {
+                mul_vector(v[1-w], this->op(i), v[w]);
+            }
+            mul_vector(y, this->op(0), v[w]);
+        }
+
+    /* Multiply a run-time sized chain in the cheapest order: */
+    template<class ResultT>
+        void chain_product(ResultT& C, dynamic_size_tag)
+        {
+            size_t p[max_length+1];
+            for(size_t i = 0; i < m_length; ++i) {
+                p[i] = this->op(i).rows();
+            }
+            p[m_length] = this->op(m_length-1).cols();
+            this->order(p, m_length);
+            this->reset_workspace();
+            this->multiply(C, 0, m_length-1, size_t(-1));
+        }
+
+    /* Apply a run-time sized chain to x in the cheapest order.
+     *
+     * x is treated as the last matrix (with one column) of the chain, so
+     * the products form a spine of blocks m_i*...*m_k from the right,
+     * each one applied in turn to the vector computed so far.
+     */
+    template<class ResultT, class VecT>
+        void chain_product(ResultT& y, const VecT& x, dynamic_size_tag)
+        {
+            typedef typename vector_result<VecT>::type vector_type;
+            size_t p[max_length+2];
+            for(size_t i = 0; i < m_length; ++i) {
+                p[i] = this->op(i).rows();
+            }
+            p[m_length] = x.size();
+            p[m_length+1] = 1;
+            this->order(p, m_length+1);
+            this->reset_workspace();
+
+            /* Find the first matrix of each block: */
+            size_t first[max_length], n = 0;
+            for(size_t i = 0; i < m_length; i = m_split[i][m_length]+1) {
+                first[n++] = i;
+            }
+
+            /* Apply the blocks from the right: */
+            vector_type v[2];
+            size_t w = 0, end = m_length;
+            for(size_t b = n; b > 0; --b) {
+                size_t i = first[b-1], k = end-1;
+                if(b == 1) {
+                    this->apply(y, i, k, x, v[w], b == n);
+                } else {
+                    this->apply(v[1-w], i, k, x, v[w], b == n);
+                    w = 1-w;
+                }
+                end = i;
+            }
+        }
+
+    /* Compute y = (m_i*...*m_k)*v, where v is x for the first block: */
+    template<class ResultT, class VecT, class TmpT>
+        void apply(ResultT& y, size_t i, size_t k, const VecT& x,
+                const TmpT& v, bool first)
+        {
+            if(i == k) {
+                if(first) mul_vector(y, this->op(i), x);
+                else mul_vector(y, this->op(i), v);
+            } else {
+                size_t t = this->acquire(size_t(-1));
+                this->multiply(m_work[t], i, k, t);
+                if(first) mul_vector(y, m_work[t], x);
+                else mul_vector(y, m_work[t], v);
+                m_busy[t] = false;
+            }
+        }
+
+    /* Find the cheapest order to multiply the n matrices with sizes
+     * p[i] x p[i+1], filling m_split:
+     */
+    void order(const size_t* p, size_t n) {
+        size_t cost[max_length+1][max_length+1];
+        for(size_t i = 0; i < n; ++i) cost[i][i] = 0;
+        for(size_t len = 1; len < n; ++len) {
+            for(size_t i = 0; i + len < n; ++i) {
+                size_t j = i + len;
+                cost[i][j] = size_t(-1);
+                for(size_t k = i; k < j; ++k) {
+                    size_t c = cost[i][k] + cost[k+1][j]
+                        + p[i]*p[k+1]*p[j+1];
+                    if(c < cost[i][j]) {
+                        cost[i][j] = c;
+                        m_split[i][j] = k;
+                    }
+                }
+            }
+        }
+    }
+
+    /* Compute dest = m_i*...*m_j, for j > i.  out is the workspace index
+     * of dest, which the two factors must not be written to, or -1:
+     */
+    template<class ResultT>
+        void multiply(ResultT& dest, size_t i, size_t j, size_t out)
+        {
+            size_t k = m_split[i][j];
+            if(k == i && k+1 == j) {
+                mul(dest, this->op(i), this->op(j));
+            } else if(k == i) {
+                size_t b = this->evaluate(k+1, j, out);
+                mul(dest, this->op(i), m_work[b]);
+                m_busy[b] = false;
+            } else if(k+1 == j) {
+                size_t a = this->evaluate(i, k, out);
+                mul(dest, m_work[a], this->op(j));
+                m_busy[a] = false;
+            } else {
+                size_t a = this->evaluate(i, k, out);
+                size_t b = this->evaluate(k+1, j, out);
+                mul(dest, m_work[a], m_work[b]);
+                m_busy[a] = m_busy[b] = false;
+            }
+        }
+
+    /* Compute m_i*...*m_j into a workspace matrix other than out, and
+     * return its index.  The matrix stays busy until released:
+     */
+    size_t evaluate(size_t i, size_t j, size_t out) {
+        size_t t = this->acquire(out);
+        this->multiply(m_work[t], i, j, t);
+        m_busy[t] = true;
+        return t;
+    }
+
+    /* Return the index of a workspace matrix that is neither busy nor
+     * out.  It is not marked busy until its product is computed, so the
+     * factors of that product may reuse the matrices of its parent:
+     */
+    size_t acquire(size_t out) const {
+        size_t t = 0;
+        while(m_busy[t] || t == out) ++t;
+        return t;
+    }
+
+    void reset_workspace() {
+        for(size_t i = 0; i < size_t(workspace_size); ++i) {
+            m_busy[i] = false;
+        }
+    }
+
+
+  protected:
+
+    enum { workspace_size = detail::MulChainWorkspace<size_tag>::size };
+
+    const MatT* m_ops[max_length];
+    size_t m_length;
+
+    /* The matrix after which the product of m_i..m_j is split: */
+    size_t m_split[max_length+1][max_length+1];
+
+    /* The workspace: */
+    temporary_type m_work[workspace_size];
+    bool m_busy[workspace_size];
+
+
+  private:
+
+    /* Cannot be copied: */
+    matrix_chain(const chain_type&);
+    chain_type& operator=(const chain_type&);
+};
+
+namespace detail {
+
+/** Return the product of the n matrices m[0]..m[n-1]. */
+template<class MatT> inline typename MatT::temporary_type
+MulChain(const MatT* const* m, size_t n)
+{
+    matrix_chain<MatT> chain;
+    for(size_t i = 0; i < n; ++i) chain.push_back(*m[i]);
+    typename MatT::temporary_type C;
+    chain.product(C);
+    return C;
+}
+
+/** Return the product of the n matrices m[0]..m[n-1] and x. */
+template<class MatT, class VecT> inline
+typename matrix_chain<MatT>::template vector_result<VecT>::type
+MulChain(const MatT* const* m, size_t n, const VecT& x)
+{
+    matrix_chain<MatT> chain;
+    for(size_t i = 0; i < n; ++i) chain.push_back(*m[i]);
+    typename matrix_chain<MatT>::template vector_result<VecT>::type y;
+    chain.product(y, x);
+    return y;
+}
+
+} // namespace detail
+
+/* Products of 2 to 10 matrices: */
+
+/** Return m1*m2. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2)
+{
+    const MatT* m[] = { &m1, &m2 };
+    return detail::MulChain(m, 2);
+}
+
+/** Return m1*m2*m3. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3)
+{
+    const MatT* m[] = { &m1, &m2, &m3 };
+    return detail::MulChain(m, 3);
+}
+
+/** Return m1*m2*m3*m4. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4 };
+    return detail::MulChain(m, 4);
+}
+
+/** Return m1*...*m5. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5 };
+    return detail::MulChain(m, 5);
+}
+
+/** Return m1*...*m6. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6 };
+    return detail::MulChain(m, 6);
+}
+
+/** Return m1*...*m7. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6, &m7 };
+    return detail::MulChain(m, 7);
+}
+
+/** Return m1*...*m8. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7, const MatT& m8)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6, &m7, &m8 };
+    return detail::MulChain(m, 8);
+}
+
+/** Return m1*...*m9. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7, const MatT& m8,
+        const MatT& m9)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6, &m7, &m8, &m9 };
+    return detail::MulChain(m, 9);
+}
+
+/** Return m1*...*m10. */
+template<class MatT> inline typename MatT::temporary_type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7, const MatT& m8,
+        const MatT& m9, const MatT& m10)
+{
+    const MatT* m[] = {
+        &m1, &m2, &m3, &m4, &m5, &m6, &m7, &m8, &m9, &m10 };
+    return detail::MulChain(m, 10);
+}
+
+/* Products of 1 to 10 matrices and a vector: */
+
+/** Return m1*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1 };
+    return detail::MulChain(m, 1, x);
+}
+
+/** Return m1*m2*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2 };
+    return detail::MulChain(m, 2, x);
+}
+
+/** Return m1*m2*m3*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3,
+        const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2, &m3 };
+    return detail::MulChain(m, 3, x);
+}
+
+/** Return m1*...*m4*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4 };
+    return detail::MulChain(m, 4, x);
+}
+
+/** Return m1*...*m5*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5 };
+    return detail::MulChain(m, 5, x);
+}
+
+/** Return m1*...*m6*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6 };
+    return detail::MulChain(m, 6, x);
+}
+
+/** Return m1*...*m7*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7,
+        const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6, &m7 };
+    return detail::MulChain(m, 7, x);
+}
+
+/** Return m1*...*m8*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7, const MatT& m8,
+        const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6, &m7, &m8 };
+    return detail::MulChain(m, 8, x);
+}
+
+/** Return m1*...*m9*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7, const MatT& m8,
+        const MatT& m9, const vector<E,AT>& x)
+{
+    const MatT* m[] = { &m1, &m2, &m3, &m4, &m5, &m6, &m7, &m8, &m9 };
+    return detail::MulChain(m, 9, x);
+}
+
+/** Return m1*...*m10*x. */
+template<class MatT, typename E, class AT> inline
+typename matrix_chain<MatT>::template vector_result< vector<E,AT> >::type
+mul_chain(const MatT& m1, const MatT& m2, const MatT& m3, const MatT& m4,
+        const MatT& m5, const MatT& m6, const MatT& m7, const MatT& m8,
+        const MatT& m9, const MatT& m10, const vector<E,AT>& x)
+{
+    const MatT* m[] = {
+        &m1, &m2, &m3, &m4, &m5, &m6, &m7, &m8, &m9, &m10 };
+    return detail::MulChain(m, 10, x);
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
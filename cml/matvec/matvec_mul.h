@@ -9,15 +9,22 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 /** @file
  *  @brief Multiply a matrix and a vector.
  *
- * @todo Implement smarter temporary generation.
+ * A product is returned as an et::MatVecMulOp node, which is evaluated when
+ * it is assigned: y = A*x, and y = A*x + z (or any other element-wise
+ * operation of the product with an operand), are written straight into y
+ * in a single pass.  An operand that is a vector expression is evaluated
+ * into a temporary first, so y = A*(B*x) needs just the temporary for B*x.
  *
- * @todo Does it make sense to put mat-vec multiplication as a node into the
- * expression tree?
+ * A matrix operand that is itself a product is not computed: (A*B)*x is
+ * evaluated as A*(B*x), and x*(A*B) as (x*A)*B, replacing the O(N^3)
+ * mat-mat product with two O(N^2) mat-vec products.  If y shares storage
+ * with A or x, the product is computed into a temporary before y is
+ * written.
  *
- * @internal This does not need to return an expression type, since the
- * temporary generation for the matrix result is handled automatically by the
- * compiler.  i.e. when used in an expression, the result is automatically
- * included in the expression tree as a temporary by the compiler.
+ * As for matrix products, a product that is part of a larger expression
+ * is computed into a temporary by et::Materialize<> before the expression
+ * is read.  Define CML_NO_LAZY_PRODUCTS to have operator*() return the
+ * product as a temporary vector instead.
  */
 
 #ifndef	matvec_mul_h
@@ -26,7 +33,9 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/core/cml_meta.h>
 #include <cml/vector/vector_expr.h>
 #include <cml/matrix/matrix_expr.h>
+#include <cml/matrix/matrix_mul.h>
 #include <cml/matvec/matvec_promotions.h>
+#include <cml/core/parallel.h>
 
 /* This is used below to create a more meaningful compile-time error when
  * mat-vec mul is not provided with the right arguments:
@@ -41,6 +50,17 @@ namespace detail {
 typedef true_type mul_Ax;
 typedef false_type mul_xA;
 
+/** Deduce the vector type of A*x (mul_Ax) or x*A (mul_xA). */
+template<class MatT, class VecT, class OrderT> struct MatVecMulPromote;
+
+template<class MatT, class VecT> struct MatVecMulPromote<MatT,VecT,mul_Ax> {
+    typedef typename et::MatVecPromote<MatT,VecT>::temporary_type type;
+};
+
+template<class MatT, class VecT> struct MatVecMulPromote<MatT,VecT,mul_xA> {
+    typedef typename et::MatVecPromote<VecT,MatT>::temporary_type type;
+};
+
 /** Compute y = A*x. */
 template<typename LeftT, typename RightT> inline
 typename et::MatVecPromote<
@@ -145,8 +165,616 @@ mul(const LeftT& x, const RightT& A, mul_xA)
     return y;
 }
 
+/** Return the size of A*x. */
+template<class MatT> inline size_t MatVecSize(const MatT& A, mul_Ax) {
+    return A.rows();
+}
+
+/** Return the size of x*A. */
+template<class MatT> inline size_t MatVecSize(const MatT& A, mul_xA) {
+    return A.cols();
+}
+
+/** Compute elements [first,last) of y OpT= f(A*x). */
+template<class OpT, class ResultT, class MatT, class VecT, class CombineT>
+void MatVecRange(ResultT& y, const MatT& A, const VecT& x,
+        const CombineT& f, size_t first, size_t last, mul_Ax)
+{
+    typedef typename ResultT::value_type sum_type;
+    for(size_t i = first; i < last; ++i) {
+        sum_type sum(A(i,0)*x[0]);
+        for(size_t k = 1; k < x.size(); ++k) {
+            sum += (A(i,k)*x[k]);
+        }
+        OpT().apply(y[i], f(sum,i));
+    }
+}
+
+/** Compute elements [first,last) of y OpT= f(x*A). */
+template<class OpT, class ResultT, class MatT, class VecT, class CombineT>
+void MatVecRange(ResultT& y, const MatT& A, const VecT& x,
+        const CombineT& f, size_t first, size_t last, mul_xA)
+{
+    typedef typename ResultT::value_type sum_type;
+    for(size_t i = first; i < last; ++i) {
+        sum_type sum(x[0]*A(0,i));
+        for(size_t k = 1; k < x.size(); ++k) {
+            sum += (x[k]*A(k,i));
+        }
+        OpT().apply(y[i], f(sum,i));
+    }
+}
+
+/** Compute y OpT= f(A*x) or f(x*A), combining each element as it is
+ * computed.
+ *
+ * When CML_PARALLEL is defined and A is large enough, the elements of y
+ * are split across threads.  f computed the products in its operand when
+ * it was constructed (see et::detail::ProductCombine), so the threads only
+ * read from it.
+ */
+template<class OpT, class ResultT, class MatT, class VecT, class CombineT,
+    class OrderT>
+void MatVecLoop(ResultT& y, const MatT& A, const VecT& x, const CombineT& f,
+        OrderT)
+{
+    const size_t N = MatVecSize(A, OrderT());
+#if defined(CML_PARALLEL)
+    if(cml::parallel::use_threads(N*x.size())) {
+        size_t grain = cml::parallel::get_policy().grain;
+        grain = std::max(grain/std::max(x.size(), size_t(1)), size_t(1));
+        cml::parallel::for_each_range(N, grain,
+                [&](size_t begin, size_t end) {
+                    MatVecRange<OpT>(y, A, x, f, begin, end, OrderT());
+                });
+        return;
+    }
+#endif
+    MatVecRange<OpT>(y, A, x, f, 0, N, OrderT());
+}
+
+/** Compute dest OpT= f(A*x) or f(x*A) for a matrix and a vector.
+ *
+ * The product is written straight into dest when dest has its size (or
+ * is resized to it) and shares no storage with A or x.  Otherwise, it is
+ * computed into a temporary, which is then assigned to dest like any
+ * other vector.
+ *
+ * @sa et::detail::ProductTerm
+ * @sa et::detail::ProductCombine
+ */
+template<class OpT, class VecT, typename E, class AT, typename BO,
+    typename L, class XT, class CombineT, class OrderT>
+void
+MatVecEval(VecT& dest, const matrix<E,AT,BO,L>& A, const XT& x,
+        const CombineT& f, OrderT)
+{
+    typedef typename MatVecMulPromote<
+        matrix<E,AT,BO,L>, XT, OrderT>::type result_type;
+    typedef typename result_type::value_type value_type;
+
+    const size_t N = MatVecSize(A, OrderT());
+    bool aliased = (et::detail::OperandAliases(dest, A)
+            || et::detail::OperandAliases(dest, x));
+
+    /* A dest that is assigned, and not read, can take the product's size: */
+    if(et::detail::IsAssignOp<OpT>::is_true && !aliased && !f.aliases(dest))
+        cml::et::detail::Resize(dest, N);
+
+    if(!aliased && dest.size() == N && f.fits(N)) {
+        MatVecLoop<OpT>(dest, A, x, f, OrderT());
+    } else {
+        result_type P;
+        cml::et::detail::Resize(P, N);
+        MatVecLoop< et::OpAssign<value_type,value_type> >(
+                P, A, x, et::detail::ProductTerm(), OrderT());
+        f.template assign<OpT>(dest, P);
+    }
+}
+
+/** Compute dest OpT= f(A*x) or f(x*A) for a matrix expression.
+ *
+ * The expression is evaluated into a temporary first.
+ */
+template<class OpT, class VecT, class MatT, class XT, class CombineT,
+    class OrderT>
+inline void
+MatVecEval(VecT& dest, const MatT& A, const XT& x, const CombineT& f, OrderT)
+{
+    typedef et::ExprTraits<MatT> matrix_traits;
+    typename et::MatrixXpr<MatT>::temporary_type tmp;
+    cml::et::detail::Resize(tmp,
+            matrix_traits().rows(A), matrix_traits().cols(A));
+    tmp = et::MatrixXpr<MatT>(A);
+    MatVecEval<OpT>(dest, tmp, x, f, OrderT());
+}
+
+/** Compute dest OpT= f((L*R)*x) as f(L*(R*x)). */
+template<class OpT, class VecT, class LeftT, class RightT, class XT,
+    class CombineT>
+inline void
+MatVecEval(VecT& dest, const et::MatrixMulOp<LeftT,RightT>& A, const XT& x,
+        const CombineT& f, mul_Ax)
+{
+    typedef et::ExprTraits<RightT> right_traits;
+    typedef typename MatVecMulPromote<
+        typename right_traits::result_type, XT, mul_Ax>::type tmp_type;
+    typedef typename tmp_type::value_type value_type;
+
+    tmp_type tmp;
+    cml::et::detail::Resize(tmp, right_traits().rows(A.right_expression()));
+    MatVecEval< et::OpAssign<value_type,value_type> >(tmp,
+            A.right_expression(), x, et::detail::ProductTerm(), mul_Ax());
+    MatVecEval<OpT>(dest, A.left_expression(), tmp, f, mul_Ax());
+}
+
+/** Compute dest OpT= f(x*(L*R)) as f((x*L)*R). */
+template<class OpT, class VecT, class LeftT, class RightT, class XT,
+    class CombineT>
+inline void
+MatVecEval(VecT& dest, const et::MatrixMulOp<LeftT,RightT>& A, const XT& x,
+        const CombineT& f, mul_xA)
+{
+    typedef et::ExprTraits<LeftT> left_traits;
+    typedef typename MatVecMulPromote<
+        typename left_traits::result_type, XT, mul_xA>::type tmp_type;
+    typedef typename tmp_type::value_type value_type;
+
+    tmp_type tmp;
+    cml::et::detail::Resize(tmp, left_traits().cols(A.left_expression()));
+    MatVecEval< et::OpAssign<value_type,value_type> >(tmp,
+            A.left_expression(), x, et::detail::ProductTerm(), mul_xA());
+    MatVecEval<OpT>(dest, A.right_expression(), tmp, f, mul_xA());
+}
+
+/** Compute dest OpT= f(A*x) or f(x*A) for a vector x. */
+template<class OpT, class VecT, class MatT, typename E, class AT,
+    class CombineT, class OrderT>
+inline void
+MatVecAssign(VecT& dest, const MatT& A, const vector<E,AT>& x,
+        const CombineT& f, OrderT)
+{
+    MatVecEval<OpT>(dest, A, x, f, OrderT());
+}
+
+/** Compute dest OpT= f(A*x) or f(x*A) for a vector expression x.
+ *
+ * The expression is evaluated into a temporary first.
+ */
+template<class OpT, class VecT, class MatT, class XT, class CombineT,
+    class OrderT>
+inline void
+MatVecAssign(VecT& dest, const MatT& A, const XT& x, const CombineT& f,
+        OrderT)
+{
+    typename et::VectorXpr<XT>::temporary_type tmp;
+    cml::et::detail::Resize(tmp, et::ExprTraits<XT>().size(x));
+    tmp = et::VectorXpr<XT>(x);
+    MatVecEval<OpT>(dest, A, tmp, f, OrderT());
+}
+
 } // namespace detail
 
+namespace et {
+
+/** A matrix-vector product in an expression tree.
+ *
+ * OrderT is detail::mul_Ax for A*x, or detail::mul_xA for x*A.  The
+ * product is evaluated when it is assigned, by detail::MatVecAssign();
+ * see VectorAssignment<> below, or into a temporary by Materialize<> when
+ * it is part of a larger expression.  Element access computes the single
+ * element as an inner product, so the node never changes once built.
+ */
+template<class MatT, class VecT, class OrderT>
+class MatVecMulOp
+{
+  public:
+
+    typedef MatVecMulOp<MatT,VecT,OrderT> expr_type;
+
+    /* Record ary-ness of the expression: */
+    typedef binary_expression expr_ary;
+
+    /* Copy the expression by value into higher-up expressions: */
+    typedef expr_type expr_const_reference;
+
+    typedef vector_result_tag result_tag;
+
+    /* For matching by assignability: */
+    typedef cml::et::not_assignable_tag assignable_tag;
+
+    /* Record the expression traits for the two subexpressions: */
+    typedef ExprTraits<MatT> matrix_traits;
+    typedef ExprTraits<VecT> vector_traits;
+
+    /* Reference types for the two subexpressions: */
+    typedef typename matrix_traits::const_reference matrix_reference;
+    typedef typename vector_traits::const_reference vector_reference;
+
+    /* Figure out the expression's resulting (vector) type: */
+    typedef typename cml::detail::MatVecMulPromote<
+        typename matrix_traits::result_type,
+        typename vector_traits::result_type, OrderT>::type result_type;
+    typedef typename result_type::value_type value_type;
+    typedef typename result_type::size_tag size_tag;
+
+    /* Get the temporary type: */
+    typedef typename result_type::temporary_type temporary_type;
+
+
+  public:
+
+    /** Record result size as an enum. */
+    enum { array_size = result_type::array_size };
+
+
+  public:
+
+    /** Return square of the length. */
+    value_type length_squared() const {
+        temporary_type v(VectorXpr<expr_type>(*this));
+        return v.length_squared();
+    }
+
+    /** Return the length. */
+    value_type length() const {
+        temporary_type v(VectorXpr<expr_type>(*this));
+        return v.length();
+    }
+
+    /** Return the result as a normalized vector. */
+    result_type normalize() const {
+        result_type v(VectorXpr<expr_type>(*this));
+        return v.normalize();
+    }
+
+    /** Compute value at index i of the result vector. */
+    value_type operator[](size_t i) const {
+        return this->element(i, OrderT());
+    }
+
+
+  public:
+
+    /** Return the size of the vector result. */
+    size_t size() const {
+        return this->size(OrderT());
+    }
+
+    /** Return reference to the matrix expression. */
+    matrix_reference matrix_expression() const { return m_mat; }
+
+    /** Return reference to the vector expression. */
+    vector_reference vector_expression() const { return m_vec; }
+
+
+  public:
+
+    /** Construct from the matrix and vector subexpressions.
+     *
+     * @throws std::invalid_argument if the sizes of the subexpressions do
+     * not match, and CML_CHECK_MATVEC_EXPR_SIZES is defined.
+     */
+    explicit MatVecMulOp(matrix_reference A, vector_reference x)
+        : m_mat(A), m_vec(x)
+    {
+        this->check_size(OrderT());
+    }
+
+    /** Copy constructor. */
+    MatVecMulOp(const expr_type& e)
+        : m_mat(e.m_mat), m_vec(e.m_vec) {}
+
+
+  protected:
+
+    value_type element(size_t i, cml::detail::mul_Ax) const {
+        value_type sum(matrix_traits().get(m_mat,i,0)
+                *vector_traits().get(m_vec,0));
+        for(size_t k = 1; k < vector_traits().size(m_vec); ++k) {
+            sum += (matrix_traits().get(m_mat,i,k)
+                    *vector_traits().get(m_vec,k));
+        }
+        return sum;
+    }
+
+    value_type element(size_t i, cml::detail::mul_xA) const {
+        value_type sum(vector_traits().get(m_vec,0)
+                *matrix_traits().get(m_mat,0,i));
+        for(size_t k = 1; k < vector_traits().size(m_vec); ++k) {
+            sum += (vector_traits().get(m_vec,k)
+                    *matrix_traits().get(m_mat,k,i));
+        }
+        return sum;
+    }
+
+    size_t size(cml::detail::mul_Ax) const {
+        return matrix_traits().rows(m_mat);
+    }
+
+    size_t size(cml::detail::mul_xA) const {
+        return matrix_traits().cols(m_mat);
+    }
+
+    void check_size(cml::detail::mul_Ax) const {
+        CheckedSize(m_mat, m_vec, size_tag());
+    }
+
+    void check_size(cml::detail::mul_xA) const {
+        CheckedSize(m_vec, m_mat, size_tag());
+    }
+
+
+  protected:
+
+    matrix_reference m_mat;
+    vector_reference m_vec;
+
+
+  private:
+
+    /* Cannot be assigned to: */
+    expr_type& operator=(const expr_type&);
+};
+
+/** Expression traits class for MatVecMulOp<>. */
+template<class MatT, class VecT, class OrderT>
+struct ExprTraits< MatVecMulOp<MatT,VecT,OrderT> >
+{
+    typedef MatVecMulOp<MatT,VecT,OrderT> expr_type;
+    typedef MatT left_type;
+    typedef VecT right_type;
+
+    typedef typename expr_type::value_type value_type;
+    typedef typename expr_type::expr_const_reference const_reference;
+    typedef typename expr_type::result_tag result_tag;
+    typedef typename expr_type::size_tag size_tag;
+    typedef typename expr_type::result_type result_type;
+    typedef typename expr_type::assignable_tag assignable_tag;
+    typedef expr_node_tag node_tag;
+
+    value_type get(const expr_type& v, size_t i) const { return v[i]; }
+    size_t size(const expr_type& e) const { return e.size(); }
+};
+
+namespace detail {
+
+/** Compute dest OpT= f(P) for the mat-vec product P. */
+template<class OpT, class VecT, class MatT, class XT, class OrderT,
+    class CombineT>
+inline void
+AssignMatVecProduct(VecT& dest, const MatVecMulOp<MatT,XT,OrderT>& P,
+        const CombineT& f)
+{
+    cml::detail::MatVecAssign<OpT>(
+            dest, P.matrix_expression(), P.vector_expression(), f, OrderT());
+}
+
+/** Assign a mat-vec product. */
+template<class MatT, class XT, class OrderT>
+struct VectorAssignment< VectorXpr< MatVecMulOp<MatT,XT,OrderT> > >
+{
+    typedef VectorXpr< MatVecMulOp<MatT,XT,OrderT> > src_type;
+
+    template<class OpT, typename E, class AT>
+        static void assign(cml::vector<E,AT>& dest, const src_type& src)
+        {
+            AssignMatVecProduct<OpT>(
+                    dest, src.expression(), ProductTerm());
+        }
+};
+
+/** Assign a mat-vec product combined element-wise with another operand. */
+template<class MatT, class XT, class OrderT, class ExprT, class OpT2>
+struct VectorAssignment< VectorXpr<
+        BinaryVectorOp<MatVecMulOp<MatT,XT,OrderT>,ExprT,OpT2> > >
+{
+    typedef BinaryVectorOp<MatVecMulOp<MatT,XT,OrderT>,ExprT,OpT2>
+        expr_type;
+    typedef ProductCombine<ExprT,OpT2,true_type> combine_type;
+
+    template<class OpT, typename E, class AT>
+        static void assign(cml::vector<E,AT>& dest,
+                const VectorXpr<expr_type>& src)
+        {
+            expr_type e(src.expression());
+            combine_type f(e.right_expression());
+            AssignMatVecProduct<OpT>(dest, e.left_expression(), f);
+        }
+};
+
+/** Assign an operand combined element-wise with a mat-vec product. */
+template<class ExprT, class MatT, class XT, class OrderT, class OpT2>
+struct VectorAssignment< VectorXpr<
+        BinaryVectorOp<ExprT,MatVecMulOp<MatT,XT,OrderT>,OpT2> > >
+{
+    typedef BinaryVectorOp<ExprT,MatVecMulOp<MatT,XT,OrderT>,OpT2>
+        expr_type;
+    typedef ProductCombine<ExprT,OpT2,false_type> combine_type;
+
+    template<class OpT, typename E, class AT>
+        static void assign(cml::vector<E,AT>& dest,
+                const VectorXpr<expr_type>& src)
+        {
+            expr_type e(src.expression());
+            combine_type f(e.left_expression());
+            AssignMatVecProduct<OpT>(dest, e.right_expression(), f);
+        }
+};
+
+/** Assign two mat-vec products combined element-wise.
+ *
+ * The right product is computed into a temporary first (see
+ * ProductCombine<>), and the left one is written into dest.
+ */
+template<class MatT1, class XT1, class OrderT1,
+    class MatT2, class XT2, class OrderT2, class OpT2>
+struct VectorAssignment< VectorXpr< BinaryVectorOp<
+        MatVecMulOp<MatT1,XT1,OrderT1>,
+        MatVecMulOp<MatT2,XT2,OrderT2>, OpT2> > >
+{
+    typedef MatVecMulOp<MatT2,XT2,OrderT2> right_type;
+    typedef BinaryVectorOp<MatVecMulOp<MatT1,XT1,OrderT1>,right_type,OpT2>
+        expr_type;
+    typedef ProductCombine<right_type,OpT2,true_type> combine_type;
+
+    template<class OpT, typename E, class AT>
+        static void assign(cml::vector<E,AT>& dest,
+                const VectorXpr<expr_type>& src)
+        {
+            expr_type e(src.expression());
+            combine_type f(e.right_expression());
+            AssignMatVecProduct<OpT>(dest, e.left_expression(), f);
+        }
+};
+
+} // namespace detail
+
+/** Materialize<> for MatVecMulOp<>: compute the product. */
+template<class MatT, class VecT, class OrderT>
+class Materialize< MatVecMulOp<MatT,VecT,OrderT> >
+{
+  public:
+
+    typedef MatVecMulOp<MatT,VecT,OrderT> expr_type;
+    typedef typename expr_type::temporary_type type;
+
+
+  public:
+
+    /** Return the product. */
+    const type& expression() const { return m_result; }
+
+
+  public:
+
+    /** Compute the product e into a temporary. */
+    explicit Materialize(const expr_type& e) {
+        typedef typename expr_type::value_type value_type;
+        typedef OpAssign<value_type,value_type> op_type;
+        cml::et::detail::Resize(m_result, e.size());
+        detail::AssignMatVecProduct<op_type>(
+                m_result, e, detail::ProductTerm());
+    }
+
+
+  protected:
+
+    type m_result;
+};
+
+/** Materialize<> for a VectorXpr<> holding a product. */
+template<class MatT, class VecT, class OrderT>
+class Materialize< VectorXpr< MatVecMulOp<MatT,VecT,OrderT> > >
+    : public Materialize< MatVecMulOp<MatT,VecT,OrderT> >
+{
+  public:
+
+    /** Compute the product e into a temporary. */
+    explicit Materialize(
+            const VectorXpr< MatVecMulOp<MatT,VecT,OrderT> >& e)
+        : Materialize< MatVecMulOp<MatT,VecT,OrderT> >(e.expression()) {}
+};
+
+} // namespace et
+
+#if !defined(CML_NO_LAZY_PRODUCTS)
+
+/** operator*() for a matrix and a vector. */
+template<typename E1, class AT1, typename BO, class L,
+         typename E2, class AT2>
+inline et::VectorXpr< et::MatVecMulOp<
+    matrix<E1,AT1,BO,L>, vector<E2,AT2>, detail::mul_Ax> >
+operator*(const matrix<E1,AT1,BO,L>& left,
+          const vector<E2,AT2>& right)
+{
+    typedef et::MatVecMulOp<
+        matrix<E1,AT1,BO,L>, vector<E2,AT2>, detail::mul_Ax> ExprT;
+    return et::VectorXpr<ExprT>(ExprT(left,right));
+}
+
+/** operator*() for a matrix and a VectorXpr. */
+template<typename E, class AT, class L, typename BO, typename XprT>
+inline et::VectorXpr< et::MatVecMulOp<
+    matrix<E,AT,BO,L>, XprT, detail::mul_Ax> >
+operator*(const matrix<E,AT,BO,L>& left,
+          const et::VectorXpr<XprT>& right)
+{
+    typedef et::MatVecMulOp<
+        matrix<E,AT,BO,L>, XprT, detail::mul_Ax> ExprT;
+    return et::VectorXpr<ExprT>(ExprT(left,right.expression()));
+}
+
+/** operator*() for a MatrixXpr and a vector. */
+template<typename XprT, typename E, class AT>
+inline et::VectorXpr< et::MatVecMulOp<
+    XprT, vector<E,AT>, detail::mul_Ax> >
+operator*(const et::MatrixXpr<XprT>& left,
+          const vector<E,AT>& right)
+{
+    typedef et::MatVecMulOp<XprT, vector<E,AT>, detail::mul_Ax> ExprT;
+    return et::VectorXpr<ExprT>(ExprT(left.expression(),right));
+}
+
+/** operator*() for a MatrixXpr and a VectorXpr. */
+template<typename XprT1, typename XprT2>
+inline et::VectorXpr< et::MatVecMulOp<XprT1, XprT2, detail::mul_Ax> >
+operator*(const et::MatrixXpr<XprT1>& left,
+          const et::VectorXpr<XprT2>& right)
+{
+    typedef et::MatVecMulOp<XprT1, XprT2, detail::mul_Ax> ExprT;
+    return et::VectorXpr<ExprT>(
+            ExprT(left.expression(),right.expression()));
+}
+
+/** operator*() for a vector and a matrix. */
+template<typename E1, class AT1, typename E2, class AT2, typename BO, class L>
+inline et::VectorXpr< et::MatVecMulOp<
+    matrix<E2,AT2,BO,L>, vector<E1,AT1>, detail::mul_xA> >
+operator*(const vector<E1,AT1>& left,
+          const matrix<E2,AT2,BO,L>& right)
+{
+    typedef et::MatVecMulOp<
+        matrix<E2,AT2,BO,L>, vector<E1,AT1>, detail::mul_xA> ExprT;
+    return et::VectorXpr<ExprT>(ExprT(right,left));
+}
+
+/** operator*() for a vector and a MatrixXpr. */
+template<typename XprT, typename E, class AT>
+inline et::VectorXpr< et::MatVecMulOp<
+    XprT, vector<E,AT>, detail::mul_xA> >
+operator*(const vector<E,AT>& left,
+          const et::MatrixXpr<XprT>& right)
+{
+    typedef et::MatVecMulOp<XprT, vector<E,AT>, detail::mul_xA> ExprT;
+    return et::VectorXpr<ExprT>(ExprT(right.expression(),left));
+}
+
+/** operator*() for a VectorXpr and a matrix. */
+template<typename XprT, typename E, class AT, typename BO, class L>
+inline et::VectorXpr< et::MatVecMulOp<
+    matrix<E,AT,BO,L>, XprT, detail::mul_xA> >
+operator*(const et::VectorXpr<XprT>& left,
+          const matrix<E,AT,BO,L>& right)
+{
+    typedef et::MatVecMulOp<
+        matrix<E,AT,BO,L>, XprT, detail::mul_xA> ExprT;
+    return et::VectorXpr<ExprT>(ExprT(right,left.expression()));
+}
+
+/** operator*() for a VectorXpr and a MatrixXpr. */
+template<typename XprT1, typename XprT2>
+inline et::VectorXpr< et::MatVecMulOp<XprT2, XprT1, detail::mul_xA> >
+operator*(const et::VectorXpr<XprT1>& left,
+          const et::MatrixXpr<XprT2>& right)
+{
+    typedef et::MatVecMulOp<XprT2, XprT1, detail::mul_xA> ExprT;
+    return et::VectorXpr<ExprT>(
+            ExprT(right.expression(),left.expression()));
+}
+
+#else
+
 
 /** operator*() for a matrix and a vector. */
 template<typename E1, class AT1, typename BO, class L,
@@ -277,6 +905,8 @@ operator*(const et::VectorXpr<XprT1>& left,
     return detail::mul(left_tmp,right_tmp,detail::mul_xA());
 }
 
+#endif // CML_NO_LAZY_PRODUCTS
+
 } // namespace cml
 
 #endif
@@ -0,0 +1,250 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief The dual_quaternion<> class.
+ *
+ * @note Include cml/dual_quaternion.h rather than this file.
+ */
+
+#ifndef dual_quaternion_h
+#define dual_quaternion_h
+
+#include <cml/quaternion.h>
+
+namespace cml {
+namespace detail {
+
+/** Return the Hamilton product a*b of quaternions with positive_cross. */
+template<class QuatT> inline QuatT
+hamilton_product(const QuatT& a, const QuatT& b, positive_cross)
+{
+    return a*b;
+}
+
+/** Return the Hamilton product a*b of quaternions with negative_cross. */
+template<class QuatT> inline QuatT
+hamilton_product(const QuatT& a, const QuatT& b, negative_cross)
+{
+    return b*a;
+}
+
+} // namespace detail
+
+template<typename Element, class Order, class Cross>
+class dual_quaternion
+{
+  public:
+
+    /* Shorthand for the type of this dual quaternion: */
+    typedef dual_quaternion<Element,Order,Cross> dual_quaternion_type;
+
+    /* The type of the real and dual parts: */
+    typedef quaternion<Element,fixed<>,Order,Cross> quaternion_type;
+
+    /* The type of a translation: */
+    typedef vector< Element, fixed<3> > vector_type;
+
+    /* Standard: */
+    typedef Element value_type;
+    typedef Order order_type;
+    typedef Cross cross_type;
+
+
+  public:
+
+    /** Return the real part. */
+    const quaternion_type& real() const { return m_real; }
+
+    /** Return the real part. */
+    quaternion_type& real() { return m_real; }
+
+    /** Return the dual part. */
+    const quaternion_type& dual() const { return m_dual; }
+
+    /** Return the dual part. */
+    quaternion_type& dual() { return m_dual; }
+
+    /** Return the rotation of a unit dual quaternion. */
+    const quaternion_type& rotation() const { return m_real; }
+
+    /** Return the translation of a unit dual quaternion. */
+    vector_type translation() const {
+        quaternion_type c = cml::conjugate(m_real);
+        return value_type(2) * detail::hamilton_product(
+                m_dual, c, cross_type()).imaginary();
+    }
+
+    /** Set this to the identity transform. */
+    dual_quaternion_type& identity() {
+        m_real.identity();
+        for(int i = 0; i < 4; ++ i) m_dual[i] = value_type(0);
+        return *this;
+    }
+
+    /** Normalize to a unit dual quaternion.
+     *
+     * Both parts are divided by the length of the real part, then the
+     * dual part is made orthogonal to the real part.
+     */
+    dual_quaternion_type& normalize() {
+        value_type s = inv_sqrt(m_real.length_squared());
+        m_real *= s;
+        m_dual *= s;
+        m_dual -= m_real * cml::dot(m_real, m_dual);
+        return *this;
+    }
+
+    /** Set this to its quaternion conjugate.
+     *
+     * For a unit dual quaternion, this is the inverse transform.
+     */
+    dual_quaternion_type& conjugate() {
+        m_real.conjugate();
+        m_dual.conjugate();
+        return *this;
+    }
+
+    /** Return access to the 8 coefficients, real part first. */
+    value_type* data() { return m_real.data(); }
+
+    /** Return access to the 8 coefficients, real part first. */
+    const value_type* data() const { return m_real.data(); }
+
+
+  public:
+
+    /** Default constructor.
+     *
+     * @note The coefficients are not initialized.
+     */
+    dual_quaternion() {}
+
+    /** Construct from the real and dual parts. */
+    dual_quaternion(const quaternion_type& r, const quaternion_type& d)
+        : m_real(r), m_dual(d) {}
+
+    /** Construct the rigid transform rotating by r, then translating by t.
+     *
+     * r must be a unit quaternion.
+     */
+    template<typename E, class AT>
+    dual_quaternion(const quaternion_type& r, const vector<E,AT>& t)
+        : m_real(r)
+    {
+        quaternion_type q(value_type(0), vector_type(t));
+        m_dual = value_type(.5) * detail::hamilton_product(
+                q, m_real, cross_type());
+    }
+
+
+  public:
+
+    dual_quaternion_type& operator+=(const dual_quaternion_type& q) {
+        m_real += q.m_real;
+        m_dual += q.m_dual;
+        return *this;
+    }
+
+    dual_quaternion_type& operator-=(const dual_quaternion_type& q) {
+        m_real -= q.m_real;
+        m_dual -= q.m_dual;
+        return *this;
+    }
+
+    /** Accumulated multiplication, p = p*q. */
+    dual_quaternion_type& operator*=(const dual_quaternion_type& q) {
+        return (*this = *this * q);
+    }
+
+    dual_quaternion_type& operator*=(const value_type& s) {
+        m_real *= s;
+        m_dual *= s;
+        return *this;
+    }
+
+    dual_quaternion_type& operator/=(const value_type& s) {
+        return (*this *= value_type(1) / s);
+    }
+
+
+  protected:
+
+    quaternion_type m_real, m_dual;
+};
+
+/** Multiply two dual quaternions.
+ *
+ * The products of the parts follow the cross type, as for quaternions: with
+ * positive_cross, p*q transforms by q and then by p, and with
+ * negative_cross it transforms by p and then by q.
+ */
+template<typename E, class OT, class CT>
+inline dual_quaternion<E,OT,CT>
+operator*(const dual_quaternion<E,OT,CT>& p, const dual_quaternion<E,OT,CT>& q)
+{
+    return dual_quaternion<E,OT,CT>(p.real()*q.real(),
+            p.real()*q.dual() + p.dual()*q.real());
+}
+
+template<typename E, class OT, class CT>
+inline dual_quaternion<E,OT,CT>
+operator+(const dual_quaternion<E,OT,CT>& p, const dual_quaternion<E,OT,CT>& q)
+{
+    dual_quaternion<E,OT,CT> result(p);
+    return result += q;
+}
+
+template<typename E, class OT, class CT>
+inline dual_quaternion<E,OT,CT>
+operator-(const dual_quaternion<E,OT,CT>& p, const dual_quaternion<E,OT,CT>& q)
+{
+    dual_quaternion<E,OT,CT> result(p);
+    return result -= q;
+}
+
+template<typename E, class OT, class CT>
+inline dual_quaternion<E,OT,CT>
+operator*(const dual_quaternion<E,OT,CT>& p, const E& s)
+{
+    dual_quaternion<E,OT,CT> result(p);
+    return result *= s;
+}
+
+template<typename E, class OT, class CT>
+inline dual_quaternion<E,OT,CT>
+operator*(const E& s, const dual_quaternion<E,OT,CT>& p)
+{
+    dual_quaternion<E,OT,CT> result(p);
+    return result *= s;
+}
+
+/** Return the unit dual quaternion nearest q. */
+template<typename E, class OT, class CT>
+inline dual_quaternion<E,OT,CT>
+normalize(const dual_quaternion<E,OT,CT>& q)
+{
+    dual_quaternion<E,OT,CT> result(q);
+    return result.normalize();
+}
+
+/** Return the quaternion conjugate of q. */
+template<typename E, class OT, class CT>
+inline dual_quaternion<E,OT,CT>
+conjugate(const dual_quaternion<E,OT,CT>& q)
+{
+    dual_quaternion<E,OT,CT> result(q);
+    return result.conjugate();
+}
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
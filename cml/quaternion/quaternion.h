@@ -23,6 +23,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/mathlib/epsilon.h>
 #include <cml/quaternion/quaternion_expr.h>
 #include <cml/quaternion/quaternion_dot.h>
+#include <cml/quaternion/quaternion_kernels.h>
 #include <cml/util.h>
 
 /* This is used below to create a more meaningful compile-time error when
@@ -31,6 +32,22 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 struct quaternion_requires_fixed_size_array_type_error;
 
 namespace cml {
+namespace detail {
+
+/* True if ArrayType is fixed<> (with any alignment) or external<>: */
+template<class ArrayType> struct is_quaternion_storage {
+    enum { is_true = false };
+};
+
+template<int Align> struct is_quaternion_storage< fixed<-1,-1,Align> > {
+    enum { is_true = true };
+};
+
+template<> struct is_quaternion_storage< external<> > {
+    enum { is_true = true };
+};
+
+} // namespace detail
 
 /** A configurable quaternion type.
  *
@@ -45,10 +62,11 @@ template<
 >
 class quaternion
 {
-    /* The ArrayType must be fixed<> or external<>: */
+    /* The ArrayType must be fixed<> (optionally aligned, e.g.
+     * fixed<-1,-1,16>) or external<>:
+     */
     CML_STATIC_REQUIRE_M(
-            (same_type< ArrayType, fixed<> >::is_true
-             || same_type< ArrayType, external<> >::is_true),
+            detail::is_quaternion_storage<ArrayType>::is_true,
             quaternion_requires_fixed_size_array_type_error);
 
   public:
@@ -159,11 +177,17 @@ class quaternion
     }
 
     /** Normalize this quaternion (divide by its length).
+     *
+     * The quaternion is scaled by cml::inv_sqrt() of its squared length
+     * instead when CML_DEFAULT_INV_SQRT_PRECISION is not exact.
      *
      * @todo Make this return a QuaternionXpr.
      */
     quaternion_type& normalize() {
-        return (*this /= length());
+        typedef typename is_true<
+            detail::use_quaternion_kernel<quaternion_type>::value
+            >::result use_kernel;
+        return this->normalize(use_kernel());
     }
 
     /** Set this quaternion to the conjugate. */
@@ -498,6 +522,18 @@ class quaternion
 
   protected:
 
+    /** Normalize with scalar arithmetic. */
+    quaternion_type& normalize(false_type) {
+        return detail::normalize_to_precision(
+                *this, default_inv_sqrt_precision());
+    }
+
+    /** Normalize with the 4-lane kernel. */
+    quaternion_type& normalize(true_type) {
+        detail::quaternion_kernel<Element,Order,Cross>::normalize(data());
+        return *this;
+    }
+
     /** Overloaded function to assign the quaternion from 4 scalars. */
     void assign(const value_type& a, const value_type& b,
 	const value_type& c, const value_type& d, scalar_first)
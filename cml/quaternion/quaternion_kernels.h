@@ -0,0 +1,209 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief 4-lane kernels for fixed-size quaternions.
+ *
+ * quaternion_kernel<T,Order,Cross> evaluates the quaternion product and
+ * normalization with the 4 coefficients of a quaternion held in one SIMD
+ * register.  The lane shuffles are computed at compile time from the Order
+ * and Cross types, so scalar_first and vector_first quaternions, and both
+ * cross product conventions, share the same code.
+ *
+ * The kernels are used for fixed<> quaternions whose element type has a
+ * native 4-lane packet (float with SSE, double with AVX).  Define
+ * CML_NO_QUATERNION_KERNELS to always use the scalar expressions instead.
+ */
+
+#ifndef quaternion_kernels_h
+#define quaternion_kernels_h
+
+#include <cml/core/simd.h>
+
+namespace cml {
+namespace detail {
+
+/** Lane shuffles of 4-lane packets of T.
+ *
+ * shuffle<I0,I1,I2,I3>(a) returns (a[I0],a[I1],a[I2],a[I3]), and
+ * negate<N0,N1,N2,N3>(a) negates the lanes i with Ni set.
+ */
+template<typename T> struct quaternion_lanes
+{
+    typedef simd::packet_traits<T,4> pt;
+    typedef typename pt::packet_type packet_type;
+
+    template<int I0, int I1, int I2, int I3>
+    static packet_type shuffle(const packet_type& a) {
+        packet_type r;
+        r.v[0] = a.v[I0]; r.v[1] = a.v[I1];
+        r.v[2] = a.v[I2]; r.v[3] = a.v[I3];
+        return r;
+    }
+
+    template<int N0, int N1, int N2, int N3>
+    static packet_type negate(const packet_type& a) {
+        packet_type r;
+        r.v[0] = N0 ? -a.v[0] : a.v[0]; r.v[1] = N1 ? -a.v[1] : a.v[1];
+        r.v[2] = N2 ? -a.v[2] : a.v[2]; r.v[3] = N3 ? -a.v[3] : a.v[3];
+        return r;
+    }
+};
+
+#if defined(CML_SIMD_SSE2)
+template<> struct quaternion_lanes<float>
+{
+    typedef simd::packet_traits<float,4> pt;
+    typedef pt::packet_type packet_type;
+
+    template<int I0, int I1, int I2, int I3>
+    static packet_type shuffle(packet_type a) {
+        return _mm_shuffle_ps(a,a,_MM_SHUFFLE(I3,I2,I1,I0));
+    }
+
+    template<int N0, int N1, int N2, int N3>
+    static packet_type negate(packet_type a) {
+        return _mm_xor_ps(a, _mm_set_ps(N3 ? -0.f : 0.f, N2 ? -0.f : 0.f,
+                    N1 ? -0.f : 0.f, N0 ? -0.f : 0.f));
+    }
+};
+#endif
+
+#if defined(CML_SIMD_AVX)
+template<> struct quaternion_lanes<double>
+{
+    typedef simd::packet_traits<double,4> pt;
+    typedef pt::packet_type packet_type;
+
+    template<int I0, int I1, int I2, int I3>
+    static packet_type shuffle(packet_type a) {
+#if defined(__AVX2__)
+        return _mm256_permute4x64_pd(a, _MM_SHUFFLE(I3,I2,I1,I0));
+#else
+        /* AVX only permutes within 128-bit halves, so permute copies of
+         * both halves and blend:
+         */
+        enum {
+            pick = (I0&1) | (I1&1)<<1 | (I2&1)<<2 | (I3&1)<<3,
+            high = (I0>>1) | (I1>>1)<<1 | (I2>>1)<<2 | (I3>>1)<<3
+        };
+        __m256d lo = _mm256_permute2f128_pd(a,a,0x00);
+        __m256d hi = _mm256_permute2f128_pd(a,a,0x11);
+        return _mm256_blend_pd(_mm256_permute_pd(lo,pick),
+                _mm256_permute_pd(hi,pick), high);
+#endif
+    }
+
+    template<int N0, int N1, int N2, int N3>
+    static packet_type negate(packet_type a) {
+        return _mm256_xor_pd(a, _mm256_set_pd(N3 ? -0. : 0.,
+                    N2 ? -0. : 0., N1 ? -0. : 0., N0 ? -0. : 0.));
+    }
+};
+#endif
+
+/** Map per-component values (for W, X, Y and Z) to lane positions. */
+template<class OT, int AW, int AX, int AY, int AZ> struct quaternion_by_lane
+{
+    enum {
+        L0 = (OT::W == 0) ? AW : (OT::X == 0) ? AX : (OT::Y == 0) ? AY : AZ,
+        L1 = (OT::W == 1) ? AW : (OT::X == 1) ? AX : (OT::Y == 1) ? AY : AZ,
+        L2 = (OT::W == 2) ? AW : (OT::X == 2) ? AX : (OT::Y == 2) ? AY : AZ,
+        L3 = (OT::W == 3) ? AW : (OT::X == 3) ? AX : (OT::Y == 3) ? AY : AZ
+    };
+};
+
+/** Quaternion kernels for 4-lane packets of T.
+ *
+ * The product p*q is computed as the sum over the components k of p of
+ * p[k] times a signed permutation of q, i.e. 4 broadcasts, 3 shuffles and
+ * 4 multiply-adds.
+ */
+template<typename T, class OT, class CT> struct quaternion_kernel
+{
+    typedef quaternion_lanes<T> lanes;
+    typedef typename lanes::pt pt;
+    typedef typename lanes::packet_type packet_type;
+
+    enum {
+        W = OT::W, X = OT::X, Y = OT::Y, Z = OT::Z,
+
+        /* Set if the cross product term is subtracted: */
+        S = same_type<CT,negative_cross>::is_true
+    };
+
+    /** Broadcast component K of a to every lane. */
+    template<int K> static packet_type splat(const packet_type& a) {
+        return lanes::template shuffle<K,K,K,K>(a);
+    }
+
+    /** Permute the components of a, then negate some of them.
+     *
+     * The result holds a[SW], a[SX], a[SY] and a[SZ] in the W, X, Y and Z
+     * lanes, negated where NW, NX, NY or NZ is set.
+     */
+    template<int SW, int SX, int SY, int SZ, int NW, int NX, int NY, int NZ>
+    static packet_type permute(const packet_type& a) {
+        typedef quaternion_by_lane<OT,SW,SX,SY,SZ> src;
+        typedef quaternion_by_lane<OT,NW,NX,NY,NZ> neg;
+        return lanes::template negate<neg::L0,neg::L1,neg::L2,neg::L3>(
+                lanes::template shuffle<src::L0,src::L1,src::L2,src::L3>(a));
+    }
+
+    /** Return the quaternion product a*b. */
+    static packet_type mul(const packet_type& a, const packet_type& b) {
+        packet_type r = pt::mul(splat<W>(a), b);
+        r = pt::madd(splat<X>(a), permute<X,W,Z,Y,1,0,!S,S>(b), r);
+        r = pt::madd(splat<Y>(a), permute<Y,Z,W,X,1,S,0,!S>(b), r);
+        r = pt::madd(splat<Z>(a), permute<Z,Y,X,W,1,!S,S,0>(b), r);
+        return r;
+    }
+
+    /** Return a divided by its length.
+     *
+     * The squares are summed in element order, as by the scalar
+     * normalize(), so that both give the same result.
+     */
+    static packet_type normalize(const packet_type& a) {
+        packet_type s = pt::mul(a,a);
+        packet_type l = pt::add(splat<0>(s), splat<1>(s));
+        l = pt::add(l, splat<2>(s));
+        l = pt::add(l, splat<3>(s));
+        return simd::div_sqrt<pt>(a, l);
+    }
+
+    /** Store the product a*b in r. */
+    static void mul(const T* a, const T* b, T* r) {
+        pt::storeu(r, mul(pt::loadu(a), pt::loadu(b)));
+    }
+
+    /** Normalize the quaternion q in place. */
+    static void normalize(T* q) {
+        pt::storeu(q, normalize(pt::loadu(q)));
+    }
+};
+
+/** True if QuatT is evaluated by quaternion_kernel<>. */
+template<class QuatT> struct use_quaternion_kernel {
+    enum { value = false };
+};
+
+#if !defined(CML_NO_QUATERNION_KERNELS)
+template<typename E, int Align, class OT, class CT>
+struct use_quaternion_kernel< quaternion<E,fixed<-1,-1,Align>,OT,CT> > {
+    enum { value = simd::packet_traits<E,4>::vectorized };
+};
+#endif
+
+} // namespace detail
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -10,7 +10,8 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
  *  @brief Multiplication of two quaternions, p*q.
  *
  * This uses the expression tree, since the result is closed-form and can be
- * computed by index.
+ * computed by index.  Products of two fixed-size quaternions of the same
+ * type are computed by quaternion_kernel<> when it is vectorized.
  */
 
 #ifndef quaternion_mul_h
@@ -18,6 +19,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 
 #include <cml/mathlib/checking.h>
 #include <cml/quaternion/quaternion_promotions.h>
+#include <cml/quaternion/quaternion_kernels.h>
 
 namespace cml {
 namespace detail {
@@ -83,6 +85,37 @@ QuaternionMult(const Quat1_T& q1, const Quat2_T& q2)
     return result;
 }
 
+/** Multiply two quaternions without the 4-lane kernel. */
+template < class Quat1_T, class Quat2_T >
+inline typename et::QuaternionPromote<
+    typename Quat1_T::temporary_type, typename Quat2_T::temporary_type
+>::temporary_type
+QuaternionMult(const Quat1_T& q1, const Quat2_T& q2, false_type)
+{
+    return QuaternionMult(q1, q2);
+}
+
+/** Multiply two quaternions of the same type with the 4-lane kernel. */
+template < class QuatT > inline QuatT
+QuaternionMult(const QuatT& q1, const QuatT& q2, true_type)
+{
+    typedef quaternion_kernel<typename QuatT::value_type,
+            typename QuatT::order_type, typename QuatT::cross_type> kernel;
+
+    QuatT result;
+    kernel::mul(q1.data(), q2.data(), result.data());
+    return result;
+}
+
+/** True if a product of Quat1_T and Quat2_T uses the 4-lane kernel. */
+template < class Quat1_T, class Quat2_T > struct use_quaternion_mul_kernel {
+    enum { value = false };
+};
+
+template < class QuatT > struct use_quaternion_mul_kernel<QuatT,QuatT> {
+    enum { value = use_quaternion_kernel<QuatT>::value };
+};
+
 } // namespace detail
 
 /** Declare mul taking two quaternion operands. */
@@ -94,7 +127,10 @@ inline typename et::QuaternionPromote<
     const quaternion<E1,AT1,OT,CT>& left,
     const quaternion<E2,AT2,OT,CT>& right)
 {
-    return detail::QuaternionMult(left, right);
+    typedef typename is_true<detail::use_quaternion_mul_kernel<
+        quaternion<E1,AT1,OT,CT>, quaternion<E2,AT2,OT,CT>
+        >::value>::result use_kernel;
+    return detail::QuaternionMult(left, right, use_kernel());
 }
 
 /** Declare mul taking a quaternion and a et::QuaternionXpr. */
@@ -82,6 +82,33 @@ operator<<(std::ostream& os, const et::QuaternionXpr<XprT>& q)
     return os;
 }
 
+/** Input a quaternion from a std::istream, as written by operator<< by
+ * default: "[ w x y z ]", with the real part first whatever the order of
+ * the quaternion.
+ */
+template<typename E, class AT, class OT, typename CT> std::istream&
+operator>>(std::istream& is, cml::quaternion<E,AT,OT,CT>& q)
+{
+    typedef typename cml::quaternion<E,AT,OT,CT>::order_type order_type;
+    enum {
+        W = order_type::W,
+        X = order_type::X,
+        Y = order_type::Y,
+        Z = order_type::Z
+    };
+
+    char open = 0, close = 0;
+    E w, x, y, z;
+    is >> open >> w >> x >> y >> z >> close;
+    if(!is) return is;
+    if(open != '[' || close != ']') {
+        is.setstate(std::ios::failbit);
+        return is;
+    }
+    q[W] = w; q[X] = x; q[Y] = y; q[Z] = z;
+    return is;
+}
+
 } // namespace cml
 
 #endif
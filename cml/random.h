@@ -0,0 +1,208 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Pseudo-random number engines.
+ *
+ * The engines are small value types, so each thread can own one instead
+ * of sharing the hidden state of std::rand().  They return 32 uniformly
+ * distributed bits from operator(), and can be passed to the random
+ * helpers of cml/util.h, cml/mathlib/vector_misc.h and
+ * cml/mathlib/random_sampling.h, as can any other engine returning at least
+ * 32 random bits (e.g. std::mt19937).
+ *
+ * xoshiro128pp is xoshiro128++ by Blackman and Vigna, with 16 bytes of
+ * state; jump() advances it by 2^64 draws, to give each thread a stream
+ * that does not overlap the others.  pcg32 is PCG-XSH-RR by O'Neill, with
+ * 2^63 streams selected when it is seeded.
+ */
+
+#ifndef cml_random_h
+#define cml_random_h
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#pragma push_macro("min")
+#pragma push_macro("max")
+#undef min
+#undef max
+#endif
+
+namespace cml {
+namespace detail {
+
+/** Return the next value of the splitmix64 sequence, for seeding. */
+inline uint64_t splitmix64(uint64_t& x)
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+inline uint32_t rotl32(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+/** Uniform values in [0,1) of type T, from 32-bit draws. */
+template<typename T> struct random_uniform_bits
+{
+    /** Return 53 random bits from two draws. */
+    template<class Engine> static T draw(Engine& g) {
+        uint32_t a = uint32_t(g()) >> 5, b = uint32_t(g()) >> 6;
+        return T((double(a)*67108864. + double(b))
+                * (1./9007199254740992.));
+    }
+};
+
+/** Return 24 random bits from one draw. */
+template<> struct random_uniform_bits<float>
+{
+    template<class Engine> static float draw(Engine& g) {
+        return float(uint32_t(g()) >> 8) * (1.f/16777216.f);
+    }
+};
+
+/** Return a uniform value in [0,1) of type T from the engine g. */
+template<typename T, class Engine> inline T
+random_uniform(Engine& g)
+{
+    return random_uniform_bits<T>::draw(g);
+}
+
+} // namespace detail
+
+/** The xoshiro128++ engine. */
+class xoshiro128pp
+{
+  public:
+
+    typedef uint32_t result_type;
+
+
+  public:
+
+    /** Seed from a 64-bit value. */
+    explicit xoshiro128pp(uint64_t s = 0) { seed(s); }
+
+    /** Seed from a 64-bit value, through splitmix64. */
+    void seed(uint64_t s) {
+        for(int i = 0; i < 4; i += 2) {
+            uint64_t z = detail::splitmix64(s);
+            m_s[i] = uint32_t(z);
+            m_s[i+1] = uint32_t(z >> 32);
+        }
+    }
+
+    static result_type min() { return 0; }
+    static result_type max() { return 0xffffffffu; }
+
+    /** Return the next 32 random bits. */
+    result_type operator()() {
+        uint32_t result = detail::rotl32(m_s[0] + m_s[3], 7) + m_s[0];
+        uint32_t t = m_s[1] << 9;
+        m_s[2] ^= m_s[0];
+        m_s[3] ^= m_s[1];
+        m_s[1] ^= m_s[2];
+        m_s[0] ^= m_s[3];
+        m_s[2] ^= t;
+        m_s[3] = detail::rotl32(m_s[3], 11);
+        return result;
+    }
+
+    /** Advance by 2^64 draws.
+     *
+     * Copying an engine and jumping each copy once more than the last
+     * gives streams for threads that do not overlap.
+     */
+    void jump() {
+        static const uint32_t J[4] = {
+            0x8764000bu, 0xf542d2d3u, 0x6fa035c3u, 0x77f2db5bu };
+        uint32_t s[4] = { 0, 0, 0, 0 };
+        for(int i = 0; i < 4; ++ i) {
+            for(int b = 0; b < 32; ++ b) {
+                if(J[i] & (uint32_t(1) << b)) {
+                    s[0] ^= m_s[0]; s[1] ^= m_s[1];
+                    s[2] ^= m_s[2]; s[3] ^= m_s[3];
+                }
+                (*this)();
+            }
+        }
+        for(int i = 0; i < 4; ++ i) m_s[i] = s[i];
+    }
+
+
+  protected:
+
+    uint32_t m_s[4];
+};
+
+/** The PCG-XSH-RR engine with 64 bits of state. */
+class pcg32
+{
+  public:
+
+    typedef uint32_t result_type;
+
+
+  public:
+
+    /** Seed with the given initial state and stream. */
+    explicit pcg32(uint64_t s = 0x853c49e6748fea9bULL,
+            uint64_t stream = 0xda3e39cb94b95bdbULL)
+    {
+        seed(s, stream);
+    }
+
+    /** Seed with the given initial state and stream.
+     *
+     * Engines with different streams give independent sequences, e.g. one
+     * stream per thread.
+     */
+    void seed(uint64_t s, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+        m_state = 0;
+        m_inc = (stream << 1) | 1;
+        (*this)();
+        m_state += s;
+        (*this)();
+    }
+
+    static result_type min() { return 0; }
+    static result_type max() { return 0xffffffffu; }
+
+    /** Return the next 32 random bits. */
+    result_type operator()() {
+        uint64_t old = m_state;
+        m_state = old*6364136223846793005ULL + m_inc;
+        uint32_t x = uint32_t(((old >> 18) ^ old) >> 27);
+        uint32_t r = uint32_t(old >> 59);
+        return (x >> r) | (x << ((32 - r) & 31));
+    }
+
+
+  protected:
+
+    uint64_t m_state, m_inc;
+};
+
+/** The default engine. */
+typedef xoshiro128pp random_engine;
+
+} // namespace cml
+
+#if defined(_MSC_VER)
+#pragma pop_macro("min")
+#pragma pop_macro("max")
+#endif
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
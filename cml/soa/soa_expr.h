@@ -0,0 +1,454 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Expression classes for soa_vector<>.
+ *
+ * An SoA expression is evaluated one component plane at a time.  Each
+ * expression node has a component_type, which is the vector expression
+ * (UnaryVectorOp or BinaryVectorOp) computing one plane of the result from
+ * the planes of its operands, and component(i) returns that expression for
+ * plane i.  Assigning an SoA expression to an soa_vector therefore runs
+ * the ordinary vector assignment, including SIMD packet evaluation, once
+ * per plane.
+ *
+ * Nodes whose planes read more than one plane of an operand (cross() and
+ * normalize()) set mixes_components, so that soa_vector evaluates them
+ * through a temporary when assigning.  normalize() keeps the reciprocal
+ * lengths it computes for the first plane, and reuses them for the rest.
+ */
+
+#ifndef soa_expr_h
+#define soa_expr_h
+
+#include <cml/et/scalar_ops.h>
+#include <cml/vector/vector_expr.h>
+#include <cml/vector/vector_promotions.h>
+#include <cml/vector/vector_unroller.h>
+
+namespace cml {
+namespace et {
+
+/** Operand traits for SoA expressions (default: a scalar).
+ *
+ * A scalar has the same value in every component plane.
+ */
+template<class T> struct SoaTraits
+{
+    typedef T expr_type;
+    typedef T value_type;
+    typedef T const_reference;
+    typedef T component_type;
+    typedef T component_reference;
+
+    enum { dimension = 0, mixes_components = false };
+
+    static component_reference component(const_reference s, int) {
+        return s;
+    }
+};
+
+/** SoA operand traits for soa_vector<>. */
+template<typename E, int N, class A> struct SoaTraits< soa_vector<E,N,A> >
+{
+    typedef soa_vector<E,N,A> expr_type;
+    typedef E value_type;
+    typedef const expr_type& const_reference;
+    typedef typename expr_type::plane_type component_type;
+    typedef const component_type& component_reference;
+
+    enum { dimension = N, mixes_components = false };
+
+    static component_reference component(const_reference v, int i) {
+        return v.plane(i);
+    }
+};
+
+/** SoA operand traits for an expression node, which is copied by value. */
+template<class ExprT> struct SoaNodeTraits
+{
+    typedef ExprT expr_type;
+    typedef typename ExprT::value_type value_type;
+    typedef ExprT const_reference;
+    typedef typename ExprT::component_type component_type;
+    typedef component_type component_reference;
+
+    enum {
+        dimension = ExprT::dimension,
+        mixes_components = ExprT::mixes_components
+    };
+
+    static component_reference component(const ExprT& e, int i) {
+        return e.component(i);
+    }
+};
+
+
+/** Build the plane expression sum_i left_i*right_i over N planes. */
+template<class LeftT, class RightT, int N> struct SoaDot
+{
+    typedef SoaTraits<LeftT> left_traits;
+    typedef SoaTraits<RightT> right_traits;
+    typedef SoaDot<LeftT,RightT,N-1> head;
+
+    typedef OpMul<typename left_traits::value_type,
+            typename right_traits::value_type> mul_op;
+    typedef BinaryVectorOp<typename left_traits::component_type,
+            typename right_traits::component_type, mul_op> product_type;
+    typedef OpAdd<typename head::value_type,
+            typename mul_op::value_type> add_op;
+
+    typedef BinaryVectorOp<typename head::type, product_type, add_op> type;
+    typedef typename add_op::value_type value_type;
+
+    static type make(const LeftT& left, const RightT& right) {
+        return type(head::make(left,right), product_type(
+                    left_traits::component(left,N-1),
+                    right_traits::component(right,N-1)));
+    }
+};
+
+template<class LeftT, class RightT> struct SoaDot<LeftT,RightT,1>
+{
+    typedef SoaTraits<LeftT> left_traits;
+    typedef SoaTraits<RightT> right_traits;
+
+    typedef OpMul<typename left_traits::value_type,
+            typename right_traits::value_type> mul_op;
+    typedef BinaryVectorOp<typename left_traits::component_type,
+            typename right_traits::component_type, mul_op> type;
+    typedef typename mul_op::value_type value_type;
+
+    static type make(const LeftT& left, const RightT& right) {
+        return type(left_traits::component(left,0),
+                right_traits::component(right,0));
+    }
+};
+
+
+/** A placeholder for an SoA expression in an expression tree. */
+template<class ExprT>
+class SoaVectorXpr
+{
+  public:
+
+    typedef SoaVectorXpr<ExprT> expr_type;
+    typedef ExprT expression_type;
+    typedef typename ExprT::value_type value_type;
+    typedef typename ExprT::component_type component_type;
+    typedef typename ExprT::temporary_type temporary_type;
+
+    enum {
+        dimension = ExprT::dimension,
+        mixes_components = ExprT::mixes_components
+    };
+
+
+  public:
+
+    /** Return the vector expression for component plane i. */
+    component_type component(int i) const { return m_expr.component(i); }
+
+    /** Return the number of vectors in the bundle. */
+    size_t size() const { return m_expr.component(0).size(); }
+
+    /** Return the expression. */
+    const ExprT& expression() const { return m_expr; }
+
+
+  public:
+
+    /** Construct from an expression. */
+    explicit SoaVectorXpr(const ExprT& expr) : m_expr(expr) {}
+
+
+  protected:
+
+    ExprT m_expr;
+};
+
+
+/** A unary SoA expression, computed plane by plane. */
+template<class ArgT, class OpT>
+class SoaUnaryOp
+{
+  public:
+
+    typedef SoaUnaryOp<ArgT,OpT> expr_type;
+    typedef SoaTraits<ArgT> arg_traits;
+    typedef typename arg_traits::const_reference arg_reference;
+    typedef typename OpT::value_type value_type;
+
+    typedef UnaryVectorOp<typename arg_traits::component_type, OpT>
+        component_type;
+
+    enum {
+        dimension = arg_traits::dimension,
+        mixes_components = arg_traits::mixes_components
+    };
+
+    typedef soa_vector<value_type, dimension> temporary_type;
+
+
+  public:
+
+    /** Return the vector expression for component plane i. */
+    component_type component(int i) const {
+        return component_type(arg_traits::component(m_arg,i));
+    }
+
+
+  public:
+
+    /** Construct from the subexpression. */
+    explicit SoaUnaryOp(arg_reference arg) : m_arg(arg) {}
+
+
+  protected:
+
+    arg_reference m_arg;
+};
+
+
+/** A binary, element-wise SoA expression, computed plane by plane.
+ *
+ * One operand may be a scalar, which is used for every plane.
+ */
+template<class LeftT, class RightT, class OpT>
+class SoaBinaryOp
+{
+  public:
+
+    typedef SoaBinaryOp<LeftT,RightT,OpT> expr_type;
+    typedef SoaTraits<LeftT> left_traits;
+    typedef SoaTraits<RightT> right_traits;
+    typedef typename left_traits::const_reference left_reference;
+    typedef typename right_traits::const_reference right_reference;
+    typedef typename OpT::value_type value_type;
+
+    typedef BinaryVectorOp<typename left_traits::component_type,
+            typename right_traits::component_type, OpT> component_type;
+
+    enum {
+        dimension = (int(left_traits::dimension) > 0)
+            ? int(left_traits::dimension) : int(right_traits::dimension),
+        mixes_components = left_traits::mixes_components
+            || right_traits::mixes_components
+    };
+
+    typedef soa_vector<value_type, dimension> temporary_type;
+
+
+  public:
+
+    /** Return the vector expression for component plane i. */
+    component_type component(int i) const {
+        return component_type(
+                left_traits::component(m_left,i),
+                right_traits::component(m_right,i));
+    }
+
+
+  public:
+
+    /** Construct from the two subexpressions. */
+    SoaBinaryOp(left_reference left, right_reference right)
+        : m_left(left), m_right(right)
+    {
+        CML_STATIC_REQUIRE(
+                int(left_traits::dimension) == 0
+                || int(right_traits::dimension) == 0
+                || int(left_traits::dimension)
+                    == int(right_traits::dimension));
+    }
+
+
+  protected:
+
+    left_reference m_left;
+    right_reference m_right;
+};
+
+
+/** The plane-wise cross product of two 3D SoA expressions. */
+template<class LeftT, class RightT>
+class SoaCrossOp
+{
+  public:
+
+    typedef SoaCrossOp<LeftT,RightT> expr_type;
+    typedef SoaTraits<LeftT> left_traits;
+    typedef SoaTraits<RightT> right_traits;
+    typedef typename left_traits::const_reference left_reference;
+    typedef typename right_traits::const_reference right_reference;
+
+    typedef OpMul<typename left_traits::value_type,
+            typename right_traits::value_type> mul_op;
+    typedef BinaryVectorOp<typename left_traits::component_type,
+            typename right_traits::component_type, mul_op> product_type;
+    typedef OpSub<typename mul_op::value_type,
+            typename mul_op::value_type> sub_op;
+    typedef typename sub_op::value_type value_type;
+
+    typedef BinaryVectorOp<product_type, product_type, sub_op>
+        component_type;
+
+    enum { dimension = 3, mixes_components = true };
+
+    typedef soa_vector<value_type, dimension> temporary_type;
+
+
+  public:
+
+    /** Return the vector expression for component plane i. */
+    component_type component(int i) const {
+        int j = (i+1)%3, k = (i+2)%3;
+        return component_type(
+                product_type(left_traits::component(m_left,j),
+                    right_traits::component(m_right,k)),
+                product_type(left_traits::component(m_left,k),
+                    right_traits::component(m_right,j)));
+    }
+
+
+  public:
+
+    /** Construct from the two subexpressions. */
+    SoaCrossOp(left_reference left, right_reference right)
+        : m_left(left), m_right(right)
+    {
+        CML_STATIC_REQUIRE(int(left_traits::dimension) == 3
+                && int(right_traits::dimension) == 3);
+    }
+
+
+  protected:
+
+    left_reference m_left;
+    right_reference m_right;
+};
+
+
+/** The plane-wise normalization of an SoA expression.
+ *
+ * Each plane is scaled by the reciprocal length of the vectors (see
+ * cml::inv_sqrt()).  The reciprocal lengths are computed into a plane the
+ * first time a component is requested, and that plane is reused by the
+ * other components.
+ */
+template<class ArgT>
+class SoaNormalizeOp
+{
+  public:
+
+    typedef SoaNormalizeOp<ArgT> expr_type;
+    typedef SoaTraits<ArgT> arg_traits;
+    typedef typename arg_traits::const_reference arg_reference;
+
+    enum { dimension = arg_traits::dimension, mixes_components = true };
+
+    typedef SoaDot<ArgT,ArgT,dimension> dot_type;
+    typedef typename dot_type::value_type scale_value;
+    typedef UnaryVectorOp<typename dot_type::type,
+            OpInvSqrt<scale_value> > scale_expr;
+    typedef cml::vector< scale_value, dynamic<> > scale_type;
+    typedef OpMul<typename arg_traits::value_type, scale_value> mul_op;
+    typedef typename mul_op::value_type value_type;
+
+    typedef BinaryVectorOp<typename arg_traits::component_type,
+            scale_type, mul_op> component_type;
+
+    typedef soa_vector<value_type, dimension> temporary_type;
+
+
+  public:
+
+    /** Return the vector expression for component plane i. */
+    component_type component(int i) const {
+        if(!m_ready) {
+            scale_expr e(dot_type::make(m_arg,m_arg));
+            m_scale.resize(e.size());
+            UnrollAssignment< OpAssign<scale_value,scale_value> >(
+                    m_scale, e);
+            m_ready = true;
+        }
+        return component_type(arg_traits::component(m_arg,i), m_scale);
+    }
+
+
+  public:
+
+    /** Construct from the subexpression. */
+    explicit SoaNormalizeOp(arg_reference arg)
+        : m_arg(arg), m_ready(false) {}
+
+    /** Copy the subexpression, but not the reciprocal lengths. */
+    SoaNormalizeOp(const SoaNormalizeOp& e)
+        : m_arg(e.m_arg), m_ready(false) {}
+
+
+  protected:
+
+    arg_reference m_arg;
+
+    /* The reciprocal lengths, once computed: */
+    mutable scale_type m_scale;
+    mutable bool m_ready;
+
+
+  private:
+
+    SoaNormalizeOp& operator=(const SoaNormalizeOp&);
+};
+
+
+/* The generic dot() and cross() templates deduce their result types from
+ * ExprTraits<> and VectorPromote<>, so these are specialized for the SoA
+ * types as well; the SoA overloads of dot() and cross() are selected
+ * anyway, since they are more specialized.
+ */
+template<typename E, int N, class A> struct ExprTraits< soa_vector<E,N,A> >
+{
+    typedef soa_vector<E,N,A> expr_type;
+    typedef E value_type;
+    typedef soa_vector<E,N,A> result_type;
+};
+
+template<class ExprT> struct ExprTraits< SoaVectorXpr<ExprT> >
+{
+    typedef SoaVectorXpr<ExprT> expr_type;
+    typedef typename ExprT::value_type value_type;
+    typedef typename ExprT::temporary_type result_type;
+};
+
+template<typename E1, int N, class A1, typename E2, class A2>
+struct VectorPromote< soa_vector<E1,N,A1>, soa_vector<E2,N,A2> >
+{
+    typedef soa_vector<typename ScalarPromote<E1,E2>::type, N> type;
+    typedef type temporary_type;
+};
+
+/* Expression nodes are held by value: */
+template<class ArgT, class OpT> struct SoaTraits< SoaUnaryOp<ArgT,OpT> >
+    : SoaNodeTraits< SoaUnaryOp<ArgT,OpT> > {};
+template<class LeftT, class RightT, class OpT>
+struct SoaTraits< SoaBinaryOp<LeftT,RightT,OpT> >
+    : SoaNodeTraits< SoaBinaryOp<LeftT,RightT,OpT> > {};
+template<class LeftT, class RightT>
+struct SoaTraits< SoaCrossOp<LeftT,RightT> >
+    : SoaNodeTraits< SoaCrossOp<LeftT,RightT> > {};
+template<class ArgT> struct SoaTraits< SoaNormalizeOp<ArgT> >
+    : SoaNodeTraits< SoaNormalizeOp<ArgT> > {};
+
+} // namespace et
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,419 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Operators and functions on soa_vector<> expressions.
+ *
+ * As for vector expressions, the operators hoist the operands of
+ * SoaVectorXpr<> arguments into the new node, so that only the root of an
+ * SoA expression tree is an SoaVectorXpr.
+ */
+
+#ifndef soa_ops_h
+#define soa_ops_h
+
+#include <cml/soa/soa_expr.h>
+
+#define SOAXPR_ARG_TYPE  const et::SoaVectorXpr<XprT>&
+#define SOAXPR_ARG_TYPE_N(_N_)  const et::SoaVectorXpr<XprT##_N_>&
+
+/** Declare a unary operator on an soa_vector and an SoaVectorXpr. */
+#define CML_SOA_UNIOP(_op_, _OpT_)                                      \
+template<typename E, int N, class A>                                    \
+inline et::SoaVectorXpr< et::SoaUnaryOp< soa_vector<E,N,A>, _OpT_ <E> > > \
+_op_ (const soa_vector<E,N,A>& arg)                                     \
+{                                                                       \
+    typedef et::SoaUnaryOp< soa_vector<E,N,A>, _OpT_ <E> > ExprT;       \
+    return et::SoaVectorXpr<ExprT>(ExprT(arg));                         \
+}                                                                       \
+                                                                        \
+template<class XprT>                                                    \
+inline et::SoaVectorXpr<                                                \
+    et::SoaUnaryOp< XprT, _OpT_ <typename XprT::value_type> >           \
+>                                                                       \
+_op_ (SOAXPR_ARG_TYPE arg)                                              \
+{                                                                       \
+    typedef et::SoaUnaryOp<                                             \
+        XprT, _OpT_ <typename XprT::value_type> > ExprT;                \
+    return et::SoaVectorXpr<ExprT>(ExprT(arg.expression()));            \
+}
+
+/** Declare an operator taking two soa_vector operands. */
+#define CML_SOA_SOA_BINOP(_op_, _OpT_)                                  \
+template<typename E1, int N, class A1, typename E2, class A2>           \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp<                                                    \
+        soa_vector<E1,N,A1>, soa_vector<E2,N,A2>, _OpT_ <E1,E2>         \
+    >                                                                   \
+>                                                                       \
+_op_ (const soa_vector<E1,N,A1>& left, const soa_vector<E2,N,A2>& right) \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        soa_vector<E1,N,A1>, soa_vector<E2,N,A2>, _OpT_ <E1,E2>         \
+        > ExprT;                                                        \
+    return et::SoaVectorXpr<ExprT>(ExprT(left,right));                  \
+}
+
+/** Declare an operator taking an soa_vector and an SoaVectorXpr. */
+#define CML_SOA_SOAXPR_BINOP(_op_, _OpT_)                               \
+template<typename E, int N, class A, class XprT>                        \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp<                                                    \
+        soa_vector<E,N,A>, XprT, _OpT_ <E, typename XprT::value_type>   \
+    >                                                                   \
+>                                                                       \
+_op_ (const soa_vector<E,N,A>& left, SOAXPR_ARG_TYPE right)             \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        soa_vector<E,N,A>, XprT, _OpT_ <E, typename XprT::value_type>   \
+        > ExprT;                                                        \
+    return et::SoaVectorXpr<ExprT>(ExprT(left,right.expression()));     \
+}
+
+/** Declare an operator taking an SoaVectorXpr and an soa_vector. */
+#define CML_SOAXPR_SOA_BINOP(_op_, _OpT_)                               \
+template<class XprT, typename E, int N, class A>                        \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp<                                                    \
+        XprT, soa_vector<E,N,A>, _OpT_ <typename XprT::value_type, E>   \
+    >                                                                   \
+>                                                                       \
+_op_ (SOAXPR_ARG_TYPE left, const soa_vector<E,N,A>& right)             \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        XprT, soa_vector<E,N,A>, _OpT_ <typename XprT::value_type, E>   \
+        > ExprT;                                                        \
+    return et::SoaVectorXpr<ExprT>(ExprT(left.expression(),right));     \
+}
+
+/** Declare an operator taking two SoaVectorXpr operands. */
+#define CML_SOAXPR_SOAXPR_BINOP(_op_, _OpT_)                            \
+template<class XprT1, class XprT2>                                      \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp<                                                    \
+        XprT1, XprT2,                                                   \
+        _OpT_ <typename XprT1::value_type, typename XprT2::value_type>  \
+    >                                                                   \
+>                                                                       \
+_op_ (SOAXPR_ARG_TYPE_N(1) left, SOAXPR_ARG_TYPE_N(2) right)            \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        XprT1, XprT2,                                                   \
+        _OpT_ <typename XprT1::value_type, typename XprT2::value_type>  \
+        > ExprT;                                                        \
+    return et::SoaVectorXpr<ExprT>(                                     \
+            ExprT(left.expression(),right.expression()));              \
+}
+
+/** Declare an operator taking an soa_vector and a scalar. */
+#define CML_SOA_SCALAR_BINOP(_op_, _OpT_)                               \
+template<typename E, int N, class A, typename ScalarT>                  \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp< soa_vector<E,N,A>, ScalarT, _OpT_ <E,ScalarT> >    \
+>                                                                       \
+_op_ (const soa_vector<E,N,A>& left, SCALAR_ARG_TYPE right)             \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        soa_vector<E,N,A>, ScalarT, _OpT_ <E,ScalarT> > ExprT;          \
+    return et::SoaVectorXpr<ExprT>(ExprT(left,right));                  \
+}
+
+/** Declare an operator taking a scalar and an soa_vector. */
+#define CML_SCALAR_SOA_BINOP(_op_, _OpT_)                               \
+template<typename ScalarT, typename E, int N, class A>                  \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp< ScalarT, soa_vector<E,N,A>, _OpT_ <ScalarT,E> >    \
+>                                                                       \
+_op_ (SCALAR_ARG_TYPE left, const soa_vector<E,N,A>& right)             \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        ScalarT, soa_vector<E,N,A>, _OpT_ <ScalarT,E> > ExprT;          \
+    return et::SoaVectorXpr<ExprT>(ExprT(left,right));                  \
+}
+
+/** Declare an operator taking an SoaVectorXpr and a scalar. */
+#define CML_SOAXPR_SCALAR_BINOP(_op_, _OpT_)                            \
+template<class XprT, typename ScalarT>                                  \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp<                                                    \
+        XprT, ScalarT, _OpT_ <typename XprT::value_type,ScalarT>        \
+    >                                                                   \
+>                                                                       \
+_op_ (SOAXPR_ARG_TYPE left, SCALAR_ARG_TYPE right)                      \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        XprT, ScalarT, _OpT_ <typename XprT::value_type,ScalarT>        \
+        > ExprT;                                                        \
+    return et::SoaVectorXpr<ExprT>(ExprT(left.expression(),right));     \
+}
+
+/** Declare an operator taking a scalar and an SoaVectorXpr. */
+#define CML_SCALAR_SOAXPR_BINOP(_op_, _OpT_)                            \
+template<typename ScalarT, class XprT>                                  \
+inline et::SoaVectorXpr<                                                \
+    et::SoaBinaryOp<                                                    \
+        ScalarT, XprT, _OpT_ <ScalarT, typename XprT::value_type>       \
+    >                                                                   \
+>                                                                       \
+_op_ (SCALAR_ARG_TYPE left, SOAXPR_ARG_TYPE right)                      \
+{                                                                       \
+    typedef et::SoaBinaryOp<                                            \
+        ScalarT, XprT, _OpT_ <ScalarT, typename XprT::value_type>       \
+        > ExprT;                                                        \
+    return et::SoaVectorXpr<ExprT>(ExprT(left,right.expression()));     \
+}
+
+namespace cml {
+
+CML_SOA_UNIOP(operator+, et::OpPos)
+CML_SOA_UNIOP(operator-, et::OpNeg)
+
+CML_SOA_SOA_BINOP(       operator+, et::OpAdd)
+CML_SOA_SOAXPR_BINOP(    operator+, et::OpAdd)
+CML_SOAXPR_SOA_BINOP(    operator+, et::OpAdd)
+CML_SOAXPR_SOAXPR_BINOP( operator+, et::OpAdd)
+
+CML_SOA_SOA_BINOP(       operator-, et::OpSub)
+CML_SOA_SOAXPR_BINOP(    operator-, et::OpSub)
+CML_SOAXPR_SOA_BINOP(    operator-, et::OpSub)
+CML_SOAXPR_SOAXPR_BINOP( operator-, et::OpSub)
+
+CML_SOA_SCALAR_BINOP(    operator*, et::OpMul)
+CML_SCALAR_SOA_BINOP(    operator*, et::OpMul)
+CML_SOAXPR_SCALAR_BINOP( operator*, et::OpMul)
+CML_SCALAR_SOAXPR_BINOP( operator*, et::OpMul)
+
+CML_SOA_SCALAR_BINOP(    operator/, et::OpDiv)
+CML_SOAXPR_SCALAR_BINOP( operator/, et::OpDiv)
+
+
+namespace detail {
+
+/** The SoA expression node for an soa_vector or SoaVectorXpr argument. */
+template<class T> struct SoaNode
+{
+    typedef T type;
+    static const T& get(const T& v) { return v; }
+};
+
+template<class XprT> struct SoaNode< et::SoaVectorXpr<XprT> >
+{
+    typedef XprT type;
+    static const XprT& get(const et::SoaVectorXpr<XprT>& e) {
+        return e.expression();
+    }
+};
+
+/** Build the result of dot() for two SoA arguments. */
+template<class LeftT, class RightT> struct SoaDotResult
+{
+    typedef typename SoaNode<LeftT>::type left_type;
+    typedef typename SoaNode<RightT>::type right_type;
+    typedef et::SoaTraits<left_type> left_traits;
+    typedef et::SoaTraits<right_type> right_traits;
+    typedef et::SoaDot<left_type, right_type, left_traits::dimension>
+        dot_type;
+    typedef et::VectorXpr<typename dot_type::type> type;
+
+    static type make(const LeftT& left, const RightT& right) {
+        CML_STATIC_REQUIRE(
+                int(left_traits::dimension) == int(right_traits::dimension));
+        return type(dot_type::make(
+                    SoaNode<LeftT>::get(left), SoaNode<RightT>::get(right)));
+    }
+};
+
+/** Build the result of length() for an SoA argument. */
+template<class ArgT> struct SoaLengthResult
+{
+    typedef SoaDotResult<ArgT,ArgT> dot_result;
+    typedef typename dot_result::dot_type dot_type;
+    typedef et::OpSqrt<typename dot_type::value_type> sqrt_op;
+    typedef et::UnaryVectorOp<typename dot_type::type, sqrt_op> length_op;
+    typedef et::VectorXpr<length_op> type;
+
+    static type make(const ArgT& arg) {
+        return type(length_op(dot_result::make(arg,arg).expression()));
+    }
+};
+
+/** Build the result of cross() for two SoA arguments. */
+template<class LeftT, class RightT> struct SoaCrossResult
+{
+    typedef et::SoaCrossOp<typename SoaNode<LeftT>::type,
+            typename SoaNode<RightT>::type> cross_op;
+    typedef et::SoaVectorXpr<cross_op> type;
+
+    static type make(const LeftT& left, const RightT& right) {
+        return type(cross_op(
+                    SoaNode<LeftT>::get(left), SoaNode<RightT>::get(right)));
+    }
+};
+
+/** Build the result of normalize() for an SoA argument. */
+template<class ArgT> struct SoaNormalizeResult
+{
+    typedef et::SoaNormalizeOp<typename SoaNode<ArgT>::type> normalize_op;
+    typedef et::SoaVectorXpr<normalize_op> type;
+
+    static type make(const ArgT& arg) {
+        return type(normalize_op(SoaNode<ArgT>::get(arg)));
+    }
+};
+
+} // namespace detail
+
+/** Plane-wise dot product of two soa_vectors.
+ *
+ * The result is a vector expression with one element per vector.
+ */
+template<typename E1, int N, class A1, typename E2, class A2>
+inline typename detail::SoaDotResult<
+    soa_vector<E1,N,A1>, soa_vector<E2,N,A2> >::type
+dot(const soa_vector<E1,N,A1>& left, const soa_vector<E2,N,A2>& right)
+{
+    return detail::SoaDotResult<
+        soa_vector<E1,N,A1>, soa_vector<E2,N,A2> >::make(left,right);
+}
+
+/** Plane-wise dot product of an soa_vector and an SoA expression. */
+template<typename E, int N, class A, class XprT>
+inline typename detail::SoaDotResult<
+    soa_vector<E,N,A>, et::SoaVectorXpr<XprT> >::type
+dot(const soa_vector<E,N,A>& left, SOAXPR_ARG_TYPE right)
+{
+    return detail::SoaDotResult<
+        soa_vector<E,N,A>, et::SoaVectorXpr<XprT> >::make(left,right);
+}
+
+/** Plane-wise dot product of an SoA expression and an soa_vector. */
+template<class XprT, typename E, int N, class A>
+inline typename detail::SoaDotResult<
+    et::SoaVectorXpr<XprT>, soa_vector<E,N,A> >::type
+dot(SOAXPR_ARG_TYPE left, const soa_vector<E,N,A>& right)
+{
+    return detail::SoaDotResult<
+        et::SoaVectorXpr<XprT>, soa_vector<E,N,A> >::make(left,right);
+}
+
+/** Plane-wise dot product of two SoA expressions. */
+template<class XprT1, class XprT2>
+inline typename detail::SoaDotResult<
+    et::SoaVectorXpr<XprT1>, et::SoaVectorXpr<XprT2> >::type
+dot(SOAXPR_ARG_TYPE_N(1) left, SOAXPR_ARG_TYPE_N(2) right)
+{
+    return detail::SoaDotResult<
+        et::SoaVectorXpr<XprT1>, et::SoaVectorXpr<XprT2> >::make(left,right);
+}
+
+/** Plane-wise cross product of two 3D soa_vectors. */
+template<typename E1, class A1, typename E2, class A2>
+inline typename detail::SoaCrossResult<
+    soa_vector<E1,3,A1>, soa_vector<E2,3,A2> >::type
+cross(const soa_vector<E1,3,A1>& left, const soa_vector<E2,3,A2>& right)
+{
+    return detail::SoaCrossResult<
+        soa_vector<E1,3,A1>, soa_vector<E2,3,A2> >::make(left,right);
+}
+
+/** Plane-wise cross product of an soa_vector and an SoA expression. */
+template<typename E, class A, class XprT>
+inline typename detail::SoaCrossResult<
+    soa_vector<E,3,A>, et::SoaVectorXpr<XprT> >::type
+cross(const soa_vector<E,3,A>& left, SOAXPR_ARG_TYPE right)
+{
+    return detail::SoaCrossResult<
+        soa_vector<E,3,A>, et::SoaVectorXpr<XprT> >::make(left,right);
+}
+
+/** Plane-wise cross product of an SoA expression and an soa_vector. */
+template<class XprT, typename E, class A>
+inline typename detail::SoaCrossResult<
+    et::SoaVectorXpr<XprT>, soa_vector<E,3,A> >::type
+cross(SOAXPR_ARG_TYPE left, const soa_vector<E,3,A>& right)
+{
+    return detail::SoaCrossResult<
+        et::SoaVectorXpr<XprT>, soa_vector<E,3,A> >::make(left,right);
+}
+
+/** Plane-wise cross product of two SoA expressions. */
+template<class XprT1, class XprT2>
+inline typename detail::SoaCrossResult<
+    et::SoaVectorXpr<XprT1>, et::SoaVectorXpr<XprT2> >::type
+cross(SOAXPR_ARG_TYPE_N(1) left, SOAXPR_ARG_TYPE_N(2) right)
+{
+    return detail::SoaCrossResult<
+        et::SoaVectorXpr<XprT1>, et::SoaVectorXpr<XprT2> >::make(left,right);
+}
+
+/** Squared lengths of the vectors in an soa_vector. */
+template<typename E, int N, class A>
+inline typename detail::SoaDotResult<
+    soa_vector<E,N,A>, soa_vector<E,N,A> >::type
+length_squared(const soa_vector<E,N,A>& arg)
+{
+    return dot(arg,arg);
+}
+
+/** Squared lengths of the vectors in an SoA expression. */
+template<class XprT>
+inline typename detail::SoaDotResult<
+    et::SoaVectorXpr<XprT>, et::SoaVectorXpr<XprT> >::type
+length_squared(SOAXPR_ARG_TYPE arg)
+{
+    return dot(arg,arg);
+}
+
+/** Lengths of the vectors in an soa_vector. */
+template<typename E, int N, class A>
+inline typename detail::SoaLengthResult< soa_vector<E,N,A> >::type
+length(const soa_vector<E,N,A>& arg)
+{
+    return detail::SoaLengthResult< soa_vector<E,N,A> >::make(arg);
+}
+
+/** Lengths of the vectors in an SoA expression. */
+template<class XprT>
+inline typename detail::SoaLengthResult< et::SoaVectorXpr<XprT> >::type
+length(SOAXPR_ARG_TYPE arg)
+{
+    return detail::SoaLengthResult< et::SoaVectorXpr<XprT> >::make(arg);
+}
+
+/** Normalize the vectors in an soa_vector. */
+template<typename E, int N, class A>
+inline typename detail::SoaNormalizeResult< soa_vector<E,N,A> >::type
+normalize(const soa_vector<E,N,A>& arg)
+{
+    return detail::SoaNormalizeResult< soa_vector<E,N,A> >::make(arg);
+}
+
+/** Normalize the vectors in an SoA expression. */
+template<class XprT>
+inline typename detail::SoaNormalizeResult< et::SoaVectorXpr<XprT> >::type
+normalize(SOAXPR_ARG_TYPE arg)
+{
+    return detail::SoaNormalizeResult< et::SoaVectorXpr<XprT> >::make(arg);
+}
+
+} // namespace cml
+
+#undef CML_SOA_UNIOP
+#undef CML_SOA_SOA_BINOP
+#undef CML_SOA_SOAXPR_BINOP
+#undef CML_SOAXPR_SOA_BINOP
+#undef CML_SOAXPR_SOAXPR_BINOP
+#undef CML_SOA_SCALAR_BINOP
+#undef CML_SCALAR_SOA_BINOP
+#undef CML_SOAXPR_SCALAR_BINOP
+#undef CML_SCALAR_SOAXPR_BINOP
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,213 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief The soa_vector<> class.
+ *
+ * @note Include cml/soa_vector.h rather than this file.
+ */
+
+#ifndef soa_soa_vector_h
+#define soa_soa_vector_h
+
+#include <cml/soa/soa_expr.h>
+#include <cml/vector/vector_unroller.h>
+
+namespace cml {
+
+template<typename Element, int Size, class Alloc>
+class soa_vector
+{
+  public:
+
+    /* Shorthand for the type of this bundle: */
+    typedef soa_vector<Element,Size,Alloc> soa_vector_type;
+
+    /* For integration into the SoA expression templates: */
+    typedef soa_vector_type expr_type;
+    typedef soa_vector_type temporary_type;
+
+    /* The type holding one component of every vector: */
+    typedef cml::vector< Element, dynamic<Alloc> > plane_type;
+
+    /* The type of a single vector in the bundle: */
+    typedef cml::vector< Element, fixed<Size> > element_type;
+
+    /* Standard: */
+    typedef Element value_type;
+
+    /* The dimension of the vectors: */
+    enum { dimension = Size };
+
+
+  public:
+
+    /** Return the number of vectors. */
+    size_t size() const { return m_planes[0].size(); }
+
+    /** Set the number of vectors.
+     *
+     * @note The contents are not preserved.
+     */
+    void resize(size_t n) {
+        for(int i = 0; i < Size; ++ i) m_planes[i].resize(n);
+    }
+
+    /** Return component plane i, holding component i of every vector. */
+    plane_type& plane(int i) { return m_planes[i]; }
+
+    /** Return component plane i, holding component i of every vector. */
+    const plane_type& plane(int i) const { return m_planes[i]; }
+
+    /** Gather vector k. */
+    element_type get(size_t k) const {
+        element_type v;
+        for(int i = 0; i < Size; ++ i) v[i] = m_planes[i][k];
+        return v;
+    }
+
+    /** Scatter v into vector k. */
+    template<typename E, class AT>
+    void set(size_t k, const vector<E,AT>& v) {
+        for(int i = 0; i < Size; ++ i) m_planes[i][k] = v[i];
+    }
+
+    /** Normalize every vector in place.
+     *
+     * The reciprocal lengths are computed once, to the precision of
+     * cml::inv_sqrt(), then each plane is scaled by them.
+     */
+    soa_vector_type& normalize() {
+        typedef et::SoaDot<soa_vector_type,soa_vector_type,Size> dot_type;
+        typedef et::UnaryVectorOp<typename dot_type::type,
+                et::OpInvSqrt<Element> > scale_type;
+
+        plane_type scale;
+        et::UnrollAssignment< et::OpAssign<Element,Element> >(
+                scale, scale_type(dot_type::make(*this,*this)));
+        for(int i = 0; i < Size; ++ i)
+            et::UnrollAssignment< et::OpMulAssign<Element,Element> >(
+                    m_planes[i], scale);
+        return *this;
+    }
+
+
+  public:
+
+    /** Default constructor, for an empty bundle. */
+    soa_vector() {}
+
+    /** Construct a bundle of n vectors. */
+    explicit soa_vector(size_t n) { resize(n); }
+
+    /** Construct from an SoA expression. */
+    template<class XprT> soa_vector(const et::SoaVectorXpr<XprT>& e) {
+        typedef et::OpAssign<Element,typename XprT::value_type> OpT;
+        this->resize(e.size());
+        this->assign<OpT>(e.expression());
+    }
+
+
+  public:
+
+    /** Assign from an SoA expression. */
+    template<class XprT>
+    soa_vector_type& operator=(const et::SoaVectorXpr<XprT>& e) {
+        typedef et::OpAssign<Element,typename XprT::value_type> OpT;
+        typedef typename is_true<XprT::mixes_components>::result aliased;
+        this->assign<OpT>(e.expression(), aliased());
+        return *this;
+    }
+
+    /** Add an soa_vector. */
+    template<typename E, class A>
+    soa_vector_type& operator+=(const soa_vector<E,Size,A>& v) {
+        for(int i = 0; i < Size; ++ i) m_planes[i] += v.plane(i);
+        return *this;
+    }
+
+    /** Add an SoA expression. */
+    template<class XprT>
+    soa_vector_type& operator+=(const et::SoaVectorXpr<XprT>& e) {
+        typedef et::OpAddAssign<Element,typename XprT::value_type> OpT;
+        typedef typename is_true<XprT::mixes_components>::result aliased;
+        this->assign<OpT>(e.expression(), aliased());
+        return *this;
+    }
+
+    /** Subtract an soa_vector. */
+    template<typename E, class A>
+    soa_vector_type& operator-=(const soa_vector<E,Size,A>& v) {
+        for(int i = 0; i < Size; ++ i) m_planes[i] -= v.plane(i);
+        return *this;
+    }
+
+    /** Subtract an SoA expression. */
+    template<class XprT>
+    soa_vector_type& operator-=(const et::SoaVectorXpr<XprT>& e) {
+        typedef et::OpSubAssign<Element,typename XprT::value_type> OpT;
+        typedef typename is_true<XprT::mixes_components>::result aliased;
+        this->assign<OpT>(e.expression(), aliased());
+        return *this;
+    }
+
+    /** Scale every vector. */
+    soa_vector_type& operator*=(const Element& s) {
+        for(int i = 0; i < Size; ++ i) m_planes[i] *= s;
+        return *this;
+    }
+
+    /** Divide every vector by a scalar. */
+    soa_vector_type& operator/=(const Element& s) {
+        for(int i = 0; i < Size; ++ i) m_planes[i] /= s;
+        return *this;
+    }
+
+
+  protected:
+
+    /** Evaluate an expression into the planes, one plane at a time. */
+    template<class OpT, class ExprT> void assign(const ExprT& e) {
+        CML_STATIC_REQUIRE(int(ExprT::dimension) == Size);
+        for(int i = 0; i < Size; ++ i)
+            et::UnrollAssignment<OpT>(m_planes[i], e.component(i));
+    }
+
+    /** Evaluate an expression that does not read across planes. */
+    template<class OpT, class ExprT>
+        void assign(const ExprT& e, false_type) { this->assign<OpT>(e); }
+
+    /** Evaluate an expression that may read this bundle across planes.
+     *
+     * The planes of e are computed into a temporary first, since a plane
+     * written early could otherwise be read by a later one.
+     */
+    template<class OpT, class ExprT>
+        void assign(const ExprT& e, true_type)
+    {
+        typedef typename OpT::right_value src_value_type;
+        soa_vector<src_value_type,Size,Alloc> t(e.component(0).size());
+        t.template assign< et::OpAssign<src_value_type,src_value_type> >(e);
+        for(int i = 0; i < Size; ++ i)
+            et::UnrollAssignment<OpT>(m_planes[i], t.plane(i));
+    }
+
+    template<typename E, int N, class A> friend class soa_vector;
+
+
+  protected:
+
+    plane_type m_planes[Size];
+};
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,56 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief The structure-of-arrays soa_vector<> class.
+ */
+
+#ifndef cml_soa_vector_h
+#define cml_soa_vector_h
+
+#include <cml/core/common.h>
+#include <cml/dynamic.h>
+
+namespace cml {
+
+/** A bundle of n Size-dimensional vectors, stored as Size component planes.
+ *
+ * Component i of every vector in the bundle is kept in plane(i), a dynamic
+ * cml::vector of length n, so that e.g. all of the x coordinates are
+ * contiguous.  Element-wise expressions on soa_vectors (+, -, scalar * and
+ * /, cross(), normalize()) are evaluated one plane at a time by the vector
+ * expression templates, which process a SIMD packet of vectors per step.
+ * dot() and length() of soa_vectors are ordinary vector expressions with
+ * one element per vector in the bundle.
+ *
+ * @sa cml/vector/vector_packet.h
+ */
+template<typename Element, int Size,
+    class Alloc = CML_DEFAULT_ARRAY_ALLOC> class soa_vector;
+
+} // namespace cml
+
+#include <cml/vector.h>
+#include <cml/soa/soa_expr.h>
+#include <cml/soa/soa_ops.h>
+#include <cml/soa/soa_vector.h>
+
+namespace cml {
+
+/* Bundles of 3D and 4D vectors: */
+typedef soa_vector< float,  3 > soa_vector3f;
+typedef soa_vector< double, 3 > soa_vector3d;
+typedef soa_vector< float,  4 > soa_vector4f;
+typedef soa_vector< double, 4 > soa_vector4d;
+
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
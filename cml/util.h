@@ -16,6 +16,8 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <algorithm>   // For std::min and std::max.
 #include <cstdlib>     // For std::rand.
 #include <cml/constants.h>
+#include <cml/core/simd.h>
+#include <cml/random.h>
 
 #if defined(_MSC_VER)
 #pragma push_macro("min")
@@ -82,12 +84,60 @@ T cub(T value) {
     return value * value * value;
 }
 
-/** Inverse square root. */
+/** Inverse square root, computed exactly. */
 template < typename T >
-T inv_sqrt(T value) {
+T inv_sqrt(T value, inv_sqrt_exact) {
     return T(1.0 / std::sqrt(value));
 }
 
+/** Inverse square root, from the estimate refined by one Newton step.
+ *
+ * The relative error is below 5e-7 with SSE, or 5e-6 otherwise.  Double
+ * precision values are estimated in single precision, so must be within
+ * the range of float.
+ */
+template < typename T >
+T inv_sqrt(T value, inv_sqrt_newton) {
+    T y = simd::rsqrt_estimate(value);
+    return y * (T(1.5) - T(.5) * value * y * y);
+}
+
+/** Inverse square root estimate.
+ *
+ * The relative error is below 3.7e-4 with SSE, or 1.8e-3 otherwise.
+ */
+template < typename T >
+T inv_sqrt(T value, inv_sqrt_estimate) {
+    return simd::rsqrt_estimate(value);
+}
+
+/** Inverse square root.
+ *
+ * The precision is selected at compile time by
+ * CML_DEFAULT_INV_SQRT_PRECISION, and is exact by default.  This is also
+ * the precision of normalize() for vectors, quaternions and planes.
+ */
+template < typename T >
+T inv_sqrt(T value) {
+    return inv_sqrt(value, default_inv_sqrt_precision());
+}
+
+namespace detail {
+
+/** Normalize x exactly, by dividing it by its length. */
+template < class T >
+T& normalize_to_precision(T& x, inv_sqrt_exact) {
+    return (x /= x.length());
+}
+
+/** Normalize x by scaling it by inv_sqrt() of its squared length. */
+template < class T, class Precision >
+T& normalize_to_precision(T& x, Precision) {
+    return (x *= inv_sqrt(x.length_squared(), Precision()));
+}
+
+} // namespace detail
+
 
 /* The next few functions deal with indexing. next() and prev() are useful
  * for operations involving the vertices of a polygon or other cyclic set,
@@ -236,6 +286,70 @@ T random_real(T min, T max) {
     return min + static_cast<T>(random_unit()) * (max - min);
 }
 
+/* Random values from an engine
+ *
+ * These overloads draw from the engine g (see cml/random.h) instead of
+ * std::rand(), so threads with their own engines do not share state.
+ */
+
+/** Random binary (0,1) value from g. */
+template < class Engine >
+size_t random_binary(Engine& g) {
+    return size_t(uint32_t(g()) >> 31);
+}
+
+/** Random polar (-1,1) value from g. */
+template < class Engine >
+int random_polar(Engine& g) {
+    return random_binary(g) ? 1 : -1;
+}
+
+/** Random real in [0,1) from g. */
+template < class Engine >
+double random_unit(Engine& g) {
+    return detail::random_uniform<double>(g);
+}
+
+/** Random integer in the range [min, max] from g (unbiased). */
+template < class Engine >
+long random_integer(long min, long max, Engine& g) {
+    /* The number of values less one, without overflowing long: */
+    uint64_t span = uint64_t(max) - uint64_t(min);
+
+    if(span <= 0xffffffffu) {
+        uint32_t range = uint32_t(span) + 1;
+        if(range == 0) return long(uint64_t(min) + uint32_t(g()));
+
+        /* Multiply into [0,range), rejecting the few draws that would
+         * favor some values (Lemire):
+         */
+        uint64_t m = uint64_t(uint32_t(g())) * range;
+        if(uint32_t(m) < range) {
+            uint32_t threshold = uint32_t(-range) % range;
+            while(uint32_t(m) < threshold)
+                m = uint64_t(uint32_t(g())) * range;
+        }
+        return long(uint64_t(min) + (m >> 32));
+    }
+
+    /* Wider ranges (with a 64-bit long): draw 64 bits, rejecting the
+     * lowest 2^64 % range values so that the remainder is unbiased:
+     */
+    uint64_t range = span + 1;
+    uint64_t x = (uint64_t(uint32_t(g())) << 32) | uint32_t(g());
+    if(range == 0) return long(uint64_t(min) + x);
+    uint64_t threshold = (0 - range) % range;
+    while(x < threshold)
+        x = (uint64_t(uint32_t(g())) << 32) | uint32_t(g());
+    return long(uint64_t(min) + x % range);
+}
+
+/** Random real number in the range [min, max) from g. */
+template < typename T, class Engine >
+T random_real(T min, T max, Engine& g) {
+    return min + detail::random_uniform<T>(g) * (max - min);
+}
+
 /** Squared length in R2. */
 template < typename T >
 T length_squared(T x, T y) {
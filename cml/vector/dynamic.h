@@ -17,6 +17,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/vector/vector_expr.h>
 #include <cml/vector/class_ops.h>
 #include <cml/vector/vector_unroller.h>
+#include <cml/util.h>
 
 namespace cml {
 
@@ -86,9 +87,15 @@ class vector< Element, dynamic<Alloc> >
         return std::sqrt(length_squared());
     }
 
-    /** Normalize the vector. */
+    /** Normalize the vector.
+     *
+     * The vector is divided by its length, or scaled by cml::inv_sqrt()
+     * of its squared length when CML_DEFAULT_INV_SQRT_PRECISION is not
+     * exact.
+     */
     vector_type& normalize() {
-        return (*this /= length());
+        return detail::normalize_to_precision(
+                *this, default_inv_sqrt_precision());
     }
 
     /** Set this vector to [0]. */
@@ -150,6 +157,18 @@ class vector< Element, dynamic<Alloc> >
     /** Construct given array size. */
     vector(size_t N) : array_type(N) {}
 
+#if defined(CML_HAS_RVALUE_REFERENCES)
+    /** Move constructor, taking over the storage of v. */
+    vector(vector_type&& v) CML_NOEXCEPT
+        : array_type(static_cast<array_type&&>(v)) {}
+
+    /** Move assignment, taking over the storage of v. */
+    vector_type& operator=(vector_type&& v) CML_NOEXCEPT {
+        array_type::operator=(static_cast<array_type&&>(v));
+        return *this;
+    }
+#endif
+
 
   public:
 
@@ -182,6 +201,13 @@ class vector< Element, dynamic<Alloc> >
     CML_VEC_ASSIGN_FROM_SCALAR(/=, cml::et::OpDivAssign)
 };
 
+/** Exchange two dynamic vectors without copying their elements. */
+template<typename E, typename A> inline void
+swap(vector< E, dynamic<A> >& a, vector< E, dynamic<A> >& b)
+{
+    a.swap(b);
+}
+
 } // namespace cml
 
 #endif
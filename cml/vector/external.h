@@ -21,6 +21,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/vector/vector_expr.h>
 #include <cml/vector/class_ops.h>
 #include <cml/vector/vector_unroller.h>
+#include <cml/util.h>
 #include <cml/vector/dynamic.h>
 
 namespace cml {
@@ -98,9 +99,15 @@ class vector< Element, external<Size> >
         return std::sqrt(length_squared());
     }
 
-    /** Normalize the vector. */
+    /** Normalize the vector.
+     *
+     * The vector is divided by its length, or scaled by cml::inv_sqrt()
+     * of its squared length when CML_DEFAULT_INV_SQRT_PRECISION is not
+     * exact.
+     */
     vector_type& normalize() {
-        return (*this /= length());
+        return detail::normalize_to_precision(
+                *this, default_inv_sqrt_precision());
     }
 
     /** Set this vector to [0]. */
@@ -248,9 +255,15 @@ class vector< Element, external<> >
         return std::sqrt(length_squared());
     }
 
-    /** Normalize the vector. */
+    /** Normalize the vector.
+     *
+     * The vector is divided by its length, or scaled by cml::inv_sqrt()
+     * of its squared length when CML_DEFAULT_INV_SQRT_PRECISION is not
+     * exact.
+     */
     vector_type& normalize() {
-        return (*this /= length());
+        return detail::normalize_to_precision(
+                *this, default_inv_sqrt_precision());
     }
 
     /** Set this vector to [0]. */
@@ -22,19 +22,22 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 
 namespace cml {
 
-/** Fixed-size, fixed-memory vector. */
-template<typename Element, int Size>
-class vector< Element, fixed<Size> >
-: public fixed_1D<Element,Size>
+/** Fixed-size, fixed-memory vector.
+ *
+ * Align selects the alignment of the array, as for fixed<>.
+ */
+template<typename Element, int Size, int Align>
+class vector< Element, fixed<Size,-1,Align> >
+: public fixed_1D<Element,Size,Align>
 {
   public:
 
     /* Shorthand for the generator: */
     typedef fixed<> storage_type;
-    typedef fixed<Size> generator_type;
+    typedef fixed<Size,-1,Align> generator_type;
 
     /* Shorthand for the array type: */
-    typedef fixed_1D<Element,Size> array_type;
+    typedef fixed_1D<Element,Size,Align> array_type;
 
     /* Shorthand for the type of this vector: */
     typedef vector<Element,generator_type> vector_type;
@@ -94,9 +97,15 @@ class vector< Element, fixed<Size> >
         return std::sqrt(length_squared());
     }
 
-    /** Normalize the vector. */
+    /** Normalize the vector.
+     *
+     * The vector is divided by its length, or scaled by cml::inv_sqrt()
+     * of its squared length when CML_DEFAULT_INV_SQRT_PRECISION is not
+     * exact.
+     */
     vector_type& normalize() {
-        return (*this /= length());
+        return detail::normalize_to_precision(
+                *this, default_inv_sqrt_precision());
     }
 
     /** Set this vector to [0]. */
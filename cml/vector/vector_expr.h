@@ -421,6 +421,99 @@ struct ExprTraits< BinaryVectorOp<LeftT,RightT,OpT> >
     size_t size(const expr_type& e) const { return e.size(); }
 };
 
+/** Materialize<> for VectorXpr<>: evaluate the products it wraps. */
+template<class ExprT>
+class Materialize< VectorXpr<ExprT> >
+{
+  public:
+
+    typedef Materialize<ExprT> expr_materialize;
+    typedef VectorXpr<typename expr_materialize::type> type;
+
+
+  public:
+
+    /** Return the expression with its products evaluated. */
+    type expression() const { return type(m_expr.expression()); }
+
+
+  public:
+
+    /** Evaluate the products of e. */
+    explicit Materialize(const VectorXpr<ExprT>& e)
+        : m_expr(e.expression()) {}
+
+
+  protected:
+
+    expr_materialize m_expr;
+};
+
+/** Materialize<> for UnaryVectorOp<>: evaluate the products of the
+ * subexpression.
+ */
+template<class ExprT, class OpT>
+class Materialize< UnaryVectorOp<ExprT,OpT> >
+{
+  public:
+
+    typedef Materialize<ExprT> expr_materialize;
+    typedef UnaryVectorOp<typename expr_materialize::type,OpT> type;
+
+
+  public:
+
+    /** Return the expression with its products evaluated. */
+    type expression() const { return type(m_expr.expression()); }
+
+
+  public:
+
+    /** Evaluate the products of e. */
+    explicit Materialize(const UnaryVectorOp<ExprT,OpT>& e)
+        : m_expr(e.expression()) {}
+
+
+  protected:
+
+    expr_materialize m_expr;
+};
+
+/** Materialize<> for BinaryVectorOp<>: evaluate the products of both
+ * subexpressions.
+ */
+template<class LeftT, class RightT, class OpT>
+class Materialize< BinaryVectorOp<LeftT,RightT,OpT> >
+{
+  public:
+
+    typedef Materialize<LeftT> left_materialize;
+    typedef Materialize<RightT> right_materialize;
+    typedef BinaryVectorOp<typename left_materialize::type,
+            typename right_materialize::type, OpT> type;
+
+
+  public:
+
+    /** Return the expression with its products evaluated. */
+    type expression() const {
+        return type(m_left.expression(), m_right.expression());
+    }
+
+
+  public:
+
+    /** Evaluate the products of e. */
+    explicit Materialize(const BinaryVectorOp<LeftT,RightT,OpT>& e)
+        : m_left(e.left_expression()), m_right(e.right_expression()) {}
+
+
+  protected:
+
+    left_materialize m_left;
+    right_materialize m_right;
+};
+
 /* Helper struct to verify that both arguments are vector expressions: */
 template<typename LeftTraits, typename RightTraits>
 struct VectorExpressions
@@ -0,0 +1,283 @@
+/* -*- C++ -*- ------------------------------------------------------------
+
+Copyright (c) 2007 Jesse Krebs and Demian Nave http://cmldev.net/
+
+The Configurable Math Library (CML) is distributed under the terms of the
+Boost Software License, v1.0 (see cml/LICENSE for details).
+
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Packet (SIMD) evaluation of vector expressions.
+ *
+ * An element-wise vector expression can be evaluated a whole SIMD packet
+ * at a time when every leaf is either a cml::vector (fixed, dynamic or
+ * external storage, all of which are contiguous) or a scalar, and every
+ * node is a VectorXpr, UnaryVectorOp or BinaryVectorOp whose operator has
+ * a packet equivalent.  VectorPacketExpr<T,ExprT> records whether this is
+ * the case for an expression ExprT and packet element type T, and if so
+ * provides load(), which evaluates the expression at elements i..i+W-1.
+ *
+ * To keep the packet results identical to the scalar ones, every node (and
+ * every vector leaf) must have value_type T.  Mixed-precision expressions
+ * are therefore evaluated by the scalar unroller as before.
+ *
+ * Define CML_NO_VECTOR_PACKET_EVAL to disable packet evaluation.
+ *
+ * @sa cml::et::detail::VectorAssignmentUnroller
+ */
+
+#ifndef vector_packet_h
+#define vector_packet_h
+
+#include <cml/core/simd.h>
+#include <cml/et/scalar_ops.h>
+#include <cml/vector/vector_expr.h>
+
+namespace cml {
+namespace et {
+namespace detail {
+
+/** Packet types for element type T. */
+template<typename T> struct VectorPacketBase {
+    enum { W = simd::native_width<T>::value };
+    typedef simd::packet_traits<T,W> packet_traits;
+    typedef typename packet_traits::packet_type packet_type;
+};
+
+/** True if U is T, ignoring a const qualifier on U. */
+template<typename T, typename U> struct PacketElement {
+    enum { is_true = same_type<T, typename remove_const<U>::type>::is_true };
+};
+
+
+/** Packet equivalent of a scalar operator (default: none). */
+template<typename T, class OpT> struct PacketOp {
+    enum { is_true = false };
+};
+
+/** Declare the packet equivalent of a unary scalar operator. */
+#define CML_PACKET_UNARY_OP(_OpT_, _expr_)                              \
+template<typename T, typename ArgT>                                     \
+struct PacketOp< T, _OpT_ <ArgT> > : VectorPacketBase<T>                \
+{                                                                       \
+    typedef VectorPacketBase<T> base;                                   \
+    typedef typename base::packet_traits pt;                            \
+    typedef typename base::packet_type packet_type;                     \
+    enum { is_true = PacketElement<                                     \
+        T, typename _OpT_ <ArgT>::value_type>::is_true };               \
+    static packet_type apply(const packet_type& a) { return _expr_; }   \
+};
+
+/** Declare the packet equivalent of a binary scalar operator. */
+#define CML_PACKET_BINARY_OP(_OpT_, _expr_)                             \
+template<typename T, typename LeftT, typename RightT>                   \
+struct PacketOp< T, _OpT_ <LeftT,RightT> > : VectorPacketBase<T>        \
+{                                                                       \
+    typedef VectorPacketBase<T> base;                                   \
+    typedef typename base::packet_traits pt;                            \
+    typedef typename base::packet_type packet_type;                     \
+    enum { is_true = PacketElement<                                     \
+        T, typename _OpT_ <LeftT,RightT>::value_type>::is_true };       \
+    static packet_type apply(                                           \
+            const packet_type& a, const packet_type& b) { return _expr_; } \
+};
+
+CML_PACKET_UNARY_OP(OpNeg, pt::neg(a))
+CML_PACKET_UNARY_OP(OpPos, a)
+CML_PACKET_UNARY_OP(OpSqrt, pt::sqrt(a))
+CML_PACKET_UNARY_OP(OpInvSqrt, simd::inv_sqrt<pt>(a))
+CML_PACKET_BINARY_OP(OpAdd, pt::add(a,b))
+CML_PACKET_BINARY_OP(OpSub, pt::sub(a,b))
+CML_PACKET_BINARY_OP(OpMul, pt::mul(a,b))
+#if defined(CML_RECIPROCAL_OPTIMIZATION)
+CML_PACKET_BINARY_OP(OpDiv, pt::mul(a, pt::div(pt::set1(T(1)),b)))
+#else
+CML_PACKET_BINARY_OP(OpDiv, pt::div(a,b))
+#endif
+
+#undef CML_PACKET_UNARY_OP
+#undef CML_PACKET_BINARY_OP
+
+
+/** Packet equivalent of an op-assignment operator (default: none).
+ *
+ * Align is the alignment of the destination array, in bytes.
+ */
+template<typename T, class OpT, int Align> struct PacketAssignOp {
+    enum { is_true = false };
+};
+
+/** Declare the packet equivalent of an op-assignment operator.
+ *
+ * _expr_ computes the new value from the destination packet d and the
+ * source packet s.
+ */
+#define CML_PACKET_ASSIGN_OP(_OpT_, _expr_)                             \
+template<typename T, typename LeftT, typename RightT, int Align>        \
+struct PacketAssignOp< T, _OpT_ <LeftT,RightT>, Align >                 \
+: VectorPacketBase<T>                                                   \
+{                                                                       \
+    typedef VectorPacketBase<T> base;                                   \
+    typedef typename base::packet_traits pt;                            \
+    typedef typename base::packet_type packet_type;                     \
+    typedef simd::packet_memory<T,base::W,Align> mem;                   \
+    enum { is_true = same_type<T,LeftT>::is_true };                     \
+    static void apply(T* p, const packet_type& s) {                     \
+        packet_type d = mem::load(p); mem::store(p, _expr_); }          \
+};
+
+template<typename T, typename LeftT, typename RightT, int Align>
+struct PacketAssignOp< T, OpAssign<LeftT,RightT>, Align >
+: VectorPacketBase<T>
+{
+    typedef VectorPacketBase<T> base;
+    typedef typename base::packet_type packet_type;
+    typedef simd::packet_memory<T,base::W,Align> mem;
+    enum { is_true = same_type<T,LeftT>::is_true };
+    static void apply(T* p, const packet_type& s) { mem::store(p,s); }
+};
+
+CML_PACKET_ASSIGN_OP(OpAddAssign, pt::add(d,s))
+CML_PACKET_ASSIGN_OP(OpSubAssign, pt::sub(d,s))
+CML_PACKET_ASSIGN_OP(OpMulAssign, pt::mul(d,s))
+#if defined(CML_RECIPROCAL_OPTIMIZATION)
+CML_PACKET_ASSIGN_OP(OpDivAssign, pt::mul(d, pt::div(pt::set1(T(1)),s)))
+#else
+CML_PACKET_ASSIGN_OP(OpDivAssign, pt::div(d,s))
+#endif
+
+#undef CML_PACKET_ASSIGN_OP
+
+
+/** Packet evaluation of an expression (default: not supported). */
+template<typename T, class ExprT,
+    class TagT = typename ExprTraits<ExprT>::result_tag>
+struct VectorPacketExpr {
+    enum { is_true = false };
+};
+
+/** A scalar leaf is broadcast to every lane. */
+template<typename T, class ExprT>
+struct VectorPacketExpr<T,ExprT,scalar_result_tag> : VectorPacketBase<T>
+{
+    typedef VectorPacketBase<T> base;
+    typedef typename base::packet_type packet_type;
+    enum { is_true = true };
+    static packet_type load(const ExprT& s, size_t) {
+        return base::packet_traits::set1(T(s));
+    }
+};
+
+/** A vector leaf is loaded directly from its array.
+ *
+ * Aligned loads are used when the array is known to be aligned to at
+ * least the packet size, since i is always a multiple of the packet width.
+ */
+template<typename T, typename E, class AT>
+struct VectorPacketExpr<T,cml::vector<E,AT>,vector_result_tag>
+: VectorPacketBase<T>
+{
+    typedef VectorPacketBase<T> base;
+    typedef typename base::packet_type packet_type;
+    typedef simd::packet_memory<T, base::W,
+            cml::vector<E,AT>::array_alignment> mem;
+    enum { is_true = PacketElement<T,E>::is_true };
+    static packet_type load(const cml::vector<E,AT>& v, size_t i) {
+        return mem::load(v.data()+i);
+    }
+};
+
+/** VectorXpr<> just forwards to its subexpression. */
+template<typename T, class ExprT>
+struct VectorPacketExpr<T,VectorXpr<ExprT>,vector_result_tag>
+: VectorPacketBase<T>
+{
+    typedef VectorPacketBase<T> base;
+    typedef typename base::packet_type packet_type;
+    typedef VectorPacketExpr<T,ExprT> sub_expr;
+    enum { is_true = sub_expr::is_true };
+    static packet_type load(const VectorXpr<ExprT>& e, size_t i) {
+        return sub_expr::load(e.expression(), i);
+    }
+};
+
+/** Packet evaluation of a unary vector expression. */
+template<typename T, class ExprT, class OpT>
+struct VectorPacketExpr<T,UnaryVectorOp<ExprT,OpT>,vector_result_tag>
+: VectorPacketBase<T>
+{
+    typedef VectorPacketBase<T> base;
+    typedef typename base::packet_type packet_type;
+    typedef VectorPacketExpr<T,ExprT> sub_expr;
+    typedef PacketOp<T,OpT> op;
+    enum { is_true = sub_expr::is_true && op::is_true };
+    static packet_type load(const UnaryVectorOp<ExprT,OpT>& e, size_t i) {
+        return op::apply(sub_expr::load(e.expression(), i));
+    }
+};
+
+/** Packet evaluation of a binary vector expression. */
+template<typename T, class LeftT, class RightT, class OpT>
+struct VectorPacketExpr<T,
+    BinaryVectorOp<LeftT,RightT,OpT>,vector_result_tag> : VectorPacketBase<T>
+{
+    typedef VectorPacketBase<T> base;
+    typedef typename base::packet_type packet_type;
+    typedef VectorPacketExpr<T,LeftT> left_expr;
+    typedef VectorPacketExpr<T,RightT> right_expr;
+    typedef PacketOp<T,OpT> op;
+    enum { is_true = left_expr::is_true && right_expr::is_true
+        && op::is_true };
+    static packet_type load(
+            const BinaryVectorOp<LeftT,RightT,OpT>& e, size_t i)
+    {
+        return op::apply(
+                left_expr::load(e.left_expression(), i),
+                right_expr::load(e.right_expression(), i));
+    }
+};
+
+
+/** Packet evaluation of dest OpT src over a contiguous array.
+ *
+ * is_true is set when the target supports packets of T, and both the
+ * assignment operator and the expression can be evaluated by packets.
+ * Align is the alignment of the destination array, in bytes.
+ */
+template<typename T, class OpT, class SrcT, int Align>
+struct VectorPacketAssign
+{
+    typedef VectorPacketBase<T> base;
+    typedef PacketAssignOp<T,OpT,Align> assign_op;
+    typedef VectorPacketExpr<T,SrcT> src_expr;
+
+    enum { W = base::W };
+    enum { is_true =
+#if defined(CML_NO_VECTOR_PACKET_EVAL)
+        false
+#else
+        (W > 1) && assign_op::is_true && src_expr::is_true
+#endif
+    };
+
+    /** Evaluate whole packets from element i (a multiple of W) up to N,
+     * and return the index of the first element not done.
+     *
+     * The remaining (N-i) % W elements are left to the caller.
+     */
+    static size_t eval(T* dest, const SrcT& src, size_t N, size_t i = 0) {
+        for(; i + W <= N; i += W) {
+            assign_op::apply(dest+i, src_expr::load(src,i));
+        }
+        return i;
+    }
+};
+
+} // namespace detail
+} // namespace et
+} // namespace cml
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
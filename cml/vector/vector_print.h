@@ -14,6 +14,9 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #define vector_print_h
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 namespace cml {
 
@@ -39,6 +42,58 @@ operator<<(std::ostream& os, const et::VectorXpr<XprT>& v)
     return os;
 }
 
+namespace detail {
+
+/* Read the numbers of the next non-blank line into a resizable vector: */
+template<typename E, class AT> inline void
+read_vector_line(std::istream& is, vector<E,AT>& v, resizable_tag)
+{
+    std::string line;
+    is >> std::ws;
+    if(!std::getline(is, line)) return;
+    std::istringstream ls(line);
+    ls.imbue(is.getloc());
+    std::vector<E> values;
+    E value;
+    while(ls >> value) values.push_back(value);
+    if(!ls.eof() || values.empty()) {
+        is.setstate(std::ios::failbit);
+        return;
+    }
+    v.resize(values.size());
+    for(size_t i = 0; i < values.size(); ++i) v[i] = values[i];
+}
+
+/* A vector of size 0 that cannot be resized cannot be read: */
+template<typename E, class AT> inline void
+read_vector_line(std::istream& is, vector<E,AT>&, not_resizable_tag)
+{
+    is.setstate(std::ios::failbit);
+}
+
+} // namespace detail
+
+/** Input a vector from a std::istream, as written by operator<<.
+ *
+ * The elements are separated by whitespace.  A resizable vector of size 0
+ * is resized to hold the numbers of the next line that is not blank (so
+ * the end of the line before it is skipped, as after is >> n).  Reading a
+ * vector of size 0 that cannot be resized sets failbit.
+ */
+template<typename E, class AT> inline std::istream&
+operator>>(std::istream& is, vector<E,AT>& v)
+{
+    if(v.size() == 0) {
+        typedef typename vector<E,AT>::resizing_tag resizing_tag;
+        detail::read_vector_line(is, v, resizing_tag());
+        return is;
+    }
+    for(size_t i = 0; i < v.size() && is; ++i) {
+        is >> v[i];
+    }
+    return is;
+}
+
 } // namespace cml
 
 #endif
@@ -22,6 +22,7 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/vector/vector_unroller.h>
 #include <cml/vector/vector_expr.h>
 #include <cml/vector/vecop_macros.h>
+#include <cml/core/parallel.h>
 #include <cml/matrix/matrix_expr.h>
 
 /* This is used below to create a more meaningful compile-time error when
@@ -127,47 +128,79 @@ UnrollDot(const LeftT& left, const RightT& right, fixed_size_tag)
     return Unroller()(left,right);
 }
 
-/** Use a loop to compute the dot product for dynamic arrays.
- *
- * @note This should only be called for vectors.
+/** Compute the dot product of elements [first,N) of two vectors.
  *
- * @sa cml::dot
+ * first must be less than N.
  */
 template<typename LeftT, typename RightT>
 inline typename DotPromote<LeftT,RightT>::promoted_scalar
-UnrollDot(const LeftT& left, const RightT& right, dynamic_size_tag)
+DotRange(const LeftT& left, const RightT& right, size_t first, size_t N)
 {
-    /* Shorthand: */
     typedef DotPromote<LeftT,RightT> dot_helper;
-    typedef et::ExprTraits<LeftT> left_traits;
-    typedef et::ExprTraits<RightT> right_traits;
     typedef typename dot_helper::op_mul op_mul;
     typedef typename dot_helper::op_add op_add;
-
-    /* Record the return type: */
     typedef typename dot_helper::promoted_scalar sum_type;
 
-    /* Verify expression sizes: */
-    const size_t N = et::CheckedSize(left,right,dynamic_size_tag());
-
-    /* Initialize the sum. Left and right must be vector expressions, so
-     * it's okay to use array notation here:
+    /* Left and right must be vector expressions, so it's okay to use
+     * array notation here:
      */
-    sum_type sum(op_mul().apply(left[0],right[0]));
-    for(size_t i = 1; i < N; ++i) {
+    sum_type sum(op_mul().apply(left[first],right[first]));
+    for(size_t i = first+1; i < N; ++i) {
         /* XXX This might not be optimized properly by some compilers.
          * but to do anything else requires changing the requirements
          * of a scalar operator, or requires defining a new class of scalar
          * <op>= operators.
          */
         sum = op_add().apply(sum, op_mul().apply(left[i], right[i]));
-        /* Note: we don't need get(), since both arguments are required to
-         * be vector expressions.
-         */
     }
     return sum;
 }
 
+/** Use a loop to compute the dot product for dynamic arrays.
+ *
+ * When CML_PARALLEL is defined and the vectors are long enough, the sum
+ * is split across threads (see cml::parallel::reduce()).  The products in
+ * either expression are computed into temporaries first (see
+ * et::Materialize<>), so the loops only read from them.
+ *
+ * @note This should only be called for vectors.
+ *
+ * @sa cml::dot
+ */
+template<typename LeftT, typename RightT>
+inline typename DotPromote<LeftT,RightT>::promoted_scalar
+UnrollDot(const LeftT& left, const RightT& right, dynamic_size_tag)
+{
+    /* Shorthand: */
+    typedef et::Materialize<LeftT> left_materialize;
+    typedef et::Materialize<RightT> right_materialize;
+
+    /* Verify expression sizes: */
+    const size_t N = et::CheckedSize(left,right,dynamic_size_tag());
+
+    /* Compute the products in left and right: */
+    left_materialize left_eval(left);
+    right_materialize right_eval(right);
+    const typename left_materialize::type& l = left_eval.expression();
+    const typename right_materialize::type& r = right_eval.expression();
+
+#if defined(CML_PARALLEL)
+    if(cml::parallel::use_threads(N)) {
+        typedef DotPromote<LeftT,RightT> dot_helper;
+        typedef typename dot_helper::op_add op_add;
+        typedef typename dot_helper::promoted_scalar sum_type;
+        return cml::parallel::reduce<sum_type>(N,
+                [&](size_t begin, size_t end) {
+                    return DotRange(l, r, begin, end);
+                },
+                [](const sum_type& a, const sum_type& b) {
+                    return op_add().apply(a, b);
+                });
+    }
+#endif
+    return DotRange(l, r, 0, N);
+}
+
 /** For cross(): compile-time check for a 3D vector. */
 template<typename VecT> inline void
 Require3D(const VecT&, fixed_size_tag) {
@@ -11,6 +11,10 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
  *
  * Defines vector unrollers.
  *
+ * Element-wise assignments whose leaves are all cml::vector arrays or
+ * scalars are evaluated by SIMD packets, with a scalar loop for any
+ * remaining elements (see cml/vector/vector_packet.h).
+ *
  * @todo Add unrolling for dynamic vectors, and for vectors longer than
  * CML_VECTOR_UNROLL_LIMIT.
  *
@@ -25,6 +29,8 @@ Boost Software License, v1.0 (see cml/LICENSE for details).
 #include <cml/et/traits.h>
 #include <cml/et/size_checking.h>
 #include <cml/et/scalar_ops.h>
+#include <cml/vector/vector_packet.h>
+#include <cml/core/parallel.h>
 
 #if !defined(CML_VECTOR_UNROLL_LIMIT)
 #error "CML_VECTOR_UNROLL_LIMIT is undefined."
@@ -58,6 +64,10 @@ class VectorAssignmentUnroller
     typedef ExprTraits<vector_type> dest_traits;
     typedef ExprTraits<SrcT> src_traits;
 
+    /* Packet evaluation of the expression, if possible: */
+    typedef VectorPacketAssign<E,OpT,SrcT,
+            vector_type::array_alignment> packet_assign;
+
     /** Evaluate the binary operator for the first Len-1 elements. */
     template<int N, int Last> struct Eval<N,Last,true> {
         void operator()(vector_type& dest, const SrcT& src) const {
@@ -121,19 +131,80 @@ class VectorAssignmentUnroller
          * is a dynamic-sized expression, the check will still happen.
          */
 
-        /* Now, call the unroller: */
-        Unroller()(dest,src);
+        /* Now, call the unroller, or evaluate by packets if the vector is
+         * at least one packet long:
+         */
+        typedef typename is_true<packet_assign::is_true
+            && (int(Len) >= int(packet_assign::W))>::result use_packets;
+        this->Unroll(dest, src, Unroller(), use_packets());
     }
 
 
   private:
+
+    /** Evaluate elements [first,N) by packets, and the rest by scalars.
+     *
+     * first must be a multiple of the packet width.
+     */
+    void Loop(vector_type& dest, const SrcT& src, size_t first, size_t N,
+            true_type)
+    {
+        /* The packets end at the last multiple of W past first: */
+        const size_t W = packet_assign::W;
+        const size_t tail = first + (N - first)/W*W;
+        packet_assign::eval(dest.data(), src, tail, first);
+        for(size_t i = tail; i < N; ++i) {
+            OpT().apply(dest[i], src_traits().get(src,i));
+        }
+    }
+
+    /** Evaluate elements [first,N) by scalars. */
+    void Loop(vector_type& dest, const SrcT& src, size_t first, size_t N,
+            false_type)
+    {
+        for(size_t i = first; i < N; ++i) {
+            OpT().apply(dest[i], src_traits().get(src,i));
+            /* Note: we don't need get(), since dest is a vector. */
+        }
+    }
+
+    /** Evaluate a fixed-size assignment by packets. */
+    template<class UnrollerT> void Unroll(
+            vector_type& dest, const SrcT& src, UnrollerT, true_type)
+    {
+        this->Loop(dest, src, 0, size_t(vector_type::array_size),
+                true_type());
+    }
+
+    /** Evaluate a fixed-size assignment by the scalar unroller. */
+    template<class UnrollerT> void Unroll(
+            vector_type& dest, const SrcT& src, UnrollerT, false_type)
+    {
+        UnrollerT()(dest,src);
+    }
+
+    /** Return the size of a vector src, which dest is resized to. */
+    template<class ResultT> size_t AssignedSize(
+            const vector_type&, const SrcT& src, ResultT)
+    {
+        return src_traits().size(src);
+    }
+
+    /** A scalar src is assigned to each element, so keep dest's size. */
+    size_t AssignedSize(
+            const vector_type& dest, const SrcT&, scalar_result_tag)
+    {
+        return dest.size();
+    }
+
     /* XXX Blah, a temp. hack to fix the auto-resizing stuff below. */
     size_t CheckOrResize(
             vector_type& dest, const SrcT& src, cml::resizable_tag)
     {
 #if defined(CML_AUTOMATIC_VECTOR_RESIZE_ON_ASSIGNMENT)
         /* Get the size of src.  This also causes src to check its size: */
-        size_t N = std::max(dest.size(),src_traits().size(src));
+        size_t N = this->AssignedSize(
+                dest,src,typename src_traits::result_tag());
 
         /* Set the destination vector's size: */
         cml::et::detail::Resize(dest,N);
@@ -153,17 +224,30 @@ class VectorAssignmentUnroller
   public:
     
 
-    /** Just use a loop to assign to a runtime-sized vector. */
+    /** Just use a loop to assign to a runtime-sized vector.
+     *
+     * The loop is evaluated by packets when possible, and is split across
+     * threads when CML_PARALLEL is defined and the vector is long enough.
+     * The products in src were already computed by VectorAssignment<>, so
+     * the threads only read from it.
+     */
     void operator()(vector_type& dest, const SrcT& src, cml::dynamic_size_tag)
     {
-        /* Shorthand: */
-        typedef ExprTraits<SrcT> src_traits;
         size_t N = this->CheckOrResize(
                 dest,src,typename vector_type::resizing_tag());
-        for(size_t i = 0; i < N; ++i) {
-            OpT().apply(dest[i], src_traits().get(src,i));
-            /* Note: we don't need get(), since dest is a vector. */
+        typedef typename is_true<packet_assign::is_true>::result use_packets;
+#if defined(CML_PARALLEL)
+        if(cml::parallel::use_threads(N)) {
+            /* Keep the ranges aligned to whole packets: */
+            size_t grain = (cml::parallel::get_policy().grain + 63)/64*64;
+            cml::parallel::for_each_range(N, grain,
+                    [&](size_t begin, size_t end) {
+                        this->Loop(dest, src, begin, end, use_packets());
+                    });
+            return;
         }
+#endif
+        this->Loop(dest, src, 0, N, use_packets());
     }
 
 };
@@ -223,10 +307,35 @@ struct VectorAccumulateUnroller
                             left[i],right_traits().get(right,i)));
                 /* Note: we don't need get(), since dest is a vector. */
             }
+            return accum;
         }
     };
 };
 
+/** Assign an expression to a vector.
+ *
+ * The primary template assigns element by element with the unroller,
+ * after computing the products in src into temporaries (see
+ * Materialize<>).  Expressions that are better evaluated as a whole
+ * specialize this, e.g. mat-vec products in cml/matvec/matvec_mul.h.
+ */
+template<class SrcT> struct VectorAssignment
+{
+    template<class OpT, typename E, class AT>
+        static void assign(cml::vector<E,AT>& dest, const SrcT& src)
+        {
+            typedef cml::vector<E,AT> vector_type;
+            typedef typename Materialize<SrcT>::type src_type;
+            typedef VectorAssignmentUnroller<OpT,E,AT,src_type> unroller;
+            Materialize<SrcT> evaluated(src);
+            unroller()(dest, evaluated.expression(),
+                    typename vector_type::size_tag());
+            /* XXX It may make sense to unroll if either side is a fixed
+             * size.
+             */
+        }
+};
+
 }
 
 /** Construct an assignment unroller.
@@ -239,15 +348,7 @@ struct VectorAccumulateUnroller
 template<class OpT, class SrcT, typename E, class AT> inline
 void UnrollAssignment(cml::vector<E,AT>& dest, const SrcT& src)
 {
-    /* Record the destination vector type, and the expression traits: */
-    typedef cml::vector<E,AT> vector_type;
-
-    /* Record the type of the unroller: */
-    typedef detail::VectorAssignmentUnroller<OpT,E,AT,SrcT> unroller;
-
-    /* Do the unroll call: */
-    unroller()(dest, src, typename vector_type::size_tag());
-    /* XXX It may make sense to unroll if either side is a fixed size. */
+    detail::VectorAssignment<SrcT>::template assign<OpT>(dest, src);
 }
 
 } // namespace et
@@ -0,0 +1,213 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check aligned fixed<> storage and aligned_allocator<>, and that vector
+ * expressions, products and quaternions over aligned arrays give the same
+ * results as over unaligned ones.
+ */
+
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+bool is_aligned(const void* p, size_t align)
+{
+    return reinterpret_cast<size_t>(p) % align == 0;
+}
+
+template<class VecT1, class VecT2> void
+equal_or_fail(const VecT1& a, const VecT2& b, const std::string& msg)
+{
+    require(a.size() == b.size(), msg + ": size");
+    for(size_t i = 0; i < a.size(); ++ i)
+        require(std::fabs(a[i] - b[i]) < 1e-5, msg);
+}
+
+void allocator_test()
+{
+    typedef aligned_allocator<double,64> allocator;
+    allocator a;
+    for(size_t n = 1; n < 40; n += 3) {
+        double* p = a.allocate(n);
+        require(is_aligned(p, 64), "allocate: alignment");
+        for(size_t i = 0; i < n; ++ i) p[i] = double(i);
+        a.deallocate(p, n);
+    }
+
+    /* Sizes whose padded byte count overflows are rejected: */
+    bool thrown = false;
+    try {
+        a.allocate(size_t(-1)/sizeof(double));
+    } catch(std::bad_alloc&) {
+        thrown = true;
+    }
+    require(thrown, "allocate: overflow");
+    require(a.max_size() < size_t(-1)/sizeof(double), "max_size");
+
+    /* Rebinding keeps the alignment: */
+    allocator::rebind<char>::other c;
+    char* q = c.allocate(3);
+    require(is_aligned(q, 64), "rebind: alignment");
+    c.deallocate(q, 3);
+
+    std::vector< float, aligned_allocator<float,32> > v(17, 1.f);
+    require(is_aligned(&v[0], 32), "std::vector: alignment");
+}
+
+void fixed_test()
+{
+    typedef vector< float, fixed<8,-1,32> > vector8fa;
+    typedef vector< float, fixed<8> > vector8f;
+    typedef vector< float, fixed<3,-1,16> > vector3fa;
+
+    require(sizeof(vector3fa) == 16, "fixed<3,-1,16>: size");
+    require(int(vector8fa::array_alignment) == 32, "array_alignment");
+
+    vector8fa a, b, c;
+    vector8f ua, ub, uc;
+    for(int i = 0; i < 8; ++ i) {
+        ua[i] = a[i] = float(std::sin(0.3*i));
+        ub[i] = b[i] = float(std::cos(0.7*i));
+    }
+    require(is_aligned(a.data(), 32) && is_aligned(c.data(), 32),
+            "fixed<8,-1,32>: alignment");
+
+    c = a*2.f + b - a/4.f; uc = ua*2.f + ub - ua/4.f;
+    equal_or_fail(c, uc, "fixed<8,-1,32>: expression");
+    c += a; uc += ua;
+    equal_or_fail(c, uc, "fixed<8,-1,32>: +=");
+
+    /* Mixed with unaligned operands: */
+    c = a + ub; uc = ua + ub;
+    equal_or_fail(c, uc, "fixed<8,-1,32>: mixed operands");
+    require(std::fabs(dot(a,b) - dot(ua,ub)) < 1e-5, "fixed: dot");
+
+    /* 4x4 products: */
+    typedef matrix< float, fixed<4,4,16>, col_basis, row_major > matrix44fa;
+    typedef matrix< float, fixed<4,4,16>, col_basis, col_major > matrix44fac;
+    matrix44fa A, B, C;
+    matrix44fac Ac, Bc, Cc;
+    matrix44f_r uA, uB, uC;
+    for(int i = 0; i < 4; ++ i)
+        for(int j = 0; j < 4; ++ j) {
+            uA(i,j) = Ac(i,j) = A(i,j) = float(std::sin(1. + i + 0.3*j));
+            uB(i,j) = Bc(i,j) = B(i,j) = float(std::cos(2. + 0.7*i - j));
+        }
+    require(is_aligned(C.data(), 16), "fixed<4,4,16>: alignment");
+    C = A*B; Cc = Ac*Bc; uC = uA*uB;
+    for(int i = 0; i < 4; ++ i)
+        for(int j = 0; j < 4; ++ j) {
+            require(std::fabs(C(i,j) - uC(i,j)) < 1e-5, "4x4 row-major");
+            require(std::fabs(Cc(i,j) - uC(i,j)) < 1e-5, "4x4 col-major");
+        }
+}
+
+void heap_test()
+{
+    typedef vector< float, fixed<16,-1,32> > vector16fa;
+    typedef matrix< float, fixed<4,4,16>, col_basis, row_major > matrix44fa;
+
+    /* Separate allocations, so that at most one is aligned by chance: */
+    vector16fa* a = new vector16fa;
+    vector16fa* b = new vector16fa;
+    require(is_aligned(a->data(), 32) && is_aligned(b->data(), 32),
+            "new fixed<16,-1,32>: alignment");
+    for(int i = 0; i < 16; ++ i) {
+        (*a)[i] = float(i);
+        (*b)[i] = float(2*i);
+    }
+    *a = *a + *b;
+    for(int i = 0; i < 16; ++ i)
+        require((*a)[i] == float(3*i), "new fixed<16,-1,32>: expression");
+    delete a;
+    delete b;
+
+    vector16fa* v = new vector16fa[3];
+    for(int i = 0; i < 3; ++ i)
+        require(is_aligned(v[i].data(), 32), "new[] fixed<16,-1,32>");
+    delete [] v;
+
+    matrix44fa* A = new matrix44fa;
+    matrix44fa* B = new matrix44fa;
+    A->identity(); B->identity();
+    require(is_aligned(A->data(), 16) && is_aligned(B->data(), 16),
+            "new fixed<4,4,16>: alignment");
+    *B = *A * *B;
+    require((*B)(2,2) == 1.f && (*B)(2,3) == 0.f, "new fixed<4,4,16>: product");
+    delete A;
+    delete B;
+
+    vector16fa z; z.zero();
+    std::vector< vector16fa, aligned_allocator<vector16fa,32> > w(5, z);
+    for(size_t i = 0; i < w.size(); ++ i)
+        require(is_aligned(w[i].data(), 32), "std::vector: fixed alignment");
+}
+
+void quaternion_test()
+{
+    typedef quaternion< float, fixed<-1,-1,16> > quaternionfa;
+    quaternionfa a(1.f, 2.f, 3.f, 4.f), b(.5f, 1.f, 0.f, -1.f), c;
+    quaternionf ua(a), ub(b), uc;
+    require(is_aligned(c.data(), 16), "quaternion: alignment");
+    c = a*b; c.normalize(); uc = ua*ub; uc.normalize();
+    for(int i = 0; i < 4; ++ i)
+        require(std::fabs(c[i] - uc[i]) < 1e-5, "quaternion: product");
+}
+
+void dynamic_test()
+{
+    typedef vector< double, dynamic< aligned_allocator<double,64> > >
+        vectorda;
+    typedef vector< double, dynamic<> > vectord;
+
+    require(int(vectorda::array_alignment) == 64, "dynamic: alignment");
+    for(size_t n = 1; n < 30; n += 7) {
+        vectorda a(n), b(n), c;
+        vectord ua(n), ub(n), uc;
+        for(size_t i = 0; i < n; ++ i) {
+            ua[i] = a[i] = std::sin(0.3*i);
+            ub[i] = b[i] = std::cos(0.7*i);
+        }
+        c = a*2. - b; uc = ua*2. - ub;
+        require(is_aligned(c.data(), 64), "dynamic: result alignment");
+        equal_or_fail(c, uc, "dynamic: expression");
+    }
+
+    typedef matrix< double, dynamic< aligned_allocator<double,32> >,
+            col_basis, row_major > matrixda;
+    matrixda M(40,40);
+    require(is_aligned(M.data(), 32), "dynamic matrix: alignment");
+}
+
+int main()
+{
+    try {
+        allocator_test();
+        fixed_test();
+        heap_test();
+        quaternion_test();
+        dynamic_test();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
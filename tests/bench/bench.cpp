@@ -0,0 +1,498 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+#include "bench.h"
+
+#include <cml/defaults.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace bench {
+
+#if defined(_WIN32)
+double now_ns()
+{
+    LARGE_INTEGER count, freq;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return double(count.QuadPart)*1e9/double(freq.QuadPart);
+}
+#else
+double now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec)*1e9 + double(ts.tv_nsec);
+}
+#endif
+
+#if !defined(__GNUC__)
+void use_pointer(const volatile void*) {}
+#endif
+
+std::string case_base::name() const
+{
+    std::string s = family + "/" + op + "/" + storage + "/" + size + "/"
+        + type;
+    return layout.empty() ? s : s + "/" + layout;
+}
+
+double result::count(const std::string& name) const
+{
+    for(size_t i = 0; i < counts.size(); ++i) {
+        if((*events)[i].name == name) return counts[i];
+    }
+    return -1.;
+}
+
+double result::ipc() const
+{
+    double cycles = count("cycles"), instructions = count("instructions");
+    return cycles > 0. && instructions >= 0. ? instructions/cycles : -1.;
+}
+
+double result::flops_per_cycle() const
+{
+    double cycles = count("cycles");
+    return cycles > 0. ? c->flops/cycles : -1.;
+}
+
+namespace {
+
+std::vector<case_base*>& registry()
+{
+    static std::vector<case_base*> all;
+    return all;
+}
+
+/* Time one repetition of n iterations, in nanoseconds: */
+double time_run(case_base& c, size_t n)
+{
+    double start = now_ns();
+    c.run(n);
+    clobber_memory();
+    return now_ns() - start;
+}
+
+std::string escape(const std::string& s)
+{
+    std::string r;
+    for(size_t i = 0; i < s.size(); ++i) {
+        if(s[i] == '"' || s[i] == '\\') r += '\\';
+        r += s[i];
+    }
+    return r;
+}
+
+std::string compiler()
+{
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    std::ostringstream s;
+    s << "msvc " << _MSC_VER;
+    return s.str();
+#else
+    return "unknown";
+#endif
+}
+
+bool optimized()
+{
+#if defined(__OPTIMIZE__) || (defined(_MSC_VER) && defined(NDEBUG))
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* The CML settings that change the generated code: */
+std::vector< std::pair<std::string,long> > configuration()
+{
+    std::vector< std::pair<std::string,long> > cfg;
+    cfg.push_back(std::make_pair("CML_VECTOR_UNROLL_LIMIT",
+                long(CML_VECTOR_UNROLL_LIMIT)));
+    cfg.push_back(std::make_pair("CML_VECTOR_DOT_UNROLL_LIMIT",
+                long(CML_VECTOR_DOT_UNROLL_LIMIT)));
+#if defined(CML_2D_UNROLLER)
+    cfg.push_back(std::make_pair("CML_2D_UNROLLER", 1L));
+#else
+    cfg.push_back(std::make_pair("CML_2D_UNROLLER", 0L));
+#endif
+    cfg.push_back(std::make_pair("CML_MATRIX_BLOCKED_MUL_THRESHOLD",
+                long(CML_MATRIX_BLOCKED_MUL_THRESHOLD)));
+#if defined(CML_NO_SIMD)
+    cfg.push_back(std::make_pair("CML_NO_SIMD", 1L));
+#else
+    cfg.push_back(std::make_pair("CML_NO_SIMD", 0L));
+#endif
+    return cfg;
+}
+
+std::string timestamp()
+{
+    char buf[32];
+    std::time_t t = std::time(0);
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+    return buf;
+}
+
+/* A count, or null if it is not available: */
+std::string json_number(double value)
+{
+    if(value < 0.) return "null";
+    std::ostringstream s;
+    s.precision(6);
+    s << value;
+    return s.str();
+}
+
+double gflops(const result& r)
+{
+    return r.median > 0. ? r.c->flops/r.median : 0.;
+}
+
+/* Format a count in width characters, or - if it is not available: */
+std::string counter_field(double value, int width)
+{
+    char field[64];
+    if(value < 0.) {
+        std::sprintf(field, " %*s", width, "-");
+    } else {
+        std::sprintf(field, " %*.4g", width, value);
+    }
+    return field;
+}
+
+void write_text(std::ostream& out, const std::vector<result>& results,
+        const options& opts)
+{
+    bool ratio = false;
+    for(size_t i = 0; i < results.size(); ++i) {
+        ratio = ratio || results[i].baseline > 0.;
+    }
+    if(!optimized()) {
+        out << "warning: built without optimization" << std::endl;
+    }
+
+    char line[256];
+    std::sprintf(line, "%-52s %10s %10s %10s %10s %8s",
+            "name", "iters", "median ns", "p10 ns", "p90 ns", "GFLOP/s");
+    out << line;
+    for(size_t j = 0; j < opts.events.size(); ++j) {
+        std::sprintf(line, " %14s", opts.events[j].name.c_str());
+        out << line;
+    }
+    if(!opts.events.empty()) out << "    IPC flops/cyc";
+    out << (ratio ? "    ratio" : "") << std::endl;
+
+    for(size_t i = 0; i < results.size(); ++i) {
+        const result& r = results[i];
+        std::sprintf(line, "%-52s %10lu %10.4g %10.4g %10.4g %8.3g",
+                r.c->name().c_str(), (unsigned long) r.iterations,
+                r.median, r.p10, r.p90, gflops(r));
+        out << line;
+        for(size_t j = 0; j < r.counts.size(); ++j) {
+            out << counter_field(r.counts[j], 14);
+        }
+        if(!opts.events.empty()) {
+            out << counter_field(r.ipc(), 6)
+                << counter_field(r.flops_per_cycle(), 9);
+        }
+        if(r.baseline > 0.) {
+            std::sprintf(line, " %8.3f", r.median/r.baseline);
+            out << line;
+        }
+        out << std::endl;
+    }
+}
+
+const char* csv_header =
+    "name,family,op,storage,size,type,layout,iterations,reps,"
+    "min_ns,p10_ns,median_ns,p90_ns,max_ns,mean_ns,stddev_ns,flops";
+
+void write_csv(std::ostream& out, const std::vector<result>& results,
+        const options& opts)
+{
+    out << csv_header << ",baseline_ns";
+    for(size_t j = 0; j < opts.events.size(); ++j) {
+        out << ',' << opts.events[j].name;
+    }
+    if(!opts.events.empty()) out << ",ipc,flops_per_cycle";
+    out << std::endl;
+    out.precision(6);
+    for(size_t i = 0; i < results.size(); ++i) {
+        const result& r = results[i];
+        const case_base& c = *r.c;
+        out << c.name() << ',' << c.family << ',' << c.op << ','
+            << c.storage << ',' << c.size << ',' << c.type << ','
+            << c.layout << ',' << r.iterations << ',' << r.reps << ','
+            << r.min << ',' << r.p10 << ',' << r.median << ',' << r.p90
+            << ',' << r.max << ',' << r.mean << ',' << r.stddev << ','
+            << c.flops << ',' << r.baseline;
+        for(size_t j = 0; j < r.counts.size(); ++j) {
+            out << ',';
+            if(r.counts[j] >= 0.) out << r.counts[j];
+        }
+        if(!opts.events.empty()) {
+            out << ',';
+            if(r.ipc() >= 0.) out << r.ipc();
+            out << ',';
+            if(r.flops_per_cycle() >= 0.) out << r.flops_per_cycle();
+        }
+        out << std::endl;
+    }
+}
+
+void write_json(std::ostream& out, const std::vector<result>& results,
+        const options& opts)
+{
+    out.precision(6);
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << timestamp() << "\",\n"
+        << "    \"compiler\": \"" << escape(compiler()) << "\",\n"
+        << "    \"optimized\": " << (optimized() ? "true" : "false")
+        << ",\n"
+        << "    \"reps\": " << opts.reps << ",\n"
+        << "    \"warmup\": " << opts.warmup << ",\n"
+        << "    \"min_time\": " << opts.min_time << ",\n"
+        << "    \"configuration\": {";
+    std::vector< std::pair<std::string,long> > cfg = configuration();
+    for(size_t i = 0; i < cfg.size(); ++i) {
+        out << (i ? ", " : "") << "\"" << cfg[i].first << "\": "
+            << cfg[i].second;
+    }
+    out << "}\n  },\n  \"benchmarks\": [";
+    for(size_t i = 0; i < results.size(); ++i) {
+        const result& r = results[i];
+        const case_base& c = *r.c;
+        out << (i ? "," : "") << "\n    {"
+            << "\"name\": \"" << escape(c.name()) << "\", "
+            << "\"family\": \"" << c.family << "\", "
+            << "\"op\": \"" << c.op << "\", "
+            << "\"storage\": \"" << c.storage << "\", "
+            << "\"size\": \"" << c.size << "\", "
+            << "\"type\": \"" << c.type << "\", "
+            << "\"layout\": \"" << c.layout << "\",\n     "
+            << "\"iterations\": " << r.iterations << ", "
+            << "\"reps\": " << r.reps << ", "
+            << "\"min_ns\": " << r.min << ", "
+            << "\"p10_ns\": " << r.p10 << ", "
+            << "\"median_ns\": " << r.median << ", "
+            << "\"p90_ns\": " << r.p90 << ", "
+            << "\"max_ns\": " << r.max << ",\n     "
+            << "\"mean_ns\": " << r.mean << ", "
+            << "\"stddev_ns\": " << r.stddev << ", "
+            << "\"flops\": " << c.flops << ", "
+            << "\"gflops\": " << gflops(r);
+        if(r.baseline > 0.) {
+            out << ", \"baseline_ns\": " << r.baseline
+                << ", \"ratio\": " << r.median/r.baseline;
+        }
+        if(!opts.events.empty()) {
+            out << ",\n     \"counters\": {";
+            for(size_t j = 0; j < r.counts.size(); ++j) {
+                out << (j ? ", " : "") << "\"" << opts.events[j].name
+                    << "\": " << json_number(r.counts[j]);
+            }
+            out << "}, \"ipc\": " << json_number(r.ipc())
+                << ", \"flops_per_cycle\": "
+                << json_number(r.flops_per_cycle());
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}" << std::endl;
+}
+
+/* Split a line of a CSV file without quoted fields: */
+std::vector<std::string> split(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::string::size_type begin = 0, end;
+    while((end = line.find(',', begin)) != std::string::npos) {
+        fields.push_back(line.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    fields.push_back(line.substr(begin));
+    return fields;
+}
+
+} // namespace
+
+namespace {
+
+typedef std::multimap<int, void (*)()> suite_map;
+
+suite_map& suites()
+{
+    static suite_map all;
+    return all;
+}
+
+} // namespace
+
+suite::suite(int order, void (*add)())
+{
+    suites().insert(std::make_pair(order, add));
+}
+
+void add_suites()
+{
+    for(suite_map::const_iterator i = suites().begin();
+            i != suites().end(); ++i)
+    {
+        (*i->second)();
+    }
+}
+
+void add_case(case_base* c)
+{
+    registry().push_back(c);
+}
+
+const std::vector<case_base*>& cases()
+{
+    return registry();
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if(sorted.empty()) return 0.;
+    double pos = p*double(sorted.size() - 1);
+    size_t i = size_t(pos);
+    if(i + 1 >= sorted.size()) return sorted.back();
+    return sorted[i] + (pos - double(i))*(sorted[i+1] - sorted[i]);
+}
+
+result measure(case_base& c, const options& opts)
+{
+    /* Find the iterations per repetition, growing by at most 10x to avoid
+     * overshooting after a slow first call:
+     */
+    const double min_ns = opts.min_time*1e9;
+    size_t n = 1;
+    for(;;) {
+        double t = time_run(c, n);
+        if(t >= min_ns) break;
+        double grow = t > 0. ? 1.4*min_ns/t : 10.;
+        n = size_t(double(n)*std::max(2., std::min(10., grow)));
+    }
+
+    for(size_t i = 0; i < opts.warmup; ++i) time_run(c, n);
+
+    result r;
+    std::vector<double> samples(std::max(opts.reps, size_t(1)));
+    perf_counters counters(opts.events);
+    counters.start();
+    for(size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = time_run(c, n)/double(n);
+    }
+    counters.stop();
+    std::sort(samples.begin(), samples.end());
+
+    r.events = &opts.events;
+    for(size_t i = 0; i < counters.size(); ++i) {
+        double v = counters.value(i);
+        r.counts.push_back(v < 0. ? v : v/double(n*samples.size()));
+    }
+    r.c = &c;
+    r.iterations = n;
+    r.reps = samples.size();
+    r.min = samples.front();
+    r.max = samples.back();
+    r.p10 = percentile(samples, .1);
+    r.median = percentile(samples, .5);
+    r.p90 = percentile(samples, .9);
+    double sum = 0., sum2 = 0.;
+    for(size_t i = 0; i < samples.size(); ++i) sum += samples[i];
+    r.mean = sum/double(samples.size());
+    for(size_t i = 0; i < samples.size(); ++i) {
+        sum2 += (samples[i] - r.mean)*(samples[i] - r.mean);
+    }
+    r.stddev = samples.size() > 1
+        ? std::sqrt(sum2/double(samples.size() - 1)) : 0.;
+    r.baseline = 0.;
+    return r;
+}
+
+void report(const std::vector<result>& results, const options& opts)
+{
+    std::ofstream file;
+    if(!opts.output.empty()) {
+        file.open(opts.output.c_str());
+        if(!file) throw std::runtime_error("cannot write " + opts.output);
+    }
+    std::ostream& out = opts.output.empty() ? std::cout : file;
+
+    if(opts.format == "csv") {
+        write_csv(out, results, opts);
+    } else if(opts.format == "json") {
+        write_json(out, results, opts);
+    } else {
+        write_text(out, results, opts);
+    }
+}
+
+std::map<std::string,double> read_medians(const std::string& file)
+{
+    std::ifstream in(file.c_str());
+    if(!in) throw std::runtime_error("cannot read " + file);
+
+    std::string line;
+    std::getline(in, line);
+    std::vector<std::string> header = split(line);
+    size_t name = header.size(), median = header.size();
+    for(size_t i = 0; i < header.size(); ++i) {
+        if(header[i] == "name") name = i;
+        if(header[i] == "median_ns") median = i;
+    }
+    if(name == header.size() || median == header.size()) {
+        throw std::runtime_error(file + " is not a benchmark CSV file");
+    }
+
+    std::map<std::string,double> medians;
+    while(std::getline(in, line)) {
+        std::vector<std::string> fields = split(line);
+        if(fields.size() != header.size()) continue;
+        medians[fields[name]] = std::atof(fields[median].c_str());
+    }
+    return medians;
+}
+
+void read_baseline(std::vector<result>& results, const std::string& file)
+{
+    std::map<std::string,double> medians = read_medians(file);
+    for(size_t i = 0; i < results.size(); ++i) {
+        std::map<std::string,double>::const_iterator it
+            = medians.find(results[i].c->name());
+        if(it != medians.end()) results[i].baseline = it->second;
+    }
+}
+
+} // namespace bench
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,191 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief A small micro-benchmark harness for the CML benchmark suite.
+ *
+ * Each benchmark is a case_base whose run(n) performs n iterations of the
+ * measured operation.  The runner first finds an iteration count that
+ * makes one repetition last at least options::min_time, runs a few
+ * warm-up repetitions, and then times options::reps repetitions with a
+ * monotonic clock.  The per-iteration times of the repetitions are
+ * reported as a median and percentiles, as text, CSV or JSON.
+ *
+ * When options::events is not empty, the timed repetitions also count
+ * those hardware events (see perf_counters.h), reported per iteration,
+ * together with the instructions per cycle and the flops per cycle.
+ */
+
+#ifndef bench_h
+#define bench_h
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../timing/perf_counters.h"
+
+namespace bench {
+
+/** Return the time of a monotonic clock, in nanoseconds. */
+double now_ns();
+
+/** Force value to be computed, without letting the compiler see how it is
+ * used.
+ */
+template<class T> inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    extern void use_pointer(const volatile void*);
+    use_pointer(&value);
+#endif
+}
+
+/** Force pending writes to memory, and any value to be reloaded from it. */
+inline void clobber_memory()
+{
+#if defined(__GNUC__)
+    asm volatile("" : : : "memory");
+#else
+    extern void use_pointer(const volatile void*);
+    use_pointer(0);
+#endif
+}
+
+/** A benchmarked operation. */
+class case_base
+{
+  public:
+
+    /** Describe the case.
+     *
+     * flops is the number of floating-point operations per iteration, or 0
+     * if the operation is not arithmetic.
+     */
+    case_base(const std::string& family, const std::string& op,
+            const std::string& storage, const std::string& size,
+            const std::string& type, const std::string& layout,
+            double flops)
+        : family(family), op(op), storage(storage), size(size), type(type)
+        , layout(layout), flops(flops) {}
+
+    virtual ~case_base() {}
+
+    /** Run n iterations of the operation. */
+    virtual void run(size_t n) = 0;
+
+    /** Return family/op/storage/size/type[/layout]. */
+    std::string name() const;
+
+
+  public:
+
+    std::string family, op, storage, size, type, layout;
+    double flops;
+};
+
+/** Add a case to the suite, which takes ownership of it. */
+void add_case(case_base* c);
+
+/** Return the cases of the suite, in the order they were added. */
+const std::vector<case_base*>& cases();
+
+/** The settings of a benchmark run. */
+struct options
+{
+    options()
+        : reps(15), warmup(2), min_time(.01), format("text") {}
+
+    /** The number of timed repetitions of each case. */
+    size_t reps;
+
+    /** The number of untimed repetitions before the timed ones. */
+    size_t warmup;
+
+    /** The shortest time of a repetition, in seconds. */
+    double min_time;
+
+    /** Only run the cases whose name contains one of these (all if none). */
+    std::vector<std::string> filters;
+
+    /** text, csv or json. */
+    std::string format;
+
+    /** The file to write the results to (stdout if empty). */
+    std::string output;
+
+    /** A CSV file of earlier results to compare with. */
+    std::string baseline;
+
+    /** The hardware events to count. */
+    std::vector<perf_event_spec> events;
+};
+
+/** The measurements of one case, in nanoseconds per iteration. */
+struct result
+{
+    const case_base* c;
+    size_t iterations, reps;
+    double min, p10, median, p90, max, mean, stddev;
+
+    /** The median of the baseline, or 0 if there is none. */
+    double baseline;
+
+    /** The events counted (options::events). */
+    const std::vector<perf_event_spec>* events;
+
+    /** The count of each event per iteration, or -1 for the events that
+     * could not be counted.
+     */
+    std::vector<double> counts;
+
+    /** Return the count of the named event per iteration, or -1. */
+    double count(const std::string& name) const;
+
+    /** Return the instructions per cycle, or -1. */
+    double ipc() const;
+
+    /** Return the flops per cycle, or -1. */
+    double flops_per_cycle() const;
+};
+
+/** Time c as requested by opts. */
+result measure(case_base& c, const options& opts);
+
+/** Return the value below which a fraction p of the sorted samples lie,
+ * interpolating between neighbours.
+ */
+double percentile(const std::vector<double>& sorted, double p);
+
+/** Write results as requested by opts. */
+void report(const std::vector<result>& results, const options& opts);
+
+/** Return the medians of a CSV file written by report(), by case name. */
+std::map<std::string,double> read_medians(const std::string& file);
+
+/** Read the medians of a CSV file written by report() into results. */
+void read_baseline(std::vector<result>& results, const std::string& file);
+
+/** Register the function adding the cases of one part of the suite.
+ *
+ * Each part defines a static suite, so that a program made of only some
+ * of the parts (like the variants built by the tune target) runs only
+ * those.  The parts are added in increasing order.
+ */
+struct suite
+{
+    suite(int order, void (*add)());
+};
+
+/** Add the cases of all registered parts of the suite. */
+void add_suites();
+
+} // namespace bench
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,112 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Run the CML benchmark suite.
+ *
+ * Usage: cml_bench [--format=text|csv|json] [--output=FILE]
+ *     [--filter=SUBSTRING]... [--reps=N] [--warmup=N] [--min-time=SEC]
+ *     [--baseline=FILE.csv] [--counters[=EVENT,...]] [--quick] [--list]
+ *
+ * --counters counts hardware events during the timed repetitions (by
+ * default cycles, instructions, cache misses and branch misses; see
+ * tests/timing/perf_counters.h for the event names).
+ */
+
+#include "bench.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/* True if arg is --key=value, with value set to what follows =: */
+bool option(const std::string& arg, const std::string& key,
+        std::string& value)
+{
+    std::string prefix = "--" + key + "=";
+    if(arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+bool selected(const bench::case_base& c, const bench::options& opts)
+{
+    if(opts.filters.empty()) return true;
+    std::string name = c.name();
+    for(size_t i = 0; i < opts.filters.size(); ++i) {
+        if(name.find(opts.filters[i]) != std::string::npos) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        bench::options opts;
+        bool list = false;
+        for(int i = 1; i < argc; ++i) {
+            std::string arg = argv[i], value;
+            if(option(arg, "format", value)) {
+                if(value != "text" && value != "csv" && value != "json") {
+                    throw std::runtime_error("unknown format " + value);
+                }
+                opts.format = value;
+            } else if(option(arg, "output", value)) {
+                opts.output = value;
+            } else if(option(arg, "filter", value)) {
+                opts.filters.push_back(value);
+            } else if(option(arg, "reps", value)) {
+                opts.reps = std::atoi(value.c_str());
+            } else if(option(arg, "warmup", value)) {
+                opts.warmup = std::atoi(value.c_str());
+            } else if(option(arg, "min-time", value)) {
+                opts.min_time = std::atof(value.c_str());
+            } else if(option(arg, "baseline", value)) {
+                opts.baseline = value;
+            } else if(option(arg, "counters", value)) {
+                opts.events = parse_perf_events(value);
+            } else if(arg == "--counters") {
+                opts.events = parse_perf_events(PERF_COUNTERS_DEFAULT);
+            } else if(arg == "--quick") {
+                opts.reps = 3;
+                opts.warmup = 0;
+                opts.min_time = 1e-4;
+            } else if(arg == "--list") {
+                list = true;
+            } else {
+                throw std::runtime_error("unknown option " + arg);
+            }
+        }
+
+        bench::add_suites();
+
+        const std::vector<bench::case_base*>& cases = bench::cases();
+        std::vector<bench::result> results;
+        for(size_t i = 0; i < cases.size(); ++i) {
+            if(!selected(*cases[i], opts)) continue;
+            if(list) {
+                std::cout << cases[i]->name() << std::endl;
+            } else {
+                results.push_back(bench::measure(*cases[i], opts));
+            }
+        }
+        if(list) return 0;
+
+        if(!opts.baseline.empty()) {
+            bench::read_baseline(results, opts.baseline);
+        }
+        bench::report(results, opts);
+    } catch(std::exception& e) {
+        std::cerr << "cml_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,140 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Benchmarks of the mathlib transform functions.
+ */
+
+#include "bench.h"
+#include "bench_operands.h"
+
+namespace bench {
+
+namespace {
+
+/* The operands shared by the mathlib cases: */
+template<class MatT> class mathlib_case : public case_base
+{
+  public:
+
+    typedef typename MatT::value_type value_type;
+    typedef typename MatT::layout layout;
+    typedef cml::vector< value_type, cml::fixed<3> > vector_type;
+    typedef cml::quaternion< value_type, cml::fixed<>, cml::scalar_first,
+            cml::positive_cross > quaternion_type;
+
+    mathlib_case(const std::string& op, double flops)
+        : case_base("mathlib", op, "fixed", "4x4",
+                type_name<value_type>::name(), layout_name<layout>::name(),
+                flops)
+        , m_eye(1,2,3), m_target(0,0,0), m_up(0,1,0), m_p(.5,-.5,2)
+        , m_q(.9,.1,.3,-.2)
+    {
+        cml::matrix_rotation_euler(m_R, value_type(.3), value_type(-.2),
+                value_type(.7), cml::euler_order_xyz);
+        cml::matrix_set_translation(m_R, m_p);
+        m_q.normalize();
+    }
+
+  protected:
+
+    MatT m_M, m_R;
+    vector_type m_eye, m_target, m_up, m_p, m_u;
+    quaternion_type m_q;
+};
+
+/* matrix_rotation_euler(M, ...): */
+template<class MatT> struct mathlib_rotation_euler : mathlib_case<MatT>
+{
+    mathlib_rotation_euler() : mathlib_case<MatT>("rotation_euler", 0.) {}
+    void run(size_t n_iter) {
+        typedef typename MatT::value_type value_type;
+        for(size_t i = 0; i < n_iter; ++i) {
+            cml::matrix_rotation_euler(this->m_M, value_type(.3),
+                    value_type(-.2), value_type(.7), cml::euler_order_xyz);
+            do_not_optimize(this->m_M);
+        }
+    }
+};
+
+/* matrix_rotation_quaternion(M, q): */
+template<class MatT> struct mathlib_rotation_quaternion : mathlib_case<MatT>
+{
+    mathlib_rotation_quaternion()
+        : mathlib_case<MatT>("rotation_quaternion", 0.) {}
+    void run(size_t n_iter) {
+        for(size_t i = 0; i < n_iter; ++i) {
+            cml::matrix_rotation_quaternion(this->m_M, this->m_q);
+            do_not_optimize(this->m_M);
+        }
+    }
+};
+
+/* matrix_look_at_RH(M, eye, target, up): */
+template<class MatT> struct mathlib_look_at : mathlib_case<MatT>
+{
+    mathlib_look_at() : mathlib_case<MatT>("look_at", 0.) {}
+    void run(size_t n_iter) {
+        for(size_t i = 0; i < n_iter; ++i) {
+            cml::matrix_look_at_RH(this->m_M, this->m_eye, this->m_target,
+                    this->m_up);
+            do_not_optimize(this->m_M);
+        }
+    }
+};
+
+/* u = transform_point(R, p): */
+template<class MatT> struct mathlib_transform_point : mathlib_case<MatT>
+{
+    mathlib_transform_point()
+        : mathlib_case<MatT>("transform_point", 18.) {}
+    void run(size_t n_iter) {
+        for(size_t i = 0; i < n_iter; ++i) {
+            this->m_u = cml::transform_point(this->m_R, this->m_p);
+            do_not_optimize(this->m_u);
+        }
+    }
+};
+
+/* M = inverse_rigid(R): */
+template<class MatT> struct mathlib_inverse_rigid : mathlib_case<MatT>
+{
+    mathlib_inverse_rigid() : mathlib_case<MatT>("inverse_rigid", 0.) {}
+    void run(size_t n_iter) {
+        for(size_t i = 0; i < n_iter; ++i) {
+            this->m_M = cml::inverse_rigid(this->m_R);
+            do_not_optimize(this->m_M);
+        }
+    }
+};
+
+template<class MatT> void add_cases()
+{
+    add_case(new mathlib_rotation_euler<MatT>);
+    add_case(new mathlib_rotation_quaternion<MatT>);
+    add_case(new mathlib_look_at<MatT>);
+    add_case(new mathlib_transform_point<MatT>);
+    add_case(new mathlib_inverse_rigid<MatT>);
+}
+
+template<typename E> void add_type_cases()
+{
+    using namespace cml;
+    add_cases< matrix< E, fixed<4,4>, col_basis, row_major > >();
+    add_cases< matrix< E, fixed<4,4>, col_basis, col_major > >();
+}
+
+void add_mathlib_cases()
+{
+    add_type_cases<float>();
+    add_type_cases<double>();
+}
+
+const suite mathlib_suite(5, add_mathlib_cases);
+
+} // namespace
+
+} // namespace bench
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,190 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Matrix benchmarks.
+ */
+
+#include "bench.h"
+#include "bench_operands.h"
+
+namespace bench {
+
+namespace {
+
+/* The operands shared by the matrix cases: */
+template<class MatT> class matrix_case : public case_base
+{
+  public:
+
+    typedef matrix_operand<MatT> operand_type;
+    typedef typename MatT::value_type value_type;
+    typedef typename MatT::layout layout;
+
+    matrix_case(const std::string& op, size_t n, double flops)
+        : case_base("matrix", op, operand_type::storage(), size_name(n,n),
+                type_name<value_type>::name(), layout_name<layout>::name(),
+                flops)
+        , m_C(n,n), m_A(n,n), m_B(n,n)
+    {
+        fill_matrix(m_C.x, 0.); fill_matrix(m_A.x, .5);
+        fill_matrix(m_B.x, 1.5);
+    }
+
+  protected:
+
+    operand_type m_C, m_A, m_B;
+};
+
+/* C = A + B: */
+template<class MatT> struct matrix_add : matrix_case<MatT>
+{
+    explicit matrix_add(size_t n) : matrix_case<MatT>("add", n, 1.*n*n) {}
+    void run(size_t n_iter) {
+        MatT& C = this->m_C.x;
+        const MatT& A = this->m_A.x, & B = this->m_B.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            C = A + B;
+            do_not_optimize(C);
+        }
+    }
+};
+
+/* C = C + A + B + A + B, one of the two forms compared by the XXX
+ * comments in tests/timing/matrix_algebra1.cpp:
+ */
+template<class MatT> struct matrix_sum5 : matrix_case<MatT>
+{
+    explicit matrix_sum5(size_t n)
+        : matrix_case<MatT>("sum5", n, 4.*n*n) {}
+    void run(size_t n_iter) {
+        MatT& C = this->m_C.x;
+        const MatT& A = this->m_A.x, & B = this->m_B.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            C = C + A + B + A + B;
+            do_not_optimize(C);
+        }
+    }
+};
+
+/* C += A + B + A + B, the other form: */
+template<class MatT> struct matrix_add_assign4 : matrix_case<MatT>
+{
+    explicit matrix_add_assign4(size_t n)
+        : matrix_case<MatT>("add_assign4", n, 4.*n*n) {}
+    void run(size_t n_iter) {
+        MatT& C = this->m_C.x;
+        const MatT& A = this->m_A.x, & B = this->m_B.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            C += A + B + A + B;
+            do_not_optimize(C);
+        }
+    }
+};
+
+/* C = A*B: */
+template<class MatT> struct matrix_mul : matrix_case<MatT>
+{
+    explicit matrix_mul(size_t n)
+        : matrix_case<MatT>("mul", n, 2.*n*n*n) {}
+    void run(size_t n_iter) {
+        MatT& C = this->m_C.x;
+        const MatT& A = this->m_A.x, & B = this->m_B.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            C = A*B;
+            do_not_optimize(C);
+        }
+    }
+};
+
+/* C = transpose(A): */
+template<class MatT> struct matrix_transpose : matrix_case<MatT>
+{
+    explicit matrix_transpose(size_t n)
+        : matrix_case<MatT>("transpose", n, 0.) {}
+    void run(size_t n_iter) {
+        MatT& C = this->m_C.x;
+        const MatT& A = this->m_A.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            C = cml::transpose(A);
+            do_not_optimize(C);
+        }
+    }
+};
+
+/* C = inverse(A): */
+template<class MatT> struct matrix_inverse : matrix_case<MatT>
+{
+    explicit matrix_inverse(size_t n)
+        : matrix_case<MatT>("inverse", n, 0.) {}
+    void run(size_t n_iter) {
+        MatT& C = this->m_C.x;
+        const MatT& A = this->m_A.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            C = cml::inverse(A);
+            do_not_optimize(C);
+        }
+    }
+};
+
+/* determinant(A): */
+template<class MatT> struct matrix_determinant : matrix_case<MatT>
+{
+    explicit matrix_determinant(size_t n)
+        : matrix_case<MatT>("determinant", n, 0.) {}
+    void run(size_t n_iter) {
+        const MatT& A = this->m_A.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            typename MatT::value_type d = cml::determinant(A);
+            do_not_optimize(d);
+        }
+    }
+};
+
+template<class MatT> void add_cases(size_t n)
+{
+    add_case(new matrix_add<MatT>(n));
+    add_case(new matrix_sum5<MatT>(n));
+    add_case(new matrix_add_assign4<MatT>(n));
+    add_case(new matrix_mul<MatT>(n));
+    add_case(new matrix_transpose<MatT>(n));
+    if(n == 4) {
+        add_case(new matrix_inverse<MatT>(n));
+        add_case(new matrix_determinant<MatT>(n));
+    }
+}
+
+template<typename E, class L> void add_type_cases()
+{
+    using namespace cml;
+    add_cases< matrix< E, fixed<4,4>, col_basis, L > >(4);
+    add_cases< matrix< E, external<4,4>, col_basis, L > >(4);
+    add_cases< matrix< E, dynamic<>, col_basis, L > >(4);
+    add_cases< matrix< E, dynamic<>, col_basis, L > >(64);
+
+    /* Products on both sides of CML_MATRIX_BLOCKED_MUL_THRESHOLD, and
+     * larger than the blocks of the blocked kernel:
+     */
+    typedef matrix< E, dynamic<>, col_basis, L > dynamic_type;
+    add_case(new matrix_mul<dynamic_type>(16));
+    add_case(new matrix_mul<dynamic_type>(32));
+    add_case(new matrix_mul<dynamic_type>(128));
+    add_case(new matrix_mul<dynamic_type>(256));
+}
+
+void add_matrix_cases()
+{
+    add_type_cases<float, cml::row_major>();
+    add_type_cases<float, cml::col_major>();
+    add_type_cases<double, cml::row_major>();
+    add_type_cases<double, cml::col_major>();
+}
+
+const suite matrix_suite(2, add_matrix_cases);
+
+} // namespace
+
+} // namespace bench
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,104 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Matrix-vector product benchmarks.
+ */
+
+#include "bench.h"
+#include "bench_operands.h"
+
+namespace bench {
+
+namespace {
+
+/* The operands shared by the matrix-vector cases: */
+template<class MatT, class VecT> class matvec_case : public case_base
+{
+  public:
+
+    typedef matrix_operand<MatT> matrix_type;
+    typedef vector_operand<VecT> vector_type;
+    typedef typename MatT::value_type value_type;
+    typedef typename MatT::layout layout;
+
+    matvec_case(const std::string& op, size_t n)
+        : case_base("matvec", op, matrix_type::storage(), size_name(n,n),
+                type_name<value_type>::name(), layout_name<layout>::name(),
+                2.*n*n)
+        , m_A(n,n), m_x(n), m_y(n)
+    {
+        fill_matrix(m_A.x, .5); fill(m_x.x, 1.5); fill(m_y.x, 0.);
+    }
+
+  protected:
+
+    matrix_type m_A;
+    vector_type m_x, m_y;
+};
+
+/* y = A*x: */
+template<class MatT, class VecT> struct matvec_Ax : matvec_case<MatT,VecT>
+{
+    explicit matvec_Ax(size_t n) : matvec_case<MatT,VecT>("Ax", n) {}
+    void run(size_t n_iter) {
+        VecT& y = this->m_y.x;
+        const MatT& A = this->m_A.x;
+        const VecT& x = this->m_x.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            y = A*x;
+            do_not_optimize(y);
+        }
+    }
+};
+
+/* y = x*A: */
+template<class MatT, class VecT> struct matvec_xA : matvec_case<MatT,VecT>
+{
+    explicit matvec_xA(size_t n) : matvec_case<MatT,VecT>("xA", n) {}
+    void run(size_t n_iter) {
+        VecT& y = this->m_y.x;
+        const MatT& A = this->m_A.x;
+        const VecT& x = this->m_x.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            y = x*A;
+            do_not_optimize(y);
+        }
+    }
+};
+
+template<class MatT, class VecT> void add_cases(size_t n)
+{
+    add_case(new matvec_Ax<MatT,VecT>(n));
+    add_case(new matvec_xA<MatT,VecT>(n));
+}
+
+template<typename E, class L> void add_type_cases()
+{
+    using namespace cml;
+    add_cases< matrix< E, fixed<4,4>, col_basis, L >,
+        vector< E, fixed<4> > >(4);
+    add_cases< matrix< E, external<4,4>, col_basis, L >,
+        vector< E, external<4> > >(4);
+    add_cases< matrix< E, dynamic<>, col_basis, L >,
+        vector< E, dynamic<> > >(4);
+    add_cases< matrix< E, dynamic<>, col_basis, L >,
+        vector< E, dynamic<> > >(256);
+}
+
+void add_matvec_cases()
+{
+    add_type_cases<float, cml::row_major>();
+    add_type_cases<float, cml::col_major>();
+    add_type_cases<double, cml::row_major>();
+    add_type_cases<double, cml::col_major>();
+}
+
+const suite matvec_suite(3, add_matvec_cases);
+
+} // namespace
+
+} // namespace bench
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
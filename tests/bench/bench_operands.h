@@ -0,0 +1,168 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Operands of the benchmark cases, for each kind of CML storage.
+ *
+ * vector_operand<> and matrix_operand<> hold a CML vector or matrix in x,
+ * together with the array an external<> one refers to, and name its
+ * storage for the benchmark reports.
+ */
+
+#ifndef bench_operands_h
+#define bench_operands_h
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include <cml/cml.h>
+
+namespace bench {
+
+/** Name element types in the reports. */
+template<typename E> struct type_name;
+template<> struct type_name<float> {
+    static std::string name() { return "float"; }
+};
+template<> struct type_name<double> {
+    static std::string name() { return "double"; }
+};
+
+/** Name array layouts in the reports. */
+template<class L> struct layout_name;
+template<> struct layout_name<cml::row_major> {
+    static std::string name() { return "row_major"; }
+};
+template<> struct layout_name<cml::col_major> {
+    static std::string name() { return "col_major"; }
+};
+
+/** Return "n", or "rxc" for a matrix. */
+inline std::string size_name(size_t rows, size_t cols = 0)
+{
+    std::ostringstream s;
+    s << rows;
+    if(cols) s << 'x' << cols;
+    return s.str();
+}
+
+/** A vector operand of n elements. */
+template<class VecT> class vector_operand;
+
+template<typename E, int N>
+class vector_operand< cml::vector< E, cml::fixed<N> > >
+{
+  public:
+    typedef cml::vector< E, cml::fixed<N> > vector_type;
+    static std::string storage() { return "fixed"; }
+    explicit vector_operand(size_t) {}
+    vector_type x;
+  private:
+    vector_operand(const vector_operand&);
+    vector_operand& operator=(const vector_operand&);
+};
+
+template<typename E, int N>
+class vector_operand< cml::vector< E, cml::external<N> > >
+{
+  public:
+    typedef cml::vector< E, cml::external<N> > vector_type;
+    static std::string storage() { return "external"; }
+    explicit vector_operand(size_t) : m_data(), x(m_data) {}
+  private:
+    E m_data[N];
+  public:
+    vector_type x;
+  private:
+    vector_operand(const vector_operand&);
+    vector_operand& operator=(const vector_operand&);
+};
+
+template<typename E, class A>
+class vector_operand< cml::vector< E, cml::dynamic<A> > >
+{
+  public:
+    typedef cml::vector< E, cml::dynamic<A> > vector_type;
+    static std::string storage() { return "dynamic"; }
+    explicit vector_operand(size_t n) : x(n) {}
+    vector_type x;
+  private:
+    vector_operand(const vector_operand&);
+    vector_operand& operator=(const vector_operand&);
+};
+
+/** A matrix operand of rows x cols elements. */
+template<class MatT> class matrix_operand;
+
+template<typename E, int R, int C, class B, class L>
+class matrix_operand< cml::matrix< E, cml::fixed<R,C>, B, L > >
+{
+  public:
+    typedef cml::matrix< E, cml::fixed<R,C>, B, L > matrix_type;
+    static std::string storage() { return "fixed"; }
+    matrix_operand(size_t, size_t) {}
+    matrix_type x;
+  private:
+    matrix_operand(const matrix_operand&);
+    matrix_operand& operator=(const matrix_operand&);
+};
+
+template<typename E, int R, int C, class B, class L>
+class matrix_operand< cml::matrix< E, cml::external<R,C>, B, L > >
+{
+  public:
+    typedef cml::matrix< E, cml::external<R,C>, B, L > matrix_type;
+    static std::string storage() { return "external"; }
+    matrix_operand(size_t, size_t) : m_data(), x(m_data) {}
+  private:
+    E m_data[R*C];
+  public:
+    matrix_type x;
+  private:
+    matrix_operand(const matrix_operand&);
+    matrix_operand& operator=(const matrix_operand&);
+};
+
+template<typename E, class A, class B, class L>
+class matrix_operand< cml::matrix< E, cml::dynamic<A>, B, L > >
+{
+  public:
+    typedef cml::matrix< E, cml::dynamic<A>, B, L > matrix_type;
+    static std::string storage() { return "dynamic"; }
+    matrix_operand(size_t rows, size_t cols) : x(rows, cols) {}
+    matrix_type x;
+  private:
+    matrix_operand(const matrix_operand&);
+    matrix_operand& operator=(const matrix_operand&);
+};
+
+/** Fill v with values in [-1,1] that depend on seed. */
+template<class VecT> void fill(VecT& v, double seed)
+{
+    typedef typename VecT::value_type value_type;
+    for(size_t i = 0; i < v.size(); ++i) {
+        v[i] = value_type(std::sin(seed + 0.71*i));
+    }
+}
+
+/** Fill m with values that depend on seed, and a heavy diagonal so that
+ * square ones are well conditioned.
+ */
+template<class MatT> void fill_matrix(MatT& m, double seed)
+{
+    typedef typename MatT::value_type value_type;
+    for(size_t i = 0; i < m.rows(); ++i) {
+        for(size_t j = 0; j < m.cols(); ++j) {
+            m(i,j) = value_type(std::sin(seed + 0.37*i + 1.13*j)
+                    + (i == j ? 4. : 0.));
+        }
+    }
+}
+
+} // namespace bench
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
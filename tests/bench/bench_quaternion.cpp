@@ -0,0 +1,127 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Quaternion benchmarks.
+ *
+ * The layout field of these cases names the quaternion's order type.
+ */
+
+#include "bench.h"
+#include "bench_operands.h"
+
+namespace bench {
+
+namespace {
+
+template<class OrderT> struct order_name;
+template<> struct order_name<cml::scalar_first> {
+    static std::string name() { return "scalar_first"; }
+};
+template<> struct order_name<cml::vector_first> {
+    static std::string name() { return "vector_first"; }
+};
+
+/* The operands shared by the quaternion cases: */
+template<class QuatT> class quaternion_case : public case_base
+{
+  public:
+
+    typedef typename QuatT::value_type value_type;
+    typedef typename QuatT::order_type order_type;
+    typedef cml::vector< value_type, cml::fixed<3> > vector_type;
+
+    quaternion_case(const std::string& op, double flops)
+        : case_base("quaternion", op, "fixed", "4",
+                type_name<value_type>::name(),
+                order_name<order_type>::name(), flops)
+        , m_q(1,0,0,0), m_q1(.5,.5,-.5,.5), m_q2(.9,.1,.3,-.2)
+        , m_v(1,2,3), m_u(0,0,0)
+    {
+        m_q2.normalize();
+    }
+
+  protected:
+
+    QuatT m_q, m_q1, m_q2;
+    vector_type m_v, m_u;
+};
+
+/* q = q1*q2: */
+template<class QuatT> struct quaternion_mul : quaternion_case<QuatT>
+{
+    quaternion_mul() : quaternion_case<QuatT>("mul", 28.) {}
+    void run(size_t n_iter) {
+        for(size_t i = 0; i < n_iter; ++i) {
+            this->m_q = this->m_q1*this->m_q2;
+            do_not_optimize(this->m_q);
+        }
+    }
+};
+
+/* q = normalize(q1): */
+template<class QuatT> struct quaternion_normalize : quaternion_case<QuatT>
+{
+    quaternion_normalize() : quaternion_case<QuatT>("normalize", 12.) {}
+    void run(size_t n_iter) {
+        for(size_t i = 0; i < n_iter; ++i) {
+            this->m_q = cml::normalize(this->m_q1);
+            do_not_optimize(this->m_q);
+        }
+    }
+};
+
+/* q = slerp(q1,q2,t): */
+template<class QuatT> struct quaternion_slerp : quaternion_case<QuatT>
+{
+    quaternion_slerp() : quaternion_case<QuatT>("slerp", 0.) {}
+    void run(size_t n_iter) {
+        typename QuatT::value_type t(.3);
+        for(size_t i = 0; i < n_iter; ++i) {
+            this->m_q = cml::slerp(this->m_q1, this->m_q2, t);
+            do_not_optimize(this->m_q);
+        }
+    }
+};
+
+/* u = quaternion_rotate_vector(q2,v): */
+template<class QuatT> struct quaternion_rotate : quaternion_case<QuatT>
+{
+    quaternion_rotate() : quaternion_case<QuatT>("rotate", 30.) {}
+    void run(size_t n_iter) {
+        for(size_t i = 0; i < n_iter; ++i) {
+            this->m_u = cml::quaternion_rotate_vector(this->m_q2, this->m_v);
+            do_not_optimize(this->m_u);
+        }
+    }
+};
+
+template<class QuatT> void add_cases()
+{
+    add_case(new quaternion_mul<QuatT>);
+    add_case(new quaternion_normalize<QuatT>);
+    add_case(new quaternion_slerp<QuatT>);
+    add_case(new quaternion_rotate<QuatT>);
+}
+
+template<typename E> void add_type_cases()
+{
+    using namespace cml;
+    add_cases< quaternion< E, fixed<>, scalar_first, positive_cross > >();
+    add_cases< quaternion< E, fixed<>, vector_first, positive_cross > >();
+}
+
+void add_quaternion_cases()
+{
+    add_type_cases<float>();
+    add_type_cases<double>();
+}
+
+const suite quaternion_suite(4, add_quaternion_cases);
+
+} // namespace
+
+} // namespace bench
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
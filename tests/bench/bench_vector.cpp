@@ -0,0 +1,141 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Vector benchmarks.
+ */
+
+#include "bench.h"
+#include "bench_operands.h"
+
+namespace bench {
+
+namespace {
+
+/* The operands shared by the vector cases: */
+template<class VecT> class vector_case : public case_base
+{
+  public:
+
+    typedef vector_operand<VecT> operand_type;
+    typedef typename VecT::value_type value_type;
+
+    vector_case(const std::string& op, size_t n, double flops)
+        : case_base("vector", op, operand_type::storage(), size_name(n),
+                type_name<value_type>::name(), "", flops)
+        , m_v(n), m_a(n), m_b(n), m_c(n)
+    {
+        fill(m_v.x, 0.); fill(m_a.x, .5); fill(m_b.x, 1.5); fill(m_c.x, 2.5);
+    }
+
+  protected:
+
+    operand_type m_v, m_a, m_b, m_c;
+};
+
+/* v = a + b + c: */
+template<class VecT> struct vector_add3 : vector_case<VecT>
+{
+    explicit vector_add3(size_t n) : vector_case<VecT>("add3", n, 2.*n) {}
+    void run(size_t n_iter) {
+        VecT& v = this->m_v.x;
+        const VecT& a = this->m_a.x, & b = this->m_b.x, & c = this->m_c.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            v = a + b + c;
+            do_not_optimize(v);
+        }
+    }
+};
+
+/* v = s*a + b: */
+template<class VecT> struct vector_axpy : vector_case<VecT>
+{
+    explicit vector_axpy(size_t n) : vector_case<VecT>("axpy", n, 2.*n) {}
+    void run(size_t n_iter) {
+        typename VecT::value_type s(.75);
+        VecT& v = this->m_v.x;
+        const VecT& a = this->m_a.x, & b = this->m_b.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            v = s*a + b;
+            do_not_optimize(v);
+        }
+    }
+};
+
+/* dot(a,b): */
+template<class VecT> struct vector_dot : vector_case<VecT>
+{
+    explicit vector_dot(size_t n) : vector_case<VecT>("dot", n, 2.*n) {}
+    void run(size_t n_iter) {
+        const VecT& a = this->m_a.x, & b = this->m_b.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            typename VecT::value_type d = cml::dot(a,b);
+            do_not_optimize(d);
+        }
+    }
+};
+
+/* v = normalize(a): */
+template<class VecT> struct vector_normalize : vector_case<VecT>
+{
+    explicit vector_normalize(size_t n)
+        : vector_case<VecT>("normalize", n, 3.*n) {}
+    void run(size_t n_iter) {
+        VecT& v = this->m_v.x;
+        const VecT& a = this->m_a.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            v = cml::normalize(a);
+            do_not_optimize(v);
+        }
+    }
+};
+
+/* v = cross(a,b): */
+template<class VecT> struct vector_cross : vector_case<VecT>
+{
+    vector_cross() : vector_case<VecT>("cross", 3, 9.) {}
+    void run(size_t n_iter) {
+        VecT& v = this->m_v.x;
+        const VecT& a = this->m_a.x, & b = this->m_b.x;
+        for(size_t i = 0; i < n_iter; ++i) {
+            v = cml::cross(a,b);
+            do_not_optimize(v);
+        }
+    }
+};
+
+template<class VecT> void add_cases(size_t n)
+{
+    add_case(new vector_add3<VecT>(n));
+    add_case(new vector_axpy<VecT>(n));
+    add_case(new vector_dot<VecT>(n));
+    add_case(new vector_normalize<VecT>(n));
+}
+
+template<typename E> void add_type_cases()
+{
+    using namespace cml;
+    add_cases< vector< E, fixed<4> > >(4);
+    add_cases< vector< E, external<4> > >(4);
+    add_cases< vector< E, fixed<16> > >(16);
+    add_cases< vector< E, external<16> > >(16);
+    add_cases< vector< E, dynamic<> > >(4);
+    add_cases< vector< E, dynamic<> > >(1024);
+    add_case(new vector_cross< vector< E, fixed<3> > >);
+    add_case(new vector_cross< vector< E, external<3> > >);
+}
+
+void add_vector_cases()
+{
+    add_type_cases<float>();
+    add_type_cases<double>();
+}
+
+const suite vector_suite(1, add_vector_cases);
+
+} // namespace
+
+} // namespace bench
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,266 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Choose the CML settings that run fastest on this host.
+ *
+ * Usage: cml_tune --output=FILE [--tolerance=FRACTION] [--reps=N]
+ *     [--min-time=SEC] (--knob=MACRO[,MACRO]... [--filter=SUBSTRING]...
+ *     --variant=DEFINITION[,DEFINITION]...@PROGRAM...)...
+ *
+ * Each --knob starts a setting to tune: the macros it names, the cases of
+ * the benchmark suite it affects (--filter), and its candidate values.
+ * Each --variant is a cml_bench built with the given definitions (like
+ * CML_VECTOR_UNROLL_LIMIT=16, or CML_2D_UNROLLER), and the first one of a
+ * knob is the library default.  The tune target in CMakeLists.txt builds
+ * the variants and runs this program.
+ *
+ * A variant is scored by the geometric mean, over the selected cases, of
+ * its median time relative to that of the default.  The best variant is
+ * kept only if it beats the default by more than the tolerance (2% by
+ * default), so that noise does not change the settings.  The knobs are
+ * tuned one at a time, with the other settings at their defaults.
+ *
+ * The chosen definitions are written to FILE, to be included by
+ * cml/defaults.h when CML_TUNED_CONFIG is defined.
+ */
+
+#include "bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* A candidate value of a knob: */
+struct variant
+{
+    std::vector<std::string> definitions;
+    std::string program;
+    double score;
+};
+
+/* A setting to tune: */
+struct knob
+{
+    std::vector<std::string> macros;
+    std::vector<std::string> filters;
+    std::vector<variant> variants;
+    size_t chosen;
+};
+
+/* True if arg is --key=value, with value set to what follows =: */
+bool option(const std::string& arg, const std::string& key,
+        std::string& value)
+{
+    std::string prefix = "--" + key + "=";
+    if(arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+std::vector<std::string> split_list(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::string::size_type begin = 0;
+    while(begin <= list.size()) {
+        std::string::size_type end = list.find(',', begin);
+        if(end == std::string::npos) end = list.size();
+        if(end > begin) items.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+std::string join(const std::vector<std::string>& items, const char* sep)
+{
+    std::string s;
+    for(size_t i = 0; i < items.size(); ++i) {
+        if(i > 0) s += sep;
+        s += items[i];
+    }
+    return s;
+}
+
+/* Return the medians of the cases of k run by v: */
+std::map<std::string,double> run_variant(const knob& k, const variant& v,
+        const std::string& settings, const std::string& csv)
+{
+    std::string command = "\"" + v.program + "\" --format=csv --output=\""
+        + csv + "\"" + settings;
+    for(size_t i = 0; i < k.filters.size(); ++i) {
+        command += " \"--filter=" + k.filters[i] + "\"";
+    }
+    std::cerr << "cml_tune: " << join(v.definitions, " ") << std::endl;
+    if(std::system(command.c_str()) != 0) {
+        throw std::runtime_error("failed to run " + v.program);
+    }
+    std::map<std::string,double> medians = bench::read_medians(csv);
+    std::remove(csv.c_str());
+    if(medians.empty()) {
+        throw std::runtime_error(v.program + " ran no cases");
+    }
+    return medians;
+}
+
+/* Score the variants of k, and choose one: */
+void tune(knob& k, const std::string& settings, const std::string& csv,
+        double tolerance)
+{
+    std::vector< std::map<std::string,double> > medians;
+    for(size_t i = 0; i < k.variants.size(); ++i) {
+        medians.push_back(run_variant(k, k.variants[i], settings, csv));
+    }
+
+    /* Compare the cases run by every variant with the default: */
+    const std::map<std::string,double>& base = medians[0];
+    k.chosen = 0;
+    for(size_t i = 0; i < k.variants.size(); ++i) {
+        double log_sum = 0.;
+        size_t n = 0;
+        std::map<std::string,double>::const_iterator c;
+        for(c = base.begin(); c != base.end(); ++c) {
+            std::map<std::string,double>::const_iterator t
+                = medians[i].find(c->first);
+            if(t == medians[i].end() || !(c->second > 0.)
+                    || !(t->second > 0.)) continue;
+            log_sum += std::log(t->second/c->second);
+            ++n;
+        }
+        k.variants[i].score = n ? std::exp(log_sum/n) : 1.;
+        if(k.variants[i].score < k.variants[k.chosen].score) k.chosen = i;
+    }
+    if(k.variants[k.chosen].score > 1. - tolerance) k.chosen = 0;
+}
+
+/* Write "#define NAME VALUE" for NAME=VALUE: */
+std::string define(const std::string& definition)
+{
+    std::string d = definition;
+    std::string::size_type eq = d.find('=');
+    if(eq != std::string::npos) d[eq] = ' ';
+    return "#define " + d;
+}
+
+void write_header(const std::vector<knob>& knobs, const std::string& file)
+{
+    std::ofstream out(file.c_str());
+    if(!out) throw std::runtime_error("cannot write " + file);
+
+    char date[32] = "";
+    std::time_t t = std::time(0);
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M", std::localtime(&t));
+
+    out << "/* -*- C++ -*- " << std::string(60, '-') << "\n"
+        << " * Written by cml_tune (make tune) on " << date << ".\n"
+        << " *" << std::string(71, '-') << "*/\n"
+        << "/** @file\n"
+        << " *  @brief The CML settings that ran fastest on this host.\n"
+        << " *\n"
+        << " * Included by cml/defaults.h when CML_TUNED_CONFIG is "
+        << "defined.  The\n"
+        << " * scores are times relative to the default (first) value.  "
+        << "Settings\n"
+        << " * defined before including CML take precedence.\n"
+        << " */\n\n"
+        << "#ifndef cml_tuned_config_h\n"
+        << "#define cml_tuned_config_h\n";
+
+    for(size_t i = 0; i < knobs.size(); ++i) {
+        const knob& k = knobs[i];
+        out << "\n/* " << join(k.macros, ", ") << ":\n";
+        for(size_t j = 0; j < k.variants.size(); ++j) {
+            char score[32];
+            std::sprintf(score, "%.3f", k.variants[j].score);
+            out << " *   " << score << "  "
+                << join(k.variants[j].definitions, " ")
+                << (j == k.chosen ? "  (chosen)" : "") << "\n";
+        }
+        out << " */\n#if ";
+        for(size_t j = 0; j < k.macros.size(); ++j) {
+            out << (j > 0 ? " && " : "") << "!defined(" << k.macros[j]
+                << ")";
+        }
+        out << "\n";
+        const variant& v = k.variants[k.chosen];
+        for(size_t j = 0; j < v.definitions.size(); ++j) {
+            out << define(v.definitions[j]) << "\n";
+        }
+        out << "#endif\n";
+    }
+
+    out << "\n#endif\n\n"
+        << "// " << std::string(73, '-') << "\n"
+        << "// vim:ft=cpp\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        std::vector<knob> knobs;
+        std::string output, settings;
+        double tolerance = .02;
+        for(int i = 1; i < argc; ++i) {
+            std::string arg = argv[i], value;
+            if(option(arg, "output", value)) {
+                output = value;
+            } else if(option(arg, "tolerance", value)) {
+                tolerance = std::atof(value.c_str());
+            } else if(option(arg, "reps", value)
+                    || option(arg, "min-time", value))
+            {
+                settings += " " + arg;
+            } else if(option(arg, "knob", value)) {
+                knobs.push_back(knob());
+                knobs.back().macros = split_list(value);
+                knobs.back().chosen = 0;
+            } else if(option(arg, "filter", value) && !knobs.empty()) {
+                knobs.back().filters.push_back(value);
+            } else if(option(arg, "variant", value) && !knobs.empty()) {
+                std::string::size_type at = value.find('@');
+                if(at == std::string::npos) {
+                    throw std::runtime_error("no program in " + arg);
+                }
+                variant v;
+                v.definitions = split_list(value.substr(0, at));
+                v.program = value.substr(at + 1);
+                v.score = 1.;
+                knobs.back().variants.push_back(v);
+            } else {
+                throw std::runtime_error("unknown option " + arg);
+            }
+        }
+        if(output.empty()) throw std::runtime_error("no --output");
+
+        std::string csv = output + ".csv";
+        for(size_t i = 0; i < knobs.size(); ++i) {
+            if(knobs[i].variants.empty()) {
+                throw std::runtime_error("no variants of "
+                        + join(knobs[i].macros, ","));
+            }
+            tune(knobs[i], settings, csv, tolerance);
+            const variant& v = knobs[i].variants[knobs[i].chosen];
+            std::cout << join(knobs[i].macros, ",") << ": "
+                << join(v.definitions, " ") << std::endl;
+        }
+        write_header(knobs, output);
+        std::cout << "Wrote " << output << std::endl;
+    } catch(std::exception& e) {
+        std::cerr << "cml_tune: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
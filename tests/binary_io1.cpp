@@ -0,0 +1,348 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check that binary records of vectors, matrices and quaternions read back
+ * what was written, converting element types, layouts, quaternion orders
+ * and byte orders, and that mapped_array<> views them in place.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cml/cml.h>
+#include <cml/io.h>
+
+using namespace cml;
+
+typedef vector< double, dynamic<> > vectord;
+typedef matrix< double, dynamic<>, col_basis, row_major > matrix_dr;
+typedef matrix< double, dynamic<>, col_basis, col_major > matrix_dc;
+typedef matrix< double, fixed<4,4>, col_basis, row_major > matrix44_r;
+typedef matrix< double, fixed<4,4>, col_basis, col_major > matrix44_c;
+typedef matrix< double, fixed<4,4>, row_basis, row_major > matrix44_rb;
+typedef quaternion< double, fixed<>, scalar_first, positive_cross > quat_sf;
+typedef quaternion< double, fixed<>, vector_first, positive_cross > quat_vf;
+typedef quaternion< double, fixed<>, vector_first, negative_cross > quat_vn;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+template<class MatT> void
+fill(MatT& m, double seed)
+{
+    for(size_t i = 0; i < m.rows(); ++ i)
+        for(size_t j = 0; j < m.cols(); ++ j)
+            m(i,j) = std::sin(seed + 0.37*i + 1.13*j);
+}
+
+template<class VecT> void
+fill_vector(VecT& v, double seed)
+{
+    for(size_t i = 0; i < v.size(); ++ i) v[i] = std::sin(seed + 0.71*i);
+}
+
+template<class MatT1, class MatT2> bool
+same_matrix(const MatT1& m1, const MatT2& m2)
+{
+    if(m1.rows() != m2.rows() || m1.cols() != m2.cols()) return false;
+    for(size_t i = 0; i < m1.rows(); ++ i)
+        for(size_t j = 0; j < m1.cols(); ++ j)
+            if(m1(i,j) != m2(i,j)) return false;
+    return true;
+}
+
+template<class VecT1, class VecT2> bool
+same_vector(const VecT1& v1, const VecT2& v2)
+{
+    if(v1.size() != v2.size()) return false;
+    for(size_t i = 0; i < v1.size(); ++ i)
+        if(v1[i] != v2[i]) return false;
+    return true;
+}
+
+/* Expect reading s into x to throw Error: */
+template<class Error, class T> void
+read_fails(const std::string& s, T& x, const std::string& msg)
+{
+    std::istringstream in(s);
+    try {
+        read_binary(in, x);
+    } catch(Error&) {
+        return;
+    }
+    throw std::runtime_error(msg + ": no exception");
+}
+
+/* Overwrite the header field at offset of the record s: */
+template<typename T> std::string
+set_field(std::string s, size_t offset, T value)
+{
+    s.replace(offset, sizeof(T), (const char*) &value, sizeof(T));
+    return s;
+}
+
+void check_vectors()
+{
+    vector3d v[100];
+    for(int i = 0; i < 100; ++ i) fill_vector(v[i], 0.1*i);
+    std::ostringstream out;
+    write_binary(out, v, 100);
+    require(out.str().size() == 32 + 100*3*sizeof(double),
+            "vector record size");
+
+    vector3d w[100];
+    std::istringstream in(out.str());
+    read_binary(in, w, 100);
+    for(int i = 0; i < 100; ++ i)
+        require(same_vector(v[i], w[i]), "fixed vector round trip");
+
+    /* Convert float elements, into dynamic vectors: */
+    std::vector<vector3f> vf(10);
+    for(int i = 0; i < 10; ++ i) fill_vector(vf[i], 0.3*i);
+    std::ostringstream outf;
+    write_binary(outf, vf);
+    std::vector<vectord> vd;
+    std::istringstream inf(outf.str());
+    read_binary(inf, vd);
+    require(vd.size() == 10, "converted vector count");
+    for(int i = 0; i < 10; ++ i)
+        require(same_vector(vf[i], vd[i]), "converted vectors");
+
+    /* Records follow one another: */
+    vectord d(7);
+    fill_vector(d, 2.);
+    std::ostringstream out2;
+    write_binary(out2, d);
+    write_binary(out2, v[3]);
+    std::istringstream in2(out2.str());
+    vectord d2;
+    vector3d v2;
+    read_binary(in2, d2);
+    read_binary(in2, v2);
+    require(same_vector(d, d2) && same_vector(v[3], v2),
+            "consecutive records");
+
+    /* Wrong sizes, counts and truncated records: */
+    vector4d v4;
+    read_fails<std::invalid_argument>(out.str(), v4, "vector size");
+    read_fails<std::invalid_argument>(out.str(), v2, "vector count");
+    read_fails<std::runtime_error>(out2.str().substr(0, 60), d2,
+            "truncated record");
+    read_fails<std::runtime_error>(std::string(40, 'x'), d2, "bad magic");
+
+    /* Corrupt sizes are rejected before the objects are allocated: */
+    std::vector<vectord> many;
+    read_fails<std::runtime_error>(set_field(out2.str(), 24,
+                uint64_t(1) << 40), many, "huge count");
+    read_fails<std::runtime_error>(set_field(out2.str(), 16,
+                uint32_t(0)), many, "empty objects");
+    matrix_dr huge;
+    std::ostringstream out4;
+    write_binary(out4, matrix_dr(2,2));
+    std::string rows = set_field(out4.str(), 16, uint32_t(0xffffffff));
+    read_fails<std::runtime_error>(set_field(rows, 20,
+                uint32_t(0xffffffff)), huge, "huge matrix");
+
+    std::vector<vectord> mixed(2);
+    mixed[0].resize(2); mixed[1].resize(3);
+    std::ostringstream out3;
+    bool thrown = false;
+    try {
+        write_binary(out3, mixed);
+    } catch(std::invalid_argument&) {
+        thrown = true;
+    }
+    require(thrown, "vectors of different sizes");
+}
+
+void check_matrices()
+{
+    matrix44_r m[5];
+    for(int i = 0; i < 5; ++ i) fill(m[i], 0.7*i);
+    std::ostringstream out;
+    write_binary(out, m, 5);
+
+    /* Change the layout: */
+    matrix44_c c[5];
+    std::istringstream in(out.str());
+    read_binary(in, c, 5);
+    for(int i = 0; i < 5; ++ i)
+        require(same_matrix(m[i], c[i]), "matrix layout conversion");
+
+    /* The basis is part of the type: */
+    matrix44_rb rb;
+    std::ostringstream out1;
+    write_binary(out1, m[0]);
+    read_fails<std::invalid_argument>(out1.str(), rb, "matrix basis");
+
+    /* Run-time sized matrices, resized when read: */
+    std::vector<matrix_dc> d(4, matrix_dc(3,5));
+    for(int i = 0; i < 4; ++ i) fill(d[i], 1.1*i);
+    std::ostringstream outd;
+    write_binary(outd, d);
+    std::vector<matrix_dr> r;
+    std::istringstream ind(outd.str());
+    read_binary(ind, r);
+    require(r.size() == 4, "dynamic matrix count");
+    for(int i = 0; i < 4; ++ i)
+        require(same_matrix(d[i], r[i]), "dynamic matrix round trip");
+}
+
+void check_quaternions()
+{
+    quat_sf q[3];
+    for(int i = 0; i < 3; ++ i)
+        q[i] = quat_sf(0.5 + i, -1.25*i, 2.5, 0.125*i);
+    std::ostringstream out;
+    write_binary(out, q, 3);
+
+    quat_vf p[3];
+    std::istringstream in(out.str());
+    read_binary(in, p, 3);
+    for(int i = 0; i < 3; ++ i) {
+        require(p[i].real() == q[i].real()
+                && same_vector(p[i].imaginary(), q[i].imaginary()),
+                "quaternion order conversion");
+    }
+
+    quat_vn n;
+    std::ostringstream out1;
+    write_binary(out1, q[1]);
+    read_fails<std::invalid_argument>(out1.str(), n, "quaternion cross");
+}
+
+/* Reverse the byte order of a record of count objects of n doubles: */
+std::string swap_record(std::string s, size_t count, size_t n)
+{
+    const size_t fields[][2] = {
+        { 4, 2 }, { 16, 4 }, { 20, 4 }, { 24, 8 }
+    };
+    for(size_t f = 0; f < 4; ++ f) {
+        std::string::iterator b = s.begin() + fields[f][0];
+        std::reverse(b, b + fields[f][1]);
+    }
+    for(size_t i = 0; i < count*n; ++ i) {
+        std::string::iterator b = s.begin() + 32 + 8*i;
+        std::reverse(b, b + 8);
+    }
+    return s;
+}
+
+void check_byte_order()
+{
+    vector4d v[2];
+    fill_vector(v[0], 1.); fill_vector(v[1], 2.);
+    std::ostringstream out;
+    write_binary(out, v, 2);
+
+    std::string swapped = swap_record(out.str(), 2, 4);
+    std::istringstream in(swapped);
+    binary_header h = read_binary_header(in);
+    require(h.swapped && h.count == 2 && h.rows == 4,
+            "swapped header");
+
+    vector4d w[2];
+    std::istringstream in2(swapped);
+    read_binary(in2, w, 2);
+    require(same_vector(v[0], w[0]) && same_vector(v[1], w[1]),
+            "swapped elements");
+}
+
+void check_mapped()
+{
+    const char* path = "binary_io1.tmp";
+    std::vector<vector3d> v(50);
+    for(int i = 0; i < 50; ++ i) fill_vector(v[i], 0.2*i);
+    std::vector<matrix_dc> m(3, matrix_dc(2,3));
+    for(int i = 0; i < 3; ++ i) fill(m[i], 0.9*i);
+    {
+        std::ofstream out(path, std::ios::binary);
+        write_binary(out, v);
+        write_binary(out, m);
+    }
+
+    {
+        mapped_file file(path);
+        mapped_array< vector< double, external<3> > > mv(file);
+        require(mv.size() == 50, "mapped vector count");
+        for(int i = 0; i < 50; ++ i)
+            require(same_vector(v[i], mv[i]), "mapped vectors");
+
+        typedef matrix< double, external<>, col_basis, col_major > view_t;
+        mapped_array<view_t> mm(file, mv.end_offset());
+        require(mm.size() == 3 && mm.end_offset() == file.size(),
+                "mapped matrix count");
+        for(int i = 0; i < 3; ++ i)
+            require(same_matrix(m[i], mm[i]), "mapped matrices");
+
+        /* No conversions are made in place: */
+        bool thrown = false;
+        try {
+            mapped_array< vector< float, external<3> > > mf(file);
+        } catch(std::invalid_argument&) {
+            thrown = true;
+        }
+        require(thrown, "mapped element type mismatch");
+
+        /* Changes are private: */
+        vector< double, external<3> > x = mv[0];
+        x[0] = 1e6;
+        require(mv[0][0] == 1e6, "mapped view shares elements");
+    }
+
+    {
+        mapped_file file(path);
+        mapped_array< vector< double, external<> > > mv(file);
+        require(mv[0].size() == 3 && mv[0][0] == v[0][0],
+                "mapped file unchanged");
+    }
+
+    /* A count whose size in bytes wraps around to 0: */
+    {
+        std::ostringstream out;
+        write_binary(out, v);
+        std::ofstream file(path, std::ios::binary);
+        file << set_field(out.str(), 24, uint64_t(1) << 61);
+    }
+    {
+        mapped_file file(path);
+        bool thrown = false;
+        try {
+            mapped_array< vector< double, external<3> > > mv(file);
+        } catch(std::runtime_error&) {
+            thrown = true;
+        }
+        require(thrown, "mapped record size overflow");
+    }
+    std::remove(path);
+}
+
+int main()
+{
+    try {
+        check_vectors();
+        check_matrices();
+        check_quaternions();
+        check_byte_order();
+        check_mapped();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,171 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check dual quaternion transforms against the equivalent matrices, and the
+ * batched blending and skinning functions against dual_quaternion_blend()
+ * of each vertex.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+bool close(double a, double b)
+{
+    return std::fabs(a - b) < 1e-4*(1. + std::fabs(b));
+}
+
+template<class VecT1, class VecT2> void
+equal_or_fail(const VecT1& a, const VecT2& b, const std::string& msg)
+{
+    for(int i = 0; i < 3; ++ i) require(close(a[i], b[i]), msg);
+}
+
+template<class DualT> DualT
+make_transform(double s)
+{
+    typedef typename DualT::value_type value_type;
+    typedef typename DualT::quaternion_type quaternion_type;
+    typedef typename DualT::vector_type vector_type;
+
+    quaternion_type q;
+    vector_type axis(value_type(std::sin(s)), value_type(1),
+            value_type(std::cos(3.*s)));
+    quaternion_rotation_axis_angle(q, normalize(axis), value_type(2.*s - 1.));
+    return DualT(q, vector_type(value_type(s), value_type(-2.*s),
+                value_type(std::cos(s))));
+}
+
+/* Transform p by A and then by B: */
+template<class DualT> DualT
+compose(const DualT& A, const DualT& B, positive_cross)
+{
+    return B*A;
+}
+
+template<class DualT> DualT
+compose(const DualT& A, const DualT& B, negative_cross)
+{
+    return A*B;
+}
+
+template<class DualT> void
+check(const std::string& msg)
+{
+    typedef typename DualT::value_type value_type;
+    typedef typename DualT::vector_type vector_type;
+    typedef typename DualT::cross_type cross_type;
+    typedef matrix< value_type, fixed<4,4>, col_basis, col_major > matrix_type;
+
+    for(int i = 0; i < 10; ++ i) {
+        DualT A = make_transform<DualT>(.3*i), B = make_transform<DualT>(1.-.2*i);
+        vector_type p(value_type(i), value_type(.5), value_type(-1.5*i));
+
+        /* Rotation and translation: */
+        vector_type t(value_type(.3*i), value_type(-.6*i),
+                value_type(std::cos(.3*i)));
+        equal_or_fail(A.translation(), t, msg + ": translation");
+        matrix_type m, n;
+        matrix_dual_quaternion(m, A);
+        vector_type a = dual_quaternion_transform_point(A, p);
+        equal_or_fail(a, transform_point(m, p), msg + ": vs. matrix");
+        equal_or_fail(a, quaternion_rotate_vector(A.rotation(), p) + t,
+                msg + ": vs. rotation and translation");
+        equal_or_fail(dual_quaternion_transform_vector(A, p),
+                transform_vector(m, p), msg + ": transform vector");
+
+        DualT C;
+        dual_quaternion_matrix(C, m);
+        equal_or_fail(dual_quaternion_transform_point(C, p), a,
+                msg + ": from matrix");
+
+        /* Composition and inverse: */
+        C = compose(A, B, cross_type());
+        equal_or_fail(dual_quaternion_transform_point(C, p),
+                dual_quaternion_transform_point(B, a), msg + ": product");
+        matrix_dual_quaternion(n, B);
+        equal_or_fail(transform_point(n*m, p),
+                dual_quaternion_transform_point(C, p), msg + ": n*m");
+        C = conjugate(A) * A;
+        equal_or_fail(dual_quaternion_transform_point(C, p), p,
+                msg + ": conjugate");
+
+        C = A * value_type(3);
+        C.normalize();
+        equal_or_fail(dual_quaternion_transform_point(C, p), a,
+                msg + ": normalize");
+
+        /* Blending with a negated copy is the same transform: */
+        DualT D[2] = { A, A * value_type(-1) };
+        value_type w[2] = { value_type(.25), value_type(.75) };
+        C = dual_quaternion_blend(D, w, 2);
+        equal_or_fail(dual_quaternion_transform_point(C, p), a,
+                msg + ": blend antipodes");
+
+        vector_type in[7], out[7];
+        for(int k = 0; k < 7; ++ k) in[k] = p*value_type(k) - t;
+        dual_quaternion_transform_points(A, in, out, 7);
+        for(int k = 0; k < 7; ++ k)
+            equal_or_fail(out[k], dual_quaternion_transform_point(A, in[k]),
+                    msg + ": transform points");
+    }
+
+    /* Skinning with 3 influences per vertex: */
+    enum { n = 19, k = 3 };
+    DualT bones[5];
+    for(int b = 0; b < 5; ++ b) bones[b] = make_transform<DualT>(.7*b);
+    unsigned short indices[n*k];
+    value_type weights[n*k];
+    vector_type in[n], out[n];
+    DualT blends[n];
+    for(int i = 0; i < n; ++ i) {
+        for(int j = 0; j < k; ++ j) {
+            indices[i*k+j] = (unsigned short)((i + 2*j) % 5);
+            weights[i*k+j] = value_type(1 + (i+j) % 4)/value_type(6);
+        }
+        in[i] = vector_type(value_type(i), value_type(1), value_type(-i));
+    }
+    dual_quaternion_blend(bones, indices, weights, k, blends, n);
+    dual_quaternion_skin_points(bones, indices, weights, k, in, out, n);
+    for(int i = 0; i < n; ++ i) {
+        DualT D[k];
+        for(int j = 0; j < k; ++ j) D[j] = bones[indices[i*k+j]];
+        DualT C = dual_quaternion_blend(D, weights + i*k, k);
+        for(int c = 0; c < 8; ++ c)
+            require(close(blends[i].data()[c], C.data()[c]), msg + ": blend");
+        equal_or_fail(out[i], dual_quaternion_transform_point(C, in[i]),
+                msg + ": skin");
+    }
+}
+
+int main()
+{
+    try {
+        check< dual_quaternion<float> >("float, scalar_first, positive");
+        check< dual_quaternionf_n >("float, vector_first, negative");
+        check< dual_quaternionf_p >("float, vector_first, positive");
+        check< dual_quaterniond_n >("double, vector_first, negative");
+        check< dual_quaternion<double, scalar_first, negative_cross> >(
+                "double, scalar_first, negative");
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,171 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check that dynamic vectors and matrices reuse their storage when
+ * resized or assigned within capacity, and that swaps, moves and returned
+ * temporaries do not allocate.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <utility>
+#include <new>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+/* Count the allocations made through counting_allocator<>: */
+static size_t n_allocs = 0;
+
+template<typename T> struct counting_allocator : std::allocator<T>
+{
+    template<typename U> struct rebind {
+        typedef counting_allocator<U> other;
+    };
+
+    counting_allocator() {}
+    template<typename U> counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(size_t n, const void* = 0) {
+        ++ n_allocs;
+        return static_cast<T*>(::operator new(n*sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) { ::operator delete(p); }
+
+    void construct(T* p, const T& v) { new((void*)p) T(v); }
+    void destroy(T* p) { p->~T(); }
+};
+
+typedef vector< double, dynamic< counting_allocator<double> > > vectorc;
+typedef matrix< double, dynamic< counting_allocator<double> >,
+        col_basis, row_major > matrixc;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+void capacity_test()
+{
+    vectorc v(10);
+    for(size_t i = 0; i < 10; ++ i) v[i] = double(i);
+
+    size_t n = n_allocs;
+    v.resize(4);
+    require(v.size() == 4 && v.capacity() == 10, "vector: shrink");
+    require(v[3] == 3., "vector: shrink keeps the prefix");
+    v.resize(10);
+    require(v.size() == 10 && n_allocs == n, "vector: regrow");
+    v.resize(11);
+    require(v.capacity() == 11 && n_allocs == n+1, "vector: grow");
+
+    /* Copies into an array with room do not reallocate: */
+    vectorc w(3);
+    w[0] = 1.; w[1] = 2.; w[2] = 3.;
+    v.resize(2);
+    n = n_allocs;
+    v = w;
+    require(v.size() == 3 && v[2] == 3. && n_allocs == n, "vector: copy");
+
+    matrixc M(4,5);
+    n = n_allocs;
+    M.resize(2,3);
+    M.resize(5,4);
+    require(M.rows() == 5 && M.cols() == 4 && n_allocs == n,
+            "matrix: resize within capacity");
+    M.resize(0,7);
+    require(M.rows() == 0 && M.cols() == 0 && M.capacity() == 20,
+            "matrix: empty");
+}
+
+void swap_test()
+{
+    vectorc a(3), b(5);
+    a[0] = 1.; b[0] = 2.;
+    const double* pa = a.data();
+    size_t n = n_allocs;
+    swap(a, b);
+    require(a.size() == 5 && b.size() == 3 && b.data() == pa,
+            "vector: swap");
+    require(a[0] == 2. && b[0] == 1. && n_allocs == n, "vector: swap data");
+
+    matrixc A(2,2), B(3,3);
+    A.identity(); B.zero();
+    n = n_allocs;
+    swap(A, B);
+    require(A.rows() == 3 && B.rows() == 2 && B(1,1) == 1.,
+            "matrix: swap");
+    require(n_allocs == n, "matrix: swap allocates");
+}
+
+void temporary_test()
+{
+    matrixc A(6,6), B(6,6);
+    vectorc x(6);
+    for(int i = 0; i < 6; ++ i) {
+        x[i] = double(i);
+        for(int j = 0; j < 6; ++ j) {
+            A(i,j) = (i == j) ? 10. : std::sin(i + 1.3*j);
+            B(i,j) = std::cos(0.7*i + j);
+        }
+    }
+
+    /* Products return temporaries of the argument type: */
+    size_t n = n_allocs;
+    matrixc C(A*B);
+    vectorc y(A*x);
+    require(n_allocs == n+2, "construct from a returned temporary");
+
+    matrixc D = inverse(A)*A;
+    for(int i = 0; i < 6; ++ i)
+        for(int j = 0; j < 6; ++ j)
+            require(std::fabs(D(i,j) - ((i == j) ? 1. : 0.)) < 1e-10,
+                    "inverse");
+
+#if defined(CML_HAS_RVALUE_REFERENCES)
+    const double* pc = C.data();
+    n = n_allocs;
+    matrixc E(std::move(C));
+    require(E.data() == pc && C.data() == 0 && C.rows() == 0,
+            "matrix: move construct");
+    C = std::move(E);
+    require(C.data() == pc && E.data() == 0, "matrix: move assign");
+
+    const double* py = y.data();
+    vectorc z(std::move(y));
+    require(z.data() == py && y.size() == 0, "vector: move construct");
+    y = std::move(z);
+    require(y.data() == py && z.capacity() == 0, "vector: move assign");
+    require(n_allocs == n, "move allocates");
+
+    /* Growing a std::vector moves, rather than copies, its elements: */
+    std::vector<vectorc> vs(8, vectorc(4));
+    n = n_allocs;
+    vs.reserve(100);
+    require(n_allocs == n, "std::vector growth");
+#endif
+}
+
+int main()
+{
+    try {
+        capacity_test();
+        swap_test();
+        temporary_test();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
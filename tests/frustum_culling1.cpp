@@ -0,0 +1,143 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check cull_spheres() and cull_boxes() against the frustum<> member
+ * functions, with and without plane masks, for batches that do not divide
+ * evenly into packets.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+/* A deterministic sequence in [-1,1): */
+double next(unsigned& seed)
+{
+    seed = seed*1664525u + 1013904223u;
+    return double(seed >> 8)/double(1 << 23) - 1.;
+}
+
+/* True if the volume is within 1e-3 of a plane, where rounding may change
+ * its classification:
+ */
+template<class FrustumT, class VecT, typename Real> bool
+ambiguous(const FrustumT& f, const VecT& c, const VecT& e, Real r)
+{
+    for(int i = 0; i < 6; ++ i) {
+        const VecT& n = f.get_plane(i).normal();
+        Real d = f.get_plane(i).distance(c), s = r
+            + std::fabs(n[0])*e[0] + std::fabs(n[1])*e[1]
+            + std::fabs(n[2])*e[2];
+        if(std::fabs(d + s) < 1e-3 || std::fabs(d - s) < 1e-3) return true;
+    }
+    return false;
+}
+
+template<typename Real> void
+check(const std::string& msg)
+{
+    typedef frustum<Real> frustum_type;
+    typedef vector< Real, fixed<3> > vector_type;
+    typedef matrix< Real, fixed<4,4>, col_basis, col_major > matrix_type;
+    typedef soa_vector<Real,3> soa_type;
+
+    matrix_type view, projection;
+    matrix_look_at_RH(view, vector_type(1,2,3), vector_type(0,0,-10),
+            vector_type(0,1,0));
+    matrix_perspective_xfov_RH(projection, Real(1.2), Real(1.5), Real(.5),
+            Real(50), z_clip_neg_one);
+    frustum_type f(view, projection, z_clip_neg_one);
+
+    /* Known cases: */
+    require(f.classify_sphere(vector_type(0,0,-10), Real(1))
+            == frustum_inside, msg + ": inside sphere");
+    require(f.classify_sphere(vector_type(1,2,10), Real(1))
+            == frustum_outside, msg + ": sphere behind");
+    require(f.classify_sphere(vector_type(1,2,3), Real(1))
+            == frustum_intersect, msg + ": sphere at the eye");
+    require(f.classify_box(vector_type(-1,-1,-11), vector_type(1,1,-9))
+            == frustum_inside, msg + ": inside box");
+    require(f.classify_box(vector_type(-100,-1,-11), vector_type(1,1,-9))
+            == frustum_intersect, msg + ": box across");
+
+    enum { n = 203 };
+    unsigned seed = 1;
+    soa_type c, e, lo, hi;
+    vector< Real, dynamic<> > r(n);
+    c.resize(n); e.resize(n); lo.resize(n); hi.resize(n);
+    for(int k = 0; k < n; ++ k) {
+        vector_type p(Real(20*next(seed)), Real(20*next(seed)),
+                Real(-25 + 30*next(seed)));
+        vector_type h(Real(2 + 2*next(seed)), Real(2 + 2*next(seed)),
+                Real(2 + 2*next(seed)));
+        c.set(k, p); e.set(k, h);
+        lo.set(k, vector_type(p - h)); hi.set(k, vector_type(p + h));
+        r[k] = Real(3 + 2*next(seed));
+    }
+
+    unsigned char sr[n], br[n], masks[n], child[n];
+    size_t sn = cull_spheres(f, c, r, sr);
+    for(int k = 0; k < n; ++ k) masks[k] = 0;
+    size_t bn = cull_boxes(f, lo, hi, br, masks);
+
+    size_t sv = 0, bv = 0, inside = 0, outside = 0;
+    for(int k = 0; k < n; ++ k) {
+        vector_type p = c.get(k), h = e.get(k), z(0,0,0);
+        FrustumContainment s = f.classify_sphere(p, r[k]);
+        FrustumContainment b = f.classify_box(lo.get(k), hi.get(k));
+        sv += (s != frustum_outside); bv += (b != frustum_outside);
+        inside += (b == frustum_inside); outside += (b == frustum_outside);
+        if(!ambiguous(f, p, z, r[k]))
+            require(sr[k] == s, msg + ": cull_spheres");
+        if(!ambiguous(f, p, h, Real(0)))
+            require(br[k] == b, msg + ": cull_boxes");
+        if(b == frustum_inside)
+            require(masks[k] == frustum_type::all_planes, msg + ": mask");
+    }
+    require(sn == sv && bn == bv, msg + ": visible count");
+    require(inside > 0 && outside > 0 && inside + outside < n,
+            msg + ": classes");
+
+    /* Boxes inside their parents, tested with the parents' masks: */
+    for(int k = 0; k < n; ++ k) {
+        vector_type p = c.get(k), h = e.get(k)*Real(.5);
+        lo.set(k, vector_type(p - h)); hi.set(k, vector_type(p + h));
+    }
+    cull_boxes(f, lo, hi, child, masks);
+    for(int k = 0; k < n; ++ k) {
+        if(br[k] == frustum_outside) continue;
+        FrustumContainment b = f.classify_box(lo.get(k), hi.get(k));
+        if(!ambiguous(f, c.get(k), vector_type(e.get(k)*Real(.5)), Real(0)))
+            require(child[k] == b, msg + ": cull_boxes with masks");
+        if(br[k] == frustum_inside)
+            require(child[k] == frustum_inside, msg + ": inside parent");
+    }
+}
+
+int main()
+{
+    try {
+        check<float>("float");
+        check<double>("double");
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
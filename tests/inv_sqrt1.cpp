@@ -0,0 +1,134 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check the documented error bounds of inv_sqrt() for each precision tag,
+ * and that the normalization of vectors, quaternions, SoA vectors, dual
+ * quaternions and planes follows CML_DEFAULT_INV_SQRT_PRECISION.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+/* Build with the refined estimate: */
+#define CML_DEFAULT_INV_SQRT_PRECISION cml::inv_sqrt_newton
+#include <cml/cml.h>
+
+using namespace cml;
+
+#if defined(CML_SIMD_SSE2)
+const double newton_bound = 5e-7, estimate_bound = 3.7e-4;
+#else
+const double newton_bound = 5e-6, estimate_bound = 1.8e-3;
+#endif
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+/* The relative error of y as an estimate of 1/sqrt(x): */
+double error(double x, double y)
+{
+    return std::fabs(y*std::sqrt(x) - 1.);
+}
+
+template<typename Real> void
+check_bounds(const std::string& msg)
+{
+    enum { W = simd::native_width<Real>::value };
+    typedef simd::packet_traits<Real,W> pt;
+
+    double worst_n = 0., worst_e = 0.;
+    Real x[W], yn[W], ye[W];
+    for(int k = 0; k < 20000; ++ k) {
+        /* Values spanning several octaves, including powers of 2: */
+        double v = std::ldexp(1. + (k % 1000)/1000., k/1000 - 10);
+        Real r = Real(v);
+        require(inv_sqrt(r, inv_sqrt_exact()) == Real(1./std::sqrt(r)),
+                msg + ": exact");
+        worst_n = std::max(worst_n, error(r, inv_sqrt(r, inv_sqrt_newton())));
+        worst_e = std::max(worst_e,
+                error(r, inv_sqrt(r, inv_sqrt_estimate())));
+
+        x[k % W] = r;
+        if(k % W == W-1) {
+            pt::storeu(yn, simd::inv_sqrt<pt>(pt::loadu(x),
+                        inv_sqrt_newton()));
+            pt::storeu(ye, simd::inv_sqrt<pt>(pt::loadu(x),
+                        inv_sqrt_estimate()));
+            for(int l = 0; l < W; ++ l) {
+                worst_n = std::max(worst_n, error(x[l], yn[l]));
+                worst_e = std::max(worst_e, error(x[l], ye[l]));
+            }
+        }
+    }
+    require(worst_n < newton_bound, msg + ": newton bound");
+    require(worst_e < estimate_bound, msg + ": estimate bound");
+
+    /* The default follows CML_DEFAULT_INV_SQRT_PRECISION: */
+    Real r = Real(3);
+    require(inv_sqrt(r) == inv_sqrt(r, inv_sqrt_newton()), msg + ": default");
+}
+
+template<class T> bool
+unit(const T& v)
+{
+    return std::fabs(std::sqrt(double(v.length_squared())) - 1.)
+        < newton_bound;
+}
+
+template<typename Real> void
+check_normalize(const std::string& msg)
+{
+    typedef vector< Real, fixed<3> > vector_type;
+    typedef vector< Real, dynamic<> > dynamic_type;
+    typedef quaternion< Real, fixed<>, vector_first, positive_cross > q_type;
+    typedef dual_quaternion< Real, vector_first, positive_cross > dq_type;
+
+    vector_type v(Real(3), Real(-4), Real(12));
+    require(unit(v.normalize()), msg + ": vector");
+    require(unit(normalize(vector_type(Real(1), Real(2), Real(2)) * Real(7))),
+            msg + ": vector expression");
+    dynamic_type d(5);
+    for(int i = 0; i < 5; ++ i) d[i] = Real(i + 1);
+    require(unit(d.normalize()), msg + ": dynamic vector");
+
+    q_type q(Real(1), Real(-2), Real(3), Real(4));
+    require(unit(q.normalize()), msg + ": quaternion");
+
+    dq_type dq(q, vector_type(Real(1), Real(2), Real(3)));
+    dq.real() *= Real(3);
+    require(unit(dq.normalize().real()), msg + ": dual quaternion");
+
+    soa_vector<Real,3> s;
+    s.resize(13);
+    for(int k = 0; k < 13; ++ k)
+        s.set(k, vector_type(Real(k + 1), Real(2 - k), Real(3)));
+    s.normalize();
+    for(int k = 0; k < 13; ++ k) require(unit(s.get(k)), msg + ": soa");
+
+    plane<Real> p(Real(2), Real(3), Real(6), Real(14));
+    require(unit(p.normalize().normal()), msg + ": plane");
+}
+
+int main()
+{
+    try {
+        check_bounds<float>("float");
+        check_bounds<double>("double");
+        check_normalize<float>("float");
+        check_normalize<double>("double");
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
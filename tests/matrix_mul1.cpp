@@ -0,0 +1,157 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check the blocked and fixed-size matrix multiplication kernels against
+ * the plain loop.
+ *
+ * The block sizes are made small here so that the edge cases (partial
+ * slivers, several KC-deep blocks, several NC-wide panels) are exercised
+ * with small matrices.
+ */
+
+#define CML_MUL_BLOCK_MC 8
+#define CML_MUL_BLOCK_KC 12
+#define CML_MUL_BLOCK_NC 16
+#define CML_MATRIX_BLOCKED_MUL_THRESHOLD 4
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+template<class MatT> void
+fill(MatT& m, double seed)
+{
+    for(size_t i = 0; i < m.rows(); ++ i)
+        for(size_t j = 0; j < m.cols(); ++ j)
+            m(i,j) = std::sin(seed + 0.37*i + 1.13*j);
+}
+
+template<class MatT1, class MatT2> void
+equal_or_fail(const MatT1& m1, const MatT2& m2, const std::string& msg)
+{
+    typedef typename MatT1::value_type value_type;
+    double tol = (sizeof(value_type) < sizeof(double)) ? 1e-5 : 1e-10;
+    if(m1.rows() != m2.rows() || m1.cols() != m2.cols())
+        throw std::runtime_error(msg + ": size mismatch");
+    for(size_t i = 0; i < m1.rows(); ++ i)
+        for(size_t j = 0; j < m1.cols(); ++ j)
+            if(std::fabs(m1(i,j)-m2(i,j)) > tol)
+                throw std::runtime_error(msg + ": value mismatch");
+}
+
+template<class LeftT, class RightT> void
+check(size_t M, size_t K, size_t N, const std::string& msg)
+{
+    LeftT A(M,K); fill(A, 0.5);
+    RightT B(K,N); fill(B, 1.5);
+
+    matrix<double, dynamic<>, col_basis, row_major> C = A*B;
+    matrix<double, dynamic<>, col_basis, row_major> D(M,N);
+    detail::MatMulLoop(D, A, B);
+    equal_or_fail(C, D, msg);
+}
+
+void dynamic_test()
+{
+    typedef matrix<double, dynamic<>, col_basis, row_major> row_matrix;
+    typedef matrix<double, dynamic<>, col_basis, col_major> col_matrix;
+
+    size_t sizes[][3] = {
+        {4,4,4}, {5,7,3}, {8,12,16}, {9,13,17}, {31,40,33}, {64,25,70}
+    };
+    for(size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++ i) {
+        size_t M = sizes[i][0], K = sizes[i][1], N = sizes[i][2];
+        check<row_matrix,row_matrix>(M,K,N, "row*row");
+        check<row_matrix,col_matrix>(M,K,N, "row*col");
+        check<col_matrix,row_matrix>(M,K,N, "col*row");
+        check<col_matrix,col_matrix>(M,K,N, "col*col");
+    }
+
+    /* Result with a col-major layout: */
+    col_matrix A(19,23), B(23,21), C(19,21);
+    fill(A, 0.25); fill(B, 0.75);
+    detail::blocked_mul(C, A, B);
+    col_matrix D(19,21);
+    detail::MatMulLoop(D, A, B);
+    equal_or_fail(C, D, "blocked col-major result");
+}
+
+template<class LeftT, class RightT> void
+check_fixed(const std::string& msg)
+{
+    LeftT A; fill(A, 0.5);
+    RightT B; fill(B, 1.5);
+
+    typedef typename et::MatrixPromote<LeftT,RightT>::type result_type;
+    result_type C = A*B, D;
+    detail::MatMulLoop(D, A, B);
+    equal_or_fail(C, D, msg);
+}
+
+template<typename E, int N, typename BO> void
+check_fixed_layouts(const std::string& msg)
+{
+    typedef matrix<E, fixed<N,N>, BO, row_major> row_matrix;
+    typedef matrix<E, fixed<N,N>, BO, col_major> col_matrix;
+    check_fixed<row_matrix,row_matrix>(msg + " row*row");
+    check_fixed<row_matrix,col_matrix>(msg + " row*col");
+    check_fixed<col_matrix,row_matrix>(msg + " col*row");
+    check_fixed<col_matrix,col_matrix>(msg + " col*col");
+}
+
+void fixed_test()
+{
+    check_fixed_layouts<float,2,col_basis>("float 2x2");
+    check_fixed_layouts<float,3,col_basis>("float 3x3");
+    check_fixed_layouts<float,4,col_basis>("float 4x4");
+    check_fixed_layouts<float,4,row_basis>("float 4x4");
+    check_fixed_layouts<double,2,col_basis>("double 2x2");
+    check_fixed_layouts<double,3,row_basis>("double 3x3");
+    check_fixed_layouts<double,4,col_basis>("double 4x4");
+    check_fixed_layouts<double,4,row_basis>("double 4x4");
+
+    /* Mixed element types: */
+    check_fixed<matrix44f_c,matrix44d_c>("float*double 4x4");
+
+    /* Non-square: */
+    check_fixed<
+        matrix<double, fixed<3,4>, col_basis, row_major>,
+        matrix<double, fixed<4,4>, col_basis, row_major>
+    >("double 3x4*4x4");
+}
+
+void external_test()
+{
+    double a[20*18], b[18*22];
+    matrix<double, external<>, col_basis, row_major> A(a,20,18);
+    matrix<double, external<>, col_basis, col_major> B(b,18,22);
+    fill(A, 2.0); fill(B, 3.0);
+
+    matrix<double, dynamic<>, col_basis, row_major> C = A*B, D(20,22);
+    detail::MatMulLoop(D, A, B);
+    equal_or_fail(C, D, "external*external");
+}
+
+int main()
+{
+    try {
+        dynamic_test();
+        fixed_test();
+        external_test();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,288 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check assignments of lazy matrix and mat-vec products, with and without
+ * an element-wise operand, including destinations that alias an operand,
+ * against products computed with plain loops.
+ */
+
+#define CML_MATRIX_BLOCKED_MUL_THRESHOLD 8
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+typedef matrix< double, dynamic<>, col_basis, row_major > matrixd;
+typedef matrix< double, fixed<4,4>, col_basis, col_major > fixed44d;
+typedef matrix< double, external<>, col_basis, row_major > matrixe;
+typedef vector< double, dynamic<> > vectord;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+template<class MatT> void
+fill(MatT& m, double seed)
+{
+    for(size_t i = 0; i < m.rows(); ++ i)
+        for(size_t j = 0; j < m.cols(); ++ j)
+            m(i,j) = std::sin(seed + 0.37*i + 1.13*j);
+}
+
+template<class VecT> void
+fill_vector(VecT& v, double seed)
+{
+    for(size_t i = 0; i < v.size(); ++ i)
+        v[i] = std::cos(seed + 0.71*i);
+}
+
+/* The product computed with plain loops: */
+template<class MatT1, class MatT2> matrixd
+product(const MatT1& A, const MatT2& B)
+{
+    matrixd C(A.rows(), B.cols());
+    for(size_t i = 0; i < A.rows(); ++ i)
+        for(size_t j = 0; j < B.cols(); ++ j) {
+            double sum = 0.;
+            for(size_t k = 0; k < A.cols(); ++ k) sum += A(i,k)*B(k,j);
+            C(i,j) = sum;
+        }
+    return C;
+}
+
+template<class MatT1, class MatT2> void
+equal_or_fail(const MatT1& m1, const MatT2& m2, const std::string& msg)
+{
+    require(m1.rows() == m2.rows() && m1.cols() == m2.cols(),
+            msg + ": size mismatch");
+    for(size_t i = 0; i < m1.rows(); ++ i)
+        for(size_t j = 0; j < m1.cols(); ++ j)
+            require(std::fabs(m1(i,j)-m2(i,j)) < 1e-10,
+                    msg + ": value mismatch");
+}
+
+template<class VecT1, class VecT2> void
+vector_equal_or_fail(const VecT1& v1, const VecT2& v2,
+        const std::string& msg)
+{
+    require(v1.size() == v2.size(), msg + ": size mismatch");
+    for(size_t i = 0; i < v1.size(); ++ i)
+        require(std::fabs(v1[i]-v2[i]) < 1e-10, msg + ": value mismatch");
+}
+
+template<class MatT> void
+check_matrix(MatT A, MatT B, MatT D, const std::string& msg)
+{
+    fill(A, .5); fill(B, 1.5); fill(D, 2.5);
+    matrixd P = product(A,B), R;
+
+    MatT C = A*B;
+    equal_or_fail(C, P, msg + ": C = A*B");
+
+    C = A*B + D;
+    R = P; R += D;
+    equal_or_fail(C, R, msg + ": C = A*B + D");
+
+    C = D - A*B;
+    R = D; R -= P;
+    equal_or_fail(C, R, msg + ": C = D - A*B");
+
+    C = 2.*(A*B);
+    R = 2.*P;
+    equal_or_fail(C, R, msg + ": C = 2*(A*B)");
+
+    C = A*B + A*B;
+    equal_or_fail(C, R, msg + ": C = A*B + A*B");
+
+    C = D; C += A*B;
+    R = D; R += P;
+    equal_or_fail(C, R, msg + ": C += A*B");
+
+    C = D; C -= A*B - D;
+    R = D; R -= P; R += D;
+    equal_or_fail(C, R, msg + ": C -= A*B - D");
+
+    C = transpose(A*B);
+    R = transpose(P);
+    equal_or_fail(C, R, msg + ": C = transpose(A*B)");
+
+    C = transpose(A*B) + D;
+    R = transpose(P); R += D;
+    equal_or_fail(C, R, msg + ": C = transpose(A*B) + D");
+
+    C = A*B - transpose(A*B);
+    R = P; R -= transpose(P);
+    equal_or_fail(C, R, msg + ": C = A*B - transpose(A*B)");
+
+    /* Elements read straight from a product node: */
+    for(size_t i = 0; i < P.rows(); ++ i)
+        for(size_t j = 0; j < P.cols(); ++ j)
+            require(std::fabs((A*B)(i,j) - P(i,j)) < 1e-10,
+                    msg + ": (A*B)(i,j)");
+
+    C = (A + D)*B;
+    R = A + D; R = product(R, B);
+    equal_or_fail(C, R, msg + ": C = (A + D)*B");
+
+    C = (A*B)*D;
+    R = product(P, D);
+    equal_or_fail(C, R, msg + ": C = (A*B)*D");
+
+    /* Destinations that are read while the product is written: */
+    C = A; C = C*B;
+    equal_or_fail(C, P, msg + ": C = C*B");
+
+    C = B; C = A*C;
+    equal_or_fail(C, P, msg + ": C = A*C");
+
+    C = A; C *= B;
+    equal_or_fail(C, P, msg + ": C *= B");
+
+    C = D; C = A*B + C;
+    R = P; R += D;
+    equal_or_fail(C, R, msg + ": C = A*B + C");
+
+    C = D; C = C - A*B;
+    R = D; R -= P;
+    equal_or_fail(C, R, msg + ": C = C - A*B");
+
+    C = A; C += C*B;
+    R = A; R += P;
+    equal_or_fail(C, R, msg + ": C += C*B");
+
+    C = A; C = transpose(C*B);
+    R = transpose(P);
+    equal_or_fail(C, R, msg + ": C = transpose(C*B)");
+}
+
+void check_matvec()
+{
+    matrixd A(7,5), B(5,6);
+    vectord x(6), z(7);
+    fill(A, .5); fill(B, 1.5);
+    fill_vector(x, .25); fill_vector(z, .75);
+    matrixd P = product(A,B);
+
+    /* The reference products: */
+    vectord Px(7), wP(6);
+    for(size_t i = 0; i < 7; ++ i) {
+        Px[i] = 0.;
+        for(size_t k = 0; k < 6; ++ k) Px[i] += P(i,k)*x[k];
+    }
+    for(size_t j = 0; j < 6; ++ j) {
+        wP[j] = 0.;
+        for(size_t k = 0; k < 7; ++ k) wP[j] += z[k]*P(k,j);
+    }
+
+    vectord y = A*(B*x);
+    vector_equal_or_fail(y, Px, "y = A*(B*x)");
+
+    y = (A*B)*x;
+    vector_equal_or_fail(y, Px, "y = (A*B)*x");
+
+    y = z*(A*B);
+    vector_equal_or_fail(y, wP, "y = z*(A*B)");
+
+    y = (A*B)*x + z;
+    vectord r = Px + z;
+    vector_equal_or_fail(y, r, "y = (A*B)*x + z");
+
+    y = z; y -= 3.*((A*B)*x);
+    r = z - 3.*Px;
+    vector_equal_or_fail(y, r, "y -= 3*((A*B)*x)");
+
+    y = (A*B)*x - (A*B)*x;
+    require(length(y) < 1e-10, "y = (A*B)*x - (A*B)*x");
+
+    require(std::fabs(dot(z, (A*B)*x) - dot(z, Px)) < 1e-10,
+            "dot(z, (A*B)*x)");
+    require(std::fabs(length((A*B)*x) - length(Px)) < 1e-10,
+            "length((A*B)*x)");
+    require(std::fabs(((A*B)*x)[3] - Px[3]) < 1e-10, "((A*B)*x)[3]");
+
+    /* A destination that is an operand: */
+    matrixd S(6,6); fill(S, 3.5);
+    vectord Sx(6);
+    for(size_t i = 0; i < 6; ++ i) {
+        Sx[i] = 0.;
+        for(size_t k = 0; k < 6; ++ k) Sx[i] += S(i,k)*x[k];
+    }
+    vectord s = x; s = S*s;
+    vector_equal_or_fail(s, Sx, "s = S*s");
+
+    s = x; s = S*s + s;
+    vectord q = Sx + x;
+    vector_equal_or_fail(s, q, "s = S*s + s");
+
+    /* Fixed-size products: */
+    fixed44d F, G;
+    vector4d u(1., 2., 3., 4.), v;
+    fill(F, .5); fill(G, 1.5);
+    matrixd FG = product(F,G);
+    v = (F*G)*u;
+    for(size_t i = 0; i < 4; ++ i) {
+        double sum = 0.;
+        for(size_t k = 0; k < 4; ++ k) sum += FG(i,k)*u[k];
+        require(std::fabs(v[i] - sum) < 1e-10, "v = (F*G)*u");
+    }
+    v = u; v = F*v + u;
+    vector4d t = F*u + u;
+    vector_equal_or_fail(v, t, "v = F*v + v");
+}
+
+/* Destinations with external storage cannot be resized: */
+void check_external()
+{
+    std::vector<double> x(50*50), y(50*50), z(50*50);
+    matrixe X(&x[0],50,50), Y(&y[0],50,50), Z(&z[0],50,50);
+    fill(Y, .5); fill(Z, 1.5);
+    matrixd P = product(Y,Z), R;
+
+    X = Y*Z;
+    equal_or_fail(X, P, "external: X = Y*Z");
+
+    X = Y*Z + Y;
+    R = P; R += Y;
+    equal_or_fail(X, R, "external: X = Y*Z + Y");
+
+    X = Y; X = X*Z;
+    equal_or_fail(X, P, "external: X = X*Z");
+
+    bool thrown = false;
+    try {
+        matrixe W(&x[0],10,50);
+        W = Y*Z;
+    } catch(std::invalid_argument&) {
+        thrown = true;
+    }
+    require(thrown, "external: product of the wrong size");
+}
+
+int main()
+{
+    try {
+        check_matrix(fixed44d(), fixed44d(), fixed44d(), "fixed");
+        check_matrix(matrixd(3,3), matrixd(3,3), matrixd(3,3), "small");
+        check_matrix(matrixd(21,21), matrixd(21,21), matrixd(21,21),
+                "large");
+        check_matvec();
+        check_external();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,244 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check the pivoted LU factorization and solvers, and matrix inversion,
+ * including the rigid and affine transform inverses.
+ *
+ * The block size is made small here so that matrices of modest size are
+ * factored in several panels.
+ */
+
+#define CML_LU_BLOCK_SIZE 4
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+typedef matrix<double, dynamic<>, col_basis, row_major> row_matrix;
+typedef matrix<double, dynamic<>, col_basis, col_major> col_matrix;
+typedef vector<double, dynamic<> > dvector;
+
+template<class MatT> void
+fill(MatT& m, double seed)
+{
+    for(size_t i = 0; i < m.rows(); ++ i)
+        for(size_t j = 0; j < m.cols(); ++ j)
+            m(i,j) = std::sin(seed + 0.37*i*i + 1.13*i*j + 0.71*j);
+}
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+/* Return the largest element of |A x - b|: */
+template<class MatT, class XT, class BT> double
+residual(const MatT& A, const XT& x, const BT& b)
+{
+    double r = 0.;
+    for(size_t i = 0; i < A.rows(); ++ i) {
+        double s = -b[i];
+        for(size_t j = 0; j < A.cols(); ++ j) s += A(i,j)*x[j];
+        r = std::max(r, std::fabs(s));
+    }
+    return r;
+}
+
+template<class MatT> void
+check_solve(size_t N, const std::string& msg)
+{
+    MatT A(N,N); fill(A, 0.5);
+    lu_factorization<MatT> F(A);
+    require(!F.is_singular(), msg + ": singular");
+
+    /* Single right-hand side, via solve() and solve_inplace(): */
+    dvector b(N), x(N);
+    for(size_t i = 0; i < N; ++ i) b[i] = std::cos(0.3*i);
+    F.solve(x, b);
+    require(residual(A, x, b) < 1e-9, msg + ": solve");
+    x = b; F.solve_inplace(x);
+    require(residual(A, x, b) < 1e-9, msg + ": solve_inplace");
+
+    /* Several right-hand sides: */
+    MatT B(N,3), X(N,3); fill(B, 2.5);
+    F.solve(X, B);
+    for(size_t j = 0; j < 3; ++ j) {
+        dvector bj(N), xj(N);
+        for(size_t i = 0; i < N; ++ i) { bj[i] = B(i,j); xj[i] = X(i,j); }
+        require(residual(A, xj, bj) < 1e-9, msg + ": multiple rhs");
+    }
+
+    /* The determinant should match the one from the Doolittle LU: */
+    if(N <= 8) {
+        double d = determinant(A);
+        require(std::fabs(F.determinant() - d) < 1e-9*(1.+std::fabs(d)),
+                msg + ": determinant");
+    }
+}
+
+void pivot_test()
+{
+    /* A zero leading element requires a row interchange: */
+    matrix33d A(
+            0., 2., 1.,
+            1., 1., 1.,
+            2., 1., 0.);
+    lu_factorization<matrix33d> F = lu_factor(A);
+    require(!F.is_singular(), "pivot: singular");
+
+    vector3d b(3., 3., 3.), x;
+    F.solve(x, b);
+    require(residual(A, x, b) < 1e-12, "pivot: fixed-size solve");
+    require(std::fabs(F.determinant() - determinant(A)) < 1e-12,
+            "pivot: determinant");
+
+    /* A singular matrix is detected: */
+    matrix33d S(
+            1., 2., 3.,
+            2., 4., 6.,
+            1., 0., 1.);
+    F.factor(S);
+    require(F.is_singular(), "pivot: singular not detected");
+}
+
+/* Return the largest element of |A B - I|: */
+template<class MatT1, class MatT2> double
+identity_error(const MatT1& A, const MatT2& B)
+{
+    double r = 0.;
+    for(size_t i = 0; i < A.rows(); ++ i)
+        for(size_t j = 0; j < B.cols(); ++ j) {
+            double s = (i == j) ? -1. : 0.;
+            for(size_t k = 0; k < A.cols(); ++ k) s += A(i,k)*B(k,j);
+            r = std::max(r, std::fabs(s));
+        }
+    return r;
+}
+
+template<class MatT> void
+check_inverse(size_t N, const std::string& msg)
+{
+    MatT A(N,N); fill(A, 0.5);
+    MatT Z = inverse(A);
+    require(identity_error(A, Z) < 1e-9, msg + ": inverse");
+
+    Z = A; inverse_inplace(Z);
+    require(identity_error(A, Z) < 1e-9, msg + ": inverse_inplace");
+}
+
+void fixed_inverse_test()
+{
+    typedef matrix<double, fixed<6,6>, col_basis, row_major> matrix66d;
+    matrix66d A; fill(A, 1.5);
+    matrix66d Z = inverse(A);
+    require(identity_error(A, Z) < 1e-9, "fixed 6x6: inverse");
+    Z = A; inverse_inplace(Z);
+    require(identity_error(A, Z) < 1e-9, "fixed 6x6: inverse_inplace");
+
+    matrix33d B; fill(B, 2.5);
+    matrix33d W = B; inverse_inplace(W);
+    require(identity_error(B, W) < 1e-9, "fixed 3x3: inverse_inplace");
+}
+
+/* Return the largest element of |A - B|: */
+template<class MatT1, class MatT2> double
+max_difference(const MatT1& A, const MatT2& B)
+{
+    double r = 0.;
+    for(size_t i = 0; i < A.rows(); ++ i)
+        for(size_t j = 0; j < A.cols(); ++ j)
+            r = std::max(r, std::fabs(A(i,j) - B(i,j)));
+    return r;
+}
+
+template<class BasisT, class LayoutT> void
+check_transform_inverse(const std::string& msg)
+{
+    typedef matrix<double, fixed<4,4>, BasisT, LayoutT> matrix_type;
+
+    matrix_type R, T, S, M;
+    matrix_rotation_euler(R, 0.3, -1.1, 2.4, euler_order_zyx);
+    matrix_translation(T, 1.5, -2., 3.25);
+    matrix_scale(S, 2., 0.5, -3.);
+
+    /* Rigid transform: */
+    M = R*T;
+    require(max_difference(inverse_rigid(M), inverse(M)) < 1e-12,
+            msg + ": inverse_rigid");
+    require(max_difference(inverse_transform(M), inverse(M)) < 1e-12,
+            msg + ": inverse_transform (rigid)");
+
+    /* General affine transform: */
+    M = S*R*T;
+    require(max_difference(inverse_affine(M), inverse(M)) < 1e-12,
+            msg + ": inverse_affine");
+    require(max_difference(inverse_transform(M), inverse(M)) < 1e-12,
+            msg + ": inverse_transform (affine)");
+
+    /* Projective transforms fall back to the general inverse: */
+    M.set_basis_element(0,3, 0.25);
+    require(identity_error(M, inverse_transform(M)) < 1e-12,
+            msg + ": inverse_transform (projective)");
+}
+
+void affine_inverse_test()
+{
+    check_transform_inverse<col_basis,row_major>("col_basis, row_major");
+    check_transform_inverse<col_basis,col_major>("col_basis, col_major");
+    check_transform_inverse<row_basis,row_major>("row_basis, row_major");
+    check_transform_inverse<row_basis,col_major>("row_basis, col_major");
+
+    /* 4x3 and 3x4 affine matrices: */
+    matrix43f_r M43; matrix44f_r M44;
+    matrix_rotation_euler(M43, 0.3f, -1.1f, 2.4f, euler_order_xyz);
+    matrix_set_translation(M43, 1.f, 2.f, 3.f);
+    matrix_rotation_euler(M44, 0.3f, -1.1f, 2.4f, euler_order_xyz);
+    matrix_set_translation(M44, 1.f, 2.f, 3.f);
+    matrix44f_r Z = inverse(M44);
+    matrix43f_r Z43 = inverse_rigid(M43);
+    for(size_t i = 0; i < 4; ++ i)
+        for(size_t j = 0; j < 3; ++ j)
+            require(std::fabs(Z43(i,j) - Z(i,j)) < 1e-5f, "4x3 inverse_rigid");
+
+    matrix34f_c N34; matrix44f_c N44;
+    matrix_scale(N34, 2.f, 3.f, 4.f);
+    matrix_set_translation(N34, 1.f, 2.f, 3.f);
+    matrix_scale(N44, 2.f, 3.f, 4.f);
+    matrix_set_translation(N44, 1.f, 2.f, 3.f);
+    matrix44f_c W = inverse(N44);
+    matrix34f_c W34 = inverse_affine(N34);
+    for(size_t i = 0; i < 3; ++ i)
+        for(size_t j = 0; j < 4; ++ j)
+            require(std::fabs(W34(i,j) - W(i,j)) < 1e-5f, "3x4 inverse_affine");
+}
+
+int main()
+{
+    try {
+        size_t sizes[] = { 1, 2, 5, 8, 13, 40 };
+        for(size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++ i) {
+            check_solve<row_matrix>(sizes[i], "row-major");
+            check_solve<col_matrix>(sizes[i], "col-major");
+            check_inverse<row_matrix>(sizes[i], "row-major");
+            check_inverse<col_matrix>(sizes[i], "col-major");
+        }
+        pivot_test();
+        fixed_inverse_test();
+        affine_inverse_test();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
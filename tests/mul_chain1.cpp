@@ -0,0 +1,175 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check mul_chain() and matrix_chain<> against products evaluated left to
+ * right, for fixed-size transforms and run-time sized chains of varying
+ * shapes, with and without a vector at the end.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+typedef matrix< double, dynamic<>, col_basis, row_major > matrixd;
+typedef vector< double, dynamic<> > vectord;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+template<class MatT> void
+fill(MatT& m, double seed)
+{
+    for(size_t i = 0; i < m.rows(); ++ i)
+        for(size_t j = 0; j < m.cols(); ++ j)
+            m(i,j) = std::sin(seed + 0.37*i + 1.13*j)/std::sqrt(m.cols());
+}
+
+template<class MatT1, class MatT2> void
+equal_or_fail(const MatT1& m1, const MatT2& m2, const std::string& msg)
+{
+    require(m1.rows() == m2.rows() && m1.cols() == m2.cols(),
+            msg + ": size mismatch");
+    for(size_t i = 0; i < m1.rows(); ++ i)
+        for(size_t j = 0; j < m1.cols(); ++ j)
+            require(std::fabs(m1(i,j)-m2(i,j)) < 1e-10,
+                    msg + ": value mismatch");
+}
+
+template<class VecT1, class VecT2> void
+vector_equal_or_fail(const VecT1& v1, const VecT2& v2,
+        const std::string& msg)
+{
+    require(v1.size() == v2.size(), msg + ": size mismatch");
+    for(size_t i = 0; i < v1.size(); ++ i)
+        require(std::fabs(v1[i]-v2[i]) < 1e-10, msg + ": value mismatch");
+}
+
+void check_fixed()
+{
+    matrix44d_c m[10];
+    for(int i = 0; i < 10; ++ i) fill(m[i], 0.3*i);
+    vector4d x(1., -2., .5, 3.);
+
+    matrix44d_c R = m[0]*m[1];
+    equal_or_fail(mul_chain(m[0],m[1]), R, "fixed 2");
+    vector4d y = R*x;
+    vector_equal_or_fail(mul_chain(m[0],m[1],x), y, "fixed 2, x");
+
+    R = R*m[2]; R = R*m[3]; R = R*m[4];
+    equal_or_fail(mul_chain(m[0],m[1],m[2],m[3],m[4]), R, "fixed 5");
+    y = R*x;
+    vector_equal_or_fail(mul_chain(m[0],m[1],m[2],m[3],m[4],x), y,
+            "fixed 5, x");
+
+    R = R*m[5]; R = R*m[6]; R = R*m[7]; R = R*m[8]; R = R*m[9];
+    equal_or_fail(
+            mul_chain(m[0],m[1],m[2],m[3],m[4],m[5],m[6],m[7],m[8],m[9]),
+            R, "fixed 10");
+    y = R*x;
+    vector_equal_or_fail(
+            mul_chain(m[0],m[1],m[2],m[3],m[4],m[5],m[6],m[7],m[8],m[9],x),
+            y, "fixed 10, x");
+
+    vector_equal_or_fail(mul_chain(m[0],x), vector4d(m[0]*x), "fixed 1, x");
+
+    /* A destination that is in the chain: */
+    matrix_chain<matrix44d_c> chain;
+    matrix44d_c A = m[0];
+    chain.push_back(A).push_back(m[1]).push_back(m[2]);
+    R = m[0]*m[1]; R = R*m[2];
+    chain.product(A);
+    equal_or_fail(A, R, "fixed, aliased");
+
+    y = R*x;
+    chain.clear();
+    chain.push_back(m[0]).push_back(m[1]).push_back(m[2]);
+    chain.product(x, x);
+    vector_equal_or_fail(x, y, "fixed, aliased x");
+}
+
+void check_dynamic()
+{
+    /* A chain whose cheapest order multiplies the middle first: */
+    const size_t p[] = { 30, 35, 15, 5, 10, 20, 25 };
+    matrixd m[6];
+    for(int i = 0; i < 6; ++ i) {
+        m[i].resize(p[i], p[i+1]);
+        fill(m[i], 0.7*i);
+    }
+    matrixd R = m[0]*m[1];
+    for(int i = 2; i < 6; ++ i) R = R*m[i];
+    equal_or_fail(mul_chain(m[0],m[1],m[2],m[3],m[4],m[5]), R, "dynamic 6");
+
+    vectord x(25);
+    for(size_t i = 0; i < 25; ++ i) x[i] = std::cos(0.3*i);
+    vectord y = R*x;
+    vector_equal_or_fail(mul_chain(m[0],m[1],m[2],m[3],m[4],m[5],x), y,
+            "dynamic 6, x");
+
+    /* A row vector first makes a block product cheaper than two mat-vec
+     * products:
+     */
+    matrixd a(1,100), b(100,2);
+    fill(a, .1); fill(b, .2);
+    vectord u(2); u[0] = 1.; u[1] = -.5;
+    matrixd ab = a*b;
+    vectord v = ab*u;
+    vector_equal_or_fail(mul_chain(a,b,u), v, "dynamic block, x");
+
+    /* A reused chain, with products large enough for the blocked kernel,
+     * and longer than the overloads of mul_chain():
+     */
+    matrixd s[12];
+    matrix_chain<matrixd> chain;
+    for(int i = 0; i < 12; ++ i) {
+        s[i].resize(40 + (i%3)*5, 40 + ((i+1)%3)*5);
+        fill(s[i], 0.1*i);
+        chain.push_back(s[i]);
+    }
+    R = s[0]*s[1];
+    for(int i = 2; i < 12; ++ i) R = R*s[i];
+    matrixd C;
+    chain.product(C);
+    equal_or_fail(C, R, "dynamic 12");
+    C.zero();
+    chain.product(C);
+    equal_or_fail(C, R, "dynamic 12, reused");
+
+    /* A destination that is in the chain: */
+    chain.product(s[5]);
+    equal_or_fail(s[5], R, "dynamic 12, aliased");
+
+    /* Incompatible sizes: */
+    bool thrown = false;
+    try {
+        mul_chain(m[0], m[2]);
+    } catch(std::invalid_argument&) {
+        thrown = true;
+    }
+    require(thrown, "dynamic, incompatible sizes");
+}
+
+int main()
+{
+    try {
+        check_fixed();
+        check_dynamic();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
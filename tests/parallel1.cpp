@@ -0,0 +1,234 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check assignments, reductions and products of run-time sized vectors and
+ * matrices evaluated on a pool of threads against the same expressions
+ * evaluated on the calling thread.  Without C++11, this only checks the
+ * sequential results.
+ */
+
+#if __cplusplus >= 201103L && !defined(CML_PARALLEL)
+#define CML_PARALLEL
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+typedef matrix< double, dynamic<>, col_basis, row_major > matrixd;
+typedef vector< double, dynamic<> > vectord;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+template<class MatT> void
+fill(MatT& m, double seed)
+{
+    for(size_t i = 0; i < m.rows(); ++ i)
+        for(size_t j = 0; j < m.cols(); ++ j)
+            m(i,j) = std::sin(seed + 0.37*i + 1.13*j)/std::sqrt(m.cols());
+}
+
+template<class VecT> void
+fill_vector(VecT& v, double seed)
+{
+    for(size_t i = 0; i < v.size(); ++ i)
+        v[i] = std::cos(seed + 0.71*i);
+}
+
+template<class MatT1, class MatT2> void
+equal_or_fail(const MatT1& m1, const MatT2& m2, const std::string& msg)
+{
+    require(m1.rows() == m2.rows() && m1.cols() == m2.cols(),
+            msg + ": size mismatch");
+    for(size_t i = 0; i < m1.rows(); ++ i)
+        for(size_t j = 0; j < m1.cols(); ++ j)
+            require(std::fabs(m1(i,j)-m2(i,j)) < 1e-10,
+                    msg + ": value mismatch");
+}
+
+template<class VecT1, class VecT2> void
+vector_equal_or_fail(const VecT1& v1, const VecT2& v2,
+        const std::string& msg)
+{
+    require(v1.size() == v2.size(), msg + ": size mismatch");
+    for(size_t i = 0; i < v1.size(); ++ i)
+        require(std::fabs(v1[i]-v2[i]) < 1e-10, msg + ": value mismatch");
+}
+
+/* The results computed with plain loops: */
+struct reference
+{
+    vectord w, Ax, Axz;
+    matrixd S, C;
+    double dot, length_squared;
+};
+
+reference
+compute_reference(const vectord& u, const vectord& v, const matrixd& A,
+        const matrixd& B, const vectord& x, const vectord& z)
+{
+    reference r;
+    r.w.resize(u.size());
+    r.dot = r.length_squared = 0.;
+    for(size_t i = 0; i < u.size(); ++ i) {
+        r.w[i] = 2.*u[i] - v[i];
+        r.dot += u[i]*v[i];
+        r.length_squared += u[i]*u[i];
+    }
+
+    r.S.resize(A.rows(), A.cols());
+    for(size_t i = 0; i < A.rows(); ++ i)
+        for(size_t j = 0; j < A.cols(); ++ j)
+            r.S(i,j) = A(i,j) + 3.*A(i,j);
+
+    r.Ax.resize(A.rows());
+    r.Axz.resize(A.rows());
+    for(size_t i = 0; i < A.rows(); ++ i) {
+        double sum = 0.;
+        for(size_t k = 0; k < A.cols(); ++ k) sum += A(i,k)*x[k];
+        r.Ax[i] = sum;
+        r.Axz[i] = sum + z[i];
+    }
+
+    r.C.resize(A.rows(), B.cols());
+    for(size_t i = 0; i < A.rows(); ++ i)
+        for(size_t j = 0; j < B.cols(); ++ j) {
+            double sum = 0.;
+            for(size_t k = 0; k < A.cols(); ++ k) sum += A(i,k)*B(k,j);
+            r.C(i,j) = sum;
+        }
+    return r;
+}
+
+void check(const std::string& msg)
+{
+    const size_t n = 100003;
+    vectord u(n), v(n), w(n);
+    fill_vector(u, .25); fill_vector(v, .75);
+
+    matrixd A(301,257), B(257,263), S(301,257), C;
+    vectord x(257), z(301), y(301);
+    fill(A, .5); fill(B, 1.5);
+    fill_vector(x, 1.25); fill_vector(z, 2.25);
+
+    reference r = compute_reference(u, v, A, B, x, z);
+
+    w = 2.*u - v;
+    vector_equal_or_fail(w, r.w, msg + ": w = 2*u - v");
+
+    require(std::fabs(dot(u,v) - r.dot) < 1e-8, msg + ": dot(u,v)");
+    require(std::fabs(u.length_squared() - r.length_squared) < 1e-8,
+            msg + ": length_squared()");
+
+    S = A + 3.*A;
+    equal_or_fail(S, r.S, msg + ": S = A + 3*A");
+
+    y = A*x;
+    vector_equal_or_fail(y, r.Ax, msg + ": y = A*x");
+
+    y = A*x + z;
+    vector_equal_or_fail(y, r.Axz, msg + ": y = A*x + z");
+
+    C = A*B;
+    equal_or_fail(C, r.C, msg + ": C = A*B");
+
+    /* Products inside larger expressions are computed before the loops: */
+    vectord rz = r.Ax + z;
+    y = z + 2.*(A*x) - A*x;
+    vector_equal_or_fail(y, rz, msg + ": y = z + 2*(A*x) - A*x");
+
+    double Axz = 0.;
+    for(size_t i = 0; i < z.size(); ++ i) Axz += r.Ax[i]*z[i];
+    require(std::fabs(dot(A*x, z) - Axz) < 1e-8*std::fabs(Axz),
+            msg + ": dot(A*x, z)");
+
+    matrixd D = transpose(r.C), E = 2.*D;
+    C = transpose(A*B) + D;
+    equal_or_fail(C, E, msg + ": C = transpose(A*B) + D");
+}
+
+#if defined(CML_PARALLEL)
+/* Every chunk of many short jobs run back to back is run exactly once: */
+void check_pool()
+{
+    parallel::thread_pool pool(4);
+    const size_t chunks = 16;
+    std::vector<int> ran(chunks);
+    for(int job = 0; job < 20000; ++ job) {
+        std::fill(ran.begin(), ran.end(), 0);
+        pool.run(chunks, [&](size_t c, size_t) { ++ ran[c]; });
+        for(size_t c = 0; c < chunks; ++ c)
+            require(ran[c] == 1, "pool job chunks");
+    }
+}
+
+void check_parallel()
+{
+    /* Thresholds low enough for everything in check() to use threads: */
+    parallel::policy p;
+    p.threads = 4;
+    p.threshold = 1024;
+    p.mul_threshold = 1024;
+    p.grain = 512;
+    parallel::set_policy(p);
+    check("4 threads");
+
+    /* Deterministic reductions give the same result for any number of
+     * threads:
+     */
+    vectord u(100003), v(100003);
+    fill_vector(u, .25); fill_vector(v, .75);
+    p.deterministic = true;
+    double first = 0.;
+    for(size_t t = 1; t <= 5; ++ t) {
+        p.threads = t;
+        parallel::set_policy(p);
+        double d = dot(u,v);
+        if(t == 1) first = d;
+        require(d == first, "deterministic dot(u,v)");
+    }
+
+    /* Empty vectors reduce to 0 with either kind of reduction: */
+    p.threshold = 0;
+    vectord e(0);
+    for(int k = 0; k < 2; ++ k) {
+        p.deterministic = (k == 0);
+        parallel::set_policy(p);
+        require(dot(e,e) == 0., "dot() of empty vectors");
+    }
+
+    p.enabled = false;
+    parallel::set_policy(p);
+}
+#endif
+
+int main()
+{
+    try {
+        check("sequential");
+#if defined(CML_PARALLEL)
+        check_pool();
+        check_parallel();
+#endif
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
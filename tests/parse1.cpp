@@ -0,0 +1,288 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check that vectors, matrices and quaternions read back with operator>>
+ * what operator<< wrote, and that the parsers of cml/io/parse.h read
+ * numbers exactly, whatever the locale, from whitespace and CSV text.
+ */
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cml/cml.h>
+#include <cml/io/parse.h>
+
+using namespace cml;
+
+typedef vector< double, dynamic<> > vectord;
+typedef matrix< double, dynamic<>, col_basis, row_major > matrix_dr;
+typedef matrix< double, fixed<4,4>, col_basis, col_major > matrix44_c;
+typedef quaternion< double, fixed<>, vector_first, positive_cross > quat_vf;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+template<class VecT1, class VecT2> bool
+same_vector(const VecT1& v1, const VecT2& v2)
+{
+    if(v1.size() != v2.size()) return false;
+    for(size_t i = 0; i < v1.size(); ++ i)
+        if(v1[i] != v2[i]) return false;
+    return true;
+}
+
+template<class MatT1, class MatT2> bool
+same_matrix(const MatT1& m1, const MatT2& m2)
+{
+    if(m1.rows() != m2.rows() || m1.cols() != m2.cols()) return false;
+    for(size_t i = 0; i < m1.rows(); ++ i)
+        for(size_t j = 0; j < m1.cols(); ++ j)
+            if(m1(i,j) != m2(i,j)) return false;
+    return true;
+}
+
+/* Expect parsing text into x to throw std::invalid_argument: */
+template<class T> void
+parse_fails(const std::string& text, T& x, const std::string& msg)
+{
+    try {
+        parse_matrix(text, x);
+    } catch(std::invalid_argument&) {
+        return;
+    }
+    throw std::runtime_error(msg + ": no exception");
+}
+
+void check_streams()
+{
+    std::ostringstream out;
+    out.precision(17);
+    vector3d v(1.5, -2.25, 1e-300);
+    vectord d(5);
+    for(size_t i = 0; i < 5; ++ i) d[i] = std::sqrt(double(i + 2));
+    matrix44_c m;
+    for(size_t i = 0; i < 4; ++ i)
+        for(size_t j = 0; j < 4; ++ j) m(i,j) = std::sin(0.3*i + 1.7*j);
+    matrix_dr r(2,3);
+    for(size_t i = 0; i < 2; ++ i)
+        for(size_t j = 0; j < 3; ++ j) r(i,j) = i - 0.125*j;
+    quat_vf q(0.5, 1.5, -2.5, 3.5);
+    out << v << "\n" << d << "\n" << m << "\n" << r << "\n\n" << q;
+
+    vector3d v2;
+    vectord d2;
+    matrix44_c m2;
+    matrix_dr r2;
+    quat_vf q2;
+    std::istringstream in(out.str());
+    in >> v2 >> std::ws >> d2 >> m2 >> r2 >> q2;
+    require(!in.fail(), "stream extraction");
+    require(same_vector(v, v2), "fixed vector round trip");
+    require(same_vector(d, d2), "dynamic vector round trip");
+    require(same_matrix(m, m2), "fixed matrix round trip");
+    require(same_matrix(r, r2), "dynamic matrix round trip");
+    require(q2.real() == q.real() && same_vector(q2.imaginary(),
+                q.imaginary()), "quaternion round trip");
+
+    /* Malformed input sets failbit: */
+    std::istringstream bad("1 0 0 0\n");
+    bad >> m2;
+    require(bad.fail(), "matrix without brackets");
+    std::istringstream badq("0.5 1 2 3");
+    badq >> q2;
+    require(badq.fail(), "quaternion without brackets");
+
+    /* A dynamic vector is read from the next line that is not blank: */
+    int n = 0;
+    vectord d3;
+    std::istringstream sized("3\n\n1.5 2.5 3.5\n");
+    sized >> n >> d3;
+    require(!sized.fail() && n == 3 && d3.size() == 3 && d3[2] == 3.5,
+            "count, then a dynamic vector");
+    vectord d4;
+    std::istringstream blank("\n  \n");
+    blank >> d4;
+    require(blank.fail(), "dynamic vector from blank lines");
+    vector< double, external<> > e(0, 0);
+    std::istringstream ext("1 2 3\n");
+    ext >> e;
+    require(ext.fail(), "empty external vector");
+}
+
+void check_numbers()
+{
+    const char* cases[] = {
+        "0", "-0", "1", "-17.25", "3.141592653589793",
+        "2.2250738585072014e-308", "4.9e-324", "1.7976931348623157e308",
+        "123456789012345678901234567890",
+        "0.1", "1e22", "1e23", "9007199254740993", "0.000001234", ".5", "5.",
+        "1E-5", "+42"
+    };
+    for(size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); ++ i) {
+        const char* s = cases[i];
+        const char* end = s + std::strlen(s);
+        double d = -1.;
+        require(parse_number(s, end, d) == end, std::string("parse ") + s);
+        require(d == std::strtod(s, 0), std::string("value of ") + s);
+        float f = -1.f;
+        parse_number(s, end, f);
+        require(f == float(std::strtod(s, 0)), std::string("float ") + s);
+    }
+
+    /* Random digits against the C library: */
+    std::srand(7);
+    for(int i = 0; i < 10000; ++ i) {
+        char s[64];
+        std::sprintf(s, "%.*g", 1 + i%17,
+                (std::rand() - RAND_MAX/2)*std::pow(10., i%40 - 20));
+        double d = 0.;
+        parse_number(s, s + std::strlen(s), d);
+        require(d == std::strtod(s, 0), std::string("random ") + s);
+    }
+
+    double d = 0.;
+    const char* s = "inf nan x 1e";
+    const char* p = parse_number(s, s + 12, d);
+    require(p == s + 3 && d == std::numeric_limits<double>::infinity(),
+            "inf");
+    p = parse_number(p + 1, s + 12, d);
+    require(p == s + 7 && d != d, "nan");
+    require(parse_number(s + 8, s + 12, d) == s + 8, "not a number");
+    require(parse_number(s + 10, s + 12, d) == s + 11 && d == 1.,
+            "exponent without digits");
+
+    /* Integers, with their ranges checked: */
+    int n = 0;
+    const char* t = "-2147483648 2147483648 -3";
+    require(parse_number(t, t + 11, n) == t + 11 && n == (-2147483647 - 1),
+            "int minimum");
+    require(parse_number(t + 12, t + 22, n) == t + 12, "int overflow");
+    unsigned u = 0;
+    require(parse_number(t + 23, t + 25, u) == t + 23, "negative unsigned");
+
+    /* The decimal point does not depend on the locale: */
+    if(std::setlocale(LC_NUMERIC, "de_DE.UTF-8")
+            || std::setlocale(LC_NUMERIC, "fr_FR.UTF-8"))
+    {
+        const char* x = "0.1234567890123456789012";
+        parse_number(x, x + std::strlen(x), d);
+        std::setlocale(LC_NUMERIC, "C");
+        require(d == std::strtod(x, 0), "localized decimal point");
+    }
+}
+
+void check_rows()
+{
+    /* CSV rows, with CR/LF line ends: */
+    std::string csv = "1.5,2,3\r\n-4, 5e1 ,6\r\n\r\n7;8;9\r\n";
+    std::vector<vector3d> v;
+    parse_rows(csv, v);
+    require(v.size() == 3 && v[1][1] == 50. && v[2][2] == 9.,
+            "CSV vectors");
+
+    std::vector<vectord> d;
+    parse_rows(std::string("1 2\n3 4 5 6\n[ 7 ]\n"), d);
+    require(d.size() == 3 && d[1].size() == 4 && d[2][0] == 7.,
+            "dynamic vector rows");
+
+    std::vector<quat_vf> q;
+    parse_rows(std::string("[  0.5 1 2 3 ]\n"), q);
+    require(q.size() == 1 && q[0].real() == 0.5 && q[0][0] == 1.,
+            "quaternion rows");
+
+    bool thrown = false;
+    try {
+        parse_rows(std::string("1 2 3\n4 5\n"), v);
+    } catch(std::invalid_argument& e) {
+        thrown = std::string(e.what()).find("line 2") != std::string::npos;
+    }
+    require(thrown, "short vector row");
+
+    thrown = false;
+    try {
+        parse_rows(std::string("1 2 3\n4 5 x\n"), d);
+    } catch(std::invalid_argument&) {
+        thrown = true;
+    }
+    require(thrown, "bad number");
+
+    matrix_dr m;
+    parse_matrix(std::string("1 2 3\n4 5 6\n"), m);
+    require(m.rows() == 2 && m.cols() == 3 && m(1,0) == 4., "matrix rows");
+
+    matrix44_c f;
+    parse_fails(std::string("1 2 3\n4 5 6\n"), f, "fixed matrix size");
+    parse_fails(std::string("1 2 3\n4 5\n"), m, "ragged matrix");
+}
+
+void check_objects()
+{
+    /* Numbers across lines, then text, like tests/timing/mvals.txt: */
+    std::string text;
+    for(int i = 0; i < 48; ++ i) {
+        char s[32];
+        std::sprintf(s, "%g%s", 0.5*i, i%4 == 3 ? "\n" : " ");
+        text += s;
+    }
+    text += "\nNote: 3 matrices\n";
+
+    matrix44_c m[3];
+    const char* p = parse_objects(text.data(), text.data() + text.size(),
+            m, 3);
+    require(m[1](2,3) == 0.5*27 && m[2](3,3) == 0.5*47, "matrix objects");
+    require(std::string(p, 6) == "\n\nNote", "end of the objects");
+
+    std::vector<vector4d> v;
+    parse_objects(text.data(), text.data() + text.size(), v);
+    require(v.size() == 12 && v[11][3] == 0.5*47, "vector objects");
+
+    bool thrown = false;
+    try {
+        matrix44_c n[4];
+        parse_objects(text, n, 4);
+    } catch(std::invalid_argument&) {
+        thrown = true;
+    }
+    require(thrown, "too few numbers");
+
+    /* Default-constructed dynamic vectors have no elements to fill: */
+    thrown = false;
+    try {
+        std::vector< vector< double, dynamic<> > > d;
+        parse_objects(std::string("1 2 3\n4 5 6"), d);
+    } catch(std::invalid_argument&) {
+        thrown = true;
+    }
+    require(thrown, "dynamic objects");
+}
+
+int main()
+{
+    try {
+        check_streams();
+        check_numbers();
+        check_rows();
+        check_objects();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,239 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check pick_ray_generator<> against make_pick_ray(), and the nearest ray
+ * intersections with spheres, boxes and triangles against a search of
+ * each primitive in turn.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <limits>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+bool close(double a, double b, double tol = 1e-3)
+{
+    return std::fabs(a - b) < tol*(1. + std::fabs(b));
+}
+
+/* A deterministic sequence in [-1,1): */
+double next(unsigned& seed)
+{
+    seed = seed*1664525u + 1013904223u;
+    return double(seed >> 8)/double(1 << 23) - 1.;
+}
+
+template<class VecT> void
+equal_or_fail(const VecT& a, double x, double y, double z,
+        const std::string& msg)
+{
+    require(close(a[0], x) && close(a[1], y) && close(a[2], z), msg);
+}
+
+template<typename Real> void
+check_rays(const std::string& msg)
+{
+    typedef vector< Real, fixed<3> > vector_type;
+    typedef matrix< Real, fixed<4,4>, col_basis, col_major > matrix_type;
+    typedef soa_vector<Real,3> soa_type;
+
+    matrix_type view, projection, viewport;
+    matrix_look_at_RH(view, vector_type(1,2,3), vector_type(0,0,-10),
+            vector_type(0,1,0));
+    matrix_perspective_xfov_RH(projection, Real(1.2), Real(1.5), Real(.5),
+            Real(50), z_clip_neg_one);
+    matrix_viewport(viewport, Real(0), Real(640), Real(0), Real(480),
+            z_clip_neg_one);
+    pick_ray_generator<Real> g(view, projection, viewport);
+
+    enum { n = 23, w = 7, h = 5 };
+    Real x[n], y[n];
+    for(int k = 0; k < n; ++ k) {
+        x[k] = Real(20 + 27*k);
+        y[k] = Real(460 - 19*k);
+    }
+    soa_type o, d;
+    g.make_rays(x, y, o, d, n);
+    for(int k = 0; k < n; ++ k) {
+        vector_type p, q, r, s;
+        make_pick_ray(x[k], y[k], view, projection, viewport, p, q);
+        g.make_ray(x[k], y[k], r, s);
+        equal_or_fail(r, p[0], p[1], p[2], msg + ": ray origin");
+        equal_or_fail(s, q[0], q[1], q[2], msg + ": ray direction");
+        r = o.get(k); s = d.get(k);
+        equal_or_fail(r, p[0], p[1], p[2], msg + ": make_rays origin");
+        equal_or_fail(s, q[0], q[1], q[2], msg + ": make_rays direction");
+    }
+
+    Real ox[w*h], oy[w*h], oz[w*h], dx[w*h], dy[w*h], dz[w*h];
+    g.make_ray_grid(Real(100.5), Real(200.5), w, h, ox, oy, oz,
+            dx, dy, dz, false);
+    for(int j = 0; j < h; ++ j) {
+        for(int i = 0; i < w; ++ i) {
+            vector_type p, q;
+            make_pick_ray(Real(100.5 + i), Real(200.5 + j), view,
+                    projection, viewport, p, q, false);
+            int k = j*w + i;
+            require(close(ox[k], p[0]) && close(oy[k], p[1])
+                    && close(oz[k], p[2]), msg + ": grid origin");
+            require(close(dx[k], q[0]) && close(dy[k], q[1])
+                    && close(dz[k], q[2]), msg + ": grid direction");
+        }
+    }
+}
+
+/* The nearest of the hit distances t computed one primitive at a time by
+ * the functions below (negative for a miss):
+ */
+template<typename Real> bool
+nearest(const Real* t, size_t n, size_t& index, Real& tmin)
+{
+    bool hit = false;
+    for(size_t k = 0; k < n; ++ k) {
+        if(t[k] >= 0 && t[k] < tmin) { tmin = t[k]; index = k; hit = true; }
+    }
+    return hit;
+}
+
+template<class VecT, typename Real> Real
+sphere_distance(const VecT& o, const VecT& d, const VecT& c, Real r)
+{
+    VecT p = o - c;
+    Real a = dot(d,d), b = dot(p,d), e = dot(p,p) - r*r;
+    Real disc = b*b - a*e;
+    if(disc < 0) return -1;
+    Real s = std::sqrt(disc);
+    return (e < 0) ? (s - b)/a : (b < 0) ? (-b - s)/a : Real(-1);
+}
+
+template<typename Real, class VecT> Real
+box_distance(const VecT& o, const VecT& d, const VecT& lo, const VecT& hi)
+{
+    Real tn = 0, tf = std::numeric_limits<Real>::max();
+    for(int i = 0; i < 3; ++ i) {
+        Real a = (lo[i] - o[i])/d[i], b = (hi[i] - o[i])/d[i];
+        if(a > b) std::swap(a,b);
+        tn = std::max(tn, a); tf = std::min(tf, b);
+    }
+    return (tn <= tf) ? tn : Real(-1);
+}
+
+template<typename Real, class VecT> Real
+triangle_distance(const VecT& o, const VecT& d,
+        const VecT& a, const VecT& b, const VecT& c)
+{
+    /* Intersect the plane, then check the barycentric coordinates: */
+    VecT n = cross(b - a, c - a);
+    Real t = dot(a - o, n)/dot(d, n);
+    VecT p = o + t*d;
+    Real area = dot(n,n);
+    Real u = dot(cross(p - a, c - a), n)/area;
+    Real v = dot(cross(b - a, p - a), n)/area;
+    return (u >= 0 && v >= 0 && u + v <= 1) ? t : Real(-1);
+}
+
+template<typename Real> void
+check_intersections(const std::string& msg)
+{
+    typedef vector< Real, fixed<3> > vector_type;
+    typedef soa_vector<Real,3> soa_type;
+
+    enum { n = 61 };
+    unsigned seed = 7;
+    soa_type c, lo, hi, a, b, e;
+    vector< Real, dynamic<> > r(n);
+    c.resize(n); lo.resize(n); hi.resize(n);
+    a.resize(n); b.resize(n); e.resize(n);
+    for(int k = 0; k < n; ++ k) {
+        vector_type p(Real(10*next(seed)), Real(10*next(seed)),
+                Real(10*next(seed)));
+        vector_type s(Real(1.5 + next(seed)), Real(1.5 + next(seed)),
+                Real(1.5 + next(seed)));
+        c.set(k, p);
+        r[k] = Real(1 + .5*next(seed));
+        lo.set(k, vector_type(p - s)); hi.set(k, vector_type(p + s));
+        a.set(k, p);
+        b.set(k, vector_type(p + vector_type(s[0], 0, s[2])));
+        e.set(k, vector_type(p + vector_type(0, s[1], -s[2])));
+    }
+
+    int hits = 0;
+    for(int i = 0; i < 40; ++ i) {
+        vector_type o(Real(12*next(seed)), Real(12*next(seed)),
+                Real(12*next(seed)));
+        vector_type d(Real(next(seed)), Real(next(seed)),
+                Real(next(seed)));
+        if(i == 0) o = c.get(3);
+
+        Real ts[n], tb[n], tt[n];
+        for(int k = 0; k < n; ++ k) {
+            ts[k] = sphere_distance(o, d, c.get(k), r[k]);
+            tb[k] = box_distance<Real>(o, d, lo.get(k), hi.get(k));
+            tt[k] = triangle_distance<Real>(
+                    o, d, a.get(k), b.get(k), e.get(k));
+        }
+
+        size_t ki = n, kr = n;
+        Real t = std::numeric_limits<Real>::max(), tr = t;
+        bool hit = intersect_ray_spheres(o, d, c, r, ki, t);
+        require(hit == nearest(ts, n, kr, tr), msg + ": spheres");
+        if(hit) require(close(t, tr) && (ki == kr || close(ts[ki], tr)),
+                msg + ": nearest sphere");
+        if(i == 0) require(hit && close(t, ts[3]), msg + ": inside sphere");
+        hits += hit;
+
+        ki = kr = n;
+        t = tr = std::numeric_limits<Real>::max();
+        hit = intersect_ray_boxes(o, d, lo, hi, ki, t);
+        require(hit == nearest(tb, n, kr, tr), msg + ": boxes");
+        if(hit) require(close(t, tr) && (ki == kr || close(tb[ki], tr)),
+                msg + ": nearest box");
+        hits += hit;
+
+        ki = kr = n;
+        t = tr = std::numeric_limits<Real>::max();
+        hit = intersect_ray_triangles(o, d, a, b, e, ki, t);
+        require(hit == nearest(tt, n, kr, tr), msg + ": triangles");
+        if(hit) require(close(t, tr) && (ki == kr || close(tt[ki], tr)),
+                msg + ": nearest triangle");
+        hits += hit;
+
+        /* Nothing is nearer than the nearest hit: */
+        if(hit) {
+            Real limit = t*Real(.5);
+            require(!intersect_ray_triangles(o, d, a, b, e, ki, limit),
+                    msg + ": distance limit");
+        }
+    }
+    require(hits > 20, msg + ": too few hits");
+}
+
+int main()
+{
+    try {
+        check_rays<float>("float");
+        check_rays<double>("double");
+        check_intersections<float>("float");
+        check_intersections<double>("double");
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,106 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check the batched quaternion slerp(), nlerp() and squad() against the
+ * single-quaternion functions, for arrays that do not divide evenly into
+ * packets.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+template<class QuatT> QuatT random_unit()
+{
+    QuatT q;
+    q.random(-1., 1.);
+    return normalize(q);
+}
+
+template<class QuatT> void
+close_or_fail(const QuatT& a, const QuatT& b, double tol,
+        const std::string& msg)
+{
+    for(int i = 0; i < 4; ++ i)
+        require(std::fabs(a[i] - b[i]) < tol, msg);
+}
+
+template<class QuatT> void
+check(size_t n, double tol, const std::string& msg)
+{
+    typedef typename QuatT::value_type value_type;
+    std::vector<QuatT> q1(n), q2(n), a1(n), a2(n), out(n);
+    std::vector<value_type> t(n);
+    for(size_t k = 0; k < n; ++ k) {
+        q1[k] = random_unit<QuatT>(); q2[k] = random_unit<QuatT>();
+        a1[k] = random_unit<QuatT>(); a2[k] = random_unit<QuatT>();
+        t[k] = value_type(std::rand())/value_type(RAND_MAX);
+    }
+
+    /* Include nearly equal and exactly opposite pairs: */
+    q2[0] = q1[0];
+    if(n > 1) q2[1] = -q1[1];
+
+    slerp(&q1[0], &q2[0], &t[0], &out[0], n);
+    for(size_t k = 0; k < n; ++ k)
+        close_or_fail(out[k], slerp(q1[k], q2[k], t[k]), tol,
+                msg + ": slerp");
+
+    slerp(&q1[0], &q2[0], value_type(.3), &out[0], n);
+    for(size_t k = 0; k < n; ++ k)
+        close_or_fail(out[k], slerp(q1[k], q2[k], value_type(.3)), tol,
+                msg + ": slerp, shared weight");
+
+    nlerp(&q1[0], &q2[0], &t[0], &out[0], n);
+    for(size_t k = 0; k < n; ++ k)
+        close_or_fail(out[k], nlerp(q1[k], q2[k], t[k]), 1e-5,
+                msg + ": nlerp");
+
+    squad(&q1[0], &a1[0], &a2[0], &q2[0], &t[0], &out[0], n);
+    for(size_t k = 0; k < n; ++ k) {
+        value_type s = value_type(2)*t[k]*(value_type(1) - t[k]);
+        QuatT r = slerp(slerp(q1[k], q2[k], t[k]),
+                slerp(a1[k], a2[k], t[k]), s);
+        close_or_fail(out[k], r, 3*tol, msg + ": squad");
+    }
+
+    /* The output may be one of the inputs: */
+    std::vector<QuatT> r(q1);
+    slerp(&r[0], &q2[0], &t[0], &r[0], n);
+    for(size_t k = 0; k < n; ++ k)
+        close_or_fail(r[k], slerp(q1[k], q2[k], t[k]), tol,
+                msg + ": slerp in place");
+}
+
+int main()
+{
+    try {
+        size_t sizes[] = { 1, 3, 8, 13, 100 };
+        for(size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++ i) {
+            check<quaternionf_p>(sizes[i], 1e-4, "float");
+            check<quaterniond_n>(sizes[i], 1e-7, "double");
+        }
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,124 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check quaternion products, normalization and vector rotation against the
+ * scalar expressions and matrix_rotation_quaternion(), for both element
+ * orders and both cross product conventions.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+bool close(double a, double b)
+{
+    return std::fabs(a - b) < 1e-5*(1. + std::fabs(b));
+}
+
+template<class QuatT> QuatT
+make_quaternion(double s)
+{
+    typedef typename QuatT::value_type value_type;
+    return QuatT(value_type(std::cos(s)), value_type(std::sin(2.*s)),
+            value_type(std::cos(1. + 3.*s)), value_type(s - .5));
+}
+
+template<class QuatT> void
+check(const std::string& msg)
+{
+    typedef typename QuatT::value_type value_type;
+    typedef vector< value_type, fixed<3> > vector_type;
+    typedef matrix< value_type, fixed<3,3>, row_basis, row_major >
+        matrix_type;
+
+    for(int i = 0; i < 20; ++ i) {
+        QuatT p = make_quaternion<QuatT>(.1*i);
+        QuatT q = make_quaternion<QuatT>(1. - .3*i);
+
+        /* Products: */
+        QuatT r = p*q, s = detail::QuaternionMult(p, q);
+        for(int j = 0; j < 4; ++ j)
+            require(close(r[j], s[j]), msg + ": product");
+        r = p; r *= q;
+        for(int j = 0; j < 4; ++ j)
+            require(close(r[j], s[j]), msg + ": *=");
+        require(close(p.real(), make_quaternion<QuatT>(.1*i).real()),
+                msg + ": operand changed");
+
+        /* Normalization: */
+        r = p; r.normalize();
+        s = p / p.length();
+        for(int j = 0; j < 4; ++ j)
+            require(close(r[j], s[j]), msg + ": normalize");
+        s = normalize(p);
+        for(int j = 0; j < 4; ++ j)
+            require(close(r[j], s[j]), msg + ": normalize()");
+
+        /* Rotation of vectors, with unit quaternions: */
+        vector_type v(value_type(std::sin(.7*i)), value_type(-1),
+                value_type(.25*i));
+        matrix_type m;
+        matrix_rotation_quaternion(m, r);
+        vector_type a = quaternion_rotate_vector(r, v);
+        vector_type b = transform_vector(m, v);
+        for(int j = 0; j < 3; ++ j)
+            require(close(a[j], b[j]), msg + ": rotate vector");
+
+        /* Batches that do not divide evenly into packets: */
+        vector_type in[23], out[23];
+        for(int k = 0; k < 23; ++ k)
+            in[k] = v*value_type(k) - vector_type(1,2,3);
+        quaternion_rotate_vectors(r, in, out, 23);
+        for(int k = 0; k < 23; ++ k) {
+            b = transform_vector(m, in[k]);
+            for(int j = 0; j < 3; ++ j)
+                require(close(out[k][j], b[j]), msg + ": rotate vectors");
+        }
+    }
+}
+
+int main()
+{
+    try {
+        check< quaternion<float, fixed<>, scalar_first, positive_cross> >(
+                "float, scalar_first, positive_cross");
+        check< quaternion<float, fixed<>, scalar_first, negative_cross> >(
+                "float, scalar_first, negative_cross");
+        check< quaternion<float, fixed<>, vector_first, positive_cross> >(
+                "float, vector_first, positive_cross");
+        check< quaternion<float, fixed<>, vector_first, negative_cross> >(
+                "float, vector_first, negative_cross");
+        check< quaternion<double, fixed<>, scalar_first, positive_cross> >(
+                "double, scalar_first, positive_cross");
+        check< quaternion<double, fixed<>, vector_first, negative_cross> >(
+                "double, vector_first, negative_cross");
+
+        /* A known rotation: 90 degrees about z takes x to y. */
+        quaternionf_p q;
+        quaternion_rotation_axis_angle(q, vector3f(0.f,0.f,1.f),
+                float(constants<double>::pi()/2.));
+        vector3f y = quaternion_rotate_vector(q, vector3f(1.f,0.f,0.f));
+        require(std::fabs(y[0]) < 1e-6 && close(y[1], 1.)
+                && std::fabs(y[2]) < 1e-6, "axis-angle rotation");
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,173 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check the random engines against their reference sequences, the engine
+ * overloads of the random helpers, and the bulk samplers for unit length,
+ * cone angle and rough uniformity.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+void check_engines()
+{
+    /* The first outputs of PCG-XSH-RR with the pcg32_random_r reference
+     * seed (42,54):
+     */
+    pcg32 p(42u, 54u);
+    const uint32_t pcg_ref[6] = { 0xa15c02b7u, 0x7b47f409u, 0xba1d3330u,
+        0x83d2f293u, 0xbfa4784bu, 0xcbed606eu };
+    for(int i = 0; i < 6; ++ i)
+        require(p() == pcg_ref[i], "pcg32 sequence");
+
+    /* Equal seeds give equal sequences, and distinct ones do not: */
+    xoshiro128pp a(7), b(7), c(8);
+    bool differ = false;
+    for(int i = 0; i < 100; ++ i) {
+        uint32_t x = a();
+        require(x == b(), "xoshiro128pp determinism");
+        differ |= (x != c());
+    }
+    require(differ, "xoshiro128pp seeds");
+
+    /* A jumped copy gives a different stream: */
+    b = a;
+    b.jump();
+    differ = false;
+    for(int i = 0; i < 100; ++ i) differ |= (a() != b());
+    require(differ, "xoshiro128pp jump");
+
+    pcg32 s0(1, 1), s1(1, 2);
+    require(s0() != s1() || s0() != s1(), "pcg32 streams");
+}
+
+void check_helpers()
+{
+    random_engine g(3);
+    long lo = 0, hi = 0;
+    for(int i = 0; i < 10000; ++ i) {
+        long k = random_integer(-3, 4, g);
+        require(k >= -3 && k <= 4, "random_integer range");
+        lo += (k == -3); hi += (k == 4);
+        double u = random_unit(g);
+        require(u >= 0. && u < 1., "random_unit range");
+        float r = random_real(2.f, 5.f, g);
+        require(r >= 2.f && r <= 5.f, "random_real range");
+        int b = random_binary(g), s = random_polar(g);
+        require((b == 0 || b == 1) && (s == -1 || s == 1),
+                "random_binary/random_polar");
+    }
+    require(lo > 1000 && hi > 1000, "random_integer bounds");
+
+    /* Ranges of 2^32 values and more reach both ends: */
+    if(sizeof(long) > 4) {
+        long max = long(1) << 40, top = 0;
+        for(int i = 0; i < 1000; ++ i) {
+            long k = random_integer(-max, max, g);
+            require(k >= -max && k <= max, "wide random_integer range");
+            if(k > top) top = k;
+        }
+        require(top > max/2, "wide random_integer bounds");
+    }
+
+    vector3d v, axis(0., 0., 1.);
+    for(int i = 0; i < 1000; ++ i) {
+        random_unit(v, g);
+        require(std::fabs(length(v) - 1.) < 1e-12, "random_unit(v,g)");
+        random_unit(v, axis, .3, g);
+        require(std::fabs(length(v) - 1.) < 1e-12
+                && v[2] >= std::cos(.3) - 1e-12, "random_unit(v,axis,g)");
+    }
+
+    /* The std::rand overload still gives unit vectors: */
+    random_unit(v);
+    require(std::fabs(length(v) - 1.) < 1e-12, "random_unit(v)");
+}
+
+template<typename Real> void
+check_samplers(const std::string& msg, double tol)
+{
+    typedef vector< Real, fixed<3> > vector_type;
+    typedef quaternion< Real, fixed<>, vector_first, positive_cross > q_type;
+    typedef quaternion< Real, fixed<>, scalar_first, negative_cross > p_type;
+
+    enum { n = 4099 };
+    random_engine g(11);
+
+    soa_vector<Real,3> s;
+    s.resize(n);
+    random_unit_vectors(s, g);
+    vector_type mean(0,0,0);
+    for(int k = 0; k < n; ++ k) {
+        vector_type v = s.get(k);
+        require(std::fabs(length(v) - 1.) < tol, msg + ": unit vectors");
+        mean += v;
+    }
+    mean /= Real(n);
+    require(length(mean) < .05, msg + ": unit vector mean");
+
+    vector_type axis(1, 2, -2);
+    axis.normalize();
+    Real theta = Real(.4);
+    vector_type* p = new vector_type[n];
+    random_cone_vectors(axis, theta, p, n, g);
+    mean.zero();
+    for(int k = 0; k < n; ++ k) {
+        require(std::fabs(length(p[k]) - 1.) < tol, msg + ": cone unit");
+        require(dot(p[k], axis) >= std::cos(theta) - tol,
+                msg + ": cone angle");
+        mean += p[k];
+    }
+    mean.normalize();
+    require(dot(mean, axis) > .999, msg + ": cone mean");
+    delete [] p;
+
+    /* Rotations of a vector are uniform on the sphere: */
+    q_type* q = new q_type[n];
+    p_type* r = new p_type[n];
+    random_rotations(q, n, g);
+    random_rotations(r, n, g);
+    mean.zero();
+    vector_type mr(0,0,0);
+    for(int k = 0; k < n; ++ k) {
+        require(std::fabs(length(q[k]) - 1.) < tol, msg + ": rotations");
+        require(std::fabs(length(r[k]) - 1.) < tol, msg + ": rotations");
+        mean += quaternion_rotate_vector(q[k], vector_type(0,0,1));
+        mr += quaternion_rotate_vector(r[k], vector_type(1,0,0));
+    }
+    require(length(mean)/n < .05 && length(mr)/n < .05,
+            msg + ": rotation mean");
+    delete [] q;
+    delete [] r;
+}
+
+int main()
+{
+    try {
+        check_engines();
+        check_helpers();
+        check_samplers<float>("float", 1e-5);
+        check_samplers<double>("double", 1e-12);
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,121 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check soa_vector expressions against the same operations applied to
+ * each vector separately, for bundles that do not divide evenly into
+ * packets.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+bool close(double a, double b)
+{
+    return std::fabs(a - b) < 1e-5*(1. + std::fabs(b));
+}
+
+template<class SoaT, class VecT> void
+equal_or_fail(const SoaT& s, size_t k, const VecT& v, const std::string& msg)
+{
+    for(int i = 0; i < SoaT::dimension; ++ i)
+        require(close(s.plane(i)[k], v[i]), msg);
+}
+
+template<typename E> void
+check(size_t n, const std::string& msg)
+{
+    typedef soa_vector<E,3> soa_type;
+    typedef vector< E, fixed<3> > vector_type;
+    typedef vector< E, dynamic<> > plane_type;
+
+    soa_type a(n), b(n), c;
+    for(size_t k = 0; k < n; ++ k) {
+        a.set(k, vector_type(E(std::sin(0.3*k)), E(2), E(std::cos(0.7*k))));
+        b.set(k, vector_type(E(0.5*k), E(-1), E(std::sin(1.1*k))));
+    }
+
+    /* Element-wise operators: */
+    c = E(2)*(a + b) - b/E(4);
+    require(c.size() == n, msg + ": size");
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(c, k, E(2)*(a.get(k) + b.get(k)) - b.get(k)/E(4),
+                msg + ": linear combination");
+
+    c = -a; c += a*E(3); c -= b;
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(c, k, E(2)*a.get(k) - b.get(k), msg + ": +=, -=");
+
+    /* Products and lengths: */
+    plane_type d = dot(a, b + a), l = length(a - b);
+    for(size_t k = 0; k < n; ++ k) {
+        require(close(d[k], dot(a.get(k), b.get(k) + a.get(k))),
+                msg + ": dot");
+        require(close(l[k], length(a.get(k) - b.get(k))), msg + ": length");
+    }
+
+    soa_type x = cross(a, b);
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(x, k, cross(a.get(k), b.get(k)), msg + ": cross");
+
+    c = normalize(a + b);
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(c, k, normalize(a.get(k) + b.get(k)),
+                msg + ": normalize");
+
+    c = normalize(a)*E(2) + b;
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(c, k, normalize(a.get(k))*E(2) + b.get(k),
+                msg + ": normalize in an expression");
+
+    /* Expressions that read across planes may alias the result: */
+    c = a; c = cross(c, b);
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(c, k, x.get(k), msg + ": aliased cross");
+
+    c = a; c = normalize(c);
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(c, k, normalize(a.get(k)), msg + ": aliased normalize");
+
+    c = a; c.normalize();
+    for(size_t k = 0; k < n; ++ k)
+        equal_or_fail(c, k, normalize(a.get(k)), msg + ": normalize()");
+}
+
+int main()
+{
+    try {
+        size_t sizes[] = { 1, 3, 8, 19, 100 };
+        for(size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++ i) {
+            check<float>(sizes[i], "float");
+            check<double>(sizes[i], "double");
+        }
+
+        /* 4D bundles: */
+        soa_vector4d p(2);
+        p.set(0, vector4d(1., 2., 3., 4.));
+        p.set(1, vector4d(0., 0., 3., 4.));
+        vector< double, dynamic<> > s = length_squared(p);
+        require(s[0] == 30. && s[1] == 25., "4D length_squared");
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,84 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief An allocator that counts its allocations.
+ *
+ * The dynamic-array timing tests use counting_allocator<> to report how
+ * many heap allocations the timed loop made, alongside its run time.
+ */
+
+#ifndef counting_allocator_h
+#define counting_allocator_h
+
+#include <new>
+#include <cstddef>
+
+#define TIMING_COUNT_ALLOCATIONS
+
+/** The number of allocations made by all counting_allocator<>s. */
+inline unsigned long& allocation_count()
+{
+    static unsigned long count = 0;
+    return count;
+}
+
+/** Allocator counting each call to allocate(). */
+template<typename T> class counting_allocator
+{
+  public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<typename U> struct rebind {
+        typedef counting_allocator<U> other;
+    };
+
+
+  public:
+
+    counting_allocator() {}
+
+    template<typename U>
+        counting_allocator(const counting_allocator<U>&) {}
+
+
+  public:
+
+    pointer allocate(size_type n, const void* = 0) {
+        ++ allocation_count();
+        return static_cast<pointer>(::operator new(n*sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type) { ::operator delete(p); }
+
+    size_type max_size() const { return size_type(-1)/sizeof(T); }
+
+    void construct(pointer p, const T& v) { new((void*)p) T(v); }
+    void destroy(pointer p) { p->~T(); }
+};
+
+/** Allocator selector, as for std::allocator<void>. */
+template<> class counting_allocator<void>
+{
+  public:
+
+    typedef void value_type;
+    typedef void* pointer;
+    typedef const void* const_pointer;
+
+    template<typename U> struct rebind {
+        typedef counting_allocator<U> other;
+    };
+};
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <cml/cml.h>
+#include "counting_allocator.h"
 
 using namespace cml;
 
@@ -16,7 +17,8 @@ using namespace cml;
 using std::cerr;
 using std::endl;
 
-typedef matrix<double, dynamic<>, cml::col_basis> matrix_d44;
+typedef matrix<double, dynamic< counting_allocator<void> >, cml::col_basis>
+    matrix_d44;
 #define MATINIT(_m_) _m_(4,4)
 
 #include "print_matrix.cpp"
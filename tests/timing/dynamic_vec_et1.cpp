@@ -7,13 +7,14 @@
 
 #include <iostream>
 #include <cml/cml.h>
+#include "counting_allocator.h"
 
 /* For convenience: */
 using std::cerr;
 using std::endl;
 using namespace cml;
 
-typedef vector< double, dynamic<> > vector_d4;
+typedef vector< double, dynamic< counting_allocator<void> > > vector_d4;
 #define VECINIT(_v_) _v_(4)
 
 #include "print_vector.cpp"
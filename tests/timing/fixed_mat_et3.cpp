@@ -0,0 +1,26 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief 4x4 double, row basis, row-major product (compare with matrix_c2).
+ */
+
+#define CML_ENABLE_MATRIX_BRACES // for operator[][] to load/print a matrix
+
+#include <iostream>
+#include <cml/cml.h>
+using namespace cml;
+
+/* For convenience: */
+using std::cerr;
+using std::endl;
+
+typedef matrix<double, fixed<4,4>, cml::row_basis, cml::row_major> matrix_d44;
+#define MATINIT(_m_) _m_
+
+#include "print_matrix.cpp"
+#include "matrix_algebra2.cpp"
+#include "matrix_main2.cpp"
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,29 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief 4x4 float, col basis, col-major product (compare with matrix_c2).
+ */
+
+#define CML_ENABLE_MATRIX_BRACES // for operator[][] to load/print a matrix
+
+#include <iostream>
+#include <cml/cml.h>
+using namespace cml;
+
+/* For convenience: */
+using std::cerr;
+using std::endl;
+
+typedef matrix<float, fixed<4,4>, cml::col_basis, cml::col_major> matrix_f44;
+
+/* The shared drivers below name the matrix type matrix_d44: */
+typedef matrix_f44 matrix_d44;
+#define MATINIT(_m_) _m_
+
+#include "print_matrix.cpp"
+#include "matrix_algebra2.cpp"
+#include "matrix_main2.cpp"
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,24 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+#include <iostream>
+#include <cml/cml.h>
+using namespace cml;
+
+/* For convenience: */
+using std::cerr;
+using std::endl;
+
+typedef quaternion< float, fixed<>, scalar_first, positive_cross >
+    quaternion_f4;
+typedef vector< float, fixed<3> > vector_f3;
+
+#include "quaternion_algebra1.cpp"
+#include "quaternion_main1.cpp"
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -34,11 +34,21 @@ int main(int argc, char** argv)
     if(argc == 2)
       n_iter = std::atol(argv[1]);
 
+#if defined(TIMING_COUNT_ALLOCATIONS)
+    /* Only count allocations made by the timed loop: */
+    allocation_count() = 0;
+#endif
+    timing_counters_start();
     usec_t t_start = usec_time();
     timed1(m,m1,m2,m3, n_iter);
     usec_t t_end = usec_time();
+    timing_counters_stop();
     double t = double(t_end - t_start);
     printf("%.4g s\n", t/1e6);
+    timing_counters_print(double(n_iter));
+#if defined(TIMING_COUNT_ALLOCATIONS)
+    printf("%lu allocations\n", allocation_count());
+#endif
 
     /* Force result to be used: */
     cerr << "m = " << m << endl;
@@ -41,11 +41,14 @@ int main(int argc, char** argv)
     if(argc == 2)
       n_iter = std::atol(argv[1]);
 
+    timing_counters_start();
     usec_t t_start = usec_time();
     timed1(m,m1,m2,m3, v,v1,v2,v3,v4, n_iter);
     usec_t t_end = usec_time();
+    timing_counters_stop();
     double t = double(t_end - t_start);
     printf("%.4g s\n", t/1e6);
+    timing_counters_print(double(n_iter));
 
     /* Force result to be used: */
     cerr << "v = " << v << endl;
@@ -0,0 +1,277 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief Hardware performance counters for the timing programs.
+ *
+ * perf_counters counts hardware events of the calling thread, in user
+ * mode, between start() and stop(), using the Linux perf_event_open()
+ * system call.  On other systems, or when the kernel refuses an event (for
+ * example, in a virtual machine without a PMU, or when
+ * /proc/sys/kernel/perf_event_paranoid is above 2), that event is simply
+ * not available.
+ *
+ * The events are named by a comma-separated list of:
+ *
+ *   cycles, instructions, cache_references, cache_misses, branches,
+ *   branch_misses, l1d_misses: the generic Linux hardware events;
+ *
+ *   task_clock, page_faults: software events (nanoseconds on the CPU,
+ *   and page faults), which work without a PMU;
+ *
+ *   fp_scalar, fp_128, fp_256, fp_512: retired scalar and packed
+ *   floating-point instructions (FP_ARITH_INST_RETIRED on Intel Skylake
+ *   and later; meaningless on other CPUs);
+ *
+ *   rUUEE: a raw event, as for perf stat -e (hexadecimal umask UU and
+ *   event EE).
+ *
+ * When there are more events than hardware counters, the kernel shares the
+ * counters in turn, and the counts are scaled up to the whole interval.
+ */
+
+#ifndef perf_counters_h
+#define perf_counters_h
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/** The events counted when none are named. */
+#define PERF_COUNTERS_DEFAULT "cycles,instructions,cache_misses,branch_misses"
+
+/** A hardware event to count. */
+struct perf_event_spec
+{
+    std::string name;
+    unsigned type;
+    unsigned long long config;
+};
+
+/** Parse a comma-separated list of event names into events.
+ *
+ * @throws std::invalid_argument on an unknown name.
+ */
+inline std::vector<perf_event_spec>
+parse_perf_events(const std::string& list)
+{
+    struct named {
+        const char* name;
+        unsigned type;
+        unsigned long long config;
+    };
+#if defined(__linux__)
+    const unsigned long long l1d_read_miss = PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    static const named known[] = {
+        { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { "cache_references", PERF_TYPE_HARDWARE,
+            PERF_COUNT_HW_CACHE_REFERENCES },
+        { "cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { "branches", PERF_TYPE_HARDWARE,
+            PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+        { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { "l1d_misses", PERF_TYPE_HW_CACHE, l1d_read_miss },
+        { "task_clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+        { "page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+        { "fp_scalar", PERF_TYPE_RAW, 0x03c7 },
+        { "fp_128", PERF_TYPE_RAW, 0x0cc7 },
+        { "fp_256", PERF_TYPE_RAW, 0x30c7 },
+        { "fp_512", PERF_TYPE_RAW, 0xc0c7 },
+    };
+    const unsigned raw_type = PERF_TYPE_RAW;
+#else
+    static const named known[] = {
+        { "cycles", 0, 0 }, { "instructions", 0, 0 },
+        { "cache_references", 0, 0 }, { "cache_misses", 0, 0 },
+        { "branches", 0, 0 }, { "branch_misses", 0, 0 },
+        { "l1d_misses", 0, 0 }, { "task_clock", 0, 0 },
+        { "page_faults", 0, 0 }, { "fp_scalar", 0, 0 }, { "fp_128", 0, 0 },
+        { "fp_256", 0, 0 }, { "fp_512", 0, 0 },
+    };
+    const unsigned raw_type = 0;
+#endif
+
+    std::vector<perf_event_spec> events;
+    std::string::size_type begin = 0;
+    while(begin <= list.size()) {
+        std::string::size_type end = list.find(',', begin);
+        if(end == std::string::npos) end = list.size();
+        std::string name = list.substr(begin, end - begin);
+        begin = end + 1;
+        if(name.empty()) continue;
+
+        perf_event_spec e;
+        e.name = name;
+        size_t i = 0, n = sizeof(known)/sizeof(known[0]);
+        while(i < n && name != known[i].name) ++i;
+        if(i < n) {
+            e.type = known[i].type;
+            e.config = known[i].config;
+        } else if(name.size() > 1 && name[0] == 'r'
+                && name.find_first_not_of("0123456789abcdefABCDEF", 1)
+                == std::string::npos)
+        {
+            e.type = raw_type;
+            e.config = std::strtoull(name.c_str() + 1, 0, 16);
+        } else {
+            throw std::invalid_argument("unknown event " + name);
+        }
+        events.push_back(e);
+    }
+    return events;
+}
+
+/** Counters of hardware events for the calling thread. */
+class perf_counters
+{
+  public:
+
+    /** Open a counter for each event (the default ones if empty). */
+    explicit perf_counters(const std::vector<perf_event_spec>& events
+            = parse_perf_events(PERF_COUNTERS_DEFAULT))
+        : m_events(events), m_fds(events.size(), -1)
+        , m_values(events.size(), -1.)
+    {
+#if defined(__linux__)
+        for(size_t i = 0; i < m_events.size(); ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = m_events[i].type;
+            attr.config = m_events[i].config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            m_fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                        0));
+        }
+#endif
+    }
+
+    ~perf_counters() {
+#if defined(__linux__)
+        for(size_t i = 0; i < m_fds.size(); ++i) {
+            if(m_fds[i] >= 0) close(m_fds[i]);
+        }
+#endif
+    }
+
+    /** Return the number of events. */
+    size_t size() const { return m_events.size(); }
+
+    /** Return the name of event i. */
+    const std::string& name(size_t i) const { return m_events[i].name; }
+
+    /** True if event i can be counted. */
+    bool available(size_t i) const { return m_fds[i] >= 0; }
+
+    /** True if any event can be counted. */
+    bool available() const {
+        for(size_t i = 0; i < m_fds.size(); ++i) {
+            if(m_fds[i] >= 0) return true;
+        }
+        return false;
+    }
+
+    /** Reset the counters to zero and start counting. */
+    void start() {
+#if defined(__linux__)
+        for(size_t i = 0; i < m_fds.size(); ++i) {
+            if(m_fds[i] < 0) continue;
+            ioctl(m_fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /** Stop counting, and read the counts. */
+    void stop() {
+#if defined(__linux__)
+        for(size_t i = 0; i < m_fds.size(); ++i) {
+            if(m_fds[i] >= 0) ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+        for(size_t i = 0; i < m_fds.size(); ++i) {
+            m_values[i] = -1.;
+            unsigned long long v[3];
+            if(m_fds[i] < 0 || read(m_fds[i], v, sizeof(v)) != sizeof(v)) {
+                continue;
+            }
+            /* Scale up counts made for part of the time: */
+            if(v[2] > 0) {
+                m_values[i] = double(v[0])*double(v[1])/double(v[2]);
+            }
+        }
+#endif
+    }
+
+    /** Return the last count of event i, or -1 if it is not available. */
+    double value(size_t i) const { return m_values[i]; }
+
+    /** Return the last count of the named event, or -1 if it is not
+     * available.
+     */
+    double value(const std::string& name) const {
+        for(size_t i = 0; i < m_events.size(); ++i) {
+            if(m_events[i].name == name) return m_values[i];
+        }
+        return -1.;
+    }
+
+    /** Print the counts per iteration, with the instructions per cycle,
+     * and the flops per cycle if flops (per iteration) is not zero.
+     */
+    void print(std::FILE* out, double iterations, double flops = 0.) const
+    {
+        if(!this->available()) {
+            std::fprintf(out, "counters: not available\n");
+            return;
+        }
+        for(size_t i = 0; i < m_events.size(); ++i) {
+            if(m_values[i] < 0.) continue;
+            std::fprintf(out, "%s: %.4g per iteration\n",
+                    m_events[i].name.c_str(), m_values[i]/iterations);
+        }
+        double cycles = this->value("cycles");
+        double instructions = this->value("instructions");
+        if(cycles > 0. && instructions >= 0.) {
+            std::fprintf(out, "IPC: %.3g\n", instructions/cycles);
+        }
+        if(cycles > 0. && flops > 0.) {
+            std::fprintf(out, "flops/cycle: %.3g\n",
+                    flops*iterations/cycles);
+        }
+    }
+
+
+  protected:
+
+    std::vector<perf_event_spec> m_events;
+    std::vector<int> m_fds;
+    std::vector<double> m_values;
+
+
+  private:
+
+    perf_counters(const perf_counters&);
+    perf_counters& operator=(const perf_counters&);
+};
+
+#endif
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
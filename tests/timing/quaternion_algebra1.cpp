@@ -0,0 +1,23 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+/* Quaternion test #1: */
+inline void timed1(
+        quaternion_f4& q,
+        const quaternion_f4& q1,
+        const quaternion_f4& q2,
+        size_t n_iter
+        )
+{
+    for(size_t i = 0; i < n_iter; ++i) {
+        q = q*q1*q2;
+        q.normalize();
+    }
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,21 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+/* Quaternion test #2: */
+inline void timed2(
+        vector_f3& v,
+        const quaternion_f4& q,
+        size_t n_iter
+        )
+{
+    for(size_t i = 0; i < n_iter; ++i) {
+        v = quaternion_rotate_vector(q,v);
+    }
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,21 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+/* Quaternion test #3, rotating by products with the conjugate: */
+inline void timed2(
+        vector_f3& v,
+        const quaternion_f4& q,
+        size_t n_iter
+        )
+{
+    for(size_t i = 0; i < n_iter; ++i) {
+        v = (q*quaternion_f4(0.f,v)*conjugate(q)).imaginary();
+    }
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
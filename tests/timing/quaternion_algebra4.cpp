@@ -0,0 +1,22 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+/* Quaternion test #4, rotating an array of vectors: */
+inline void timed3(
+        vector_f3* v,
+        size_t n,
+        const quaternion_f4& q,
+        size_t n_iter
+        )
+{
+    for(size_t i = 0; i < n_iter; ++i) {
+        quaternion_rotate_vectors(q,v,v,n);
+    }
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,24 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+/* Quaternion test #5, rotating an array of vectors one at a time: */
+inline void timed3(
+        vector_f3* v,
+        size_t n,
+        const quaternion_f4& q,
+        size_t n_iter
+        )
+{
+    for(size_t i = 0; i < n_iter; ++i) {
+        for(size_t k = 0; k < n; ++k) {
+            v[k] = quaternion_rotate_vector(q,v[k]);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
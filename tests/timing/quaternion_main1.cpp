@@ -0,0 +1,39 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+#include "timing.cpp"
+
+int main(int argc, char** argv)
+{
+    quaternion_f4 q, q1, q2;
+
+    q.identity();
+    std::cin >> q1[0] >> q1[1] >> q1[2] >> q1[3];
+    std::cin >> q2[0] >> q2[1] >> q2[2] >> q2[3];
+    q1.normalize();
+    q2.normalize();
+
+    size_t n_iter = 10*1000*1000; //10 000 000
+
+    if(argc == 2)
+      n_iter = std::atol(argv[1]);
+
+    timing_counters_start();
+    usec_t t_start = usec_time();
+    timed1(q,q1,q2, n_iter);
+    usec_t t_end = usec_time();
+    timing_counters_stop();
+    double t = double(t_end - t_start);
+    std::printf("%.4g s\n", t/1e6);
+    timing_counters_print(double(n_iter));
+
+    /* Force result to be used: */
+    cerr << "q = " << q << endl;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
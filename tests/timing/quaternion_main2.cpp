@@ -0,0 +1,38 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+#include "timing.cpp"
+
+int main(int argc, char** argv)
+{
+    quaternion_f4 q;
+    vector_f3 v;
+
+    std::cin >> q[0] >> q[1] >> q[2] >> q[3];
+    std::cin >> v[0] >> v[1] >> v[2];
+    q.normalize();
+
+    size_t n_iter = 10*1000*1000; //10 000 000
+
+    if(argc == 2)
+      n_iter = std::atol(argv[1]);
+
+    timing_counters_start();
+    usec_t t_start = usec_time();
+    timed2(v,q, n_iter);
+    usec_t t_end = usec_time();
+    timing_counters_stop();
+    double t = double(t_end - t_start);
+    std::printf("%.4g s\n", t/1e6);
+    timing_counters_print(double(n_iter));
+
+    /* Force result to be used: */
+    cerr << "v = " << v << endl;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
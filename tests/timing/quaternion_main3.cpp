@@ -0,0 +1,41 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ */
+
+#include "timing.cpp"
+
+int main(int argc, char** argv)
+{
+    quaternion_f4 q;
+    vector_f3 v[1000];
+
+    std::cin >> q[0] >> q[1] >> q[2] >> q[3];
+    std::cin >> v[0][0] >> v[0][1] >> v[0][2];
+    q.normalize();
+    for(size_t k = 1; k < 1000; ++k) {
+        v[k] = v[k-1] + v[0];
+    }
+
+    size_t n_iter = 10*1000; //10 000 (x 1000 vectors)
+
+    if(argc == 2)
+      n_iter = std::atol(argv[1]);
+
+    timing_counters_start();
+    usec_t t_start = usec_time();
+    timed3(v,1000,q, n_iter);
+    usec_t t_end = usec_time();
+    timing_counters_stop();
+    double t = double(t_end - t_start);
+    std::printf("%.4g s\n", t/1e6);
+    timing_counters_print(double(n_iter));
+
+    /* Force result to be used: */
+    cerr << "v = " << v[999] << endl;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -6,6 +6,7 @@
  */
 
 #include "timing.h"
+#include "perf_counters.h"
 
 #if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
@@ -36,17 +37,39 @@ usec_t usec_time()
 }
 #else
 
-#include <sys/time.h>
+#include <time.h>
 
+/* A monotonic clock, unaffected by changes to the time of day: */
 usec_t usec_time()
 {
-  timeval tv;
-  gettimeofday(&tv,0);
-  return tv.tv_sec*1000000ULL + tv.tv_usec;
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000000ULL + ts.tv_nsec/1000;
 }
 
 #endif
 
+static perf_counters* timing_counters = 0;
+
+void timing_counters_start()
+{
+    const char* events = std::getenv("CML_PERF_COUNTERS");
+    if(!events) return;
+    timing_counters = new perf_counters(
+            parse_perf_events(*events ? events : PERF_COUNTERS_DEFAULT));
+    timing_counters->start();
+}
+
+void timing_counters_stop()
+{
+    if(timing_counters) timing_counters->stop();
+}
+
+void timing_counters_print(double n_iter)
+{
+    if(timing_counters) timing_counters->print(stdout, n_iter);
+}
+
 
 // -------------------------------------------------------------------------
 // vim:ft=cpp
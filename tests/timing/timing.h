@@ -11,6 +11,15 @@
 typedef unsigned long long usec_t;
 usec_t usec_time();
 
+/* If the CML_PERF_COUNTERS environment variable is set, count the hardware
+ * events it names (see perf_counters.h; the default ones if it is empty)
+ * from timing_counters_start() to timing_counters_stop(), and print them
+ * per iteration with timing_counters_print():
+ */
+void timing_counters_start();
+void timing_counters_stop();
+void timing_counters_print(double n_iter);
+
 #endif
 
 // -------------------------------------------------------------------------
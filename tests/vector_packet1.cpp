@@ -0,0 +1,164 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check packet evaluation of vector expressions against the element-wise
+ * result, for fixed, dynamic and external vectors whose sizes do and do
+ * not divide evenly into packets.
+ *
+ * @sa cml/vector/vector_packet.h
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+template<class VecT> void
+fill(VecT& v, double seed)
+{
+    typedef typename VecT::value_type value_type;
+    for(size_t i = 0; i < v.size(); ++ i)
+        v[i] = value_type(1.5 + std::sin(seed + 0.37*i));
+}
+
+template<class VecT, class RefT> void
+equal_or_fail(const VecT& v, const RefT& r, const std::string& msg)
+{
+    typedef typename VecT::value_type value_type;
+    double tol = (sizeof(value_type) < sizeof(double)) ? 1e-5 : 1e-12;
+    for(size_t i = 0; i < v.size(); ++ i)
+        if(std::fabs(double(v[i]) - double(r[i])) > tol)
+            throw std::runtime_error(msg + ": value mismatch");
+}
+
+/* Check the packetable expressions on vectors of the same type: */
+template<class VecT> void
+check(VecT& a, VecT& b, VecT& c, VecT& d, const std::string& msg)
+{
+    typedef typename VecT::value_type value_type;
+    size_t N = a.size();
+    fill(b, 0.5); fill(c, 1.5); fill(d, 2.5);
+    value_type s = value_type(1.25);
+    std::vector<value_type> r(N);
+
+    a = b*s + c - d;
+    for(size_t i = 0; i < N; ++ i) r[i] = b[i]*s + c[i] - d[i];
+    equal_or_fail(a, r, msg + " a = b*s+c-d");
+
+    a = -(b - c)/s;
+    for(size_t i = 0; i < N; ++ i) r[i] = -(b[i] - c[i])/s;
+    equal_or_fail(a, r, msg + " a = -(b-c)/s");
+
+    a += b*2;
+    for(size_t i = 0; i < N; ++ i) r[i] += b[i]*2;
+    equal_or_fail(a, r, msg + " a += b*2");
+
+    a -= c;
+    for(size_t i = 0; i < N; ++ i) r[i] -= c[i];
+    equal_or_fail(a, r, msg + " a -= c");
+
+    a *= s;
+    for(size_t i = 0; i < N; ++ i) r[i] *= s;
+    equal_or_fail(a, r, msg + " a *= s");
+
+    a /= s;
+    for(size_t i = 0; i < N; ++ i) r[i] /= s;
+    equal_or_fail(a, r, msg + " a /= s");
+
+    /* Aliased source and destination: */
+    a = a + a*s;
+    for(size_t i = 0; i < N; ++ i) r[i] = r[i] + r[i]*s;
+    equal_or_fail(a, r, msg + " a = a + a*s");
+
+    a = b;
+    equal_or_fail(a, b, msg + " a = b");
+}
+
+template<typename E, int N> void
+check_fixed(const std::string& msg)
+{
+    vector< E, fixed<N> > a, b, c, d;
+    check(a, b, c, d, msg);
+}
+
+template<typename E> void
+check_dynamic(size_t N, const std::string& msg)
+{
+    vector< E, dynamic<> > a(N), b(N), c(N), d(N);
+    check(a, b, c, d, msg);
+}
+
+template<typename E> void
+check_external(size_t N, const std::string& msg)
+{
+    std::vector<E> data(4*N);
+    vector< E, external<> > a(&data[0],N), b(&data[N],N),
+        c(&data[2*N],N), d(&data[3*N],N);
+    check(a, b, c, d, msg);
+}
+
+void mixed_test()
+{
+    /* Mixed-precision expressions use the scalar path: */
+    vector< float, dynamic<> > a(13), b(13);
+    vector< double, dynamic<> > c(13);
+    fill(b, 0.5); fill(c, 1.5);
+    a = b + c;
+    std::vector<float> r(13);
+    for(size_t i = 0; i < 13; ++ i) r[i] = float(b[i] + c[i]);
+    equal_or_fail(a, r, "float = float + double");
+}
+
+void resize_test()
+{
+    /* Assignment resizes a dynamic vector to the source, either way: */
+    vector< double, dynamic<> > d(10), e(6), g(3);
+    for(size_t i = 0; i < d.size(); ++ i) d[i] = 7.;
+    d = vector< double, fixed<4> >(1., 2., 3., 4.);
+    double r[] = { 1., 2., 3., 4. };
+    if(d.size() != 4) throw std::runtime_error("resize from fixed: size");
+    equal_or_fail(d, r, "resize from fixed");
+
+    fill(g, 0.5);
+    e = g;
+    if(e.size() != 3) throw std::runtime_error("resize from dynamic: size");
+    equal_or_fail(e, g, "resize from dynamic");
+}
+
+int main()
+{
+    try {
+        check_fixed<float,3>("fixed<3> float");
+        check_fixed<float,4>("fixed<4> float");
+        check_fixed<float,19>("fixed<19> float");
+        check_fixed<double,2>("fixed<2> double");
+        check_fixed<double,7>("fixed<7> double");
+        check_fixed<double,32>("fixed<32> double");
+
+        size_t sizes[] = { 1, 3, 8, 17, 1000, 1027 };
+        for(size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++ i) {
+            check_dynamic<float>(sizes[i], "dynamic float");
+            check_dynamic<double>(sizes[i], "dynamic double");
+            check_external<float>(sizes[i], "external float");
+            check_external<double>(sizes[i], "external double");
+        }
+
+        mixed_test();
+        resize_test();
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp
@@ -0,0 +1,112 @@
+/* -*- C++ -*- ------------------------------------------------------------
+ @@COPYRIGHT@@
+ *-----------------------------------------------------------------------*/
+/** @file
+ *  @brief
+ *
+ * Check the batched point and vector transforms against transform_point(),
+ * transform_vector() and transform_point_4D(), for both basis orientations
+ * and for arrays that do not divide evenly into packets.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <cml/cml.h>
+
+using namespace cml;
+
+void require(bool ok, const std::string& msg)
+{
+    if(!ok) throw std::runtime_error(msg);
+}
+
+template<class VecT, class RefT> void
+equal_or_fail(const VecT& v, const RefT& r, const std::string& msg)
+{
+    for(int k = 0; k < 3; ++ k)
+        require(std::fabs(double(v[k]) - double(r[k]))
+                < 1e-4*(1. + std::fabs(double(r[k]))), msg);
+}
+
+template<typename E, class BasisT> void
+check(size_t n, const std::string& msg)
+{
+    typedef vector< E, fixed<3> > vector_type;
+    typedef matrix< E, fixed<4,4>, BasisT, row_major > matrix_type;
+
+    matrix_type R, T, M, P;
+    matrix_rotation_euler(R, E(0.3), E(-1.1), E(2.4), euler_order_zyx);
+    matrix_translation(T, E(1.5), E(-2), E(3.25));
+    M = R*T;
+    matrix_perspective_yfov_RH(P, E(1), E(1.5), E(0.1), E(100), z_clip_neg_one);
+    P = M*P;
+
+    std::vector<vector_type> in(n), out(n);
+    std::vector<E> raw(3*n), x(n), y(n), z(n), ox(n), oy(n), oz(n);
+    for(size_t i = 0; i < n; ++ i) {
+        in[i].set(E(std::sin(0.3*i)), E(std::cos(0.7*i)), E(-5. + 0.01*i));
+        x[i] = raw[3*i+0] = in[i][0];
+        y[i] = raw[3*i+1] = in[i][1];
+        z[i] = raw[3*i+2] = in[i][2];
+    }
+
+    /* Points: */
+    transform_points(M, &in[0], &out[0], n);
+    for(size_t i = 0; i < n; ++ i)
+        equal_or_fail(out[i], transform_point(M, in[i]), msg + ": points");
+
+    transform_points(M, &x[0], &y[0], &z[0], &ox[0], &oy[0], &oz[0], n);
+    for(size_t i = 0; i < n; ++ i)
+        equal_or_fail(vector_type(ox[i], oy[i], oz[i]),
+                transform_point(M, in[i]), msg + ": SoA points");
+
+    /* Vectors, in place: */
+    std::vector<E> w = raw;
+    transform_vectors(M, &w[0], &w[0], n);
+    for(size_t i = 0; i < n; ++ i)
+        equal_or_fail(&w[3*i], transform_vector(M, in[i]),
+                msg + ": interleaved vectors");
+
+    /* Projected points: */
+    transform_points_4D(P, &raw[0], &w[0], n);
+    for(size_t i = 0; i < n; ++ i)
+        equal_or_fail(&w[3*i], transform_point_4D(P, in[i]),
+                msg + ": interleaved projected points");
+
+    out = in;
+    transform_points_4D(P, &out[0], &out[0], n);
+    for(size_t i = 0; i < n; ++ i)
+        equal_or_fail(out[i], transform_point_4D(P, in[i]),
+                msg + ": projected points");
+}
+
+int main()
+{
+    try {
+        size_t sizes[] = { 1, 3, 8, 19, 100 };
+        for(size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++ i) {
+            check<float,col_basis>(sizes[i], "float, col_basis");
+            check<float,row_basis>(sizes[i], "float, row_basis");
+            check<double,col_basis>(sizes[i], "double, col_basis");
+            check<double,row_basis>(sizes[i], "double, row_basis");
+        }
+
+        /* A 3x3 linear transform: */
+        matrix33d_r L;
+        matrix_scale(L, 2., 3., 4.);
+        vector3d v(1., 2., 3.), r;
+        transform_vectors(L, &v, &r, 1);
+        equal_or_fail(r, vector3d(2., 6., 12.), "3x3 vectors");
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------------------------------
+// vim:ft=cpp